@@ -84,4 +84,45 @@ inline void run_Cell_SPM_2(double Crate)
   file.close();
 }
 
+inline void run_Cell_SPM_fast_validation()
+{
+  /*
+   * Age a Cell_SPM and a Cell_SPM_fast with the same degradation models and
+   * compare the computation time and the states at the end of the cycle ageing.
+   */
+  DEG_ID deg;
+  deg.SEI_id.add_model(4);
+  deg.SEI_porosity = 1;
+  deg.CS_id.add_model(0);
+  deg.CS_diffusion = 0;
+  deg.LAM_id.add_model(1);
+  deg.pl_id = 0;
+
+  constexpr double Vbal = 3.5;
+  constexpr int ndata = 20;
+
+  auto age = [&](StorageUnit *su) {
+    auto p = Procedure(true, Vbal, ndata, true);
+    Clock clk;
+    p.cycleAge(su, 50, 250, 10, true, 1, 1, 4.1, 2.8); //!< 50 1C CCCV cycles, voltage limits inside the cell's safety window
+    std::cout << "Finished cycle ageing of " << su->getFullID() << " in " << clk << ".\n";
+  };
+
+  auto c0 = make<Cell_SPM>("SPM_full", deg, 1, 1, 1, 1);
+  auto c1 = make<Cell_SPM_fast>("SPM_fast", deg, 1, 1, 1, 1);
+
+  age(c0.get());
+  age(c1.get());
+
+  auto &s0 = c0->getStateObj();
+  auto &s1 = c1->getStateObj();
+  std::cout << "quantity\tCell_SPM\tCell_SPM_fast\n"
+            << "V\t" << c0->V() << '\t' << c1->V() << '\n'
+            << "SOC\t" << c0->SOC() << '\t' << c1->SOC() << '\n'
+            << "Ah\t" << s0.Ah() << '\t' << s1.Ah() << '\n'
+            << "LLI\t" << s0.LLI() << '\t' << s1.LLI() << '\n'
+            << "delta\t" << s0.delta() << '\t' << s1.delta() << '\n'
+            << "thickp\t" << s0.thickp() << '\t' << s1.thickp() << '\n';
+}
+
 } // namespace slide::benchmarks
\ No newline at end of file
@@ -29,6 +29,7 @@ protected:
   std::string ID{ "StorageUnit" };           //!< identification string
   StorageUnit *parent{ nullptr };            //!< pointer to the SU 'above' this one [e.g. the module to which a cell is connected]
   bool blockDegAndTherm{ false };            //!< if true, degradation and the thermal ODE are ignored
+  settings::cellDataStorageLevel capture{ settings::cellDataStorageLevel::storeTimeData }; //!< data stored at runtime by this SU and the SUs below it, see setCapture
   using setStates_t = std::span<double> &;   //!< To pass states to read, non-expandable container.
   using getStates_t = std::vector<double> &; //!< To pass states to save, expandable container.
   using viewStates_t = std::span<double>;
@@ -72,9 +73,17 @@ public:
 
   virtual Status setStates(setStates_t s, bool checkStates = true, bool print = true) = 0; //!< opposite of getStates, check the states are valid?
 
+  //!< snapshot of the states of this SU and all its children in buffers which are part of each SU, so no heap allocation.
+  //!< There is one snapshot per SU, a second backupStates() overwrites the first one.
   virtual void backupStates() {}  //!< Back-up states.
   virtual void restoreStates() {} //!< restore backed-up states.
 
+  //!< variables of this SU (not of its children) which are not states but are needed to continue a simulation
+  //!< exactly (e.g. accumulated heat since the last thermal update). Used by Checkpoint, see Checkpoint.hpp.
+  //!< setCheckpoint reads fields while s is not empty, so records of older versions with fewer fields can be read.
+  virtual void getCheckpoint(std::vector<double> &s) {}
+  virtual void setCheckpoint(std::span<double> s) {}
+
   //!< virtual int getNstates() = 0;
   //!< virtual double SOC() = 0;
   //!<  voltage
@@ -104,6 +113,28 @@ public:
   //!< Data collection of cycling data (I, V, T, etc. for every cell)
   virtual void storeData() = 0;
   virtual void writeData(const std::string &prefix) = 0;
+
+  auto getCapture() const { return capture; }
+  void setCapture(settings::cellDataStorageLevel level)
+  {
+    /*
+     * Set which data is stored by this SU and all SUs below it, e.g. time data for the hottest module
+     * and usage statistics for the other cells of a pack.
+     * The data storage of the cells is set by DATASTORE_CELL at compile time, a cell stores the lowest of both levels:
+     * 	noStorage 				nothing, the parent skips storeData and writeData of this subtree
+     * 	storeCumulativeData 	only the states are written
+     * 	storeHistogramData 		usage statistics (in a second data storage of the cell if DATASTORE_CELL is storeTimeData)
+     * 	storeTimeData 			every sample (the default)
+     * The parents store data if any of their children does.
+     * Set it before data is stored or right after writeData: data stored but not written yet is dropped (with a warning) if its level changes.
+     */
+    applyCapture(level);
+    for (auto *p = parent; p != nullptr; p = p->parent)
+      p->refreshCapture();
+  }
+
+  virtual void applyCapture(settings::cellDataStorageLevel level) { capture = level; } //!< set the level of this SU and all its children
+  virtual void refreshCapture() {}                                                     //!< update the level after the one of a child changed
 };
 
 // Free functions:
@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 #include <span>
+#include <algorithm>
 
 namespace slide {
 
@@ -34,7 +35,8 @@ class Cell : public StorageUnit
 protected:
   double capNom{ 16 }; //!< capacity [Ah].
 
-  CellData<settings::DATASTORE_CELL> cellData; //!< Cell data storage.
+  CellData<settings::DATASTORE_CELL> cellData;                 //!< Cell data storage.
+  CellData<settings::data::lowCaptureStorage> cellStats; //!< usage statistics if the capture of this cell is lowered to storeHistogramData
 
 public:
   constexpr static CellLimits limits{ defaultCellLimits }; // Default cell limits. #TODO make it changable.
@@ -59,6 +61,7 @@ public:
 
   virtual Status setSOC(double SOCnew, bool checkV = true, bool print = true) = 0;
   virtual double SOC() = 0;
+  virtual Status setRelaxedVoltage(double Vset) = 0; //!< go directly to the fully relaxed state (0 current) with OCV = Vset
   virtual double getThotSpot() override { return T(); }
   size_t getNcells() override final { return 1; } //!< this is a single cell
 
@@ -99,8 +102,41 @@ public:
   }
 
   //!< dataStorage
-  virtual void storeData() override { cellData.storeData(*this); }                                  //!< Add another data point in the array.
-  virtual void writeData(const std::string &prefix) override { cellData.writeData(*this, prefix); } // #TODO *this may be Cell not actual type.
+  virtual void storeData() override //!< Add another data point in the array.
+  {
+    const auto level = std::min(capture, settings::DATASTORE_CELL);
+    if (level == settings::DATASTORE_CELL)
+      cellData.storeData(*this);
+    else if (level == settings::cellDataStorageLevel::storeHistogramData)
+      cellStats.storeData(*this);
+  }
+
+  virtual void writeData(const std::string &prefix) override // #TODO *this may be Cell not actual type.
+  {
+    const auto level = std::min(capture, settings::DATASTORE_CELL);
+    if (level == settings::DATASTORE_CELL)
+      cellData.writeData(*this, prefix);
+    else if (level == settings::cellDataStorageLevel::storeHistogramData)
+      cellStats.writeData(*this, prefix);
+    else if (level == settings::cellDataStorageLevel::storeCumulativeData)
+      CellDataWriter<settings::cellDataStorageLevel::storeCumulativeData>::writeData(*this, prefix, cellStats);
+  }
+
+  //!< time of the last sample of the usage statistics, so the first sample after a restart is weighted by the right interval
+  static constexpr size_t Ncheckpoint_data{ decltype(cellData)::Ncheckpoint + decltype(cellStats)::Ncheckpoint };
+  void getCheckpoint(std::vector<double> &s) override
+  {
+    cellData.getCheckpoint(s);
+    cellStats.getCheckpoint(s);
+  }
+  void setCheckpoint(std::span<double> s) override
+  {
+    cellData.setCheckpoint(s);
+    cellStats.setCheckpoint(s);
+  }
+
+  const auto &getCellData() const { return cellData; }   //!< data stored so far (e.g. usage statistics)
+  const auto &getCellStats() const { return cellStats; } //!< usage statistics stored while the capture was storeHistogramData
 
   virtual ThroughputData getThroughputs() { return {}; }
 
@@ -30,6 +30,7 @@ class Cell_ECM : public Cell
 
 protected:
   State_ECM<N_RC> st{ settings::T_ENV, 0.5 }; //!< States T, SOC, , I, Ir, ... ;
+  State_ECM<N_RC> st_backup{};                //!< snapshot of st made by backupStates()
   //!< parameters:
 
   std::array<double, N_RC> Rp{}, inv_tau{}; // inv_tau = 1/(RC). All initialised zero.
@@ -70,6 +71,8 @@ public:
 
   double V() override; //!< crit is an optional argument
   Status setStates(setStates_t s, bool checkStates = true, bool print = true) override;
+  void backupStates() override { st_backup = st; }
+  void restoreStates() override { st = st_backup; }
 
   double getRtot() override { return Rdc; } //!< Return the total resistance, V = OCV - I*Rtot
   double getThotSpot() override { return T(); }
@@ -77,6 +80,7 @@ public:
   double getOCV() override { return OCV.interp(st.SOC(), settings::printBool::printCrit); } // Linear interpolation #TODO add a OCV model.
 
   Status setSOC(double SOCnew, bool checkV = true, bool print = true) override;
+  Status setRelaxedVoltage(double Vset) override;
   Status setCurrent(double Inew, bool checkV = true, bool print = true) override;
   Status setVoltage(double Vnew, bool checkI = true, bool print = true) override;
 
@@ -259,6 +263,33 @@ inline Status Cell_ECM<N_RC>::setSOC(double SOCnew, bool checkV, bool print) //!
   return Status::Success;
 }
 
+/**
+ * Brings the cell directly to the fully relaxed state with an open circuit voltage of Vset.
+ * The current and the currents through the parallel resistances are set to 0 and the SOC is found with bisection on the OCV curve.
+ * @tparam N_RC The number of RC-elements in the ECM model.
+ * @param Vset The open circuit voltage to go to [V].
+ * @return Invalid_Vset if Vset is outside the OCV curve (the states are not changed), else Success.
+ */
+template <size_t N_RC>
+inline Status Cell_ECM<N_RC>::setRelaxedVoltage(double Vset)
+{
+  double SOC_lo = std::max(0.0, OCV.x.front()), SOC_hi = std::min(1.0, OCV.x.back());
+  if (Vset < OCV.interp(SOC_lo) || Vset > OCV.interp(SOC_hi))
+    return Status::Invalid_Vset;
+
+  for (int i = 0; i < 60 && (SOC_hi - SOC_lo) > 1e-12; i++) {
+    const double SOC_mid = (SOC_lo + SOC_hi) / 2;
+    (OCV.interp(SOC_mid) < Vset ? SOC_lo : SOC_hi) = SOC_mid;
+  }
+
+  st.SOC() = (SOC_lo + SOC_hi) / 2;
+  st.I() = 0;
+  for (size_t i = 0; i < N_RC; i++)
+    st.Ir(i) = 0;
+
+  return Status::Success;
+}
+
 /**
  * Calculates the cell voltage based on the current state of the cell.
  * @note Throws an error if the SOC is outside the allowed range.
@@ -106,7 +106,7 @@ Status Cell_SPM::setCurrent(double Inew, bool checkV, bool print)
   const auto Vcell_valid_old = Vcell_valid;
 
   st.I() = Inew;
-  Vcell_valid = false;
+  invalidateKinetics();
 
   const auto status = checkCurrent(checkV, print);
 
@@ -114,6 +114,7 @@ Status Cell_SPM::setCurrent(double Inew, bool checkV, bool print)
 
     st.I() = old_I;
     st.V() = old_V;
+    invalidateKinetics();
     Vcell_valid = Vcell_valid_old; //!< #TODO in future make it into states.
   }
 
@@ -134,10 +135,13 @@ bool Cell_SPM::getCSurf(double &cps, double &cns, bool print)
    * cns 	surface li-concentration at the negative particle [mol m-3]
    */
 
-  const auto [Dpt, Dnt] = calcDiffConstant();
-  const auto [i_app, jp, jn] = calcMolarFlux(); //!< current density, molar flux on the pos/neg particle
-
-  std::tie(cps, cns) = calcSurfaceConcentration(jp, jn, Dpt, Dnt);
+  if (kin_surf_valid) {
+    cps = kin.cps;
+    cns = kin.cns;
+  } else {
+    const auto &rates = getRates(); //!< diffusion constants and molar flux on the pos/neg particle
+    std::tie(cps, cns) = calcSurfaceConcentration(rates.jp, rates.jn, rates.Dpt, rates.Dnt);
+  }
 
   //!< check if the surface concentration is within the allowed range
   //!< 	0 < cp < Cmaxpos  &&  0 < cn < Cmaxneg
@@ -215,16 +219,17 @@ double Cell_SPM::getOCV()
 
   const bool verb = settings::printBool::printCrit; //!< print if the (global) verbose-setting is above the threshold
 
-  //!< Get the surface concentrations
-  double cps, cns;
-  const auto flag = getCSurf(cps, cns, verb);
-  //!< Calculate the li-fraction (instead of the li-concentration)
-  const double zp_surf = (cps / Cmaxpos);
-  const double zn_surf = (cns / Cmaxneg);
-  const bool bound = true;                                              //!< in linear interpolation, throw an error if you are out of the allowed range
-  const double dOCV = OCV_curves.dOCV_tot.interp(zp_surf, verb, bound); //!< entropic coefficient of the total cell voltage [V/K]
-  const double OCV_n = OCV_curves.OCV_neg.interp(zn_surf, verb, bound); //!< anode potential [V]
-  const double OCV_p = OCV_curves.OCV_pos.interp(zp_surf, verb, bound); //!< cathode potential [V]
+  //!< Get the surface li-fractions and electrode potentials
+  const auto &k = getKinetics(verb);
+
+  if (k.inRange)
+    return (k.OCV_p - k.OCV_n + (st.T() - T_ref) * k.dOCV);
+
+  //!< out of bounds, the interpolation decides whether to extrapolate or throw
+  const bool bound = true;                                                //!< in linear interpolation, throw an error if you are out of the allowed range
+  const double dOCV = OCV_curves.dOCV_tot.interp(k.zp_surf, verb, bound); //!< entropic coefficient of the total cell voltage [V/K]
+  const double OCV_n = OCV_curves.OCV_neg.interp(k.zn_surf, verb, bound); //!< anode potential [V]
+  const double OCV_p = OCV_curves.OCV_pos.interp(k.zp_surf, verb, bound); //!< cathode potential [V]
 
   const auto entropic_effect = (st.T() - T_ref) * dOCV;
 
@@ -259,46 +264,31 @@ double Cell_SPM::V()
 
   const bool verb = settings::printBool::printCrit; //!< print if the (global) verbose-setting is above the threshold
 
-  //!< Get the surface concentrations
-  double cps, cns;
-  const auto flag = getCSurf(cps, cns, verb);
+  //!< Get the surface concentrations, electrode potentials and overpotentials
+  const auto &k = getKinetics(verb);
   //!< check if the surface concentration is within the allowed range
   //!< 	0 < cp < Cmaxpos
   //!< 	0 < cn < Cmaxneg
   //!< don't allow 0 or Cmax because in that case, i0 will be 0, and the overpotentials will have 1/0 = inf or nan
-  if (!flag) {
+  if (!k.inRange) {
     if (verb) { //!< print error message unless you want to suppress the output
       std::cerr << "ERROR in Cell_SPM::V: concentration out of bounds. the positive lithium fraction is "
-                << cps / Cmaxpos << " and the negative lithium fraction is " << cns / Cmaxneg
+                << k.zp_surf << " and the negative lithium fraction is " << k.zn_surf
                 << " they should both be between 0 and 1.\n";
     }
     //	*v = nan("double"); //!< set the voltage to nan (Not A Number)
     return 0; //!< Surface concentration is out of bounds.
   } else {
-    //!< Calculate the li-fraction (instead of the li-concentration)
-    const double zp_surf = (cps / Cmaxpos);
-    const double zn_surf = (cns / Cmaxneg);
-
-    //!< Calculate the electrode potentials
-    const bool bound = true;                                              //!< in linear interpolation, throw an error if you are out of the allowed range
-    const double dOCV = OCV_curves.dOCV_tot.interp(zp_surf, verb, bound); //!< entropic coefficient of the total cell voltage [V/K]
-    const double OCV_n = OCV_curves.OCV_neg.interp(zn_surf, verb, bound); //!< anode potential [V]
-    const double OCV_p = OCV_curves.OCV_pos.interp(zp_surf, verb, bound); //!< cathode potential [V]
-
-    const double i_app = I() / geo.elec_surf; //!< current density on the electrodes [I m-2]
-
-    const auto [etapi, etani] = calcOverPotential(cps, cns, i_app); // #TODO if current is zero dont calculate.
-
     //!< Calculate the cell voltage
     //!< the cell OCV at the reference temperature is OCV_p - OCV_n
     //!< this OCV is adapted to the actual cell temperature using the entropic coefficient dOCV * (T - Tref)
     //!< then the overpotentials and the resistive voltage drop are added
-    const auto entropic_effect = (st.T() - T_ref) * dOCV; // #TODO
-    const auto overpotential = etapi - etani;
-    const auto OCV = (OCV_p - OCV_n + entropic_effect);
+    const auto entropic_effect = (st.T() - T_ref) * k.dOCV; // #TODO
+    const auto overpotential = k.etap - k.etan;
+    const auto OCV = (k.OCV_p - k.OCV_n + entropic_effect);
 
-    st.V() = OCV + overpotential - getRdc() * I(); //
-    Vcell_valid = true;                            //!< we now have the most up to date value stored
+    st.V() = OCV + overpotential - k.Rdc * I(); //
+    Vcell_valid = true;                         //!< we now have the most up to date value stored
   }
 
   return st.V();
@@ -363,12 +353,13 @@ Status Cell_SPM::setStates(setStates_t s, bool checkV, bool print)
 
   std::copy(s.begin(), s.begin() + st.size(), st.begin()); //!< Copy states.
   s = s.last(s.size() - st.size());                        //!< Remove first Nstates elements from span.
-  Vcell_valid = false;
+  invalidateKinetics();
 
   const Status status = free::check_Cell_states(*this, checkV);
 
   if (isStatusBad(status)) {
     st = st_old; //!< Restore states here.
+    invalidateKinetics();
     Vcell_valid = Vcell_valid_prev;
   }
 
@@ -552,6 +543,9 @@ void Cell_SPM::setT(double Ti)
    * Ti		uniform cell temperature, 273 <= T <= 333 [K]
    */
 
+  if (Ti != st.T())
+    invalidateKinetics(); //!< kinetics depend on T, but setting the same value (T_MODEL == 0) keeps the snapshot valid
+
   st.T() = Ti; //!< #TODO if we need to check if we are in limits.  if T is in limits.
 
   //!< the stress values stored in the class variables for stress are no longer valid because the state has changed
@@ -625,17 +619,82 @@ void Cell_SPM::setC(double cp0, double cn0)
   sparam.s_dai_update = false;
   sparam.s_lares_update = false;
 
-  Vcell_valid = false;
+  invalidateKinetics();
+}
+
+Status Cell_SPM::setRelaxedVoltage(double Vset)
+{
+  /*
+   * Bring the cell directly to a fully relaxed state (uniform concentrations, 0 current) with an open circuit voltage of Vset.
+   * This is the state a CCCV with a vanishing cut-off current converges to, without simulating it.
+   *
+   * First only the uniform eigenmode of each particle is kept, which is the exact state after an infinitely long rest
+   * (the other modes decay and do not hold any lithium). Then the charge q which has to move from the anode
+   * to the cathode to reach Vset is found with bisection. The SOC changes by the charge q, the degradation states,
+   * time and throughput are not changed.
+   *
+   * OUT
+   * Invalid_Vset 	Vset cannot be reached within the range of the OCV curves, the states are not changed
+   */
+  using settings::nch;
+  const auto ind = static_cast<size_t>(M->Input[3]); //!< index of the uniform eigenmode, see setC
+
+  double zp1{ 0 }, zn1{ 0 }; //!< transformed concentration of a uniform li-fraction of 1
+  for (size_t i = 0; i < nch; i++) {
+    zp1 += M->Vp[ind][i] * M->xch[i] * geo.Rp * Cmaxpos;
+    zn1 += M->Vn[ind][i] * M->xch[i] * geo.Rn * Cmaxneg;
+  }
+
+  const double fp0 = st.zp(ind) / zp1, fn0 = st.zn(ind) / zn1;                    //!< relaxed li-fractions
+  const double Kp = PhyConst::F * geo.elec_surf * st.thickp() * st.ep() * Cmaxpos; //!< charge to fill the cathode [C]
+  const double Kn = PhyConst::F * geo.elec_surf * st.thickn() * st.en() * Cmaxneg; //!< charge to fill the anode [C]
+
+  const auto &xp = OCV_curves.OCV_pos.x, &xn = OCV_curves.OCV_neg.x;
+  const double fp_lo = std::max(0.0, std::min(xp.front(), xp.back())), fp_hi = std::min(1.0, std::max(xp.front(), xp.back()));
+  const double fn_lo = std::max(0.0, std::min(xn.front(), xn.back())), fn_hi = std::min(1.0, std::max(xn.front(), xn.back()));
+
+  //!< range of q for which both li-fractions stay within the OCV curves, a larger q is a lower voltage
+  double q_lo = std::max((fp_lo - fp0) * Kp, (fn0 - fn_hi) * Kn);
+  double q_hi = std::min((fp_hi - fp0) * Kp, (fn0 - fn_lo) * Kn);
+
+  const auto st_old = st;
+  auto OCV_at = [&](double q) {
+    setC(fp0 + q / Kp, fn0 - q / Kn);
+    return getOCV();
+  };
+
+  if (q_lo >= q_hi || Vset > OCV_at(q_lo) || Vset < OCV_at(q_hi)) {
+    st = st_old;
+    invalidateKinetics();
+    return Status::Invalid_Vset;
+  }
+
+  for (int i = 0; i < 60 && (q_hi - q_lo) > 1e-9; i++) {
+    const double q_mid = (q_lo + q_hi) / 2;
+    (OCV_at(q_mid) > Vset ? q_lo : q_hi) = q_mid;
+  }
+
+  const double q = (q_lo + q_hi) / 2;
+  OCV_at(q);
+  st.SOC() -= q / (3600 * Cap()); //!< q [C] left the anode as if the cell was discharged, setC does not change the SOC
+  return Status::Success;
 }
 
 Cell_SPM::Cell_SPM(std::string IDi, const DEG_ID &degid, double capf, double resf, double degfsei, double degflam) : Cell_SPM()
 {
   ID = IDi;
-  //!< Set the resistance
 
+  //!< store the cell-to-cell variations
+  var_cap = capf;
+  var_R = resf;
+  var_degSEI = degfsei;
+  var_degLAM = degflam;
+
+  //!< Set the resistance
   st.rDCcc() *= resf; //!< current collector
   st.rDCp() *= resf;  //!< cathode
-  st.rDCn() *= resf;  //!< anode   #TODO if you memoize Rdc then getRdc here.
+  st.rDCn() *= resf;  //!< anode
+  invalidateKinetics();
 
   //!< set the capacity
   setCapacity(Cap() * capf); //!< nominal capacity
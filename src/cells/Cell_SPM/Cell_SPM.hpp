@@ -19,6 +19,7 @@
 
 #include "State_SPM.hpp" //!< class that represents the state of a cell, the state is the collection of all time-varying conditions of the battery
 #include "Model_SPM.hpp" //!< defines a struct with the values for the matrices used in the spatial discretisation of the diffusion PDE
+#include "Kinetics_SPM.hpp"
 #include "param/param_SPM.hpp"
 #include "../Cell.hpp"
 #include "../../utility/utility.hpp"   // Do not remove they are required in cpp files.
@@ -43,6 +44,10 @@ public:
 
 protected:                 //!< protected such that child classes can access the class variables
   State_SPM st{}, s_ini{}; //!< the battery current/initial state, grouping all parameter which change over the battery's lifetime (see State_SPM.hpp)
+  State_SPM st_backup{};   //!< snapshot of st made by backupStates()
+
+  std::array<double, 3> Therm_backup{}; //!< snapshot of Therm_Qgen, Therm_Qgentot and Therm_time made by backupStates()
+  param::StressParam sparam_backup{};   //!< snapshot of the stress history made by backupStates()
 
   //!< Battery model constants
   double Cmaxpos{ 51385 }; //!< maximum lithium concentration in the cathode [mol m-3]  value for NMC
@@ -113,8 +118,17 @@ protected:                 //!< protected such that child classes can access the
 
   bool Vcell_valid{ false };
 
+  //!< Kinetics snapshot, shared by V(), getOCV(), dState_diffusion, dState_thermal and dState_degradation
+  Kinetics_SPM kin{};
+  bool kin_rates_valid{ false }; //!< the rate quantities in kin are up to date
+  bool kin_surf_valid{ false };  //!< the surface quantities in kin are up to date
+
   //!< Functions
-  std::pair<double, double> calcSurfaceConcentration(double jp, double jn, double Dpt, double Dnt);
+  void invalidateKinetics() noexcept { Vcell_valid = kin_rates_valid = kin_surf_valid = false; } //!< call whenever I, T or the states change
+  const Kinetics_SPM &getRates() noexcept;     //!< update (if needed) and return the rate quantities
+  const Kinetics_SPM &getKinetics(bool print); //!< update (if needed) and return the full kinetics snapshot
+
+  virtual std::pair<double, double> calcSurfaceConcentration(double jp, double jn, double Dpt, double Dnt);
   std::pair<double, double> calcOverPotential(double cps, double cns, double i_app); //!< Should not throw normally, except divide by zero?
 
   inline double calcArrheniusCoeff() { return (1 / T_ref - 1 / st.T()) / PhyConst::Rg; } //!< Calculates Arrhenius coefficient.
@@ -135,6 +149,7 @@ protected:                 //!< protected such that child classes can access the
   void dState_thermal(bool print, double &dQgen);          //!< calculate the heat generation
   void dState_degradation(bool print, State_SPM &d_state); //!< calculate the effect of lithium plating
   void dState_all(bool print, State_SPM &d_state);         //!< individual functions are combined in one function to gain speed.
+  void timeStep_thermalAndDegradation(double dt, int nstep); //!< resolve the thermal and degradation models once for dt * nstep seconds
 
   //!< thermal model
   double thermalModel_cell();
@@ -161,12 +176,13 @@ public:
 
   Status setCurrent(double Inew, bool checkV = true, bool print = true) override;
   Status setSOC(double SOCnew, bool checkV = true, bool print = true) override;
+  Status setRelaxedVoltage(double Vset) override;
 
   auto &getStateObj() { return st; }
   auto setStateObj(State_SPM &st_new)
   {
     st = st_new;
-    Vcell_valid = false;
+    invalidateKinetics();
   }
 
   std::array<double, 4> getVariations() const noexcept override { return { var_cap, var_R, var_degSEI, var_degLAM }; } // #TODO : deprecated will be deleted.
@@ -209,7 +225,7 @@ public:
   double V() override;
 
   bool getCSurf(double &cps, double &cns, bool print);                                                                           //!< get the surface concentrations
-  void getC(double cp[], double cn[]) noexcept;                                                                                  //!< get the concentrations at all nodes
+  virtual void getC(double cp[], double cn[]) noexcept;                                                                          //!< get the concentrations at all nodes
   int getVoltage(bool print, double *V, double *OCVp, double *OCVn, double *etap, double *etan, double *Rdrop, double *Temp);    //!< get the cell's voltage
   int getVoltage_ne(bool print, double *V, double *OCVp, double *OCVn, double *etap, double *etan, double *Rdrop, double *Temp); //!< get the cell's voltage noexcept
 
@@ -240,6 +256,7 @@ public:
     //!< Overwrite both current and initial states.
     st.overwriteCharacterisationStates(Dpi, Dni, ri);
     s_ini.overwriteCharacterisationStates(Dpi, Dni, ri);
+    invalidateKinetics();
   }
 
   void overwriteGeometricStates(double thickpi, double thickni, double epi, double eni, double api, double ani)
@@ -247,6 +264,7 @@ public:
     //!< Overwrite both current and initial states.
     st.overwriteGeometricStates(thickpi, thickni, epi, eni, api, ani);
     s_ini.overwriteGeometricStates(thickpi, thickni, epi, eni, api, ani);
+    invalidateKinetics();
   }
 
   //!< time integration
@@ -272,6 +290,47 @@ public:
   double getOCV() override;
   Status setStates(setStates_t sSpan, bool checkV, bool print) override;
   bool validStates(bool print = true) override;
+  void backupStates() override
+  {
+    st_backup = st;
+    Therm_backup = { Therm_Qgen, Therm_Qgentot, Therm_time };
+    sparam_backup = sparam;
+  }
+  void restoreStates() override
+  {
+    st = st_backup;
+    Therm_Qgen = Therm_backup[0];
+    Therm_Qgentot = Therm_backup[1];
+    Therm_time = Therm_backup[2];
+    sparam = sparam_backup;
+    invalidateKinetics();
+  }
+
+  static constexpr size_t Ncheckpoint{ 12 + Ncheckpoint_data }; //!< number of values written by getCheckpoint
+
+  void getCheckpoint(std::vector<double> &s) override
+  {
+    s.insert(s.end(), { Therm_Qgen, Therm_Qgentot, Therm_time }); //!< heat accumulated since the last thermal update
+
+    //!< stress of the last time step, the LAM and crack growth models use the change from it
+    s.insert(s.end(), { sparam.s_dai_p, sparam.s_dai_n, sparam.s_lares_n, sparam.s_dai_p_prev, sparam.s_dai_n_prev,
+                        sparam.s_lares_n_prev, sparam.s_dt, static_cast<double>(sparam.s_dai_update), static_cast<double>(sparam.s_lares_update) });
+
+    Cell::getCheckpoint(s);
+  }
+  void setCheckpoint(std::span<double> s) override
+  {
+    invalidateKinetics(); //!< the states have been restored by the checkpoint
+
+    for (auto *x : { &Therm_Qgen, &Therm_Qgentot, &Therm_time, &sparam.s_dai_p, &sparam.s_dai_n, &sparam.s_lares_n,
+                     &sparam.s_dai_p_prev, &sparam.s_dai_n_prev, &sparam.s_lares_n_prev, &sparam.s_dt })
+      free::pop_checkpoint(s, *x);
+
+    free::pop_checkpoint(s, sparam.s_dai_update);
+    free::pop_checkpoint(s, sparam.s_lares_update);
+
+    Cell::setCheckpoint(s);
+  }
   inline double SOC() override { return st.SOC(); }
   void timeStep_CC(double dt, int steps = 1) override;
 
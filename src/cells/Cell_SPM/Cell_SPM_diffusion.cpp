@@ -18,6 +18,7 @@
 #include <array>
 #include <algorithm>
 #include <utility>
+#include <tuple>
 
 namespace slide {
 std::pair<double, double> Cell_SPM::calcSurfaceConcentration(double jp, double jn, double Dpt, double Dnt) //!< Should not throw normally, except divide by zero?
@@ -44,11 +45,10 @@ std::pair<double, double> Cell_SPM::calcOverPotential(double cps, double cns, do
 {
   using namespace PhyConst;
 
-  const auto ArrheniusCoeff = calcArrheniusCoeff();
-
-  //!< Calculate the rate constants at the cell's temperature using an Arrhenius relation
-  const double kpt = kp * std::exp(kp_T * ArrheniusCoeff); //!< Rate constant at the positive electrode at the cell's temperature [m s-1]
-  const double knt = kn * std::exp(kn_T * ArrheniusCoeff); //!< Rate constant at the negative electrode at the cell's temperature [m s-1]
+  //!< The rate constants at the cell's temperature are part of the cached rate quantities
+  const auto &rates = getRates();
+  const double kpt = rates.kpt; //!< Rate constant at the positive electrode at the cell's temperature [m s-1]
+  const double knt = rates.knt; //!< Rate constant at the negative electrode at the cell's temperature [m s-1]
 
   //!< Calculate the overpotential using the Bulter-Volmer equation
   //!< if alpha is 0.5, the Bulter-Volmer relation can be inverted to eta = 2RT / (nF) asinh(x)
@@ -82,4 +82,66 @@ std::array<double, 2> Cell_SPM::calcDiffConstant() //!< Should not throw normall
 
   return { Dpt, Dnt };
 }
+
+const Kinetics_SPM &Cell_SPM::getRates() noexcept
+{
+  /*
+   * Calculate the quantities which only depend on the current, temperature and degradation states.
+   * These do not change during the diffusion steps of timeStep_CC, so the exponentials are evaluated once.
+   */
+  if (kin_rates_valid)
+    return kin;
+
+  const auto ArrheniusCoeff = calcArrheniusCoeff();
+
+  const auto [Dpt, Dnt] = calcDiffConstant();
+  const auto [i_app, jp, jn] = calcMolarFlux(); //!< current density, molar flux on the pos/neg particle
+
+  kin.Dpt = Dpt;
+  kin.Dnt = Dnt;
+  kin.i_app = i_app;
+  kin.jp = jp;
+  kin.jn = jn;
+
+  kin.kpt = kp * std::exp(kp_T * ArrheniusCoeff);
+  kin.knt = kn * std::exp(kn_T * ArrheniusCoeff);
+  kin.Rdc = getRdc();
+
+  kin_rates_valid = true;
+  return kin;
+}
+
+const Kinetics_SPM &Cell_SPM::getKinetics(bool print)
+{
+  /*
+   * Calculate the surface concentrations, potentials and overpotentials at the current state.
+   * If the surface concentrations are out of bounds, kin.inRange is false and the potentials are not calculated,
+   * it is up to the caller to decide whether this is an error.
+   *
+   * THROWS
+   * passed on from linear interpolation of the OCV curves (if the li-fractions are outside of the data range)
+   */
+  if (kin_surf_valid)
+    return kin;
+
+  getRates();
+  std::tie(kin.cps, kin.cns) = calcSurfaceConcentration(kin.jp, kin.jn, kin.Dpt, kin.Dnt);
+
+  //!< don't allow 0 or Cmax because in that case, i0 will be 0, and the overpotentials will have 1/0 = inf or nan
+  kin.inRange = !(kin.cps <= 0 || kin.cns <= 0 || kin.cps >= Cmaxpos || kin.cns >= Cmaxneg);
+  kin.zp_surf = kin.cps / Cmaxpos;
+  kin.zn_surf = kin.cns / Cmaxneg;
+
+  if (kin.inRange) {
+    const bool bound = true; //!< in linear interpolation, throw an error if you are out of the allowed range
+    kin.dOCV = OCV_curves.dOCV_tot.interp(kin.zp_surf, print, bound);
+    kin.OCV_n = OCV_curves.OCV_neg.interp(kin.zn_surf, print, bound);
+    kin.OCV_p = OCV_curves.OCV_pos.interp(kin.zp_surf, print, bound);
+
+    std::tie(kin.etap, kin.etan) = calcOverPotential(kin.cps, kin.cns, kin.i_app);
+  }
+
+  kin_surf_valid = true;
+  return kin;
+}
 } // namespace slide
\ No newline at end of file
@@ -40,8 +40,9 @@ void Cell_SPM::dState_diffusion(bool print, State_SPM &d_st)
 
   const auto nch = st.nch;
 
-  auto [Dpt, Dnt] = calcDiffConstant();
-  auto [i_app, jp, jn] = calcMolarFlux(); //!< current density, molar flux on the pos/neg particle
+  const auto &rates = getRates(); //!< unchanged by the diffusion steps, so only evaluated once per timeStep_CC
+  const auto Dpt = rates.Dpt, Dnt = rates.Dnt;
+  const auto jp = rates.jp, jn = rates.jn; //!< molar flux on the pos/neg particle
 
   //!< Calculate the effect of the main li-reaction on the (transformed) concentration
   for (size_t j = 0; j < nch; j++)
@@ -69,51 +70,39 @@ void Cell_SPM::dState_thermal(bool print, double &dQgen)
    * dQgen 	change in generated heat
    */
 
-  //!< Calculcate the lithium fractions at the surface of the particles
-  auto [Dpt, Dnt] = calcDiffConstant();
-  auto [i_app, jp, jn] = calcMolarFlux(); //!< current density, molar flux on the pos/neg particle
-  auto [cps, cns] = calcSurfaceConcentration(jp, jn, Dpt, Dnt);
+  //!< Get the lithium fractions at the surface of the particles, the overpotentials and the entropic coefficient
+  const auto &k = getKinetics(print);
 
   //!< check if the surface concentration is within the allowed range
   //!< 	0 < cp < Cmaxpos
   //!< 	0 < cn < Cmaxneg
-  if (cps <= 0 || cns <= 0 || cps >= Cmaxpos || cns >= Cmaxneg) //!< Do not delete if you cannot ensure zp/zn between 0-1
+  if (!k.inRange) //!< Do not delete if you cannot ensure zp/zn between 0-1
   {
     if (print) {
       std::cerr << "ERROR in Cell_SPM::dState: concentration out of bounds. the positive lithium fraction is "
-                << cps / Cmaxpos << " and the negative lithium fraction is " << cns / Cmaxneg;
+                << k.zp_surf << " and the negative lithium fraction is " << k.zn_surf;
       std::cerr << "they should both be between 0 and 1.\n";
     }
     throw 101;
   }
 
-  const double zp_surf = (cps / Cmaxpos); //!< lithium fraction (0 to 1)
-  //!< const double zn_surf = (cns / Cmaxneg);
-
-  //!< Calculate the overpotentials if needed
-  auto [etap, etan] = calcOverPotential(cps, cns, i_app);
+  auto etap = k.etap, etan = k.etan;
 
   constexpr int electr = 0;    //!< #TODO why don't we use in the new one?
   if constexpr (electr == 2) { //!< only consider negative electrode, ignore the positive electrode
-    jp = 0;
-    Dpt = 0;
     etap = 0;
   } else if constexpr (electr == 1) { //!< only consider positive electrode, ignore the negative electrode
-    jn = 0;
-    Dnt = 0;
     etan = 0;
   }
 
-  //!< Calculate the entropic coefficient
-  const bool bound = true;                                               //!< in linear interpolation, throw an error if you are outside of the allowed range of the data
-  const double dOCV = OCV_curves.dOCV_tot.interp(zp_surf, print, bound); //!< entropic coefficient of the entire cell OCV [V K-1]
+  const double dOCV = k.dOCV; //!< entropic coefficient of the entire cell OCV [V K-1]
 
   //!< temperature model
   //!< Calculate the thermal sources/sinks/transfers per unit of volume of the battery
   //!< The battery volume is given by the product of the cell thickness and the electrode surface
   const double Qrev = -I() * T() * dOCV;    //!< reversible heat due to entropy changes [W]
   const double Qrea = I() * (etan - etap);  //!< reaction heat due to the kinetics [W]
-  const double Qohm = I() * I() * getRdc(); //!< Ohmic heat due to electrode resistance [W]
+  const double Qohm = I() * I() * k.Rdc;    //!< Ohmic heat due to electrode resistance [W]
   //!< const double Qc = -Qch * SAV * (st.T() - T_env); 				//!< cooling with the environment [W m-2]
 
   //!< total heat generation and cooling in W
@@ -160,35 +149,29 @@ void Cell_SPM::dState_degradation(bool print, State_SPM &d_state)
   using namespace PhyConst;
   using settings::nch;
 
-  //!< Calculcate the lithium fractions at the surface of the particles
-  auto [Dpt, Dnt] = calcDiffConstant();
-  auto [i_app, jp, jn] = calcMolarFlux(); //!< current density, molar flux on the pos/neg particle
-  auto [cps, cns] = calcSurfaceConcentration(jp, jn, Dpt, Dnt);
+  //!< Get the lithium fractions at the surface of the particles and the overpotentials
+  const auto &k = getKinetics(print);
 
   //!< check if the surface concentration is within the allowed range
   //!< 	0 < cp < Cmaxpos
   //!< 	0 < cn < Cmaxneg
-  if (cps <= 0 || cns <= 0 || cps >= Cmaxpos || cns >= Cmaxneg) //!< Do not delete if you cannot ensure zp/zn between 0-1
+  if (!k.inRange) //!< Do not delete if you cannot ensure zp/zn between 0-1
   {
     if (print) {
       std::cerr << "ERROR in Cell_SPM::dState: concentration out of bounds. the positive lithium fraction is "
-                << cps / Cmaxpos << " and the negative lithium fraction is " << cns / Cmaxneg
+                << k.zp_surf << " and the negative lithium fraction is " << k.zn_surf
                 << " they should both be between 0 and 1.\n";
     }
     throw 101;
   }
 
-  const double zp_surf = (cps / Cmaxpos); //!< lithium fraction (0 to 1)
-  const double zn_surf = (cns / Cmaxneg);
-
-  //!< Calculate the overpotentials if needed
-  auto [etap, etan] = calcOverPotential(cps, cns, i_app);
+  const double zp_surf = k.zp_surf; //!< lithium fraction (0 to 1)
+  const double etap = k.etap, etan = k.etan;
 
   const bool bound = true;
   //!< calculate the anode potential (needed for various degradation models)
   const double dOCVn = OCV_curves.dOCV_neg.interp(zp_surf, print, bound); //!< entropic coefficient of the anode potential [V K-1]
-  const double OCV_n = OCV_curves.OCV_neg.interp(zn_surf, print, bound);  //!< anode potential [V]
-  const double OCVnt = OCV_n + (st.T() - T_ref) * dOCVn;                  //!< anode potential at the cell's temperature [V]
+  const double OCVnt = k.OCV_n + (st.T() - T_ref) * dOCVn;                //!< anode potential at the cell's temperature [V]
 
   //!< SEI growth
   double isei;        //!< current density of the SEI growth side reaction [A m-2]
@@ -275,90 +258,121 @@ void Cell_SPM::timeStep_CC(double dt, int nstep)
   sparam.s_dt = nstep * dt;
 
   //!< *********************************************  Resolve the diffusion model for every dt time step ****************************************************************************************
-  const auto dth = dt / 3600.0;
-  for (int t = 0; t < nstep; t++) {
-    slide::State_SPM d_st{};
-    //!< Calculate the time derivatives
-    dState_diffusion(print, d_st);
-
-    //!< forward Euler time integration: s(t+1) = s(t) + ds/dt * dt
-    for (size_t i = 0; i < (2 * st.nch); i++)
-      st.z(i) += dt * d_st.z(i);
-
-    st.SOC() += dt * d_st.SOC();
+  if (st.I() == 0) {
+    //!< At rest the diffusion model is dz/dt = D * A * z with a diagonal A, so every mode decays exponentially.
+    //!< Integrate it exactly over the nstep * dt seconds at once (this is also stable for any length of the period).
+    const auto &rates = getRates();
+    const double t = nstep * dt;
+    for (size_t j = 0; j < st.nch; j++) {
+      st.zp(j) *= std::exp(rates.Dpt * M->Ap[j] * t);
+      st.zn(j) *= std::exp(rates.Dnt * M->An[j] * t);
+    }
 
     Vcell_valid = false;
+    kin_surf_valid = false;
     sparam.s_dai_update = false;
     sparam.s_lares_update = false;
 
-
-    const auto dAh = st.I() * dth;
-    //!< increase the cumulative variables of this cell
-    if constexpr (settings::data::storeCumulativeData) {
-      st.time() += dt;
-      st.Ah() += std::abs(dAh);
-      st.Wh() += std::abs(dAh * V());
+    if constexpr (settings::data::storeCumulativeData)
+      st.time() += t;
+  } else {
+    const auto dth = dt / 3600.0;
+    for (int t = 0; t < nstep; t++) {
+      slide::State_SPM d_st{};
+      //!< Calculate the time derivatives
+      dState_diffusion(print, d_st);
+
+      //!< forward Euler time integration: s(t+1) = s(t) + ds/dt * dt
+      for (size_t i = 0; i < (2 * st.nch); i++)
+        st.z(i) += dt * d_st.z(i);
+
+      st.SOC() += dt * d_st.SOC();
+
+      Vcell_valid = false;
+      kin_surf_valid = false; //!< the rate quantities only depend on I, T and the degradation states, so they stay valid
+      sparam.s_dai_update = false;
+      sparam.s_lares_update = false;
+
+
+      const auto dAh = st.I() * dth;
+      //!< increase the cumulative variables of this cell
+      if constexpr (settings::data::storeCumulativeData) {
+        st.time() += dt;
+        st.Ah() += std::abs(dAh);
+        st.Wh() += std::abs(dAh * V());
+      }
     }
   }
 
+  if (!blockDegAndTherm)
+    timeStep_thermalAndDegradation(dt, nstep);
+}
+
+void Cell_SPM::timeStep_thermalAndDegradation(double dt, int nstep)
+{
+  /*
+   * Resolve the thermal and degradation models once for the nstep * dt time period,
+   * after the diffusion model has been integrated over that period.
+   */
+  const bool print = true;
+
   //!< **************************************************** Calculate the thermal model once for the nstep * dt time period *****************************************************************
-  if (!blockDegAndTherm) {
-
-    //!< Calculate the internal heat generation of the cell
-    double dQgen;
-    try {
-      dState_thermal(print, dQgen);
-    } catch (int e) {
-      if constexpr (settings::printBool::printCrit)
-        std::cout << "error in SPM cell " << getFullID() << ", error " << e
-                  << " when calculating the time derivatives of the thermal model, throwing it on.\n";
-      throw e;
-    }
+  //!< Calculate the internal heat generation of the cell
+  double dQgen;
+  try {
+    dState_thermal(print, dQgen);
+  } catch (int e) {
+    if constexpr (settings::printBool::printCrit)
+      std::cout << "error in SPM cell " << getFullID() << ", error " << e
+                << " when calculating the time derivatives of the thermal model, throwing it on.\n";
+    throw e;
+  }
 
-    Therm_Qgen += dQgen * dt * nstep;
-    Therm_time += dt * nstep;
+  Therm_Qgen += dQgen * dt * nstep;
+  Therm_time += dt * nstep;
 
-    //!< If this cell has a parent module, this parent will call the thermal model with the correct parameters
-    //!< which will include heat exchange with the cell's neighbours and cooling from the cooling system of the module.
+  //!< If this cell has a parent module, this parent will call the thermal model with the correct parameters
+  //!< which will include heat exchange with the cell's neighbours and cooling from the cooling system of the module.
 
-    //!< if there is no parent, this cell is a stand-alone cell.
-    //!< We assume convective cooling with an environment
-    //!< If there is no parent, assume we update T every nstep*dt. So update the temperature now
-    if (!parent) //!< else it is the responsibility of the parent to call the thermal model function with the correct settings
-    {
-      double Tneigh[1] = { T_env };
-      double Kneigh[1] = { Qch };                 //!< so cooling Qc = Qch * SAV * dT / (rho*cp) = Qch * A * dT / (rho*cp)
-      double Atherm[1] = { getThermalSurface() }; //!< calculate the surface of this cell
+  //!< if there is no parent, this cell is a stand-alone cell.
+  //!< We assume convective cooling with an environment
+  //!< If there is no parent, assume we update T every nstep*dt. So update the temperature now
+  if (!parent) //!< else it is the responsibility of the parent to call the thermal model function with the correct settings
+  {
+    double Tneigh[1] = { T_env };
+    double Kneigh[1] = { Qch };                 //!< so cooling Qc = Qch * SAV * dT / (rho*cp) = Qch * A * dT / (rho*cp)
+    double Atherm[1] = { getThermalSurface() }; //!< calculate the surface of this cell
 
-      const auto new_T = thermalModel(1, Tneigh, Kneigh, Atherm, Therm_time);
-      setT(new_T); //!< #TODO in slide-pack it does not check the temperature.
-    }
+    const auto new_T = thermalModel(1, Tneigh, Kneigh, Atherm, Therm_time);
+    setT(new_T); //!< #TODO in slide-pack it does not check the temperature.
+  }
 
-    //!< ******************************************************* Calculate the degradation model once for the nstep * dt time period **************************************************************
-
-    //!< Calculate the stress values stored in the attributes for the stress in this time step
-    if (sparam.s_dai) //!< only a few degradation models actually need the stress according to Dai, so only calculate it if needed
-      updateDaiStress();
-    if (sparam.s_lares) //!< only a few degradation models need the stress according to Laresgoiti
-      updateLaresgoitiStress(true);
-
-    slide::State_SPM d_st{};
-    //!< Calculate the time derivatives
-    try {
-      dState_degradation(print, d_st);
-    } catch (int e) {
-      if constexpr (settings::printBool::printCrit)
-        std::cout << "error in SPM cell " << getFullID()
-                  << " when calculating the time derivatives of the degradation: "
-                  << e << ", throwing it on.\n";
-      throw e;
-    }
+  //!< ******************************************************* Calculate the degradation model once for the nstep * dt time period **************************************************************
+
+  //!< Calculate the stress values stored in the attributes for the stress in this time step
+  if (sparam.s_dai) //!< only a few degradation models actually need the stress according to Dai, so only calculate it if needed
+    updateDaiStress();
+  if (sparam.s_lares) //!< only a few degradation models need the stress according to Laresgoiti
+    updateLaresgoitiStress(true);
 
-    //!< forward Euler time integration: s(t+1) = s(t) + ds/dt * dt
-    //!< degradation accumulation
-    for (size_t i = 0; i < st.size(); i++)
-      st[i] += d_st[i] * dt * nstep;
+  slide::State_SPM d_st{};
+  //!< Calculate the time derivatives
+  try {
+    dState_degradation(print, d_st);
+  } catch (int e) {
+    if constexpr (settings::printBool::printCrit)
+      std::cout << "error in SPM cell " << getFullID()
+                << " when calculating the time derivatives of the degradation: "
+                << e << ", throwing it on.\n";
+    throw e;
   }
+
+  //!< forward Euler time integration: s(t+1) = s(t) + ds/dt * dt
+  //!< degradation accumulation
+  for (size_t i = 0; i < st.size(); i++)
+    st[i] += d_st[i] * dt * nstep;
+
+  invalidateKinetics();
 }
 
 //!< void Cell_SPM::ETI(bool print, double dti, bool blockDegradation)
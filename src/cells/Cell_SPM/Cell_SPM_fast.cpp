@@ -0,0 +1,171 @@
+/*
+ * Cell_SPM_fast.cpp
+ *
+ * Implements the reduced-order diffusion model of Cell_SPM_fast.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#include "Cell_SPM_fast.hpp"
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <array>
+#include <utility>
+
+namespace slide {
+
+Cell_SPM_fast::Cell_SPM_fast() : Cell_SPM()
+{
+  ID = "Cell_SPM_fast";
+  setReducedModel();
+}
+
+Cell_SPM_fast::Cell_SPM_fast(std::string IDi, const DEG_ID &degid, double capf, double resf, double degfsei, double degflam)
+  : Cell_SPM(std::move(IDi), degid, capf, resf, degfsei, degflam)
+{
+  setReducedModel();
+}
+
+void Cell_SPM_fast::setReducedModel()
+{
+  /*
+   * Select the modes which are integrated and residualise the others.
+   *
+   * The uniform mode has a 0 eigenvalue and its location is written in M->Input[3].
+   * The slowest decaying mode is the one with the smallest (non-zero) eigenvalue magnitude.
+   * For every other mode j, the quasi-steady value z_j = -B_j * j / (D * A_j) is substituted in c = C * z + Dm * j / D,
+   * so the feed-through becomes Dm_eff = Dm - sum_j C(:,j) * B_j / A_j.
+   */
+  using settings::nch;
+
+  ind_u = static_cast<size_t>(M->Input[3]);
+  ind_p = ind_n = (ind_u == 0) ? 1 : 0;
+  for (size_t j = 0; j < nch; j++) {
+    if (j == ind_u) continue;
+    if (std::abs(M->Ap[j]) < std::abs(M->Ap[ind_p])) ind_p = j;
+    if (std::abs(M->An[j]) < std::abs(M->An[ind_n])) ind_n = j;
+  }
+
+  for (size_t i = 0; i < nch + 1; i++) {
+    Dp_eff[i] = M->Dp[i];
+    Dn_eff[i] = M->Dn[i];
+    for (size_t j = 0; j < nch; j++) {
+      if (j != ind_u && j != ind_p) Dp_eff[i] -= M->Cp[i][j] * M->Bp[j] / M->Ap[j];
+      if (j != ind_u && j != ind_n) Dn_eff[i] -= M->Cn[i][j] * M->Bn[j] / M->An[j];
+    }
+  }
+
+  //!< the residualised modes are not states of this model
+  for (size_t j = 0; j < nch; j++) {
+    if (j != ind_u && j != ind_p) st.zp(j) = 0;
+    if (j != ind_u && j != ind_n) st.zn(j) = 0;
+  }
+
+  s_ini = st;
+  invalidateKinetics();
+}
+
+std::pair<double, double> Cell_SPM_fast::calcSurfaceConcentration(double jp, double jn, double Dpt, double Dnt)
+{
+  //!< cp_surf = Cp[0][u] * zp[u] + Cp[0][s] * zp[s] + Dp_eff[0] * jp / Dpt
+  const double cp_surf = M->Cp[0][ind_u] * st.zp(ind_u) + M->Cp[0][ind_p] * st.zp(ind_p) + Dp_eff[0] * jp / Dpt;
+  const double cn_surf = M->Cn[0][ind_u] * st.zn(ind_u) + M->Cn[0][ind_n] * st.zn(ind_n) + Dn_eff[0] * jn / Dnt;
+
+  return std::make_pair(cp_surf, cn_surf);
+}
+
+void Cell_SPM_fast::getC(double cp[], double cn[]) noexcept
+{
+  /*
+   * Same as Cell_SPM::getC but with the retained modes and the effective feed-through.
+   * cp[0] is the surface, cp[1 to nch] the inner nodes and cp[nch + 1] the centre of the particle.
+   */
+  using settings::nch;
+
+  const auto &rates = getRates();
+  const double Dpt = rates.Dpt, Dnt = rates.Dnt;
+  const double jp = rates.jp, jn = rates.jn;
+
+  for (size_t i = 0; i < nch + 1; i++) {
+    cp[i] = M->Cp[i][ind_u] * st.zp(ind_u) + M->Cp[i][ind_p] * st.zp(ind_p) + Dp_eff[i] * jp / Dpt;
+    cn[i] = M->Cn[i][ind_u] * st.zn(ind_u) + M->Cn[i][ind_n] * st.zn(ind_n) + Dn_eff[i] * jn / Dnt;
+  }
+
+  //!< Concentration at the centre node using the symmetry boundary condition, see Cell_SPM::getC
+  double cpt{ 0 }, cnt{ 0 };
+  for (size_t i = 0; i < nch + 1; i++) {
+    cpt += M->Cc[i] * cp[i];
+    cnt += M->Cc[i] * cn[i];
+  }
+  cp[nch + 1] = (-1.0 / 2.0) * (cpt + jp * geo.Rp / Dpt);
+  cn[nch + 1] = (-1.0 / 2.0) * (cnt + jn * geo.Rn / Dnt);
+}
+
+void Cell_SPM_fast::timeStep_CC(double dt, int nstep)
+{
+  /*
+   * take a number of time steps with a constant current
+   *
+   * The retained modes are linear and decoupled, so for a constant current they are integrated exactly over dt * nstep:
+   * 		z(t + h) = z(t) * exp(D*A*h) + B * j * (exp(D*A*h) - 1) / (D*A) 		(or z(t) + B * j * h for the uniform mode)
+   * The thermal and degradation models are resolved once, for dt*nstep seconds, as in Cell_SPM
+   */
+
+  //!< check the time step is positive
+  if (dt < 0) {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "ERROR in Cell_SPM_fast::timeStep_CC, the time step dt must be 0 or positive, but has value " << dt << '\n';
+    throw 10;
+  }
+
+  using settings::nch;
+
+  //!< Update the stress values stored in the attributes with the stress of the previous time step
+  sparam.s_dai_p_prev = sparam.s_dai_p;
+  sparam.s_dai_n_prev = sparam.s_dai_n;
+  sparam.s_lares_n_prev = sparam.s_lares_n;
+  sparam.s_dt = nstep * dt;
+
+  const double h = dt * nstep;
+  const double V_start = settings::data::storeCumulativeData ? V() : 0; //!< for the trapezoidal energy throughput
+
+  const auto &rates = getRates();
+  const double lambda_p = rates.Dpt * M->Ap[ind_p]; //!< eigenvalue of the slowest positive mode [s-1], < 0
+  const double lambda_n = rates.Dnt * M->An[ind_n];
+  const double ep = std::exp(lambda_p * h);
+  const double en = std::exp(lambda_n * h);
+
+  st.zp(ind_u) += h * M->Bp[ind_u] * rates.jp;
+  st.zn(ind_u) += h * M->Bn[ind_u] * rates.jn;
+  st.zp(ind_p) = st.zp(ind_p) * ep + M->Bp[ind_p] * rates.jp * (ep - 1) / lambda_p;
+  st.zn(ind_n) = st.zn(ind_n) * en + M->Bn[ind_n] * rates.jn * (en - 1) / lambda_n;
+
+  st.SOC() += -I() * h / (Cap() * 3600); //!< dSOC state of charge
+
+  Vcell_valid = false;
+  kin_surf_valid = false; //!< the rate quantities only depend on I, T and the degradation states, so they stay valid
+  sparam.s_dai_update = false;
+  sparam.s_lares_update = false;
+
+  //!< increase the cumulative variables of this cell
+  if constexpr (settings::data::storeCumulativeData) {
+    const auto dAh = st.I() * h / 3600.0;
+    st.time() += h;
+    st.Ah() += std::abs(dAh);
+    st.Wh() += std::abs(dAh) * 0.5 * (V_start + V());
+  }
+
+  if (!blockDegAndTherm)
+    timeStep_thermalAndDegradation(dt, nstep);
+
+  //!< the side reactions of the degradation models act on all modes, keep the residualised ones at their (implicit) quasi-steady value
+  for (size_t j = 0; j < nch; j++) {
+    if (j != ind_u && j != ind_p) st.zp(j) = 0;
+    if (j != ind_u && j != ind_n) st.zn(j) = 0;
+  }
+}
+} // namespace slide
@@ -0,0 +1,53 @@
+/*
+ * Cell_SPM_fast.hpp
+ *
+ * Reduced-order single particle model for pack-level simulations.
+ *
+ * The solid diffusion in Cell_SPM is written in the eigenspace of the Chebyshev discretisation (see Model_SPM.hpp):
+ * 		dz/dt = D * A * z + B * j 			(A diagonal, one eigenvalue is 0 for the uniform concentration)
+ * 		c     = C * z + Dm * j / D
+ * Cell_SPM_fast only integrates two modes per particle, the uniform mode (the average concentration)
+ * and the slowest decaying mode (the first correction to the surface concentration).
+ * The faster modes are residualised: they are replaced by their quasi-steady value z = -B * j / (D * A),
+ * which adds a constant term to the feed-through matrix Dm so the steady-state concentration profile is still exact.
+ * Since the remaining modes are decoupled and linear, they are integrated exactly over the full dt * nstep of a CC time step.
+ *
+ * The states, parameters, OCV curves, thermal model and degradation models are all the ones of Cell_SPM.
+ * The slots of the residualised modes in State_SPM are kept at 0.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "Cell_SPM.hpp"
+
+#include <array>
+#include <string>
+#include <utility>
+
+namespace slide {
+
+class Cell_SPM_fast : public Cell_SPM
+{
+protected:
+  size_t ind_u{};                //!< index of the uniform mode (0 eigenvalue), same for both particles
+  size_t ind_p{}, ind_n{};       //!< index of the slowest decaying mode of the positive/negative particle
+  sigma_type Dp_eff{}, Dn_eff{}; //!< feed-through terms including the residualised modes, only the first nch + 1 elements are used
+
+  void setReducedModel(); //!< find the retained modes and calculate the feed-through terms
+
+  std::pair<double, double> calcSurfaceConcentration(double jp, double jn, double Dpt, double Dnt) override;
+
+public:
+  Cell_SPM_fast();
+  Cell_SPM_fast(std::string IDi, const DEG_ID &degid, double capf, double resf, double degfsei, double degflam);
+
+  void getC(double cp[], double cn[]) noexcept override;
+  void timeStep_CC(double dt, int steps = 1) override;
+
+  Cell_SPM_fast *copy() override { return new Cell_SPM_fast(*this); }
+};
+} // namespace slide
@@ -222,6 +222,7 @@ void Cell_SPM::setOCVcurve(const std::string &namepos, const std::string &namene
   try {
     OCV_curves.OCV_neg.setCurve(PathVar::data / nameneg); //!< the OCV curve of the anode, the first column gives the lithium fractions (increasing), the 2nd column gives the OCV vs li/li+
     OCV_curves.OCV_pos.setCurve(PathVar::data / namepos);
+    invalidateKinetics();
   } catch (int e) {
     //!< std::cout << "Throw test: " << 32 << '\n';
     std::cout << "ERROR in Cell_SPM::setOCVcurve when loading the OCV curves from the CSV files: "
@@ -280,9 +281,7 @@ void Cell_SPM::setGeometricParameters(double capnom, double surf, double ep, dou
   double an = 3 * en / geo.Rn;
 
   //!< overwrite the original geometric parameters, use cell version
-  overwriteGeometricStates(thickp, thickn, ep, en, ap, an);
-
-  Vcell_valid = false;
+  overwriteGeometricStates(thickp, thickn, ep, en, ap, an); //!< also invalidates the kinetics
 }
 
 void Cell_SPM::setCharacterisationParam(double Dp, double Dn, double kpi, double kni, double Rdc)
@@ -301,6 +300,7 @@ void Cell_SPM::setCharacterisationParam(double Dp, double Dn, double kpi, double
   //!< store the rate constants in the cell
   kp = kpi;
   kn = kni;
+  invalidateKinetics();
 
   //!< calculate the specific electrode resistance from the total DC resistance
   double r = Rdc * ((st.thickp() * st.ap() * geo.elec_surf + st.thickn() * st.an() * geo.elec_surf) / 2);
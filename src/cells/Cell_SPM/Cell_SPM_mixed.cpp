@@ -0,0 +1,278 @@
+/*
+ * Cell_SPM_mixed.cpp
+ *
+ * Implements the switching between the surrogate and the full SPM of Cell_SPM_mixed.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#include "Cell_SPM_mixed.hpp"
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <span>
+#include <cstring>
+#include <algorithm>
+
+namespace slide {
+
+Cell_SPM_mixed::Cell_SPM_mixed() : Cell_SPM_fast()
+{
+  ID = "Cell_SPM_mixed";
+}
+
+Cell_SPM_mixed::Cell_SPM_mixed(std::string IDi, const DEG_ID &degid, double capf, double resf, double degfsei, double degflam)
+  : Cell_SPM_fast(std::move(IDi), degid, capf, resf, degfsei, degflam)
+{
+}
+
+std::pair<double, double> Cell_SPM_mixed::calcSurfaceConcentration(double jp, double jn, double Dpt, double Dnt)
+{
+  return reduced ? Cell_SPM_fast::calcSurfaceConcentration(jp, jn, Dpt, Dnt)
+                 : Cell_SPM::calcSurfaceConcentration(jp, jn, Dpt, Dnt);
+}
+
+void Cell_SPM_mixed::getC(double cp[], double cn[]) noexcept
+{
+  if (reduced)
+    Cell_SPM_fast::getC(cp, cn);
+  else
+    Cell_SPM::getC(cp, cn);
+}
+
+bool Cell_SPM_mixed::calibrate()
+{
+  /*
+   * Linearise the voltage and the anode potential of the reduced particle model around the current state.
+   * Must be called in the reduced mode, so the residualised modes are included in the feed-through.
+   *
+   * OUT
+   * bool 	false if the surface concentrations are out of range or too close to the end of the OCV curves,
+   * 		in which case the full model should be used.
+   */
+  using PhyConst::F;
+
+  try {
+    const auto &k = getKinetics(false);
+    if (!k.inRange)
+      return false;
+
+    //!< slope of the electrode potentials to the surface concentrations [V m3 mol-1]
+    constexpr double dz = 1e-3;
+    const double gp = (OCV_curves.OCV_pos.interp(k.zp_surf + dz, false, true) - OCV_curves.OCV_pos.interp(k.zp_surf - dz, false, true)) / (2 * dz * Cmaxpos);
+    const double gn = (OCV_curves.OCV_neg.interp(k.zn_surf + dz, false, true) - OCV_curves.OCV_neg.interp(k.zn_surf - dz, false, true)) / (2 * dz * Cmaxneg);
+
+    //!< derivative of the overpotentials to the current at constant surface concentration [V A-1]
+    constexpr double di = 1e-2; //!< perturbation of the current density [A m-2]
+    const auto [etap1, etan1] = calcOverPotential(k.cps, k.cns, k.i_app + di);
+    const auto [etap0, etan0] = calcOverPotential(k.cps, k.cns, k.i_app - di);
+    const double detap_dI = (etap1 - etap0) / (2 * di * geo.elec_surf);
+    const double detan_dI = (etan1 - etan0) / (2 * di * geo.elec_surf);
+
+    //!< derivative of the surface concentrations to the current through the effective feed-through [mol m-3 A-1]
+    const double dcps_dI = -Dp_eff[0] / (k.Dpt * geo.elec_surf * st.ap() * n * F * st.thickp());
+    const double dcns_dI = Dn_eff[0] / (k.Dnt * geo.elec_surf * st.an() * n * F * st.thickn());
+
+    lin.I = I();
+    lin.T = T();
+    lin.SOC = SOC();
+    lin.zpu = st.zp(ind_u);
+    lin.zps = st.zp(ind_p);
+    lin.znu = st.zn(ind_u);
+    lin.zns = st.zn(ind_n);
+
+    lin.V = k.OCV_p - k.OCV_n + (T() - T_ref) * k.dOCV + k.etap - k.etan - k.Rdc * I(); //!< same as Cell_SPM::V
+    lin.dV_dzpu = gp * M->Cp[0][ind_u];
+    lin.dV_dzps = gp * M->Cp[0][ind_p];
+    lin.dV_dznu = -gn * M->Cn[0][ind_u];
+    lin.dV_dzns = -gn * M->Cn[0][ind_n];
+    lin.dV_dI = gp * dcps_dI - gn * dcns_dI + detap_dI - detan_dI - k.Rdc;
+    lin.dV_dT = k.dOCV;
+
+    lin.phin = k.OCV_n + k.etan;
+    lin.dphin_dznu = gn * M->Cn[0][ind_u];
+    lin.dphin_dzns = gn * M->Cn[0][ind_n];
+    lin.dphin_dI = gn * dcns_dI + detan_dI;
+  } catch (int) { //!< the perturbed lithium fractions are outside of the OCV curves
+    return false;
+  }
+
+  Vcell_valid = false; //!< V() now has to use the new linearisation
+  return true;
+}
+
+double Cell_SPM_mixed::phin_lin()
+{
+  return lin.phin + lin.dphin_dznu * (st.zn(ind_u) - lin.znu) + lin.dphin_dzns * (st.zn(ind_n) - lin.zns)
+         + lin.dphin_dI * (I() - lin.I);
+}
+
+void Cell_SPM_mixed::promote()
+{
+  /*
+   * Switch to the full SPM.
+   * The residualised modes are set to their quasi-steady value z = -B * j / (D * A),
+   * so the concentration profile is the same as the one of the reduced model.
+   */
+  using settings::nch;
+
+  const auto &r = getRates();
+  for (size_t j = 0; j < nch; j++) {
+    if (j != ind_u && j != ind_p) st.zp(j) = -M->Bp[j] * r.jp / (r.Dpt * M->Ap[j]);
+    if (j != ind_u && j != ind_n) st.zn(j) = -M->Bn[j] * r.jn / (r.Dnt * M->An[j]);
+  }
+
+  reduced = false;
+  invalidateKinetics();
+}
+
+void Cell_SPM_mixed::demote()
+{
+  /*
+   * Switch to the surrogate, the residualised modes are dropped.
+   */
+  using settings::nch;
+
+  for (size_t j = 0; j < nch; j++) {
+    if (j != ind_u && j != ind_p) st.zp(j) = 0;
+    if (j != ind_u && j != ind_n) st.zn(j) = 0;
+  }
+
+  reduced = true;
+  invalidateKinetics();
+
+  if (!calibrate())
+    promote();
+}
+
+void Cell_SPM_mixed::checkFidelity()
+{
+  /*
+   * Decide which model to use for the next time step.
+   * 	surrogate: promote if V, T or the anode potential are too close to their thresholds,
+   * 			   recalibrate if the SOC, V, T or I have drifted too far from the calibration point.
+   * 	full SPM:  demote if V, T and the anode potential are far enough (with hysteresis) from their thresholds.
+   */
+  if (reduced) {
+    const double v = V();
+    const bool critical = (v < Vmin() + fid.dV_margin) || (v > Vmax() - fid.dV_margin)
+                          || (T() > fid.T_max) || (phin_lin() < fid.phin_min);
+
+    if (critical)
+      promote();
+    else if (std::abs(SOC() - lin.SOC) > fid.dSOC_max || std::abs(v - lin.V) > fid.dV_max
+             || std::abs(T() - lin.T) > fid.dT_max || std::abs(I() - lin.I) > fid.dI_max * Cap()) {
+      if (!calibrate())
+        promote();
+    }
+
+    return;
+  }
+
+  try {
+    const auto &k = getKinetics(false);
+    if (!k.inRange)
+      return;
+
+    const double v = V();
+    const double dV = fid.dV_margin + fid.dV_hyst;
+    const bool benign = (v > Vmin() + dV) && (v < Vmax() - dV) && (T() < fid.T_max - fid.dT_hyst)
+                        && (k.OCV_n + k.etan > fid.phin_min + fid.dphin_hyst);
+
+    if (benign)
+      demote();
+  } catch (int) { //!< stay with the full model, which will report the error
+    return;
+  }
+}
+
+double Cell_SPM_mixed::V()
+{
+  if (!reduced)
+    return Cell_SPM::V();
+
+  if (Vcell_valid)
+    return st.V();
+
+  st.V() = lin.V + lin.dV_dzpu * (st.zp(ind_u) - lin.zpu) + lin.dV_dzps * (st.zp(ind_p) - lin.zps)
+           + lin.dV_dznu * (st.zn(ind_u) - lin.znu) + lin.dV_dzns * (st.zn(ind_n) - lin.zns)
+           + lin.dV_dI * (I() - lin.I) + lin.dV_dT * (T() - lin.T);
+
+  Vcell_valid = true;
+  return st.V();
+}
+
+Status Cell_SPM_mixed::setCurrent(double Inew, bool checkV, bool print)
+{
+  //!< a large current step is outside of the range of the linearisation, so recalibrate at the new current before the voltage is checked
+  if (reduced && std::abs(Inew - lin.I) > fid.dI_max * Cap()) {
+    const auto Iold = st.I();
+    st.I() = Inew;
+    invalidateKinetics();
+    const bool calibrated = calibrate();
+    st.I() = Iold;
+    invalidateKinetics();
+
+    if (!calibrated)
+      promote();
+  }
+
+  const auto status = Cell_SPM::setCurrent(Inew, checkV, print);
+
+  if (reduced) //!< only promote here, demoting is done after a time step
+    checkFidelity();
+
+  return status;
+}
+
+void Cell_SPM_mixed::timeStep_CC(double dt, int nstep)
+{
+  if (reduced) {
+    Cell_SPM_fast::timeStep_CC(dt, nstep);
+    time_reduced += dt * nstep;
+  } else
+    Cell_SPM::timeStep_CC(dt, nstep);
+
+  time_total += dt * nstep;
+  checkFidelity();
+}
+void Cell_SPM_mixed::getCheckpoint(std::vector<double> &s)
+{
+  /*
+   * Besides the heat accumulators of Cell_SPM, the surrogate needs the model in use and its linearisation
+   * since the states of the surrogate are only valid with the linearisation they were computed with.
+   */
+  static_assert(sizeof(Linearisation) % sizeof(double) == 0, "Linearisation must only contain doubles.");
+  constexpr size_t Nlin = sizeof(Linearisation) / sizeof(double);
+
+  Cell_SPM::getCheckpoint(s);
+  s.insert(s.end(), { static_cast<double>(reduced), time_total, time_reduced });
+
+  const auto n = s.size();
+  s.resize(n + Nlin);
+  std::memcpy(s.data() + n, &lin, sizeof(Linearisation));
+}
+
+void Cell_SPM_mixed::setCheckpoint(std::span<double> s)
+{
+  constexpr size_t Nlin = sizeof(Linearisation) / sizeof(double);
+
+  Cell_SPM::setCheckpoint(s.first(std::min(s.size(), Ncheckpoint)));
+  s = s.subspan(std::min(s.size(), Ncheckpoint));
+
+  free::pop_checkpoint(s, reduced);
+  free::pop_checkpoint(s, time_total);
+  free::pop_checkpoint(s, time_reduced);
+
+  if (s.size() >= Nlin)
+    std::memcpy(&lin, s.data(), sizeof(Linearisation));
+
+  invalidateKinetics();
+}
+
+} // namespace slide
@@ -0,0 +1,101 @@
+/*
+ * Cell_SPM_mixed.hpp
+ *
+ * Mixed-fidelity single particle model.
+ *
+ * In a large pack, most cells are far away from their voltage limits, cool and without risk of li-plating most of the time.
+ * Cell_SPM_mixed then runs a cheap surrogate and only uses the full Cell_SPM when the cell approaches one of the thresholds in param::FidelityParam.
+ *
+ * The surrogate is an equivalent circuit model which is calibrated on the fly from the SPM state:
+ * 		- the diffusion is resolved with the reduced-order model of Cell_SPM_fast (uniform + slowest mode per particle),
+ * 		  which act as the 'OCV' and 'RC' states of the equivalent circuit
+ * 		- the voltage and anode potential are linearised around a calibration point in the retained modes, the current and the temperature
+ * 		  V = V_cal + dV/dz * (z - z_cal) + dV/dI * (I - I_cal) + dV/dT * (T - T_cal)
+ * 		  so V() costs a few multiplications instead of three interpolations and two asinh.
+ * The surrogate is recalibrated when the SOC, voltage, temperature or current has drifted too far from the calibration point.
+ *
+ * The state mapping is exact in the surrogate -> SPM direction: the residualised modes are set to their quasi-steady value,
+ * which gives the same concentration profile. In the SPM -> surrogate direction the residualised modes are dropped,
+ * which is exact once they have reached their quasi-steady value (they decay within seconds).
+ * The thermal and degradation models always use the kinetics of the (reduced) particle model, not the linearisation.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "Cell_SPM_fast.hpp"
+
+#include <string>
+#include <utility>
+
+namespace slide {
+
+class Cell_SPM_mixed : public Cell_SPM_fast
+{
+protected:
+  param::FidelityParam fid{}; //!< switching thresholds
+  bool reduced{ false };      //!< true if the cheap surrogate is used, false if the full SPM is used
+
+  //!< linearisation of the surrogate around the calibration point
+  struct Linearisation
+  {
+    double I{}, T{}, SOC{};            //!< current [A], temperature [K] and SOC [-] at the calibration point
+    double zpu{}, zps{}, znu{}, zns{}; //!< retained (uniform and slowest) modes at the calibration point
+    double V{}, phin{};                //!< cell voltage and anode potential vs Li/Li+ at the calibration point [V]
+    double dV_dzpu{}, dV_dzps{};       //!< sensitivity of the voltage to the retained modes of the positive particle
+    double dV_dznu{}, dV_dzns{};       //!< sensitivity of the voltage to the retained modes of the negative particle
+    double dV_dI{}, dV_dT{};           //!< sensitivity of the voltage to the current [Ohm] and temperature [V K-1]
+    double dphin_dznu{}, dphin_dzns{}; //!< sensitivity of the anode potential to the retained modes of the negative particle
+    double dphin_dI{};                 //!< sensitivity of the anode potential to the current [Ohm]
+  } lin{};
+
+  double time_total{}, time_reduced{}; //!< time integrated in total and with the surrogate [s]
+
+  bool reduced_backup{ false }; //!< model and linearisation at the time of backupStates()
+  Linearisation lin_backup{};
+
+  bool calibrate();     //!< linearise the reduced particle model at the current state, false if it is not possible
+  void promote();       //!< switch to the full SPM
+  void demote();        //!< switch to the surrogate
+  void checkFidelity(); //!< promote, demote or recalibrate depending on the thresholds
+  double phin_lin();    //!< anode potential from the linearisation [V]
+
+  std::pair<double, double> calcSurfaceConcentration(double jp, double jn, double Dpt, double Dnt) override;
+
+public:
+  Cell_SPM_mixed();
+  Cell_SPM_mixed(std::string IDi, const DEG_ID &degid, double capf, double resf, double degfsei, double degflam);
+
+  void setFidelityParam(const param::FidelityParam &fidi) { fid = fidi; }
+  const auto &getFidelityParam() const { return fid; }
+  bool isReduced() const noexcept { return reduced; }
+  double getReducedFraction() const noexcept { return (time_total > 0) ? time_reduced / time_total : 0; } //!< fraction of the simulated time spent in the surrogate [-]
+
+  double V() override;
+  Status setCurrent(double Inew, bool checkV = true, bool print = true) override;
+  void getC(double cp[], double cn[]) noexcept override;
+  void timeStep_CC(double dt, int steps = 1) override;
+
+  void backupStates() override
+  {
+    Cell_SPM::backupStates();
+    reduced_backup = reduced;
+    lin_backup = lin;
+  }
+
+  void restoreStates() override
+  {
+    Cell_SPM::restoreStates();
+    reduced = reduced_backup; //!< the states of the surrogate are only valid with the linearisation they were computed with
+    lin = lin_backup;
+  }
+
+  void getCheckpoint(std::vector<double> &s) override;
+  void setCheckpoint(std::span<double> s) override;
+
+  Cell_SPM_mixed *copy() override { return new Cell_SPM_mixed(*this); }
+};
+} // namespace slide
@@ -38,20 +38,19 @@ double Cell_SPM::thermalModel_cell()
    * We do not account for neighbouring cells, and this cell is cooled convectively by the environment
    */
 
-  //!< total heat generation since last time the temperature was updated
-  double Etot = Therm_Qgen;
-
-  //!< cooling with the environment
-  double Qc = Qch * getThermalSurface() * (T_env - T()) * Therm_time; //!< cooling with the environment [W m-3]
-  Etot += Qc;
-
-  //!< Calculate the new temperature
-  //!< rho * cp * dT/dt = Qtot / V
-  //!< 		where 	Qtot is total power in W
+  //!< Calculate the new temperature from the heat generation since the last time the temperature was updated
+  //!< rho * cp * V * dT/dt = Qgen + Qch * A * (T_env - T)
+  //!< 		where 	Qgen is the average heat generation in W since the last update
   //!< 				V is the cell's volume L * elec_surf
-  //!< so integrated over time this is
-  //!< rho * cp * (Tnew - Told) = Etot / V
-  double Tnew = T() + Etot / (rho * Cp * geo.L * geo.elec_surf);
+  //!< With a constant Qgen, this is solved exactly, so the temperature relaxes to its steady state without overshooting it
+  //!< however long the time since the last update is (e.g. during a long rest)
+  const double Cth = rho * Cp * geo.L * geo.elec_surf; //!< heat capacity of the cell [J K-1]
+  const double Kth = Qch * getThermalSurface();         //!< heat transfer to the environment [W K-1]
+  double Tnew = T() + Therm_Qgen / Cth;                 //!< only heat generation if no time passed
+  if (Therm_time > 0) {
+    const double Tss = T_env + Therm_Qgen / (Therm_time * Kth); //!< steady-state temperature
+    Tnew = Tss + (T() - Tss) * std::exp(-Kth * Therm_time / Cth);
+  }
 
   //!< Check the new temperature is valid, and if so, set it
   if (Tnew > Tmax() || Tnew < Tmin() || std::isnan(Tnew)) {
@@ -60,8 +59,8 @@ double Cell_SPM::thermalModel_cell()
                 << " is outside the allowed range from " << Tmin() << " to " << Tmax()
                 << ". The time since the last time this function was called is " << Therm_time << '\n';
 
-      std::cout << "Total thermal energy " << Etot << ". internal heat generation " << Therm_Qgen << '\n'
-                << "giving change in temperature: " << Etot / (rho * Cp * geo.L * geo.elec_surf) << '\n';
+      std::cout << "Internal heat generation " << Therm_Qgen << ", cooling to the environment at " << T_env << '\n'
+                << "giving change in temperature: " << Tnew - T() << '\n';
     }
     throw 9;
   }
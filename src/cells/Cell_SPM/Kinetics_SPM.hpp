@@ -0,0 +1,34 @@
+/*
+ * Kinetics_SPM.hpp
+ *
+ * Defines a struct grouping the intermediate kinetic quantities of the SPM model.
+ * They are evaluated once for a given state and current and then shared by the voltage,
+ * thermal and degradation models instead of each of them recalculating the same values.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+namespace slide {
+struct Kinetics_SPM
+{
+  //!< Rate quantities: depend on the current, temperature and degradation states but not on the concentrations.
+  double Dpt{}, Dnt{}; //!< diffusion constants at the cell's temperature [m s-1]
+  double kpt{}, knt{}; //!< rate constants of the main reaction at the cell's temperature [m s-1]
+  double i_app{};      //!< current density on the electrodes [A m-2]
+  double jp{}, jn{};   //!< molar flux on the positive/negative particle [mol m-2 s-1]
+  double Rdc{};        //!< total DC resistance [Ohm]
+
+  //!< Surface quantities: additionally depend on the (transformed) concentrations.
+  double cps{}, cns{};         //!< surface concentration of the positive/negative particle [mol m-3]
+  double zp_surf{}, zn_surf{}; //!< lithium fraction at the surface of the positive/negative particle [-]
+  bool inRange{ false };       //!< 0 < cps < Cmaxpos && 0 < cns < Cmaxneg. If false, the quantities below are not calculated.
+
+  double etap{}, etan{};   //!< overpotential at the positive (< 0 on discharge) and negative (> 0 on discharge) electrode [V]
+  double OCV_p{}, OCV_n{}; //!< cathode and anode potential at the reference temperature [V]
+  double dOCV{};           //!< entropic coefficient of the total cell voltage [V K-1]
+};
+} // namespace slide
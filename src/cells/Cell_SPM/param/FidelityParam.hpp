@@ -0,0 +1,30 @@
+/*
+ * FidelityParam.hpp
+ *
+ * Thresholds which decide when a Cell_SPM_mixed uses its cheap linear surrogate and when it uses the full SPM.
+ *
+ */
+
+#pragma once
+
+namespace slide::param {
+//!< Define a structure with the switching thresholds of the mixed-fidelity cell
+struct FidelityParam
+{
+  //!< promote to the full model if one of these is violated
+  double dV_margin{ 0.15 };  //!< minimum distance between the cell voltage and Vmin/Vmax [V]
+  double T_max{ 313.15 };    //!< maximum cell temperature [K]
+  double phin_min{ 0.05 };   //!< minimum anode potential vs Li/Li+ (OCV_n + etan), lower values mean a risk of li-plating [V]
+
+  //!< demote to the surrogate only if the margins above are respected with some extra hysteresis
+  double dV_hyst{ 0.05 };    //!< extra voltage margin [V]
+  double dT_hyst{ 2 };       //!< extra temperature margin [K]
+  double dphin_hyst{ 0.02 }; //!< extra anode potential margin [V]
+
+  //!< recalibrate the surrogate if the cell has moved too far from the calibration point
+  double dSOC_max{ 0.02 };   //!< change in SOC [-]
+  double dV_max{ 0.02 };     //!< change in voltage, recalibrates more often where the OCV curves are steep [V]
+  double dT_max{ 2 };        //!< change in temperature [K]
+  double dI_max{ 0.25 };     //!< change in current as a fraction of the capacity [C-rate]
+};
+} // namespace slide::param
@@ -16,3 +16,4 @@
 
 #include "PLparam.hpp"
 #include "OCVparam.hpp"
+#include "FidelityParam.hpp"
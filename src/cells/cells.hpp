@@ -12,5 +12,7 @@
 
 #include "Cell_ECM/Cell_ECM.hpp"
 #include "Cell_SPM/Cell_SPM.hpp"
+#include "Cell_SPM/Cell_SPM_fast.hpp"
+#include "Cell_SPM/Cell_SPM_mixed.hpp"
 
 #include "Cell_SPM/Cell_KokamNMC.hpp"
\ No newline at end of file
@@ -327,4 +327,22 @@ void CoolSystem::writeData(const std::string &prefix)
   coolData.writeData(*this, prefix);
 }
 
+void CoolSystem::getCheckpoint(std::vector<double> &s)
+{
+  /*
+   * Append the state (coolant temperature and flow rate) and the cumulative variables of this coolsystem to s.
+   * New fields must be added at the end so older checkpoints can still be read.
+   */
+  const auto &c = coolData.cData;
+  s.insert(s.end(), { Tcoolant, flowrate, c.Qevac, c.Qevac_life, c.Qabs_life, c.t_life, c.E, c.Eoperate, c.time, c.time_life });
+}
+
+void CoolSystem::setCheckpoint(std::span<double> &s)
+{
+  //!< opposite of getCheckpoint, fields which are missing in s keep their value
+  auto &c = coolData.cData;
+  for (auto *x : { &Tcoolant, &flowrate, &c.Qevac, &c.Qevac_life, &c.Qabs_life, &c.t_life, &c.E, &c.Eoperate, &c.time, &c.time_life })
+    free::pop_checkpoint(s, *x);
+}
+
 } // namespace slide
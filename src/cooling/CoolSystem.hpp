@@ -16,6 +16,8 @@
 
 #include <string>
 #include <cstdlib>
+#include <vector>
+#include <span>
 
 namespace slide {
 class CoolSystem
@@ -72,6 +74,9 @@ public:
   virtual void storeData(size_t Ncells);
   virtual void writeData(const std::string &prefix);
 
+  virtual void getCheckpoint(std::vector<double> &s); //!< state and cumulative variables, see StorageUnit::getCheckpoint
+  virtual void setCheckpoint(std::span<double> &s);   //!< read the values of getCheckpoint and remove them from s
+
   auto getHeatEvac() { return coolData.cData.Qevac_life; }    //!< for unit testing, total heat evacuated from children over entire lifetime
   auto getHeatabsorbed() { return coolData.cData.Qabs_life; } //!< for unit testing, total heat evacuated from children over entire lifetime (heat capacity not constant -> cannot convert Tend-T1 to energy)
   auto getTotalTime() { return coolData.cData.t_life; }       //!< total time this coolsystem has existed for [s]
@@ -303,4 +303,17 @@ void CoolSystem_HVAC::writeData(const std::string &prefix)
   //!< store histograms and degradation state of cell utilisation
   HVACdata.writeData(*this, prefix); //!< #TODO -> since we are doing append we cannot write like this IMPORTANT!!!!!
 }
+void CoolSystem_HVAC::getCheckpoint(std::vector<double> &s)
+{
+  CoolSystem::getCheckpoint(s); //!< first the variables of the internal coolsystem, then those of the AC unit
+  s.insert(s.end(), { Q_ac, HVACdata.cData.Eac, HVACdata.cData.QcoolAC });
+}
+
+void CoolSystem_HVAC::setCheckpoint(std::span<double> &s)
+{
+  CoolSystem::setCheckpoint(s);
+  for (auto *x : { &Q_ac, &HVACdata.cData.Eac, &HVACdata.cData.QcoolAC })
+    free::pop_checkpoint(s, *x);
+}
+
 } // namespace slide
\ No newline at end of file
@@ -50,6 +50,9 @@ public:
   virtual void storeData(size_t Ncells) override;
   virtual void writeData(const std::string &prefix) override;
 
+  void getCheckpoint(std::vector<double> &s) override;
+  void setCheckpoint(std::span<double> &s) override;
+
   CoolSystem_HVAC *copy() override { return new CoolSystem_HVAC(*this); }
 };
 
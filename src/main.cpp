@@ -144,6 +144,7 @@ int main()
   // slide::benchmarks::run_Cell_ECM();
   // slide::benchmarks::run_Cell_SPM_1(1);
   // slide::benchmarks::run_Cell_SPM_2(1);
+  // slide::benchmarks::run_Cell_SPM_fast_validation();
   // slide::benchmarks::run_LP_case_SmallPack();
   // slide::benchmarks::run_LP_case_MediumPack();
   // slide::benchmarks::run_LP_case_LargePack();
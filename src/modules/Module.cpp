@@ -107,6 +107,10 @@ void Module::setSUs(SUs_span_t c, bool checkCells, bool print)
   }
 
   Ncells = r;
+  resetPackData(); //!< attached to the new cells at the next storeData
+
+  s_rollback.clear();
+  getStates(s_rollback); //!< reserve the rollback buffer of setStates
 }
 
 
@@ -131,8 +135,8 @@ Status Module::checkVoltage(double &v, bool print) noexcept
   //!< check the voltages of the connected cells
   double vi;
   auto res = Status::Success;
-  for (const auto &SU : SUs)
-    res = std::max(res, SU->checkVoltage(vi, print)); // get the worst status.
+  for (size_t i = 0; i < getNSUs(); i++)
+    res = std::max(res, getSU(i)->checkVoltage(vi, print)); // get the worst status.
 
   return res;
 }
@@ -142,8 +146,8 @@ double Module::getVhigh()
   //!< return the voltage of the cell with the highest voltage
   //!< 	note CELL not child SU
   double Vhigh = Vmin(); // #TODO
-  for (const auto &SU : SUs)
-    Vhigh = std::max(Vhigh, SU->getVhigh()); //!< will be called recursively to the cell levels
+  for (size_t i = 0; i < getNSUs(); i++)
+    Vhigh = std::max(Vhigh, getSU(i)->getVhigh()); //!< will be called recursively to the cell levels
 
   return Vhigh;
 }
@@ -152,8 +156,8 @@ double Module::getVlow()
 {
   //!< return the voltage of the cell with the lowest voltage note CELL not child SU
   double Vlow = Vmax(); // #TODO
-  for (const auto &SU : SUs)
-    Vlow = std::min(Vlow, SU->getVlow()); //!< will be called recursively to the cell levels
+  for (size_t i = 0; i < getNSUs(); i++)
+    Vlow = std::min(Vlow, getSU(i)->getVlow()); //!< will be called recursively to the cell levels
 
   return Vlow;
 }
@@ -165,8 +169,8 @@ void Module::getStates(getStates_t s)
    * [s0 s1 s2 ... sn Tmod]
    * where s0 is the array with the states of the first cell of this module
    */
-  for (const auto &SU : SUs)
-    SU->getStates(s); //!< pass a vector, the next nsi locations will be automatically filled with the states of cell i
+  for (size_t i = 0; i < getNSUs(); i++)
+    getSU(i)->getStates(s); //!< pass a vector, the next nsi locations will be automatically filled with the states of cell i
 
   s.push_back(T()); //!< store the module temperature
 }
@@ -213,28 +217,28 @@ Status Module::setStates(setStates_t s, bool checkV, bool print)
 
   const bool verb = print && (settings::printBool::printCrit);
 
-  std::vector<double> sorig;
-  getStates(sorig);
+  s_rollback.clear(); //!< keeps its capacity, so no allocation
+  getStates(s_rollback);
 
-  std::span<double> spn_orig{ sorig };
+  std::span<double> spn_orig{ s_rollback };
 
   Vmodule_valid = false; //!< we are changing the states, so the stored voltage is no longer valid
 
   //!< set the new cell states
   for (size_t i = 0; i < getNSUs(); i++) {
 
-    const Status status = SUs[i]->setStates(s, checkV, print); //!<  set the states
+    const Status status = getSU(i)->setStates(s, checkV, print); //!<  set the states
 
     if (verb && isStatusWarning(status))
       std::cout << "warning in Module::setStates, the voltage of cell " << i << " with id "
-                << SUs[i]->getFullID() << " is outside the allowed range. Continue for now.\n";
+                << getSU(i)->getFullID() << " is outside the allowed range. Continue for now.\n";
     else if (isStatusBad(status)) {
       if (verb)
         std::cerr << "ERROR in Module::setStates when setting the state of cell " << i
                   << ". Restoring the old states, status: " << getStatusMessage(status) << '\n';
 
       for (size_t j = 0; j <= i; j++)
-        SUs[i]->setStates(spn_orig, false, print); //!< restore the original states without checking validity (they should be valid)
+        getSU(j)->setStates(spn_orig, false, print); //!< restore the original states without checking validity (they should be valid)
 
       return status;
     }
@@ -267,6 +271,37 @@ Status Module::setStates(setStates_t s, bool checkV, bool print)
   return Status::Success; //!< return success.
 }
 
+void Module::backupStates()
+{
+  for (size_t i = 0; i < getNSUs(); i++)
+    getSU(i)->backupStates();
+
+  T_backup = T();
+}
+
+void Module::restoreStates()
+{
+  for (size_t i = 0; i < getNSUs(); i++)
+    getSU(i)->restoreStates();
+
+  setT(T_backup);
+  Vmodule_valid = false; //!< the states have changed, so the stored voltage is no longer valid
+}
+
+void Module::getCheckpoint(std::vector<double> &s)
+{
+  s.insert(s.end(), { therm.time, therm.Qcontact });
+  cool->getCheckpoint(s);
+}
+
+void Module::setCheckpoint(std::span<double> s)
+{
+  free::pop_checkpoint(s, therm.time);
+  free::pop_checkpoint(s, therm.Qcontact);
+  cool->setCheckpoint(s);
+  Vmodule_valid = false;
+}
+
 double Module::thermalModel_cell()
 {
   /*
@@ -286,7 +321,7 @@ double Module::thermalModel_cell()
   //!< calculate cells' temperature
   for (size_t i = 0; i < getNSUs(); i++) {
     try {
-      Tnew[i] = SUs[i]->thermalModel(3, Tsu, Ksu, Asu, tim);
+      Tnew[i] = getSU(i)->thermalModel(3, Tsu, Ksu, Asu, tim);
     } catch (int e) {
       if constexpr (settings::printBool::printCrit)
         std::cout << "Error in module " << getFullID() << " when calculating the thermal balance of child SU "
@@ -297,7 +332,7 @@ double Module::thermalModel_cell()
 
   //!< Set all the new temperatures to the children
   for (size_t i = 0; i < getNSUs(); i++)
-    SUs[i]->setT(Tnew[i]);
+    getSU(i)->setT(Tnew[i]);
 
   //!< the temperature of a module doesn't change
   return T();
@@ -356,8 +391,8 @@ double Module::thermalModel_coupled(int Nneighbours, double Tneighbours[], doubl
       Ksu[1] = therm.k_cell2cell; //!< conductive heat exchange via long sides of cell
 
       if (i > 0) {
-        Tsu[1] = SUs[i - 1]->T(); //!< left is cell i-1
-        Asu[1] = SUs[i - 1]->getThermalSurface();
+        Tsu[1] = getSU(i - 1)->T(); //!< left is cell i-1
+        Asu[1] = getSU(i - 1)->getThermalSurface();
       } else { //!< left is module
         Asu[1] = getThermalSurface();
         Tsu[1] = T();
@@ -367,8 +402,8 @@ double Module::thermalModel_coupled(int Nneighbours, double Tneighbours[], doubl
       Ksu[2] = therm.k_cell2cell;
       if (i + 1 < getNSUs()) //!< Last cell. getNSUs() is unsigned therefore getNSUs() -1 is omitted.
       {
-        Asu[2] = SUs[i + 1]->getThermalSurface();
-        Tsu[2] = SUs[i + 1]->T();
+        Asu[2] = getSU(i + 1)->getThermalSurface();
+        Tsu[2] = getSU(i + 1)->T();
       } else { //!< right is edge of module
         Asu[2] = getThermalSurface();
         Tsu[2] = T();
@@ -376,7 +411,7 @@ double Module::thermalModel_coupled(int Nneighbours, double Tneighbours[], doubl
 
       //!< calculate thermal balance of the child SU
       try {
-        Tnew[i] = SUs[i]->thermalModel(3, Tsu, Ksu, Asu, tim);
+        Tnew[i] = getSU(i)->thermalModel(3, Tsu, Ksu, Asu, tim);
       } catch (int e) {
         if constexpr (settings::printBool::printCrit)
           std::cout << "Error in module " << getFullID() << " when calculating the thermal balance of child SU "
@@ -388,15 +423,15 @@ double Module::thermalModel_coupled(int Nneighbours, double Tneighbours[], doubl
     //!< The cooling fluid in the module heats up from cooling all cells
     double Etot = 0;
     for (size_t i = 0; i < getNSUs(); i++) {
-      const double Atherm = std::min(Asu[0], SUs[i]->getThermalSurface());
-      Etot += Ksu[0] * Atherm * (SUs[i]->T() - T()) * tim;
+      const double Atherm = std::min(Asu[0], getSU(i)->getThermalSurface());
+      Etot += Ksu[0] * Atherm * (getSU(i)->T() - T()) * tim;
 
       //!< additional cooling to the first and last cell of the stack (which both have 1 edge from the coolsystem)
       if (i == 0)
-        Etot += Ksu[1] * Atherm * (SUs[i]->T() - T()) * tim;
+        Etot += Ksu[1] * Atherm * (getSU(i)->T() - T()) * tim;
 
       if (i == getNSUs() - 1) //!< #TODO problem.
-        Etot += Ksu[2] * Atherm * (SUs[i]->T() - T()) * tim;
+        Etot += Ksu[2] * Atherm * (getSU(i)->T() - T()) * tim;
     }
 
     //!< Add up the heat generated in all the contact resistances of this Module
@@ -424,7 +459,7 @@ double Module::thermalModel_coupled(int Nneighbours, double Tneighbours[], doubl
 
     //!< Set all the new temperatures to the children
     for (size_t i = 0; i < getNSUs(); i++)
-      SUs[i]->setT(Tnew[i]);
+      getSU(i)->setT(Tnew[i]);
 
     //!< reset the time since the last update of the thermal model
     therm.time = 0;
@@ -8,13 +8,18 @@
 #pragma once
 
 #include "../StorageUnit.hpp"
+#include "../cells/Cell.hpp"
+#include "../types/data_storage/PackDataStore.hpp"
+#include "../types/data_storage/Decimator.hpp"
 #include "../cooling/cooling.hpp"
 #include "../types/State.hpp"
 #include "../settings/settings.hpp"
 #include "../utility/utility.hpp"
+#include "../utility/io/ColumnarFile.hpp"
 
 
 #include <vector>
+#include <array>
 #include <cstdlib>
 #include <memory>
 #include <iostream>
@@ -57,6 +62,11 @@ protected:
 
   State<0, settings::data::N_CumulativeModule> st_module;
   std::vector<double> data; //!< Time data
+  Decimator decimator;      //!< skips samples of the time data in which nothing changed
+  PackDataStore<Cell> packData; //!< time data of all cells if this is the top-level module and settings::data::packCellData
+
+  double T_backup{ 0 };            //!< coolant temperature at the time of backupStates()
+  std::vector<double> s_rollback; //!< buffer for the original states in setStates, sized in setSUs so it is not reallocated
 
 
   size_t calculateNcells() override
@@ -69,6 +79,31 @@ protected:
     return Ncells = transform_sum(SUs, free::get_Ncells<SU_t>);
   }
 
+  bool isTopModule() { return parent == nullptr || dynamic_cast<Module *>(parent) == nullptr; } //!< highest module, e.g. the one of a Battery
+
+  void collectCells(std::vector<Cell *> &cells)
+  {
+    //!< append all cells of this module and its child-modules, in the order of their index, except the ones which store nothing
+    for (size_t i = 0; i < getNSUs(); i++) {
+      if (getSU(i)->getCapture() == settings::cellDataStorageLevel::noStorage)
+        continue;
+      if (auto c = dynamic_cast<Cell *>(getSU(i)))
+        cells.push_back(c);
+      else if (auto m = dynamic_cast<Module *>(getSU(i)))
+        m->collectCells(cells);
+    }
+  }
+
+  void resetPackData()
+  {
+    //!< collect the cells again at the next storeData, the samples which were not written yet can't be kept
+    if constexpr (settings::printBool::printNonCrit)
+      if (packData.size() > 0)
+        std::cout << "Warning in Module::resetPackData, module " << getFullID() << " drops " << packData.size()
+                  << " samples of its cells which were not written yet, call writeData before changing the capture or the cells.\n";
+    packData.reset();
+  }
+
   double thermalModel_cell();
   double thermalModel_coupled(int Nneighbours, double Tneighbours[], double Kneighbours[], double Aneighb[], double tim);
 
@@ -79,11 +114,13 @@ public:
   Module(std::string_view ID_, double Ti, bool print, bool pari, int Ncells, CoolSystem_t &&coolControlPtr, int cooltype);
 
   //!< common implementation for all base-modules
-  size_t getNSUs() { return SUs.size(); } //!< note that these child-SUs can be modules themselves (or they can be cells)
-  SUs_t &getSUs() { return SUs; }
+  virtual size_t getNSUs() { return SUs.size(); }               //!< note that these child-SUs can be modules themselves (or they can be cells)
+  virtual StorageUnit *getSU(size_t i) { return SUs[i].get(); } //!< child-SU i, also for modules which store their children by value (Module_T)
+  virtual SUs_t &getSUs() { return SUs; }                       //!< throws for modules which store their children by value (Module_T), use getSU(i)
+  virtual const SUs_t &getSUs() const { return SUs; }
 
-  const auto &operator[](size_t i) const { return SUs[i]; }
-  auto &operator[](size_t i) { return SUs[i]; }
+  const auto &operator[](size_t i) const { return getSUs()[i]; }
+  auto &operator[](size_t i) { return getSUs()[i]; }
 
   virtual Status checkVoltage(double &v, bool print) noexcept override; //!< get the voltage and check if it is valid
   double getVhigh() override;                                           //!< return the voltage of the cell with the highest voltage
@@ -95,6 +132,10 @@ public:
 
   virtual bool validStates(bool print = true) override; //!< check if a state-array is valid for this module (uses setStates)
   virtual Status setStates(setStates_t s, bool checkV = true, bool print = true) override;
+  void backupStates() override;
+  void restoreStates() override;
+  void getCheckpoint(std::vector<double> &s) override; //!< thermal accumulators of this module and the variables of its coolsystem
+  void setCheckpoint(std::span<double> s) override;
   //!< Set the states of this module to the given one
   //!< note: setStates is the master function to check if states and cells are valid
   //!< if checkV=true, then also the cell and module voltages are checked
@@ -115,7 +156,7 @@ public:
 
   CoolSystem *getCoolSystem() { return cool.get(); }
 
-  void setRcontact(std::span<double> Rc) //!< #TODO if ok.
+  virtual void setRcontact(std::span<double> Rc) //!< #TODO if ok.
   {
     /*
      * Set the contact resistance of each cell.
@@ -129,25 +170,74 @@ public:
 
   virtual Module *copy() override = 0;
 
+  void applyCapture(settings::cellDataStorageLevel level) override
+  {
+    for (size_t i = 0; i < getNSUs(); i++)
+      getSU(i)->applyCapture(level);
+    capture = level;
+    resetPackData();
+  }
+
+  void refreshCapture() override
+  {
+    //!< a module stores data if any of its children does
+    if (getNSUs() == 0) return;
+    capture = settings::cellDataStorageLevel::noStorage;
+    for (size_t i = 0; i < getNSUs(); i++)
+      capture = std::max(capture, getSU(i)->getCapture());
+    resetPackData();
+  }
+
   void storeData() override
   {
-    for (const auto &SU : SUs) //!< Tell all connected cells to store their data
-      SU->storeData();
+    if constexpr (settings::data::packCellData)
+      if (isTopModule()) { //!< one pass over all cells of the pack
+        if (!packData.isAttached()) {
+          std::vector<Cell *> cells;
+          collectCells(cells);
+          packData.attach(std::move(cells));
+        }
+        packData.store();
+        cool->storeData(getNcells());
+        return;
+      }
+
+    for (size_t i = 0; i < getNSUs(); i++) //!< Tell all connected cells to store their data
+      if (getSU(i)->getCapture() != settings::cellDataStorageLevel::noStorage)
+        getSU(i)->storeData();
 
     //!< Store data for the coolsystem
     cool->storeData(getNcells());
 
     if constexpr (settings::DATASTORE_MODULE >= settings::moduleDataStorageLevel::storeTimeData) //!< Store data of this module
-      data.insert(data.end(), { st_module.Ah(), st_module.Wh(), st_module.time(), I(), V(), T() });
+      if (capture != settings::cellDataStorageLevel::noStorage) {
+        static constexpr std::array<double, 6> tol{ Decimator::noTol, Decimator::noTol, Decimator::noTol,
+                                                    settings::DATASTORE_TOL_I, settings::DATASTORE_TOL_V, settings::DATASTORE_TOL_T };
+        const std::array<double, 6> sample{ st_module.Ah(), st_module.Wh(), st_module.time(), I(), V(), T() };
+        decimator.offer(sample, tol, 2, data);
+      }
   }
 
   void writeData(const std::string &prefix) override
   {
-    for (const auto &SU : SUs) //!< Tell all connected cells to write their data
-      SU->writeData(prefix);
+    for (size_t i = 0; i < getNSUs(); i++) //!< Tell all connected cells to write their data
+      if (getSU(i)->getCapture() != settings::cellDataStorageLevel::noStorage)
+        getSU(i)->writeData(prefix);
+
+    if constexpr (settings::data::packCellData)
+      if (isTopModule()) packData.write(prefix); //!< after the cells, which write their states
+
+    decimator.flush(data);
 
 
-    if constexpr (settings::DATASTORE_MODULE >= settings::moduleDataStorageLevel::storeTimeData) //!< Write data for this module
+    if constexpr (settings::DATASTORE_MODULE >= settings::moduleDataStorageLevel::storeTimeData
+                  && settings::DATASTORE_FORMAT == settings::dataFormat::binary) {
+      static const std::array<Column, 6> columns{ { { "Ah" }, { "Wh" }, { "time" }, { "I", ColumnType::f32 }, { "V", ColumnType::f32 }, { "T", ColumnType::f32 } } };
+      const auto bytes = data.size() * sizeof(double);
+      AsyncWriter::submit([writer = ColumnarWriter::get(PathVar::results / (prefix + "_data.slb")),
+                           name = getFullID() + "_ModuleData", rows = AsyncWriter::take(data)] { writer->write(name, columns, rows); },
+                          bytes);
+    } else if constexpr (settings::DATASTORE_MODULE >= settings::moduleDataStorageLevel::storeTimeData) //!< Write data for this module
     {
       std::string name = prefix + "_" + getFullID() + "_ModuleData.csv"; //!< name of the file, start with the full hierarchy-ID to identify this cell
 
@@ -172,8 +262,8 @@ public:
 
   void setBlockDegAndTherm(bool block)
   {
-    for (auto &SU : SUs)
-      SU->setBlockDegAndTherm(block);
+    for (size_t i = 0; i < getNSUs(); i++)
+      getSU(i)->setBlockDegAndTherm(block);
 
     blockDegAndTherm = block;
   }
@@ -198,8 +288,8 @@ public:
   double getThotSpot() override //!< get the maximum temperature of the cells or the module
   {
     double Thot = cool->T();
-    for (const auto &SU : SUs)
-      Thot = std::max(Thot, SU->getThotSpot());
+    for (size_t i = 0; i < getNSUs(); i++)
+      Thot = std::max(Thot, getSU(i)->getThotSpot());
 
     return Thot;
   }
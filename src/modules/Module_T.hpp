@@ -0,0 +1,126 @@
+/*
+ * Module_T.hpp
+ *
+ * Base class for modules whose children all have the same cell type Cell_t.
+ * The cells are stored by value in contiguous memory instead of as Deep_ptr<StorageUnit> in Module::SUs,
+ * so there is no separate heap allocation per cell and the module loops call the cell functions
+ * with a qualified name (c.Cell_t::V()), which is statically dispatched and can be inlined.
+ *
+ * At the module boundary nothing changes: Module_T is a Module and a StorageUnit,
+ * and generic code reaches the cells through getNSUs() and getSU(i).
+ * Module::SUs stays empty, so getSUs() throws and operator[] returns the cell itself.
+ */
+
+#pragma once
+
+#include "Module.hpp"
+#include "../settings/settings.hpp"
+#include "../utility/utility.hpp"
+
+#include <vector>
+#include <string_view>
+#include <typeinfo>
+#include <iostream>
+
+namespace slide {
+template <typename Cell_t>
+class Module_T : public Module
+{
+public:
+  using Cells_t = std::vector<Cell_t>;
+
+protected:
+  Cells_t cells; //!< child cells, stored by value
+
+  size_t calculateNcells() override { return Ncells = cells.size(); }
+  virtual bool validCells(Cells_t &cs, bool print) = 0; //!< can the cells cs be combined in this module (same current if series, same voltage if parallel)
+
+public:
+  Module_T() : Module("moduleT") {}
+  Module_T(std::string_view ID_, double Ti, bool print, bool pari, int Ncells_, int coolControl, int cooltype)
+    : Module(ID_, Ti, print, pari, Ncells_, coolControl, cooltype) {}
+
+  Module_T(const Module_T &other) : Module(other), cells(other.cells)
+  {
+    for (auto &c : cells) //!< the copied cells still point to the original module
+      c.setParent(this);
+  }
+
+  Module_T &operator=(const Module_T &) = delete;
+
+  size_t getNSUs() override { return cells.size(); }
+  StorageUnit *getSU(size_t i) override { return &cells[i]; }
+  Cells_t &getCells() { return cells; }
+
+  Cell_t &operator[](size_t i) { return cells[i]; }
+  const Cell_t &operator[](size_t i) const { return cells[i]; }
+
+  SUs_t &getSUs() override
+  {
+    //!< the cells are not stored as Deep_ptr<StorageUnit>, so there is no vector of them to return
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "ERROR in Module_T::getSUs, module " << getFullID() << " stores its cells by value, use getSU(i) or getCells(). Throwing 10.\n";
+    throw 10;
+  }
+  const SUs_t &getSUs() const override { return const_cast<Module_T *>(this)->getSUs(); }
+
+  void setCells(Cells_t c)
+  {
+    /*
+     * Sets the cells of this module, sets their parent to this module and resets all contact resistances to 0.
+     */
+    cells = std::move(c);
+    for (auto &cell : cells)
+      cell.setParent(this);
+
+    Rcontact.assign(cells.size(), 0);
+    Ncells = cells.size();
+    Vmodule_valid = false; //!< we are changing the cells, so the stored voltage is no longer valid
+
+    s_rollback.clear();
+    getStates(s_rollback); //!< reserve the rollback buffer of setStates
+  }
+
+  void setSUs(SUs_span_t c, bool checkCells = true, bool print = true) override
+  {
+    /*
+     * Copy the SUs in c into this module.
+     * The SUs must have exactly the type Cell_t (a derived cell would be sliced).
+     *
+     * THROWS
+     * 10 	one of the SUs is not a Cell_t or already belongs to a different module,
+     * 		or checkCells and the cells can't be combined in this module (see validCells)
+     */
+    const bool verb = print && (settings::printBool::printCrit);
+
+    Cells_t cs;
+    cs.reserve(c.size());
+    for (size_t i = 0; i < c.size(); i++) {
+      if (typeid(*c[i]) != typeid(Cell_t)) {
+        if (verb)
+          std::cerr << "ERROR in Module_T::setSUs, SU " << i << " with ID " << c[i]->getFullID()
+                    << " does not have the cell type of module " << getFullID() << ". Throwing 10.\n";
+        throw 10;
+      }
+
+      const auto p = c[i]->getParent();
+      if (p != nullptr && p != this) {
+        if (verb)
+          std::cerr << "ERROR in Module_T::setSUs, SU " << i << " already has a parent with full ID: "
+                    << p->getFullID() << ". Throwing 10.\n";
+        throw 10;
+      }
+
+      cs.push_back(static_cast<Cell_t &>(*c[i]));
+    }
+
+    if (checkCells && !validCells(cs, print)) {
+      if (verb)
+        std::cerr << "ERROR in Module_T::setSUs, the cells can't be combined in module " << getFullID() << ". Throwing 10.\n";
+      throw 10;
+    }
+
+    setCells(std::move(cs));
+  }
+};
+} // namespace slide
@@ -0,0 +1,287 @@
+/*
+ * Module_p_T.hpp
+ *
+ * parallel-connected Module with cells of type Cell_t stored by value, e.g. Module_p_T<Cell_ECM<1>>.
+ * Same behaviour as Module_p, see Module_T.hpp for the storage.
+ */
+
+#pragma once
+
+#include "Module_T.hpp"
+#include "../settings/settings.hpp"
+#include "../utility/utility.hpp"
+
+#include <string_view>
+#include <array>
+#include <span>
+#include <iostream>
+#include <typeinfo>
+#include <algorithm>
+#include <cmath>
+
+namespace slide {
+template <typename Cell_t>
+class Module_p_T : public Module_T<Cell_t>
+{
+protected:
+  using Module_T<Cell_t>::cells, Module_T<Cell_t>::Rcontact, Module_T<Cell_t>::Vmodule_valid;
+  using Module_T<Cell_t>::therm, Module_T<Cell_t>::cool, Module_T<Cell_t>::par, Module_T<Cell_t>::parent, Module_T<Cell_t>::blockDegAndTherm;
+  using typename Module_T<Cell_t>::Cells_t;
+
+  bool validCells(Cells_t &cs, bool print) override
+  {
+    //!< cells in parallel have the same voltage (the contact resistances are 0 after setSUs)
+    for (size_t i = 1; i < cs.size(); i++)
+      if (std::abs(cs[i].Cell_t::V() - cs[0].Cell_t::V()) > settings::MODULE_P_V_ABSTOL) {
+        if constexpr (settings::printBool::printCrit)
+          if (print)
+            std::cerr << "ERROR in Module_p_T::validCells, cell " << i << " has a voltage of " << cs[i].Cell_t::V()
+                      << "V while cell 0 has a voltage of " << cs[0].Cell_t::V() << "V.\n";
+        return false;
+      }
+    return true;
+  }
+
+  void getVall(std::span<double> Vall)
+  {
+    /*
+     * Return the voltage of cell i as seen from the terminal while accounting for the contact resistance,
+     * see Module_p::getVall.
+     */
+    double I_cumulative{ 0 };
+    for (size_t i{}; i < cells.size(); i++) {
+      const auto j = cells.size() - 1 - i;
+      Vall[j] = cells[j].Cell_t::V();
+      I_cumulative += cells[j].Cell_t::I();
+
+      for (auto k{ j }; k < cells.size(); k++)
+        Vall[k] -= I_cumulative * Rcontact[j];
+    }
+  }
+
+  int equaliseVoltages(std::span<double> Ia, std::span<double> Va, double tol, int maxIteration)
+  {
+    /*
+     * Iteratively move current from the cells with a low terminal voltage to the cells with a high one
+     * until all terminal voltages are within tol of their mean. The total current is preserved.
+     * Returns the number of iterations, or maxIteration if it did not converge.
+     */
+    const auto nSU = cells.size();
+    int iter{ 0 };
+    for (; iter < maxIteration; iter++) {
+      double Vmean{ 0 }, error{ 0 };
+      for (size_t i = 0; i < nSU; i++)
+        Vmean += Va[i];
+
+      Vmean /= nSU;
+
+      for (size_t i = 0; i < nSU; i++)
+        error += std::abs(Vmean - Va[i]);
+
+      if (error < tol)
+        break;
+
+      for (size_t i = 0; i < nSU; i++) {
+        Ia[i] = Ia[i] - (Vmean - Va[i]) * cells[i].Cell_t::Cap();
+        cells[i].Cell_t::setCurrent(Ia[i]);
+      }
+
+      getVall(Va);
+    }
+
+    if constexpr (settings::printNumIterations)
+      if (iter != 0) std::cout << "Module_p_T iterations: " << iter << '\n';
+
+    return iter;
+  }
+
+public:
+  Module_p_T() : Module_T<Cell_t>() { this->setID("moduleP"); }
+  Module_p_T(std::string_view ID_, double Ti, bool print, bool pari, int Ncells_, int coolControl, int cooltype)
+    : Module_T<Cell_t>(ID_, Ti, print, pari, Ncells_, coolControl, cooltype) {}
+
+  //!< the voltage limits are the most constraining limits of all cells ie the highest Vmin of the cells is the Vmin of the module
+  double Vmin() const override
+  {
+    double v{ 0 };
+    for (const auto &c : cells) v = std::max(v, c.Cell_t::Vmin());
+    return v;
+  }
+
+  double VMIN() const override
+  {
+    double v{ 0 };
+    for (const auto &c : cells) v = std::max(v, c.Cell_t::VMIN());
+    return v;
+  }
+
+  double Vmax() const override
+  {
+    if (cells.empty()) return 0;
+
+    double v = cells[0].Cell_t::Vmax();
+    for (const auto &c : cells) v = std::min(v, c.Cell_t::Vmax());
+    return v;
+  }
+
+  double VMAX() const override
+  {
+    if (cells.empty()) return 0;
+
+    double v = cells[0].Cell_t::VMAX();
+    for (const auto &c : cells) v = std::min(v, c.Cell_t::VMAX());
+    return v;
+  }
+
+  double I() const override //!< the current is the sum of the current of each cell
+  {
+    double i{ 0 };
+    for (const auto &c : cells) i += c.Cell_t::I();
+    return i;
+  }
+
+  double Cap() const override //!< module capacity (sum of cells)
+  {
+    double cap{ 0 };
+    for (const auto &c : cells) cap += c.Cell_t::Cap();
+    return cap;
+  }
+
+  double getOCV() override
+  {
+    if (cells.empty()) return 0;
+
+    double ocv{ 0 };
+    for (auto &c : cells) ocv += c.Cell_t::getOCV();
+    return ocv / cells.size();
+  }
+
+  double getRtot() override
+  {
+    if (cells.empty()) return 0;
+
+    //!< start from the cell furthest away, then iteratively come closer: Rcontact[i] + (Rcell[i] \\ Rtot)
+    double rtot = Rcontact.back() + cells.back().Cell_t::getRtot();
+    for (int i = static_cast<int>(cells.size()) - 2; i >= 0; i--) {
+      const double r_i = cells[i].Cell_t::getRtot();
+      rtot = Rcontact[i] + (r_i * rtot) / (r_i + rtot);
+    }
+
+    return rtot;
+  }
+
+  double V() override { return cells.empty() ? 0 : cells[0].Cell_t::V() - I() * Rcontact[0]; }
+
+  Status redistributeCurrent()
+  {
+    //!< equalise the terminal voltages of the cells while keeping the total current, see Module_p::redistributeCurrent
+    constexpr int maxIteration = 2500;
+    if (cells.size() <= 1) return Status::Success;
+
+    std::array<double, settings::MODULE_NSUs_MAX> Va, Ia;
+    getVall(Va);
+    for (size_t i = 0; i < cells.size(); i++)
+      Ia[i] = cells[i].Cell_t::I();
+
+    const int iter = equaliseVoltages(Ia, Va, 1e-10, maxIteration);
+    return (iter < maxIteration) ? Status::Success : Status::RedistributeCurrent_failed;
+  }
+
+  Status setCurrent(double Inew, bool checkV = true, bool print = true) override
+  {
+    /*
+     * Set the current of a parallel module, see Module_p::setCurrent.
+     * The change in current is first divided equally over the cells, then the terminal voltages are equalised.
+     */
+    const bool verb = print && (settings::printBool::printCrit);
+    constexpr int maxIteration = 10550;
+    const auto nSU = cells.size();
+    if (nSU == 0) return Status::Success;
+
+    Vmodule_valid = false; //!< we are changing the current, so the stored voltage is no longer valid
+
+    std::array<double, settings::MODULE_NSUs_MAX> Ia, Va;
+    double Itot{ 0 };
+    for (size_t i{}; i < nSU; i++) {
+      Ia[i] = cells[i].Cell_t::I();
+      Itot += Ia[i];
+    }
+
+    const auto dI = (Inew - Itot) / nSU;
+    for (size_t i{}; i < nSU; i++) {
+      Ia[i] += dI;
+      const auto status = cells[i].Cell_t::setCurrent(Ia[i]);
+      if (!isStatusOK(status)) {
+        if (verb)
+          std::cout << "ERROR " << getStatusMessage(status) << " in Module_p_T::setCurrent when setting the current of cell "
+                    << " with id " << cells[i].getFullID() << " for Inew = " << Inew / nSU << ".\n";
+        return status;
+      }
+    }
+
+    getVall(Va);
+    equaliseVoltages(Ia, Va, 1e-9, maxIteration);
+    return Status::Success;
+  }
+
+  void timeStep_CC(double dt, int nstep = 1) override
+  {
+    /*
+     * Take a CC time step on every cell and redistribute the current afterwards, see Module_p::timeStep_CC
+     *
+     * THROWS
+     * 10 	negative time step
+     * 14 	this module has no parent (i.e. is top level) but does not have an HVAC coolsystem
+     */
+    if (dt < 0) {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "ERROR in Module_p_T::timeStep_CC, the time step dt must be 0 or positive, but has value " << dt << '\n';
+      throw 10;
+    }
+
+    auto task_indv = [&](int i) { cells[i].Cell_t::timeStep_CC(dt, nstep); };
+
+    try {
+      run(task_indv, cells.size(), (par ? -1 : 1));
+    } catch (int e) {
+      std::cout << "Error in Module_p_T::timeStep_CC with module ID " << this->getFullID()
+                << ". error " << e << ", throwing it on.\n";
+      throw e;
+    }
+
+    if (!blockDegAndTherm) {
+      therm.time += nstep * dt;
+
+      //!< resistor i sees the currents through the cells 'behind' it
+      double Ii{ 0 };
+      for (size_t i = cells.size(); i-- > 0;) {
+        Ii += cells[i].Cell_t::I();
+        therm.Qcontact += Rcontact[i] * sqr(Ii) * nstep * dt;
+      }
+
+      if (!parent) { //!< top-level module, exchanges heat with the environment through its HVAC coolsystem
+        if (typeid(*this->getCoolSystem()) != typeid(CoolSystem_HVAC)) {
+          std::cerr << "ERROR in Module_p_T::timeStep_CC in module " << this->getFullID() << ". this is a top-level"
+                    << " module but does not have an HVAC coolsystem for active cooling with the environment.\n";
+          throw 14;
+        }
+
+        double Tneigh[1], Kneigh[1], Aneigh[1];
+        this->setT(this->thermalModel(0, Tneigh, Kneigh, Aneigh, therm.time)); //!< the 0 signals there are no neighbours or parents
+      }
+
+      //!< control the cooling system
+      double Tlocal{ 0 };
+      for (auto &c : cells) Tlocal = std::max(Tlocal, c.Cell_t::T());
+      cool->control(Tlocal, this->getThotSpot());
+    }
+
+    Vmodule_valid = false; //!< we have changed the SOC/concentration, so the stored voltage is no longer valid
+
+    if (redistributeCurrent() != Status::Success)
+      throw 100000; //!< same error as Module_p::timeStep_CC
+  }
+
+  Module_p_T *copy() override { return new Module_p_T(*this); }
+};
+} // namespace slide
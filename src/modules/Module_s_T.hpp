@@ -0,0 +1,207 @@
+/*
+ * Module_s_T.hpp
+ *
+ * series-connected Module with cells of type Cell_t stored by value, e.g. Module_s_T<Cell_SPM>.
+ * Same behaviour as Module_s, see Module_T.hpp for the storage.
+ */
+
+#pragma once
+
+#include "Module_T.hpp"
+#include "../settings/settings.hpp"
+#include "../utility/utility.hpp"
+
+#include <string_view>
+#include <array>
+#include <iostream>
+#include <typeinfo>
+#include <algorithm>
+#include <cmath>
+
+namespace slide {
+template <typename Cell_t>
+class Module_s_T : public Module_T<Cell_t>
+{
+protected:
+  using Module_T<Cell_t>::cells, Module_T<Cell_t>::Rcontact, Module_T<Cell_t>::Vmodule, Module_T<Cell_t>::Vmodule_valid;
+  using Module_T<Cell_t>::therm, Module_T<Cell_t>::cool, Module_T<Cell_t>::par, Module_T<Cell_t>::parent, Module_T<Cell_t>::blockDegAndTherm;
+  using typename Module_T<Cell_t>::Cells_t;
+
+  bool validCells(Cells_t &cs, bool print) override
+  {
+    //!< cells in series carry the same current
+    for (size_t i = 1; i < cs.size(); i++)
+      if (std::abs(cs[i].Cell_t::I() - cs[0].Cell_t::I()) > settings::MODULE_P_I_ABSTOL) {
+        if constexpr (settings::printBool::printCrit)
+          if (print)
+            std::cerr << "ERROR in Module_s_T::validCells, cell " << i << " has a current of " << cs[i].Cell_t::I()
+                      << "A while cell 0 has a current of " << cs[0].Cell_t::I() << "A.\n";
+        return false;
+      }
+    return true;
+  }
+
+public:
+  Module_s_T() : Module_T<Cell_t>() { this->setID("moduleS"); }
+  Module_s_T(std::string_view ID_, double Ti, bool print, bool pari, int Ncells_, int coolControl, int cooltype)
+    : Module_T<Cell_t>(ID_, Ti, print, pari, Ncells_, coolControl, cooltype) {}
+
+  //!< Since cells are in series following functions are just sum.
+  double Vmin() const override
+  {
+    double v{ 0 };
+    for (const auto &c : cells) v += c.Cell_t::Vmin();
+    return v;
+  }
+
+  double VMIN() const override
+  {
+    double v{ 0 };
+    for (const auto &c : cells) v += c.Cell_t::VMIN();
+    return v;
+  }
+
+  double Vmax() const override
+  {
+    double v{ 0 };
+    for (const auto &c : cells) v += c.Cell_t::Vmax();
+    return v;
+  }
+
+  double VMAX() const override
+  {
+    double v{ 0 };
+    for (const auto &c : cells) v += c.Cell_t::VMAX();
+    return v;
+  }
+
+  double I() const override { return cells.empty() ? 0 : cells[0].Cell_t::I(); } //!< the current is the same in all cells
+
+  double Cap() const override //!< module capacity is the capacity of the smallest cell
+  {
+    if (cells.empty()) return 0;
+
+    double cap = cells[0].Cell_t::Cap();
+    for (const auto &c : cells) cap = std::min(cap, c.Cell_t::Cap());
+    return cap;
+  }
+
+  double getOCV() override
+  {
+    double ocv{ 0 };
+    for (auto &c : cells) ocv += c.Cell_t::getOCV();
+    return ocv;
+  }
+
+  double getRtot() override
+  {
+    double rtot{ 0 };
+    for (size_t i = 0; i < cells.size(); i++)
+      rtot += cells[i].Cell_t::getRtot() + Rcontact[i];
+    return rtot;
+  }
+
+  double V() override
+  {
+    //!< sum of the voltage of all cells
+    if (Vmodule_valid)
+      return Vmodule;
+
+    Vmodule = 0;
+    for (size_t i = 0; i < cells.size(); i++) {
+      const auto v_i = cells[i].Cell_t::V();
+
+      if (v_i <= 0) //!< cell has an invalid voltage.
+        return 0;
+
+      Vmodule += v_i - Rcontact[i] * cells[i].Cell_t::I();
+    }
+
+    Vmodule_valid = true;
+    return Vmodule;
+  }
+
+  Status setCurrent(double Inew, bool checkV = true, bool print = true) override
+  {
+    /*
+     * Set the same current in all cells, see Module_s::setCurrent.
+     * If a cell fails, the old currents are restored.
+     */
+    const bool verb = print && (settings::printBool::printCrit);
+    Vmodule_valid = false; //!< we are changing the current, so the stored voltage is no longer valid
+
+    std::array<double, settings::MODULE_NSUs_MAX> Iolds;
+    for (size_t i = 0; i < cells.size(); i++) {
+      Iolds[i] = cells[i].Cell_t::I();
+      const auto status = cells[i].Cell_t::setCurrent(Inew, checkV, print);
+
+      if (isStatusBad(status)) {
+        if (verb)
+          std::cerr << "ERROR in Module_s_T::setCurrent when setting the current of cell " << i
+                    << " with id " << cells[i].getFullID() << " for Inew = " << Inew
+                    << ". Restoring the old currents and throwing on error " << getStatusMessage(status) << '\n';
+
+        for (size_t j = 0; j < i; j++)
+          cells[j].Cell_t::setCurrent(Iolds[j], false, false);
+
+        return status;
+      }
+    }
+
+    return Status::Success;
+  }
+
+  void timeStep_CC(double dt, int nstep = 1) override
+  {
+    /*
+     * a time step at constant current is simply a time step of every individual cell, see Module_s::timeStep_CC
+     *
+     * THROWS
+     * 10 	negative time step
+     * 14 	this module has no parent (i.e. is top level) but does not have an HVAC coolsystem
+     */
+    if (dt < 0) {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "ERROR in Module_s_T::timeStep_CC, the time step dt must be 0 or positive, but has value " << dt << '\n';
+      throw 10;
+    }
+
+    auto task_indv = [&](int i) { cells[i].Cell_t::timeStep_CC(dt, nstep); };
+
+    try {
+      run(task_indv, cells.size(), (par ? -1 : 1));
+    } catch (int e) {
+      std::cout << "Error in Module_s_T::timeStep_CC with module ID " << this->getFullID()
+                << ". error " << e << ", throwing it on.\n";
+      throw e;
+    }
+
+    if (!blockDegAndTherm) {
+      therm.time += nstep * dt;
+      const double Icell = I();
+      for (const auto r : Rcontact)
+        therm.Qcontact += r * sqr(Icell) * nstep * dt; //!< each resistor sees the total module current
+
+      if (!parent) { //!< top-level module, exchanges heat with the environment through its HVAC coolsystem
+        if (typeid(*this->getCoolSystem()) != typeid(CoolSystem_HVAC)) {
+          std::cerr << "ERROR in Module_s_T::timeStep_CC in module " << this->getFullID() << ". this is a top-level"
+                    << " module but does not have an HVAC coolsystem for active cooling with the environment.\n";
+          throw 14;
+        }
+
+        double Tneigh[1], Kneigh[1], Aneigh[1];
+        this->setT(this->thermalModel(0, Tneigh, Kneigh, Aneigh, therm.time)); //!< the 0 signals there are no neighbours or parents
+      }
+
+      //!< control the cooling system
+      double Tlocal{ 0 };
+      for (auto &c : cells) Tlocal = std::max(Tlocal, c.Cell_t::T());
+      cool->control(Tlocal, this->getThotSpot());
+    }
+
+    Vmodule_valid = false; //!< we have changed the SOC/concentration, so the stored voltage is no longer valid
+  }
+
+  Module_s_T *copy() override { return new Module_s_T(*this); }
+};
+} // namespace slide
@@ -0,0 +1,411 @@
+/*
+ * Module_s_clustered.cpp
+ *
+ * series-connected Module with representative-cell clustering
+ */
+
+#include "Module_s_clustered.hpp"
+#include "../cells/Cell.hpp"
+#include "../utility/utility.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+namespace slide {
+
+Module_s_clustered::Feature_t Module_s_clustered::getFeatures(const SU_t &su)
+{
+  /*
+   * Normalised features of a cell, two cells with a distance <= 1 may be represented by the same cell.
+   * Child modules can't be represented by another SU, they get a feature which is far away from all other SUs.
+   */
+  auto cell = dynamic_cast<Cell *>(su.get());
+  if (!cell)
+    return { std::numeric_limits<double>::max(), 0, 0, 0, 0, 0 };
+
+  const auto [var_cap, var_R, var_degSEI, var_degLAM] = cell->getVariations();
+  return { var_cap / cpar.tol_cap, var_R / cpar.tol_R, var_degSEI / cpar.tol_deg,
+           var_degLAM / cpar.tol_deg, cell->SOC() / cpar.tol_SOC, cell->T() / cpar.tol_T };
+}
+
+double Module_s_clustered::distance(const Feature_t &a, const Feature_t &b) const noexcept
+{
+  double d{ 0 };
+  for (size_t i = 0; i < a.size(); i++)
+    d = std::max(d, std::abs(a[i] - b[i]));
+
+  return d;
+}
+
+void Module_s_clustered::setSUs(SUs_span_t c, bool checkCells, bool print)
+{
+  /*
+   * Cluster the cells in c and connect the representatives and sentinels to this module.
+   * The other cells are not simulated, they are only remembered by their features.
+   * The contact resistances of all original cells are reset to 0.
+   *
+   * Clustering is done with the leader algorithm:
+   * a cell joins the first cluster whose representative is within distance 1, else it starts a new cluster.
+   */
+  feat.clear();
+  clusters.clear();
+  for (const auto &su : c)
+    feat.push_back(getFeatures(su));
+
+  for (size_t i = 0; i < c.size(); i++) {
+    auto it = std::find_if(clusters.begin(), clusters.end(),
+                           [&](const Cluster &cl) { return distance(feat[cl.rep_member], feat[i]) <= 1; });
+
+    if (it == clusters.end()) {
+      clusters.emplace_back();
+      clusters.back().rep_member = i;
+      it = clusters.end() - 1;
+    }
+
+    it->members.push_back(i);
+  }
+
+  //!< The sentinel of each cluster is the member furthest away from the representative
+  for (auto &cl : clusters) {
+    double dmax{ 0 };
+    for (const auto m : cl.members)
+      if (m != cl.rep_member && distance(feat[m], feat[cl.rep_member]) >= dmax) {
+        dmax = distance(feat[m], feat[cl.rep_member]);
+        cl.sent_member = m;
+      }
+  }
+
+  //!< Connect the simulated SUs to this module
+  std::vector<SU_t> simulated;
+  for (auto &cl : clusters) {
+    cl.rep = simulated.size();
+    simulated.push_back(std::move(c[cl.rep_member]));
+
+    if (cl.sent_member != npos) {
+      cl.sent = simulated.size();
+      simulated.push_back(std::move(c[cl.sent_member]));
+    }
+  }
+
+  Module::setSUs(simulated, checkCells, print);
+
+  spare.clear();
+  for (auto &su : c) //!< the simulated cells were moved out
+    spare.push_back(std::move(su));
+
+  Rc_member.assign(c.size(), 0);
+  Ncells = c.size();
+  updateWeights();
+
+  if constexpr (settings::printBool::printNonCrit)
+    if (print)
+      std::cout << "Module_s_clustered " << getFullID() << " represents " << Ncells << " cells with "
+                << clusters.size() << " clusters and " << getNSUs() << " simulated cells.\n";
+}
+
+void Module_s_clustered::setRcontact(std::span<double> Rc)
+{
+  assert(Rc.size() == Rc_member.size());
+  std::copy(Rc.begin(), Rc.end(), Rc_member.begin());
+  updateWeights();
+}
+
+void Module_s_clustered::updateWeights()
+{
+  /*
+   * A representative stands for all members except the sentinel.
+   * The contact resistances of the members are lumped in the SU which stands for them.
+   */
+  w.assign(getNSUs(), 0);
+  Rcontact.assign(getNSUs(), 0);
+
+  for (const auto &cl : clusters)
+    for (const auto m : cl.members) {
+      const auto i = (m == cl.sent_member) ? cl.sent : cl.rep;
+      w[i] += 1;
+      Rcontact[i] += Rc_member[m];
+    }
+
+  Vmodule_valid = false;
+}
+
+double Module_s_clustered::Vmin() const
+{
+  double v{ 0 };
+  for (size_t i = 0; i < SUs.size(); i++)
+    v += w[i] * SUs[i]->Vmin();
+  return v;
+}
+
+double Module_s_clustered::VMIN() const
+{
+  double v{ 0 };
+  for (size_t i = 0; i < SUs.size(); i++)
+    v += w[i] * SUs[i]->VMIN();
+  return v;
+}
+
+double Module_s_clustered::Vmax() const
+{
+  double v{ 0 };
+  for (size_t i = 0; i < SUs.size(); i++)
+    v += w[i] * SUs[i]->Vmax();
+  return v;
+}
+
+double Module_s_clustered::VMAX() const
+{
+  double v{ 0 };
+  for (size_t i = 0; i < SUs.size(); i++)
+    v += w[i] * SUs[i]->VMAX();
+  return v;
+}
+
+double Module_s_clustered::getOCV()
+{
+  double ocv{ 0 };
+  for (size_t i = 0; i < getNSUs(); i++)
+    ocv += w[i] * SUs[i]->getOCV();
+  return ocv;
+}
+
+double Module_s_clustered::getRtot()
+{
+  double rtot{ 0 };
+  for (size_t i = 0; i < getNSUs(); i++)
+    rtot += w[i] * SUs[i]->getRtot() + Rcontact[i];
+  return rtot;
+}
+
+double Module_s_clustered::V()
+{
+  //!< weighted sum of the voltage of all simulated cells
+  if (Vmodule_valid)
+    return Vmodule;
+
+  Vmodule = 0;
+  for (size_t i = 0; i < getNSUs(); i++) {
+    const auto v_i = SUs[i]->V();
+
+    if (v_i <= 0) //!< SU has an invalid voltage.
+      return 0;
+
+    Vmodule += w[i] * v_i - Rcontact[i] * SUs[i]->I();
+  }
+
+  Vmodule_valid = true;
+  return Vmodule;
+}
+
+void Module_s_clustered::timeStep_CC(double dt, int nstep)
+{
+  Module_s::timeStep_CC(dt, nstep);
+  checkClusters();
+}
+
+void Module_s_clustered::checkClusters()
+{
+  /*
+   * Measure the divergence between the sentinel and the representative of each cluster
+   * and split the clusters where it is too large.
+   */
+  for (size_t k = 0; k < clusters.size(); k++) {
+    auto &cl = clusters[k];
+    if (cl.sent == npos)
+      continue;
+
+    auto rep = dynamic_cast<Cell *>(SUs[cl.rep].get());
+    auto sent = dynamic_cast<Cell *>(SUs[cl.sent].get());
+    cl.dV = cl.dV0 + std::abs(sent->V() - rep->V());
+    cl.dSOC = cl.dSOC0 + std::abs(sent->SOC() - rep->SOC());
+
+    if (cl.dV > cpar.dV_split || cl.dSOC > cpar.dSOC_split)
+      split(k); //!< appends a cluster, which is checked in this loop as well
+  }
+}
+
+void Module_s_clustered::split(size_t k)
+{
+  /*
+   * Split cluster k in two: the members closer to the sentinel than to the representative form a new cluster
+   * with the sentinel as representative. The divergence of both clusters is extrapolated linearly with the distance
+   * of their furthest member, which becomes their new sentinel (see setSentinel).
+   */
+  auto &cl = clusters[k];
+  const auto &f_rep = feat[cl.rep_member];
+  const auto &f_sent = feat[cl.sent_member];
+  const double d_rs = std::max(distance(f_rep, f_sent), 1e-12);
+
+  Cluster cl_new;
+  cl_new.rep = cl.sent;
+  cl_new.rep_member = cl.sent_member;
+
+  std::vector<size_t> members_old;
+  double dmax_old{ 0 }, dmax_new{ 0 };
+  for (const auto m : cl.members) {
+    const double d_rep = distance(feat[m], f_rep), d_sent = distance(feat[m], f_sent);
+    if (d_sent < d_rep || m == cl.sent_member) {
+      cl_new.members.push_back(m);
+      dmax_new = std::max(dmax_new, d_sent);
+    } else {
+      members_old.push_back(m);
+      dmax_old = std::max(dmax_old, d_rep);
+    }
+  }
+
+  cl_new.dV = cl.dV * dmax_new / d_rs;
+  cl_new.dSOC = cl.dSOC * dmax_new / d_rs;
+  cl.dV *= dmax_old / d_rs;
+  cl.dSOC *= dmax_old / d_rs;
+  cl.members = std::move(members_old);
+  cl.sent = cl.sent_member = npos;
+
+  if constexpr (settings::printBool::printNonCrit)
+    std::cout << "Module_s_clustered " << getFullID() << " splits a cluster of " << cl.members.size() + cl_new.members.size()
+              << " cells into " << cl.members.size() << " and " << cl_new.members.size() << " cells.\n";
+
+  setSentinel(cl);
+  setSentinel(cl_new);
+  clusters.push_back(std::move(cl_new)); //!< invalidates cl
+  updateWeights();
+}
+
+void Module_s_clustered::setSentinel(Cluster &cl)
+{
+  /*
+   * Make the member furthest away from the representative the sentinel of cl, cl must not have a sentinel.
+   * The member was represented so far, so it starts from the states of the representative but keeps its own parameters.
+   * The divergence it measures is added to the current (extrapolated) divergence of the cluster.
+   * A cluster of one cell, or a module which can't have more SUs, gets no sentinel.
+   */
+  double dmax{ 0 };
+  size_t m_sent{ npos };
+  for (const auto m : cl.members)
+    if (m != cl.rep_member && spare[m] && distance(feat[m], feat[cl.rep_member]) >= dmax) {
+      dmax = distance(feat[m], feat[cl.rep_member]);
+      m_sent = m;
+    }
+
+  if (m_sent == npos || getNSUs() >= static_cast<size_t>(settings::MODULE_NSUs_MAX))
+    return;
+
+  auto &sent = spare[m_sent];
+  std::vector<double> st;
+  SUs[cl.rep]->getStates(st);
+  std::span<double> spn{ st };
+  if (isStatusBad(sent->setStates(spn, false, false)))
+    return;
+
+  sent->setParent(this);
+  cl.sent = SUs.size();
+  cl.sent_member = m_sent;
+  SUs.push_back(std::move(sent));
+  Rcontact.push_back(0); //!< set by updateWeights
+  cl.dV0 = cl.dV;
+  cl.dSOC0 = cl.dSOC;
+
+  s_rollback.clear();
+  getStates(s_rollback); //!< reserve the rollback buffer of setStates for the extra SU
+}
+
+ClusterError Module_s_clustered::getClusterError() const
+{
+  /*
+   * The sentinel is the member furthest away from the representative, so every member the representative stands for
+   * deviates at most dV from it. Summing this for all represented members bounds the error in the module voltage.
+   */
+  ClusterError err{ Ncells, clusters.size(), SUs.size() };
+  for (const auto &cl : clusters) {
+    const double Nrepresented = w[cl.rep] - 1; //!< the representative itself is simulated exactly
+    err.dV += Nrepresented * cl.dV;
+    err.dSOC = std::max(err.dSOC, cl.dSOC);
+  }
+
+  return err;
+}
+
+double Module_s_clustered::thermalModel(int Nneighbours, double Tneighbours[], double Kneighbours[], double Aneighb[], double tim)
+{
+  //!< without coupling, every cell only depends on its own heat generation so clustering makes no difference
+  if constexpr (settings::T_MODEL != 2)
+    return Module::thermalModel(Nneighbours, Tneighbours, Kneighbours, Aneighb, tim);
+  else {
+    double Tout;
+    try {
+      Tout = thermalModel_clustered(Nneighbours, Tneighbours, Kneighbours, Aneighb, tim);
+    } catch (int e) {
+      therm.time = 0;
+      therm.Qcontact = 0;
+      throw e;
+    }
+
+    //!< Reset the cumulative thermal variables
+    therm.time = 0;
+    therm.Qcontact = 0;
+    return Tout;
+  }
+}
+
+double Module_s_clustered::thermalModel_clustered(int Nneighbours, double Tneighbours[], double Kneighbours[], double Aneighb[], double tim)
+{
+  /*
+   * Same as Module::thermalModel_coupled but for clusters: the members of a cluster are not located next to each other,
+   * so a simulated cell only exchanges heat with the coolant (its neighbours are assumed to be at its own temperature).
+   * The heat extracted by the coolant is weighted by the number of cells each simulated cell stands for.
+   *
+   * throws
+   * 98 	invalid time keeping
+   * 99 	invalid module temperature
+   */
+  if (std::abs(therm.time - tim) > 1) {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "ERROR in Module_s_clustered::thermalModel of SU " << getFullID() << ", according to the internal timing, "
+                << therm.time << "s have passed since the last thermal model solution. The external time provided was "
+                << tim << "s, which is more than 1s difference. Throwing an error.\n";
+    throw 98;
+  }
+
+  if (tim == 0)
+    return T();
+
+  std::vector<double> Tnew(getNSUs());
+  double Tsu[3], Ksu[3], Asu[3]; //!< parent, left neighbour, right neighbour
+  Tsu[0] = T();
+  Ksu[0] = cool->getH();
+  Asu[0] = therm.A;
+  Ksu[1] = Ksu[2] = therm.k_cell2cell;
+
+  double Etot{ 0 };
+  for (size_t i = 0; i < getNSUs(); i++) {
+    Tsu[1] = Tsu[2] = SUs[i]->T();
+    Asu[1] = Asu[2] = SUs[i]->getThermalSurface();
+    Tnew[i] = SUs[i]->thermalModel(3, Tsu, Ksu, Asu, tim);
+
+    const double Atherm = std::min(Asu[0], SUs[i]->getThermalSurface());
+    Etot += w[i] * Ksu[0] * Atherm * (SUs[i]->T() - T()) * tim;
+  }
+
+  Etot += therm.Qcontact;
+  const double Echildren = Etot;
+
+  for (int i = 0; i < Nneighbours; i++)
+    Etot += Kneighbours[i] * std::min(Aneighb[i], therm.A) * (Tneighbours[i] - T()) * tim;
+
+  const double Tcool_new = cool->dstate(Etot, Echildren, tim);
+
+  for (size_t i = 0; i < getNSUs(); i++)
+    SUs[i]->setT(Tnew[i]);
+
+  if (Tcool_new < PhyConst::Kelvin || Tcool_new > PhyConst::Kelvin + 75.0 || std::isnan(Tcool_new)) {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "ERROR in Module_s_clustered::thermalModel of SU " << getFullID() << ", the new temperature of "
+                << Tcool_new << " is outside the allowed range from (273+0) K to (273+75) K.\n";
+    throw 99;
+  }
+
+  return Tcool_new;
+}
+} // namespace slide
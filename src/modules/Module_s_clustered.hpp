@@ -0,0 +1,120 @@
+/*
+ * Module_s_clustered.hpp
+ *
+ * series-connected Module which simulates K representative cells instead of all N cells.
+ *
+ * Cells with similar parameters (cell-to-cell variations of capacity, resistance and degradation rate) and states (SOC, T)
+ * are grouped into a cluster. Per cluster two cells are simulated:
+ * 		the representative, which is the first cell of the cluster and stands for all members except the sentinel
+ * 		the sentinel, which is the member furthest away from the representative
+ * The voltage, OCV, resistance, voltage limits and heat of a representative are weighted by the number of members it stands for.
+ * All cells in a series module carry the same current, so the current needs no weighting.
+ *
+ * The sentinel is a real member, so the difference between the sentinel and the representative bounds how far the
+ * members of a cluster have diverged. If this difference grows above the thresholds in ClusterParam, the cluster is split
+ * in two: the members closest to the sentinel get the sentinel as their representative.
+ * Both clusters then get the member furthest away from their representative as new sentinel. This cell was not simulated yet,
+ * so it starts from the states of the representative with its own parameters. The divergence at the split is extrapolated
+ * with the distance of the new sentinel, and the sentinel measures how much the cluster diverges after the split.
+ * The cells which are not simulated are kept, so they can become a sentinel later.
+ *
+ * Clustering is done per module, so temperature differences between modules (e.g. thermal gradients in the pack)
+ * are resolved by the module hierarchy itself.
+ */
+
+#pragma once
+
+#include "Module_s.hpp"
+#include "../settings/settings.hpp"
+#include "../utility/utility.hpp"
+
+#include <array>
+#include <vector>
+#include <span>
+#include <string_view>
+#include <limits>
+
+namespace slide {
+
+struct ClusterParam
+{
+  //!< cells whose parameters and states differ less than these values from the representative are put in the same cluster
+  double tol_cap{ 0.004 }; //!< relative capacity [-]
+  double tol_R{ 0.025 };   //!< relative resistance [-]
+  double tol_deg{ 0.1 };   //!< relative degradation rate of SEI growth and LAM [-]
+  double tol_SOC{ 0.01 };  //!< state of charge [-]
+  double tol_T{ 1 };       //!< temperature [K]
+
+  //!< a cluster is split if its sentinel diverges more than these values from its representative
+  double dV_split{ 0.01 };   //!< voltage [V]
+  double dSOC_split{ 0.01 }; //!< state of charge [-]
+};
+
+struct ClusterError
+{
+  size_t Ncells{};     //!< number of cells in the module
+  size_t Nclusters{};  //!< number of clusters
+  size_t Nsimulated{}; //!< number of simulated cells (representatives and sentinels)
+  double dV{};         //!< estimated upper bound on the error of the module voltage w.r.t. simulating all cells [V]
+  double dSOC{};       //!< estimated largest deviation between the SOC of a member and its representative [-]
+};
+
+class Module_s_clustered : public Module_s
+{
+public:
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+  using Feature_t = std::array<double, 6>; //!< normalised capacity, resistance, SEI and LAM rate, SOC and T
+
+protected:
+  struct Cluster
+  {
+    size_t rep{}, sent{ npos };               //!< index of the representative and sentinel in SUs (npos if no sentinel)
+    size_t rep_member{}, sent_member{ npos }; //!< index of the representative and sentinel in the original cells
+    std::vector<size_t> members;              //!< indices of the original cells of this cluster
+    double dV{}, dSOC{};                      //!< divergence of the members (measured if there is a sentinel, extrapolated otherwise)
+    double dV0{}, dSOC0{};                    //!< divergence when the sentinel was chosen, the sentinel measures the divergence since then
+  };
+
+  ClusterParam cpar{};
+  std::vector<Cluster> clusters;
+  std::vector<Feature_t> feat;   //!< features of the original cells
+  std::vector<double> Rc_member; //!< contact resistance of the original cells
+  std::vector<double> w;         //!< number of original cells each SU stands for
+  std::vector<SU_t> spare;       //!< original cells which are not simulated (null if the cell is simulated)
+
+  Feature_t getFeatures(const SU_t &su);
+  double distance(const Feature_t &a, const Feature_t &b) const noexcept; //!< max-norm, <= 1 means the same cluster
+  void updateWeights();                                                   //!< calculate w and Rcontact from the clusters
+  void split(size_t k);                                                   //!< split cluster k in two
+  void setSentinel(Cluster &cl);                                          //!< simulate the member furthest away from the representative
+  void checkClusters();                                                   //!< measure the divergence and split clusters if needed
+
+  double thermalModel_clustered(int Nneighbours, double Tneighbours[], double Kneighbours[], double Aneighb[], double tim);
+
+public:
+  Module_s_clustered() : Module_s() {}
+  Module_s_clustered(std::string_view ID_, double Ti, bool print, bool pari, int Ncells_, int coolControl, int cooltype, ClusterParam cpar_ = {})
+    : Module_s(ID_, Ti, print, pari, Ncells_, coolControl, cooltype), cpar(cpar_) {}
+
+  void setSUs(SUs_span_t c, bool checkCells = true, bool print = true) override; //!< cluster the cells c, only the representatives and sentinels are kept
+  void setRcontact(std::span<double> Rc) override;                                //!< Rc has one value per original cell
+
+  double Vmin() const override;
+  double VMIN() const override;
+  double Vmax() const override;
+  double VMAX() const override;
+
+  double getOCV() override;
+  double getRtot() override;
+  double V() override;
+
+  double thermalModel(int Nneighbours, double Tneighbours[], double Kneighbours[], double Aneighb[], double tim) override;
+  void timeStep_CC(double dt, int steps = 1) override;
+
+  size_t getNclusters() const noexcept { return clusters.size(); }
+  const auto &getWeights() const noexcept { return w; }
+  ClusterError getClusterError() const; //!< estimate of the error w.r.t. simulating every cell
+
+  Module_s_clustered *copy() override { return new Module_s_clustered(*this); }
+};
+} // namespace slide
@@ -12,4 +12,7 @@
 #pragma once
 
 #include "Module_s.hpp"
+#include "Module_s_clustered.hpp"
 #include "Module_p.hpp"
+#include "Module_s_T.hpp"
+#include "Module_p_T.hpp"
@@ -0,0 +1,229 @@
+/*
+ * Checkpoint.cpp
+ *
+ * Binary checkpoint of a storage unit and the progress of an ageing procedure, see Checkpoint.hpp
+ */
+
+#include "Checkpoint.hpp"
+#include "procedure_util.hpp"
+#include "../utility/io/MappedFile.hpp"
+#include "../settings/settings.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <array>
+#include <algorithm>
+
+namespace slide {
+
+namespace {
+  constexpr std::array<char, 8> magic{ 'S', 'L', 'I', 'D', 'E', 'C', 'K', 'P' };
+  constexpr uint32_t byteOrder{ 0x01020304 }; //!< reads differently if the checkpoint was written on a machine with another byte order
+
+  constexpr uint32_t makeTag(const char (&c)[5])
+  {
+    return uint32_t(c[0]) | (uint32_t(c[1]) << 8) | (uint32_t(c[2]) << 16) | (uint32_t(c[3]) << 24);
+  }
+
+  constexpr uint32_t tag_tree = makeTag("TREE"), tag_states = makeTag("STAT");
+  constexpr uint32_t tag_nodes = makeTag("NODE"), tag_procedure = makeTag("PROC");
+
+  template <typename T>
+  void append(std::vector<char> &b, const T &x)
+  {
+    const auto n = b.size();
+    b.resize(n + sizeof(T));
+    std::memcpy(b.data() + n, &x, sizeof(T));
+  }
+
+  void appendSection(std::vector<char> &b, uint32_t tag, std::span<const double> d)
+  {
+    append(b, tag);
+    append(b, uint32_t{ 0 });
+    append(b, uint64_t{ d.size() });
+
+    const auto n = b.size();
+    b.resize(n + d.size_bytes());
+    std::memcpy(b.data() + n, d.data(), d.size_bytes());
+  }
+
+  std::array<double, 3> getTree(StorageUnit *su, size_t Nstates)
+  {
+    size_t Nnodes{ 0 };
+    visit_SUs(su, [&](auto) { Nnodes++; });
+    return { static_cast<double>(Nnodes), static_cast<double>(su->getNcells()), static_cast<double>(Nstates) };
+  }
+} // namespace
+
+Checkpoint::~Checkpoint()
+{
+  try {
+    wait();
+  } catch (int e) {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "ERROR in Checkpoint::~Checkpoint, the last checkpoint could not be written to " << name
+                << ", error " << e << ".\n";
+  }
+}
+
+void Checkpoint::wait()
+{
+  if (pending.valid())
+    pending.get(); //!< rethrows the error of the writing thread
+}
+
+void Checkpoint::serialise(StorageUnit *su, const CheckpointProcedure &proc)
+{
+  buf.clear(); //!< keeps its capacity
+  append(buf, magic);
+  append(buf, version_major);
+  append(buf, version_minor);
+  append(buf, byteOrder);
+  append(buf, uint32_t{ 0 });
+  append(buf, uint64_t{ 4 }); //!< number of sections
+
+  s.clear();
+  su->getStates(s);
+  const auto tree = getTree(su, s.size());
+  appendSection(buf, tag_tree, tree);
+  appendSection(buf, tag_states, s);
+
+  s.clear();
+  getCheckpoints(su, s);
+  appendSection(buf, tag_nodes, s);
+
+  s.clear();
+  s.push_back(proc.cycle);
+  s.insert(s.end(), proc.th.begin(), proc.th.end());
+  for (const auto &t : proc.throughput)
+    s.insert(s.end(), { t.charge, t.energy, t.coolSystemLoad, t.convloss });
+  appendSection(buf, tag_procedure, s);
+}
+
+void Checkpoint::write(StorageUnit *su, const CheckpointProcedure &proc)
+{
+  /*
+   * Write a checkpoint of su and proc.
+   * The states are copied into a buffer on this thread, after which the simulation can continue
+   * while the buffer is written to a temporary file on a separate thread.
+   * The temporary file is then renamed, so there is always one complete checkpoint on disk.
+   *
+   * THROWS (on this thread when the previous write failed, else by wait() or the next write)
+   * 11 	the checkpoint file could not be written
+   */
+  wait(); //!< normally long finished, the previous write owns buf until then
+  serialise(su, proc);
+
+  pending = std::async(std::launch::async, [this]() {
+    auto tmp = name;
+    tmp += ".tmp";
+
+    std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+    file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    file.close();
+
+    std::error_code ec;
+    if (file.fail() || (std::filesystem::rename(tmp, name, ec), ec)) {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "ERROR in Checkpoint::write, could not write the checkpoint file " << name << ".\n";
+      throw 11;
+    }
+  });
+}
+
+bool Checkpoint::read(StorageUnit *su, CheckpointProcedure &proc)
+{
+  /*
+   * Restore the states of su and its nodes, and the progress of the procedure from the checkpoint file.
+   * The file is memory mapped, so the sections are read straight from the page cache.
+   *
+   * OUT
+   * returns false if there is no checkpoint file, su and proc are not changed
+   *
+   * THROWS
+   * 2 	the file could not be opened
+   * 3 	the file is not a valid checkpoint (wrong magic number or byte order, or truncated)
+   * 4 	the checkpoint has a different major version
+   * 5 	the checkpoint is of a storage unit with a different configuration
+   */
+  wait(); //!< the last write must be on disk
+  if (!exists()) return false;
+
+  const MappedFile file(name);
+  auto b = file.bytes();
+
+  auto invalid = [&](const char *why) {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "ERROR in Checkpoint::read, " << name << " is not a valid checkpoint: " << why << ".\n";
+    throw 3;
+  };
+
+  auto get = [&](auto &x) {
+    if (b.size() < sizeof(x)) invalid("the file is truncated");
+    std::memcpy(&x, b.data(), sizeof(x));
+    b = b.subspan(sizeof(x));
+  };
+
+  std::array<char, 8> magic_file;
+  uint32_t major, minor, order, reserved;
+  uint64_t Nsections;
+  get(magic_file);
+  if (magic_file != magic) invalid("wrong magic number");
+
+  get(major);
+  get(minor);
+  get(order);
+  get(reserved);
+  get(Nsections);
+  if (order != byteOrder) invalid("written on a machine with a different byte order");
+
+  if (major != version_major) {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "ERROR in Checkpoint::read, " << name << " has version " << major << '.' << minor
+                << " which can't be read by version " << version_major << '.' << version_minor << ".\n";
+    throw 4;
+  }
+
+  for (uint64_t k = 0; k < Nsections; k++) {
+    uint32_t tag;
+    uint64_t N;
+    get(tag);
+    get(reserved);
+    get(N);
+
+    if (b.size() / sizeof(double) < N) invalid("the file is truncated");
+    s.resize(N); //!< the mapped bytes do not need to be aligned, so copy them into a buffer of doubles
+    std::memcpy(s.data(), b.data(), N * sizeof(double));
+    b = b.subspan(N * sizeof(double));
+
+    if (tag == tag_tree) {
+      std::vector<double> sc;
+      su->getStates(sc);
+      const auto tree = getTree(su, sc.size());
+      if (!std::equal(tree.begin(), tree.end(), s.begin(), s.end())) {
+        if constexpr (settings::printBool::printCrit)
+          std::cerr << "ERROR in Checkpoint::read, " << name << " is of a storage unit with a different configuration than "
+                    << su->getFullID() << ".\n";
+        throw 5;
+      }
+    } else if (tag == tag_states) {
+      std::span<double> spn{ s };
+      if (!setStates_unchecked(su, spn)) invalid("the states do not fit the storage unit");
+    } else if (tag == tag_nodes) {
+      setCheckpoints(su, s);
+    } else if (tag == tag_procedure) {
+      std::span<double> spn{ s };
+      free::pop_checkpoint(spn, proc.cycle);
+      for (auto &x : proc.th)
+        free::pop_checkpoint(spn, x);
+
+      proc.throughput.clear();
+      for (; spn.size() >= 4; spn = spn.subspan(4))
+        proc.throughput.push_back({ spn[0], spn[1], spn[2], spn[3] });
+    } //!< unknown sections were added by a newer minor version and are skipped
+  }
+
+  return true;
+}
+} // namespace slide
@@ -0,0 +1,71 @@
+/*
+ * Checkpoint.hpp
+ *
+ * Binary checkpoint of a storage unit and the progress of an ageing procedure, to restart long simulations.
+ *
+ * File layout (native byte order, all fields 8-byte aligned):
+ * 	header 	"SLIDECKP", uint32 major version, uint32 minor version, uint32 byte order marker, uint32 reserved, uint64 number of sections
+ * 	section uint32 tag, uint32 reserved, uint64 number of doubles, followed by the doubles
+ *
+ * Sections:
+ * 	TREE 	number of nodes, cells and states of the storage unit, to check the checkpoint belongs to the same configuration
+ * 	STAT 	the states of the storage unit (getStates)
+ * 	NODE 	for every node of the tree (visit_SUs order) the length of its record followed by getCheckpoint
+ * 	PROC 	cycle number, throughput so far, and the throughput of each step of the procedure
+ *
+ * A different major version can't be read. A minor version may add sections (unknown tags are skipped)
+ * or append fields at the end of a record (readers leave missing fields at their current value).
+ *
+ * Not checkpointed: the usage statistics of cells and coolsystems (cellData, histograms; of a cell only the time of
+ * its last sample is kept) and the cluster structure of Module_s_clustered, which must be the same as when the checkpoint was written.
+ */
+
+#pragma once
+
+#include "../StorageUnit.hpp"
+#include "../types/data_storage/cell_data.hpp"
+
+#include <vector>
+#include <span>
+#include <filesystem>
+#include <future>
+#include <cstdint>
+
+namespace slide {
+
+struct CheckpointProcedure //!< progress of a procedure
+{
+  int cycle{ 0 };                                  //!< cycle at which the procedure continues
+  ThroughputData th{};                             //!< throughput so far
+  std::vector<ProcedureThroughputData> throughput; //!< throughput of each step so far
+};
+
+class Checkpoint
+{
+public:
+  static constexpr uint32_t version_major = 2; //!< increase if existing records change, older checkpoints become invalid
+  static constexpr uint32_t version_minor = 0; //!< increase if fields or sections are added
+
+private:
+  std::filesystem::path name;
+  std::vector<double> s;       //!< states / node records, reused between checkpoints
+  std::vector<char> buf;       //!< serialised checkpoint, owned by the writing thread until pending is finished
+  std::future<void> pending{}; //!< asynchronous write of buf
+
+  void serialise(StorageUnit *su, const CheckpointProcedure &proc);
+
+public:
+  Checkpoint() = default;
+  explicit Checkpoint(std::filesystem::path name_) : name(std::move(name_)) {}
+  Checkpoint(const Checkpoint &) = delete;
+  Checkpoint &operator=(const Checkpoint &) = delete;
+  ~Checkpoint();
+
+  const auto &getName() const { return name; }
+  bool exists() const { return !name.empty() && std::filesystem::exists(name); }
+
+  void write(StorageUnit *su, const CheckpointProcedure &proc); //!< serialise now and write the file on a separate thread
+  bool read(StorageUnit *su, CheckpointProcedure &proc);        //!< restore su and proc, false if there is no checkpoint
+  void wait();                                                  //!< wait until the last write is finished
+};
+} // namespace slide
@@ -6,9 +6,12 @@
  */
 
 #include "Cycler.hpp"
+#include "procedure_util.hpp"
 #include "../settings/settings.hpp"
 #include "../utility/utility.hpp"
 #include "../cells/cells.hpp"
+#include "../system/Battery.hpp"
+#include "../types/data_storage/PackDataStore.hpp"
 
 #include <iostream>
 #include <cmath>
@@ -16,8 +19,75 @@
 #include <string>
 #include <span>
 #include <algorithm>
+#include <type_traits>
+#include <vector>
 
 namespace slide {
+
+namespace {
+  constexpr int CC_nOnceMax = 20;            //!< maximum number of time steps taken at once in a CC phase
+  constexpr double event_tfrac = 0.5;        //!< take steps of this fraction of the predicted time until the voltage limit
+  constexpr double event_Vreltol = 1e-4;     //!< relative tolerance on the voltage at which a voltage limit is located
+  constexpr double event_Ireltol = 1e-3;     //!< relative tolerance on the current at which a current limit is located
+  constexpr double event_tminfrac = 1e-3;    //!< stop locating an event if the bracket is smaller than this fraction of dt
+  constexpr int event_maxIteration = 20;     //!< maximum number of iterations to locate an event
+  constexpr int rest_nOnceMax_current = 10;  //!< maximum number of time steps taken at once in rest while cells carry a current
+  constexpr double rest_tmax = 3600;         //!< maximum time [s] taken at once in rest while no cell carries a current
+  constexpr double rest_Irel = 1e-6;         //!< cell currents below this fraction of the capacity count as no current during rest
+  constexpr double rest_dTmax = 0.5;         //!< maximum temperature change [K] of steps taken at once in rest
+  constexpr double CV_Vreltol = 1e-5;        //!< relative tolerance on the voltage in a CV phase
+  constexpr int CV_maxCorrection = 2;        //!< Newton corrections of the current in a CV step before using setVoltage
+  constexpr double CV_dIrel_increase = 0.02; //!< take more steps at once in CV if the current changes less than this
+  constexpr double CV_dIrel_decrease = 0.1;  //!< take fewer steps at once in CV if the current changes more than this
+  constexpr double CP_Preltol = 1e-6;        //!< relative tolerance on the power in a CP phase
+  constexpr int CP_maxIteration = 20;        //!< maximum number of iterations to reach the power in a CP step
+
+  template <typename Fredo>
+  double locateEvent(double h, double g0, double gh, double tol, double tmin, Fredo &&redo)
+  {
+    /*
+     * Find the time in [0, h] at which the event function g crosses 0 with the Illinois method (regula falsi
+     * which halves the value at the end point which is retained twice in a row, so it converges superlinearly).
+     *
+     * IN
+     * g0, gh 	event function at the start and end of the step, they have a different sign
+     * tol 		stop if |g| < tol at a point past the event
+     * tmin 	stop if the bracket is smaller than tmin
+     * redo 	function which goes back to the start of the step, integrates for tau seconds and returns g(tau)
+     *
+     * OUT
+     * returns the time tau at which the SU is left, g(tau) has the same sign as gh, i.e. the event is just passed
+     */
+    double a{ 0 }, ga{ g0 }, b{ h }, gb{ gh }, gb_true{ gh };
+    int side{ 0 };     //!< +1 if the last point replaced b, -1 if it replaced a
+    bool atb{ false }; //!< the SU is at time b (rather than at the point evaluated last)
+
+    for (int iter = 0; iter < event_maxIteration && std::abs(gb_true) > tol && (b - a) > tmin; iter++) {
+      const double margin = 0.01 * (b - a);
+      const double tau = std::clamp(b - gb * (b - a) / (gb - ga), a + margin, b - margin);
+      const double g = redo(tau);
+
+      if ((g > 0) == (gh > 0)) { //!< past the event
+        b = tau;
+        gb = gb_true = g;
+        atb = true;
+        if (side == 1) ga /= 2;
+        side = 1;
+      } else {
+        a = tau;
+        ga = g;
+        atb = false;
+        if (side == -1) gb /= 2;
+        side = -1;
+      }
+    }
+
+    if (!atb) redo(b);
+
+    return b;
+  }
+} // namespace
+
 Cycler &Cycler::initialise(StorageUnit *sui, const std::string &IDi)
 {
   su = sui;
@@ -37,6 +107,16 @@ Cycler &Cycler::setDiagnostic(bool newDia)
   return *this;
 }
 
+Cycler &Cycler::setConverter(bool newConv)
+{
+  /*
+   * include the losses of the power electronic converter in the power of CP, i.e. the power is the power on the grid side.
+   * The connected storage unit must then be a Battery.
+   */
+  converter = newConv;
+  return *this;
+}
+
 int Cycler::writeData()
 {
   su->writeData(ID);
@@ -47,7 +127,9 @@ int Cycler::writeData()
 
 int Cycler::storeData()
 {
-  if (index >= settings::CELL_NDATA_MAX) // #TODO this one should not be here if we want to specialise every cell.
+  //!< the time data of all cells of a large pack is written before it outgrows the memory of the AsyncWriter
+  const size_t Nmax = settings::data::packCellData ? PackDataStore<Cell>::maxRows(su->getNcells()) : settings::CELL_NDATA_MAX;
+  if (index >= Nmax) // #TODO this one should not be here if we want to specialise every cell.
     writeData();
 
   su->storeData();
@@ -75,6 +157,17 @@ int Cycler::storeData()
  */
 Status Cycler::rest(double tlim, double dt, int ndt_data, ThroughputData &th)
 {
+  /*
+   * At rest, the number of time steps taken at once grows quickly, up to rest_tmax seconds at once.
+   * The diffusion models are still resolved every dt (SPM cells integrate them exactly at zero current),
+   * but the thermal and degradation models only once per nOnce * dt, so long rests and calendar ageing become cheap.
+   * Steps are only this long if no cell carries a current, e.g. parallel cells which are still equalising
+   * keep the old maximum of 10 steps at once.
+   * The bulk thermal model of the cells (T_MODEL 1) is solved exactly, so it is stable for steps of any length.
+   * A step in which the temperature of a cell changes by more than rest_dTmax is undone and repeated with half the number of steps,
+   * so the degradation models see the temperature of a cell which is cooling down or warming up.
+   * The coupled thermal model (T_MODEL 2) is explicit and only stable for short steps, so then rest keeps the old maximum.
+   */
   const bool boolStoreData = ndt_data > 0;
   //!< store data point
   if (boolStoreData) storeData();
@@ -84,14 +177,13 @@ Status Cycler::rest(double tlim, double dt, int ndt_data, ThroughputData &th)
   double ttot = 0;   //!< total time done
   int idat = 0;      //!< consecutive number of time steps done without storing data
   int nOnce = 1;     //!< number of time steps we take at once, will change dynamically
-  int nOnceMax = 10; //!< allow maximum this number of steps to be taken at once
-                     //!< careful with thermal stability. Thermal model only calculated every nOnce*dt
-                     //!< 	so that can be in the unstable region for large batteries with cooling systems
-                     //!< so don't have nOnceMax above 10 (even though once everything is in equilibrium, you could take much larger steps)
+  const int nOnceMax_rest = (settings::T_MODEL == 2) ? rest_nOnceMax_current
+                                                     : std::max(rest_nOnceMax_current, static_cast<int>(rest_tmax / dt)); //!< maximum if no cell carries a current
+  int nOnceMax = rest_nOnceMax_current; //!< allow maximum this number of steps to be taken at once while cells carry a current
+                                        //!< careful with thermal stability. Thermal model only calculated every nOnce*dt
+                                        //!< 	so that can be in the unstable region for large batteries with cooling systems
 
-  bool ninc = true; //!< can nonce increase this iteration?
-  if (boolStoreData)
-    nOnceMax = std::min(nOnceMax, ndt_data); //!< if we store data, never take more than the interval at which you want to store the voltage
+  std::vector<double> Tcells; //!< temperature of every cell at the start of a step
 
   Status succ = Status::Unknown_problem;
   //!< apply current
@@ -114,13 +206,34 @@ Status Cycler::rest(double tlim, double dt, int ndt_data, ThroughputData &th)
       return succ;
     }
 
+    //!< only take long steps if no cell carries a current
+    bool quiet{ true };
+    visit_SUs(su, [&](auto node) {
+      if constexpr (std::is_convertible_v<decltype(node), Cell *>)
+        quiet = quiet && std::abs(node->I()) <= rest_Irel * node->Cap();
+    });
+    nOnceMax = quiet ? nOnceMax_rest : rest_nOnceMax_current;
+    if (boolStoreData)
+      nOnceMax = std::min(nOnceMax, ndt_data); //!< if we store data, never take more than the interval at which you want to store the voltage
+    nOnce = std::clamp(nOnce, 1, nOnceMax);
+
     //!< change length of the time step in the last iteration to get exactly tlim seconds
-    if (nOnce * dti > (tlim - ttot)) //!< we are close to the total time -> set nOnce to 1
-      nOnce = 1;
+    if (nOnce * dti > (tlim - ttot)) //!< we are close to the total time -> take as many steps as fit in the remaining time
+      nOnce = std::max(1, static_cast<int>((tlim - ttot) / dti));
 
     if (dti > tlim - ttot) //!< the last time step, ensure we end up exactly at the right time
       dti = tlim - ttot;
 
+    const bool checkT = settings::T_MODEL != 0 && nOnce > 1; //!< without a thermal model, the temperatures do not change
+    if (checkT) {
+      Tcells.clear();
+      visit_SUs(su, [&](auto node) {
+        if constexpr (std::is_convertible_v<decltype(node), Cell *>)
+          Tcells.push_back(node->T());
+      });
+      snap.save(su); //!< to undo the steps if the temperature changed too much
+    }
+
     //!< take a number of time steps
     try { // #TODO timeStep_CC to return Status
       su->timeStep_CC(dti, nOnce);
@@ -131,6 +244,20 @@ Status Cycler::rest(double tlim, double dt, int ndt_data, ThroughputData &th)
       throw e;
     }
 
+    if (checkT) {
+      double dTmax{ 0 }; //!< largest temperature change of a cell in this step
+      size_t i{ 0 };
+      visit_SUs(su, [&](auto node) {
+        if constexpr (std::is_convertible_v<decltype(node), Cell *>)
+          dTmax = std::max(dTmax, std::abs(node->T() - Tcells[i++]));
+      });
+
+      if (dTmax > rest_dTmax && snap.restore(su)) {
+        nOnce /= 2;
+        continue;
+      }
+    }
+
     //!< Increase the throughput
     ttot += dti * nOnce;
     idat += nOnce;
@@ -141,18 +268,7 @@ Status Cycler::rest(double tlim, double dt, int ndt_data, ThroughputData &th)
       idat = 0;
     }
 
-    //!< adapt the number of time steps we take at once
-    if (tlim - ttot < 2 * (nOnce * dti)) //!< getting close to the end
-      nOnce = static_cast<int>(std::floor(nOnce / 2));
-    else {
-      //!< increase every other iteration, else thermal model might freak out
-      if (ninc) { //!< e.g. rest after cycle -> cell needs to cool down before you can take very long time steps
-        nOnce++;  //!< #TODO Increasing nOnce will cause not saving data regularly. We are probably not saving data every ndata_step
-        ninc = false;
-      } else
-        ninc = true;
-    }
-    nOnce = std::clamp(nOnce, 1, nOnceMax); //!< respect min and maximum
+    nOnce *= 2; //!< the states relax, so allow longer steps. nOnceMax and the temperature change limit the number of steps
 
   } //!< end time integration
 
@@ -249,15 +365,14 @@ Status Cycler::CC(double I, double vlim, double tlim, double dt, int ndt_data, T
   double dti = dt; //!< length of time step i
   double ttot{};   //!< total time done
 
-  int idat = 0;                    //!< consecutive number of time steps done without storing data
-  int nOnce = 1;                   //!< number of time steps we take at once, will change dynamically
-  constexpr double sfactor = 10.0; //!< increase nOnce if the voltage headroom is bigger than sfactor*dV (dV = change in this iteration)
-  int nOnceMax = 2;                //!< allow maximum this number of steps to be taken at once
-  if (boolStoreData)               //!< if we store data, never take more than the interval at which you want to store the voltage
+  int idat = 0;                 //!< consecutive number of time steps done without storing data
+  int nOnce = 1;                //!< number of time steps we take at once, set by the step size controller
+  int nOnceMax = CC_nOnceMax;   //!< allow maximum this number of steps to be taken at once
+  if (boolStoreData)            //!< if we store data, never take more than the interval at which you want to store the voltage
     nOnceMax = std::min(nOnceMax, ndt_data);
   bool vtot = false;              //!< boolean indicating if vlim has been reached
   double vo{ su->V() }, vi{ vo }; //!< voltage in the previous/this iteration
-  bool allowUp = true;            //!< do we allow nOnce to increase?
+  const double Vtol = event_Vreltol * std::abs(vlim);
 
   //!< check the voltage limit
   if ((I < 0 && vi > vlim) || (I > 0 && vi < vlim)) //!< charging -> exceeded if Vnew > vlim
@@ -267,12 +382,14 @@ Status Cycler::CC(double I, double vlim, double tlim, double dt, int ndt_data, T
   while (ttot < tlim) {
     auto succ = setCurrent(I, vlim); // #TODO this was not here I added to get nice results from
     //!< change length of the time step in the last iteration to get exactly tlim seconds
-    if (nOnce * dti > tlim - ttot) //!< we are close to the total time -> set nOnce to 1
-      nOnce = 1;
+    if (nOnce * dti > tlim - ttot) //!< we are close to the total time -> take as many steps as fit in the remaining time
+      nOnce = std::max(1, static_cast<int>((tlim - ttot) / dti));
 
     if (dti > tlim - ttot) //!< the last time step, ensure we end up exactly at the right time
       dti = tlim - ttot;
 
+    snap.save(su); //!< to undo (part of) this step if it crosses the voltage limit
+
     //!< take a number of time steps
     try {
       su->timeStep_CC(dti, nOnce);
@@ -288,6 +405,11 @@ Status Cycler::CC(double I, double vlim, double tlim, double dt, int ndt_data, T
     if (diagnostic) {
       const auto status = su->checkVoltage(vi, true);
       if (!isStatusSuccessful(status)) { //!< in diagnostic mode and the voltage of one of the cells was violated
+        if (nOnce > 1 && snap.restore(su)) {
+          nOnce = 1; //!< the step was too large for one of the cells, redo it with a single time step
+          continue;
+        }
+
         if constexpr (settings::printBool::printNonCrit)
           std::cout << "in Cycler::CC, the voltage of a cell became invalid in time step when the total voltage was "
                     << vi << '\n';
@@ -304,13 +426,33 @@ Status Cycler::CC(double I, double vlim, double tlim, double dt, int ndt_data, T
       }
     }
 
-    auto myVnow = su->V();
+    double dt_now = dti * nOnce;
+    int nstep_now = nOnce;
+
+    //!< check the voltage limit
+    if (((I < 0) && (vi > vlim)) || ((I > 0) && (vi < vlim))) { //!< charging -> exceeded if Vnew > vlim
+      vtot = true;                                              //!< indicate the voltage limit was reached
+
+      //!< locate the time in this step at which the voltage limit was crossed, and end there
+      if (std::abs(vi - vlim) > Vtol && snap.restore(su)) {
+        auto redo = [&](double tau) {
+          nstep_now = static_cast<int>(std::ceil(tau / dti - 1e-9));
+          snap.restore(su);
+          su->timeStep_CC(tau / nstep_now, nstep_now);
+          return su->V() - vlim;
+        };
+
+        dt_now = locateEvent(dt_now, vo - vlim, vi - vlim, Vtol, dti * event_tminfrac, redo);
+        nstep_now = static_cast<int>(std::ceil(dt_now / dti - 1e-9));
+        vi = su->V();
+      }
+    }
+
     //!< Increase the throughput
-    const auto dt_now = dti * nOnce;
     th.time() += dt_now;
     ttot += dt_now;
     th.Ah() += std::abs(I) * dt_now / 3600.0;
-    idat += nOnce;
+    idat += nstep_now;
     th.Wh() += std::abs(I) * dt_now / 3600 * vi;
 
     //!< Store a data point if needed
@@ -319,71 +461,13 @@ Status Cycler::CC(double I, double vlim, double tlim, double dt, int ndt_data, T
       idat = 0;
     }
 
-    //!< check the voltage limit
-    if (((I < 0) && (vi > vlim)) || ((I > 0) && (vi < vlim))) { //!< charging -> exceeded if Vnew > vlim
-      vtot = true;                                              //!< indicate the voltage limit was reached
-      break;
-    }
+    if (vtot) break;
 
-    //!< #TODO this is pretty much unnecessary.
-    // Check if the given limit at the beginning inside voltage limits.
-    // Otherwise clamp!
-
-    //!< adapt the number of time steps we take at once
-    if (I < 0) {                           //!< if charging, voltage is increasing -> increase if dV < Vlim-V
-      if (vi - vo < (vlim - vi) / sfactor) //!< still far of, increase nOnce
-        nOnce++;
-      else if (vi - vo >= (vlim - vi)) //!< very close, immediately reset to 1 to avoid overshoot
-        nOnce = 1;
-      else //!< fairly close, reduce nOnce
-        nOnce--;
-
-
-      //!< check the highest cell voltage, if it is close, reduce nOnce aggressively
-      /*
-       * Note: the code below makes the simulation works with more variation and more degraded cells
-       * e.g. v > 4.1 n-2 and v > 4.15 n = 1
-       * 		unit test procedure_test stress test with large variation: simulate to a capacity of 10%
-       * 		large battery simulation coolsystem 2: simulate 3592 cycles instead of 3295
-       *
-       * however, it also significantly slows down the simulation time.
-       * 	e.g. same settings for large batter increase simulation time from 5s per cycle to 12.2s per cycle
-       *
-       * v>4.15 n-2
-       * 	large distribution unit test goes to 30% capacity
-       * 	large simulation takes 25 s per cycle
-       */
-      /*	if(su->getVhigh() >= 4.1){
-                      nOnce-= 2;										//!< reduce nOnce
-                      allowUp = false;								//!< block nOnce from increasing
-
-              }
-              if(su->getVhigh() >= 4.15){
-                      nOnce = 1;										//!< reduce nOnce
-                      allowUp = false;								//!< block nOnce from increasing
-
-              }*/
-    } else //!< on discharge be careful with steep OCV change at low SoC
-    {
-      if (vo - vi < (vi - vlim) / sfactor && allowUp)
-        nOnce++;
-      else if (vo - vi >= (vi - vlim) * 2.0) //!< add the *2 to reduce faster on discharge
-        nOnce = 1;
-      else
-        nOnce -= 2; //!< reduce by 2 to reduce faster
-
-
-      //!< check the lowest cell voltage, and if it is on the steep part, reduce nOnce aggressively
-      if (su->getVlow() < 3.1) { //!< this gets directly to the cell level, so we know for sure the value which matters is 3.1
-        nOnce -= 2;              //!< reduce nOnce
-        allowUp = false;         //!< block nOnce from increasing
-      }
-      if (su->getVlow() < 3.0) //!< #TODO this are for cells? What about modules?
-      {                        //!< this gets directly to the cell level, so we know for sure the value which matters is 3
-        nOnce = 1;
-        allowUp = false;
-      }
-    }
+    //!< step size controller: take a fraction of the time to reach vlim predicted from the local voltage slope
+    const double slope = (vi - vo) / dt_now;
+    const double t_hit = (slope * (vlim - vi) > 0) ? (vlim - vi) / slope : TIME_INF;
+    const double n_hit = std::floor(event_tfrac * t_hit / dt);
+    nOnce = (n_hit < 2.0 * nOnce) ? static_cast<int>(n_hit) : 2 * nOnce; //!< at most double the step every iteration for the thermal model
 
     //!< check minimum and maximum of nOnce
     nOnce = std::clamp(nOnce, 1, nOnceMax); //!< respect min and max
@@ -392,10 +476,10 @@ Status Cycler::CC(double I, double vlim, double tlim, double dt, int ndt_data, T
   } //!< end time integration
 
   //!< check why we stopped the time integration
-  if (ttot >= tlim)
-    succ = Status::ReachedTimeLimit;
-  else if (vtot)
+  if (vtot)
     succ = Status::ReachedVoltageLimit;
+  else if (ttot >= tlim)
+    succ = Status::ReachedTimeLimit;
   else {
     if constexpr (settings::printBool::printCrit)
       std::cerr << "Error in Cycler::CC, stopped time integration for unclear reason after "
@@ -411,8 +495,17 @@ Status Cycler::CC(double I, double vlim, double tlim, double dt, int ndt_data, T
 
 Status Cycler::CV(double Vset, double Ilim, double tlim, double dt, int ndt_data, ThroughputData &th)
 {
-  // New CV function using setVoltage.
-  using slide::util::sign; //!< #TODO normally sign is very sensitive function
+  /*
+   * Apply a constant voltage until the current limit or the time limit is reached.
+   *
+   * The current which keeps the voltage at Vset is not solved from scratch every time step:
+   * 	- the voltage after a time step (at the old current) and the effective resistance -dV/dI of the previous
+   * 	  correction give a Newton prediction of the new current, which usually is within tolerance after one evaluation.
+   * 	  Only if it is not after CV_maxCorrection evaluations, the full iterative setVoltage is used.
+   * 	- once the current decays smoothly (exponentially), multiple time steps are taken at once,
+   * 	  with the mean of the predicted exponential decay as current during the steps.
+   * 	  The number of steps is reduced when the current changes quickly or when it approaches Ilim.
+   */
   const bool boolStoreData = ndt_data > 0;
 
   //!< *************************************************************** INITIALISE *************************************************************************
@@ -431,55 +524,126 @@ Status Cycler::CV(double Vset, double Ilim, double tlim, double dt, int ndt_data
 
   //!< *******************************************************  apply voltage  ****************************************************************************
 
-  const auto nt = static_cast<size_t>(std::ceil(tlim / dt)); //!< number of time steps
-
-  double dti = dt;         //!< length of time step i
   double ttot = 0;         //!< total time done
   bool Itot = false;       //!< boolean indicating if Ilim has been reached
   bool Vtolerance = false; //!< boolean indicating if the voltage tolerance was reached
-  double dI, a;            //!< change in current we will apply to keep the voltage constant
-  bool reach;
+  const double Itol = event_Ireltol * Ilim;
+  const double Vtol = CV_Vreltol * Vset;
 
-  for (size_t i = 0; i < nt; i++) {
-    su->setVoltage(Vset);
+  int idat = 0;               //!< consecutive number of time steps done without storing data
+  int nOnce = 1;              //!< number of time steps we take at once
+  int nOnceMax = CC_nOnceMax; //!< allow maximum this number of steps to be taken at once
+  if (boolStoreData)          //!< if we store data, never take more than the interval at which you want to store the voltage
+    nOnceMax = std::min(nOnceMax, ndt_data);
+  double r = 1; //!< ratio of the current in successive time steps, < 1 if the current decays
+
+  double Reff = su->getRtot(); //!< effective resistance -dV/dI, updated with the secant slope of every correction
+  if (!(Reff > 0)) Reff = 1e-3;
+
+  auto correct = [&](double v, double tol) {
+    /*
+     * Newton iteration on the current to get the voltage v at the present current within tol of Vset, returns the new voltage.
+     */
+    double I = su->I();
+    for (int iter = 0; iter < CV_maxCorrection && std::abs(v - Vset) > tol; iter++) {
+      const double Inew = I + (v - Vset) / Reff; //!< V = OCV - R*I
+      su->setCurrent(Inew, false, false);
+      const double vnew = su->V();
+      if (std::abs(Inew - I) > 1e-12) {
+        const double Rnew = -(vnew - v) / (Inew - I);
+        if (Rnew > 0 && std::isfinite(Rnew)) Reff = Rnew;
+      }
+      I = Inew;
+      v = vnew;
+    }
+
+    if (std::abs(v - Vset) > tol) { //!< fall back to the full solve
+      su->setVoltage(Vset);
+      v = su->V();
+    }
+    return v;
+  };
 
+  vi = correct(vprev, Vtol);
+  Ii = su->I();
+
+  while (ttot < tlim) {
     //!< change length of the time step in the last iteration to get exactly tlim seconds
-    if (i + 1 == nt)
-      dti = tlim - dt * (nt - 1);
+    if (nOnce * dt > tlim - ttot)
+      nOnce = std::max(1, static_cast<int>((tlim - ttot) / dt));
+    const double dti = std::min(dt, tlim - ttot);
+
+    //!< hold the mean of the predicted exponential decay of the current during the steps
+    const double Istart = Ii;
+    const double Iblock = (nOnce > 1 && r < 1) ? Istart * (1 - std::pow(r, nOnce)) / (nOnce * (1 - r)) : Istart;
+    if (Iblock != Istart)
+      su->setCurrent(Iblock, false, false);
 
-    //!< take a time step
+    snap.save(su); //!< to locate the time at which the current reaches Ilim inside these steps
+
+    //!< take the time steps
     try {
-      su->timeStep_CC(dti); // #TODO should return status.
+      su->timeStep_CC(dti, nOnce); // #TODO should return status.
     } catch (int e) {
       if constexpr (settings::printBool::printCrit)
-        std::cout << "error in Cycler::CV of module " << su->getFullID() << " in time step "
-                  << i << " when advancing in time. Passing the error on, " << e << '\n';
+        std::cout << "error in Cycler::CV of module " << su->getFullID() << " after "
+                  << ttot << " s when advancing in time. Passing the error on, " << e << '\n';
       return Status::timeStep_CC_failed;
     }
 
     //!< increase the throughput
-    const auto dAh = std::abs(su->I() * dti / 3600.0);
+    double h = dti * nOnce;
+    auto dAh = std::abs(Iblock * h / 3600.0);
     vi = su->V();
-    ttot += dti;
+    ttot = (dti < dt) ? tlim : ttot + h;
     th.Ah() += dAh;
     th.Wh() += dAh * vi;
-
+    idat += nOnce;
 
     //!< Store a data point if needed
-    if (boolStoreData && ((i + 1) % ndt_data == 0))
+    if (boolStoreData && idat >= ndt_data) {
       storeData();
+      idat = 0;
+    }
     const auto safetyStatus = free::check_safety(vi, *this);
 
     if (safetyStatus != Status::SafeVoltage)
       return safetyStatus;
 
-    //!< check the current limit
+    //!< set the current for the next time step
+    vi = correct(vi, Vtol);
     Ii = su->I();
+
+    //!< check the current limit
     dV = std::abs(vi - Vset);
     Vlimit = (dV < settings::MODULE_P_V_ABSTOL || dV / Vset < settings::MODULE_P_V_RELTOL);
     if (std::abs(Ii) < Ilim && Vlimit) {
       Itot = true; //!< indicate the current limit was reached
       Vtolerance = true;
+
+      //!< The current decays during the steps, so Ilim was reached somewhere in these steps.
+      //!< Locate the time at which the current needed to keep Vset is Ilim, and end there.
+      if (std::abs(Ii) < Ilim - Itol && snap.restore(su)) {
+        auto redo = [&](double tau) {
+          const int nstep = static_cast<int>(std::ceil(tau / dti - 1e-9));
+          snap.restore(su);
+          su->timeStep_CC(tau / nstep, nstep);
+          correct(su->V(), std::min(Vtol, 0.1 * Itol * Reff)); //!< Vtol can be a larger error on the current than Itol
+          return std::abs(su->I()) - Ilim;
+        };
+
+        ttot -= h;
+        th.Ah() -= dAh;
+        th.Wh() -= dAh * vi;
+
+        h = locateEvent(h, std::abs(Istart) - Ilim, std::abs(Ii) - Ilim, Itol, dti * event_tminfrac, redo);
+        dAh = std::abs(Iblock) * h / 3600.0; //!< the current during the partial steps is the current of the block
+        vi = su->V();
+        ttot += h;
+        th.Ah() += dAh;
+        th.Wh() += dAh * vi;
+        Ii = su->I();
+      }
       break;
     }
 
@@ -490,6 +654,21 @@ Status Cycler::CV(double Vset, double Ilim, double tlim, double dt, int ndt_data
       Vtolerance = false; //!< but without reaching the voltage tolerance
       break;
     }
+
+    //!< adapt the number of time steps we take at once to how smoothly the current decays
+    const double ratio = Ii / Istart;
+    r = (ratio > 0) ? std::min(1.0, std::pow(ratio, 1.0 / nOnce)) : 1.0;
+    const double dIrel = std::abs(1 - ratio);
+    if (dIrel < CV_dIrel_increase)
+      nOnce *= 2;
+    else if (dIrel > CV_dIrel_decrease)
+      nOnce /= 2;
+
+    if (r < 1 && std::abs(Ii) > Ilim) { //!< take a fraction of the number of steps predicted until Ilim
+      const double n_hit = std::floor(event_tfrac * std::log(Ilim / std::abs(Ii)) / std::log(r));
+      if (n_hit < nOnce) nOnce = static_cast<int>(n_hit);
+    }
+    nOnce = std::clamp(nOnce, 1, nOnceMax); //!< respect min and max
   } //!< end time integration
 
   //!< *********************************************************** TERMINATE ******************************************************************************
@@ -589,7 +768,7 @@ double Cycler::testCapacity(double &Ah, double &ttot)
 {
   /*
    * Calculate the charge capacity of the connected SU.
-   * note, this function does not affect the Cell, it restores the original states at the end
+   * note, this function does not affect the Cell, it restores the original states at the end (with backupStates/restoreStates)
    *
    * in diagnostic mode, we cannot really do a CV since the small voltage errors during CV will cause some cells to exceed their voltage limit
    * therefore, we have to measure it with a slow (dis)charge
@@ -598,12 +777,7 @@ double Cycler::testCapacity(double &Ah, double &ttot)
   constexpr double crate = 1.0 / 25.0;
   ThroughputData th1{}, th2{};
 
-  std::vector<double> sini; //!< #TODO if it is avoidable.
-  sini.clear();
-
-  su->getStates(sini);
-
-  std::span<double> sini_span{ sini };
+  su->backupStates();
   //!< #TODO once we introduce a different temperature, set T to Tref
 
   //!< *********************************************************** 2 full charge / discharge cycle ***********************************************************************
@@ -620,7 +794,7 @@ double Cycler::testCapacity(double &Ah, double &ttot)
                 << getStatusMessage(status) << ".\n";
 
     //!< restore the original states
-    su->setStates(sini_span, false, true);
+    su->restoreStates();
 
     return 0;
   }
@@ -635,16 +809,236 @@ double Cycler::testCapacity(double &Ah, double &ttot)
                 << getStatusMessage(status) << ".\n";
 
     //!< restore the original states
-    su->setStates(sini_span, false, true);
+    su->restoreStates();
     return 0;
   }
 
+  su->restoreStates();
+
   Ah = th1.Ah() + th2.Ah();
   return th2.Ah();
 }
 
-Status Cycler::Profile(std::span<double> I_vec, double vlim, double tlim, double dt, int ndt_data, double &Ah, double &Wh)
+/**
+ * @brief Apply a constant power to the connected storage unit until either a voltage or time limit is reached.
+ *
+ * Every time step, the current is solved from V(I)*I - losses(V, I) = P with a Newton iteration.
+ * The voltage at the end of the previous step gives the first point for free,
+ * and the slope dV/dI of the previous solve is used as the derivative, so usually one voltage evaluation is enough.
+ * The losses are those of the converter of the Battery if setConverter(true), else 0.
+ *
+ * @param P[in] Power [W] to be applied (negative for charging, positive for discharging)
+ * @param vlim[in] Voltage to which the cell should be (dis)charged
+ * @param tlim[in] Time [s] for which the power should be applied
+ * @param dt[in] Time step [s] to be used for time integration
+ * @param ndt_data[in] Integer indicating after how many time steps a data point should be stored (if <= 0, no data is stored)
+ * @param th[out] ThroughputData object to store the time, charge and energy throughput
+ * @return Status indicating the reason for stopping the function
+ * @throws 101 if the converter losses are included but the connected storage unit is not a Battery
+ */
+Status Cycler::CP(double P, double vlim, double tlim, double dt, int ndt_data, ThroughputData &th)
 {
-  return Status::Unknown_problem;
+  Converter *conv{ nullptr };
+  if (converter) {
+    auto bat = dynamic_cast<Battery *>(su);
+    if (bat == nullptr) {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "ERROR in Cycler::CP, the converter losses are included but " << su->getFullID()
+                  << " is not a Battery. Throwing 101.\n";
+      throw 101;
+    }
+    conv = &bat->getConverter();
+  }
+
+  const bool boolStoreData = ndt_data > 0;
+  if (boolStoreData) storeData();
+
+  const double Ptol = CP_Preltol * std::abs(P);
+  auto residual = [&](double I, double V) { return V * I - (conv ? conv->getLosses(V, I) : 0) - P; };
+
+  double I{ su->I() }, vi{ su->V() };
+  if (I == 0 || (I > 0) != (P > 0)) { //!< no current of the right sign to start from, use P/V
+    I = P / vi;
+    su->setCurrent(I, false, false);
+    vi = su->V();
+  }
+
+  auto solve = [&]() {
+    //!< Newton iteration starting from the current I with voltage vi
+    double f = residual(I, vi);
+    for (int iter = 0; iter < CP_maxIteration && std::abs(f) > Ptol; iter++) {
+      double dL{ 0 }; //!< derivative of the losses, the converter model is cheap so use a finite difference
+      if (conv) {
+        const double dI = 1e-6 * std::max(1.0, std::abs(I));
+        dL = (conv->getLosses(vi, I + dI) - conv->getLosses(vi, I)) / dI;
+      }
+
+      const double Inew = I - f / (vi + I * dVdI - dL);
+      const auto status = su->setCurrent(Inew, diagnostic, settings::printBool::printNonCrit);
+      if (isStatusVoltageLimitsViolated(status)) return status;
+
+      const double Vnew = su->V();
+      if (std::abs(Inew - I) > 1e-9 * std::max(1.0, std::abs(I)))
+        dVdI = (Vnew - vi) / (Inew - I); //!< secant slope, kept for the next time step
+
+      I = Inew;
+      vi = Vnew;
+      f = residual(I, vi);
+    }
+
+    if (std::abs(f) > Ptol) {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "Error in Cycler::CP of SU " << su->getFullID() << ", could not find the current for a power of "
+                  << P << " W, the power is " << f + P << " W at a current of " << I << " A and voltage " << vi << " V.\n";
+      return Status::Unknown_problem;
+    }
+    return Status::Success;
+  };
+
+  auto succ = solve();
+  if (!isStatusSuccessful(succ)) return succ;
+
+  //!< check the voltage limit
+  if ((P < 0 && vi > vlim) || (P > 0 && vi < vlim))
+    return Status::ReachedVoltageLimit;
+
+  double ttot{ 0 }; //!< total time done
+  int idat{ 0 };    //!< consecutive number of time steps done without storing data
+  bool vtot{ false };
+  const double Vtol = event_Vreltol * std::abs(vlim);
+
+  while (ttot < tlim) {
+    const double dti = std::min(dt, tlim - ttot);
+    const double vo = vi;
+
+    snap.save(su); //!< to undo part of this step if it crosses the voltage limit
+
+    try {
+      su->timeStep_CC(dti, 1);
+    } catch (int e) {
+      if constexpr (settings::printBool::printCrit)
+        std::cout << "error in Cycler::CP when advancing in time with V = " << vi << " and Vlim " << vlim
+                  << ". The error is " << e << ".\n";
+      return Status::timeStep_CC_failed;
+    }
+
+    if (diagnostic) {
+      const auto status = su->checkVoltage(vi, true);
+      if (!isStatusSuccessful(status)) return status;
+    } else
+      vi = su->V();
+
+    double dt_now = dti;
+    if ((P < 0 && vi > vlim) || (P > 0 && vi < vlim)) {
+      vtot = true;
+
+      //!< locate the time in this step at which the voltage limit was crossed, and end there
+      if (std::abs(vi - vlim) > Vtol && snap.restore(su)) {
+        auto redo = [&](double tau) {
+          snap.restore(su);
+          su->timeStep_CC(tau, 1);
+          return su->V() - vlim;
+        };
+
+        dt_now = locateEvent(dti, vo - vlim, vi - vlim, Vtol, dti * event_tminfrac, redo);
+        vi = su->V();
+      }
+    }
+
+    //!< Increase the throughput
+    th.time() += dt_now;
+    ttot += dt_now;
+    th.Ah() += std::abs(I) * dt_now / 3600.0;
+    th.Wh() += std::abs(I) * dt_now / 3600.0 * vi;
+    idat++;
+
+    if (boolStoreData && idat >= ndt_data) {
+      storeData();
+      idat = 0;
+    }
+
+    if (vtot) break;
+
+    //!< the current for the next time step, vi is the voltage at the present current
+    succ = solve();
+    if (!isStatusSuccessful(succ)) return succ;
+  }
+
+  if (boolStoreData && idat > 0) storeData();
+
+  return vtot ? Status::ReachedVoltageLimit : Status::ReachedTimeLimit;
+}
+
+/**
+ * @brief Follow a current or power profile, clipping the current where it would exceed the voltage limits.
+ *
+ * Consecutive identical set-points are simulated with one CC phase, which takes multiple time steps at once.
+ * If a voltage limit is reached, the voltage is kept at the limit (CV) for the rest of that set-point,
+ * so the magnitude of the current is the minimum of the set-point and the current which keeps the voltage at the limit.
+ * Power set-points are simulated with CP, so they include the converter losses if setConverter(true).
+ *
+ * @param[in] prof Set-points, one per time step of dt seconds (negative for charging, positive for discharging)
+ * @param[in] power If true, the set-points are a power [W], else a current [A]
+ * @param[in] Vmax Voltage at which charging is clipped
+ * @param[in] Vmin Voltage at which discharging is clipped
+ * @param[in] tlim Maximum time [s] for which the profile is followed
+ * @param[in] dt Length [s] of one sample of the profile
+ * @param[in] ndt_data Integer indicating after how many samples a data point should be stored (if <= 0, no data is stored)
+ * @param[out] th ThroughputData object to store the time, charge and energy throughput
+ * @return Success at the end of the profile, ReachedTimeLimit if tlim was reached first, or the error of the CC or CV phase
+ */
+Status Cycler::Profile(ProfileStream &prof, bool power, double Vmax, double Vmin, double tlim, double dt, int ndt_data, ThroughputData &th)
+{
+  const bool boolStoreData = ndt_data > 0;
+  if (boolStoreData) storeData();
+
+  double ttot{ 0 }; //!< total time done
+  int idat{ 0 };    //!< consecutive number of samples done without storing data
+  SetPoint sp;
+
+  while (ttot < tlim && prof.next(sp)) {
+    for (size_t n = sp.n; n > 0 && ttot < tlim;) {
+      size_t nrun = n;
+      if (boolStoreData)
+        nrun = std::min(nrun, static_cast<size_t>(ndt_data - idat));
+
+      const double trun = std::min(nrun * dt, tlim - ttot);
+
+      ThroughputData th_run{};
+      Status succ;
+      if (sp.value == 0)
+        succ = rest(trun, dt, 0, th_run);
+      else {
+        const double vlim = (sp.value < 0) ? Vmax : Vmin;
+        succ = power ? CP(sp.value, vlim, trun, dt, 0, th_run) : CC(sp.value, vlim, trun, dt, 0, th_run);
+        if (succ == Status::ReachedVoltageLimit && th_run.time() < trun) //!< clip the current for the rest of the set-point
+          succ = CV(vlim, 0, trun - th_run.time(), dt, 0, th_run);
+      }
+
+      //!< CV ends early with ReachedSmallCurrent if the current needed to keep the voltage at the limit vanishes
+      if (succ > Status::ReachedSmallCurrent) {
+        if constexpr (settings::printBool::printCrit)
+          std::cerr << "Error in Cycler::Profile of SU " << su->getFullID() << " with set-point " << sp.value
+                    << " after " << ttot << "s: " << getStatusMessage(succ) << '\n';
+        return succ;
+      }
+
+      th.time() += trun;
+      th.Ah() += th_run.Ah();
+      th.Wh() += th_run.Wh();
+      ttot += trun;
+      n -= nrun;
+      idat += static_cast<int>(nrun);
+
+      if (boolStoreData && idat >= ndt_data) {
+        storeData();
+        idat = 0;
+      }
+    }
+  }
+
+  if (boolStoreData && idat > 0) storeData();
+
+  return (ttot < tlim) ? Status::Success : Status::ReachedTimeLimit;
 }
 } // namespace slide
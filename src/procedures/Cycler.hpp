@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include "procedure_util.hpp"
 #include "../StorageUnit.hpp"
 #include "../types/data_storage/cell_data.hpp"
+#include "../utility/io/ProfileStream.hpp"
 
 #include <string>
 #include <memory>
@@ -23,6 +25,9 @@ private:
 
   size_t index{ 0 };        //!< Cycler should keep its on index for data writing.
   bool diagnostic{ false }; //!< are we running in diagnostic mode or not?
+  bool converter{ false };  //!< include the losses of the converter of the Battery in the power of CP
+  double dVdI{ 0 };         //!< slope of the voltage to the current in the last CP step, to predict the current in the next step
+  Snapshot snap;            //!< state of su at the start of the last time step, to locate voltage and current limits inside a step
 
   //!< secondary functions
   Status setCurrent(double I, double vlim); //!< sets the current to the connected SU
@@ -37,16 +42,23 @@ public:
   Cycler &initialise(Deep_ptr<StorageUnit> &sui, const std::string &IDi) { return initialise(sui.get(), IDi); }
 
   Cycler &setDiagnostic(bool newDia);
+  Cycler &setConverter(bool newConv);
   double getSafetyVmin() { return su->VMIN() * 0.99; } //!< #TODO probably causing many calculations.
   double getSafetyVmax() { return su->VMAX() * 1.01; }
 
   Status rest(double tlim, double dt, int ndt_data, ThroughputData &th);
   Status CC(double I, double vlim, double tlim, double dt, int ndt_data, ThroughputData &th);
   Status CV(double Vset, double Ilim, double tlim, double dt, int ndt_data, ThroughputData &th);
+  Status CP(double P, double vlim, double tlim, double dt, int ndt_data, ThroughputData &th);
   Status CCCV(double I, double Vset, double Ilim, double dt, int ndt_data, ThroughputData &th);
   Status CCCV_with_tlim(double I, double Vset, double Ilim, double tlim, double dt, int ndt_data, ThroughputData &th);
 
-  Status Profile(std::span<double> I_vec, double vlim, double tlim, double dt, int ndt_data, double &Ah, double &Wh);
+  Status Profile(ProfileStream &prof, bool power, double Vmax, double Vmin, double tlim, double dt, int ndt_data, ThroughputData &th);
+  Status Profile(std::span<const double> I_vec, double Vmax, double Vmin, double tlim, double dt, int ndt_data, ThroughputData &th)
+  {
+    ProfileStream prof(I_vec);
+    return Profile(prof, false, Vmax, Vmin, tlim, dt, ndt_data, th);
+  }
 
   int storeData();
   int writeData();
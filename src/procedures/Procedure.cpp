@@ -12,6 +12,7 @@
 #include "../system/Battery.hpp"
 #include "../settings/settings.hpp"
 #include "../utility/utility.hpp"
+#include "../utility/io/AsyncWriter.hpp"
 
 #include <cmath>
 #include <random>
@@ -22,6 +23,7 @@
 #include <typeinfo>
 #include <vector>
 #include <memory>
+#include <algorithm>
 
 namespace slide {
 
@@ -54,11 +56,17 @@ void Procedure::cycleAge(StorageUnit *su, int Ncycle, int Ncheck, int Nbal, bool
   Status succ{};
   ThroughputData th{};
 
+  //!< continue from the last checkpoint if there is one
+  Checkpoint ckp{ checkpointName };
+  const int i0 = restoreCheckpoint(ckp, su, th);
+
   //!< Make a clock to measure how long the simulation takes
   Clock clk{};
 
   //!< loop for cycle ageing
-  for (int i = 0; i < Ncycle; i++) {
+  for (int i = i0; i < Ncycle; i++) {
+    if (i != i0) writeCheckpoint(ckp, su, i, th);
+
     if (!unitTest)
       std::cout << "SU " << su->getFullID() << " starting loop iteration " << i << " after "
                 << clk << " with V = " << su->V() << ", T = " << K_to_Celsius(su->T())
@@ -129,6 +137,8 @@ void Procedure::cycleAge(StorageUnit *su, int Ncycle, int Ncheck, int Nbal, bool
   //!< push a write such that if cells still have cycling data, this is written
   if constexpr (settings::DATASTORE_CELL == settings::cellDataStorageLevel::storeTimeData)
     su->writeData(pref); //!< only do if cycling data. Usage statistics are written by the checkup
+
+  AsyncWriter::flush(); //!< all data is written when the procedure returns
 }
 
 void Procedure::cycleAge(StorageUnit *su, bool testCV)
@@ -177,18 +187,26 @@ void Procedure::useCaseAge(StorageUnit *su, int cool)
   ThroughputData th{};
   Status succ;
 
-  //!< fully discharge the SU at a C/2
-  succ = cyc.CC(su->Cap() / 2.0, su->Vmin(), TIME_INF, dt, ndata, th);
+  //!< continue from the last checkpoint if there is one
+  Checkpoint ckp{ checkpointName };
+  const unsigned i0 = restoreCheckpoint(ckp, su, th);
 
-  if (!isLimitsReached(succ))
-    std::cout << "Error in useAge when initially discharging the battery, continue as normal.\n"
-              << getStatusMessage(succ) << '\n';
+  //!< fully discharge the SU at a C/2 (unless we continue from a checkpoint, which was made after this)
+  if (i0 == 0) {
+    succ = cyc.CC(su->Cap() / 2.0, su->Vmin(), TIME_INF, dt, ndata, th);
+
+    if (!isLimitsReached(succ))
+      std::cout << "Error in useAge when initially discharging the battery, continue as normal.\n"
+                << getStatusMessage(succ) << '\n';
+  }
 
   //!< Make a clock to measure how long the simulation takes
   Clock clk;
 
   //!< loop for use case ageing
-  for (unsigned i = 0; i < Ncycle; i++) {
+  for (unsigned i = i0; i < Ncycle; i++) {
+    if (i != i0) writeCheckpoint(ckp, su, i, th);
+
     if (!unitTest)
       std::cout << "SU " << su->getFullID() << " starting loop iteration " << i << " after "
                 << clk << " with V = " << su->V() << ", T = " << K_to_Celsius(su->T())
@@ -267,6 +285,102 @@ void Procedure::useCaseAge(StorageUnit *su, int cool)
   //!< push a write such that if cells still have cycling data, this is written
   if constexpr (settings::DATASTORE_CELL == settings::cellDataStorageLevel::storeTimeData)
     su->writeData(pref); //!< only do if cycling data. Usage statistics are written by the checkup
+
+  AsyncWriter::flush(); //!< all data is written when the procedure returns
+}
+
+Status Procedure::runProtocol(StorageUnit *su, const Protocol &prot, double dt, const std::string &pref)
+{
+  /*
+   * Run the steps of a parsed protocol on su.
+   * The program is walked with a program counter, loops jump back to the step after their repeat
+   * and check-ups or balancing use the iteration number of the innermost loop.
+   * The throughput is stored after every (dis)charge or rest and written at the end.
+   *
+   * IN
+   * su 	storage unit to run the protocol on
+   * prot 	parsed protocol, it is not changed so the same protocol can be run on many storage units in parallel
+   * dt 	time step [s], also the length of one sample of a profile
+   * pref 	prefix appended at the start of the names of all files
+   *
+   * OUT
+   * Status 	Success if all steps were done, else the status of the step which stopped the protocol
+   */
+  using Type = ProtocolStep::Type;
+  constexpr auto diagnostic = true; //!< stop (dis)charging when one of the cells reaches a voltage limit
+  auto cyc = Cycler(su, pref).setDiagnostic(diagnostic);
+
+  const auto &steps = prot.getSteps();
+  std::vector<int> iteration; //!< iteration number of each loop which is being run
+  iteration.reserve(prot.getDepth());
+
+  Status succ{ Status::Success };
+  ThroughputData th{};
+
+  for (size_t pc = 0; pc < steps.size(); pc++) {
+    const auto &s = steps[pc];
+    const double Iscale = s.Crate ? su->Cap() : 1.0;
+    const double vlim = std::isnan(s.vlim) ? ((s.value < 0) ? su->Vmax() : su->Vmin()) : s.vlim;
+
+    switch (s.type) {
+    case Type::repeat:
+      if (s.n == 0)
+        pc = s.jump; //!< skip the loop including its end
+      else
+        iteration.push_back(0);
+      continue;
+    case Type::end:
+      if (++iteration.back() < steps[s.jump].n)
+        pc = s.jump; //!< the next step is the first one of the loop
+      else
+        iteration.pop_back();
+      continue;
+    case Type::checkup:
+    case Type::balance: {
+      const int i = iteration.empty() ? 0 : iteration.back();
+      if (i % s.n == 0)
+        balanceCheckup(su, s.type == Type::balance, s.type == Type::checkup, th.Ah(), i, pref);
+      continue;
+    }
+    case Type::rest:
+      succ = cyc.rest(s.tlim, dt, ndata, th);
+      break;
+    case Type::CC:
+      succ = cyc.CC(s.value * Iscale, vlim, s.tlim, dt, ndata, th);
+      break;
+    case Type::CP:
+      succ = cyc.CP(s.value, vlim, s.tlim, dt, ndata, th);
+      break;
+    case Type::CV:
+      succ = cyc.CV(s.value, s.Ilim * Iscale, s.tlim, dt, ndata, th);
+      break;
+    case Type::profile: {
+      ProfileStream profile(PathVar::data / prot.getProfiles()[s.n], s.value * Iscale, dt);
+      succ = cyc.Profile(profile, s.power, su->Vmax(), su->Vmin(), s.tlim, dt, ndata, th);
+      break;
+    }
+    }
+
+    storeThroughput(th, su);
+
+    //!< every step ends at one of its limits, anything else is an error
+    if (succ > Status::ReachedSmallCurrent && succ != Status::Success) {
+      if constexpr (settings::printBool::printCrit)
+        std::cout << "Error in Procedure::runProtocol in step " << pc << ", stop the protocol. "
+                  << getStatusMessage(succ) << '\n';
+      break;
+    }
+    succ = Status::Success;
+  }
+
+  writeThroughput(su->getFullID(), th.Ah());
+
+  //!< push a write such that if cells still have cycling data, this is written
+  if constexpr (settings::DATASTORE_CELL == settings::cellDataStorageLevel::storeTimeData)
+    su->writeData(pref);
+
+  AsyncWriter::flush(); //!< all data is written when the procedure returns
+  return succ;
 }
 
 void Procedure::storeThroughput(ThroughputData th, StorageUnit *su)
@@ -297,6 +411,34 @@ void Procedure::storeThroughput(ThroughputData th, StorageUnit *su)
   throughput.push_back({ th.Ah(), th.Wh(), coolSystemLoad, convloss });
 }
 
+int Procedure::restoreCheckpoint(Checkpoint &ckp, StorageUnit *su, ThroughputData &th)
+{
+  /*
+   * Restore su, th and the throughput of this procedure from the checkpoint if it exists.
+   * Returns the cycle at which the procedure continues (0 if there is no checkpoint).
+   */
+  CheckpointProcedure proc;
+  if (checkpointName.empty() || !ckp.read(su, proc))
+    return 0;
+
+  if (!unitTest)
+    std::cout << "Continuing from checkpoint " << checkpointName << " at cycle " << proc.cycle << ".\n";
+
+  th = proc.th;
+  throughput = std::move(proc.throughput);
+  return proc.cycle;
+}
+
+void Procedure::writeCheckpoint(Checkpoint &ckp, StorageUnit *su, int cycle, ThroughputData th)
+{
+  //!< write a checkpoint at the start of cycle if needed. The file is written on a separate thread.
+  if (checkpointName.empty() || Ncheckpoint <= 0 || cycle % Ncheckpoint != 0)
+    return;
+
+  AsyncWriter::flush(); //!< the data until the checkpoint is on disk before the checkpoint
+  ckp.write(su, { cycle, th, throughput });
+}
+
 void Procedure::balanceCheckup(StorageUnit *su, bool balance, bool checkup, double Ahtot, int nrCycle, std::string pref)
 {
   /*
@@ -305,7 +447,7 @@ void Procedure::balanceCheckup(StorageUnit *su, bool balance, bool checkup, doub
   if (!unitTest) //!< Write battery state
   {
     const std::string name = su->getFullID() + "_state.csv";
-    std::ofstream file(PathVar::results / name);
+    std::ofstream file(PathVar::results / (outPrefix + name));
 
     if (file.is_open()) {
       std::vector<double> s; //!< #TODO if vector is removable.
@@ -319,7 +461,7 @@ void Procedure::balanceCheckup(StorageUnit *su, bool balance, bool checkup, doub
       file.close();
     } else {
       std::cout << "Error in Procedure::balanceCheckup. File:\n"
-                << PathVar::results / name << " could not be opened.\n";
+                << PathVar::results / (outPrefix + name) << " could not be opened.\n";
     }
   }
   //!< balance
@@ -372,6 +514,10 @@ Status Procedure::rebalance(StorageUnit *su)
    * Bring all lowest-level cells to the same voltage and 0 current.
    * The voltage we bring them to is given by Vset
    *
+   * The cells are independent, so they are balanced in parallel.
+   * If fastBalance, the cells go directly to their relaxed state at Vset (Cell::setRelaxedVoltage),
+   * which is what the CCCV converges to but without simulating the balancing current (so it does not age the cells).
+   *
    * Note, this is a very crude balancing algorithm.
    * Normally you would go to the mean of all cells in a module, and use hierarchical balancing between modules
    *
@@ -381,28 +527,31 @@ Status Procedure::rebalance(StorageUnit *su)
   constexpr double dt = 1;
   constexpr int ndata = 0;
 
-  //!< if it is a module, recursively call this function on all children to rebalance the cells
-  if (auto m = dynamic_cast<Module *>(su)) {
-    for (auto &cs_k : m->getSUs()) {
-      const auto status = rebalance(cs_k.get());
-      if (!isStatusSuccessful(status)) {
-        const auto k = std::distance(m->getSUs()[0].get(), cs_k.get());
-        std::cout << "Error when rebalancing of SU " << k << " whose ID = "
-                  << cs_k->getFullID() << ", error " << getStatusMessage(status) << ".\n";
-
-        return status;
-      }
+  std::vector<Cell *> cells;
+  visit_SUs(su, [&cells](auto *su_now) {
+    if (auto c = dynamic_cast<Cell *>(su_now))
+      cells.push_back(c);
+  });
+
+  std::vector<Status> status(cells.size(), Status::Success);
+  auto task_indv = [&](int i) {
+    auto *c = cells[i];
+    if (fastBalance)
+      status[i] = c->setRelaxedVoltage(balance_voltage);
+    else {
+      ThroughputData th{};
+      Cycler(c).CCCV(c->Cap() * Cset, balance_voltage, c->Cap() * Clim, dt, ndata, th); //!< #TODO if we can do it without a cycler since it initialises a string?
+      status[i] = c->setCurrent(0, true, true);                                          //!< set the current of the cell to 0
     }
+  };
+  slide::run(task_indv, static_cast<int>(cells.size()));
 
-  } else if (typeid(*su) == typeid(Cell_SPM)) { // #TODO why only SPM?
-    const double Iset = su->Cap() * Cset;
-    const double Ilim = su->Cap() * Clim;
-    ThroughputData th{};
-    Cycler(su).CCCV(Iset, balance_voltage, Ilim, dt, ndata, th); //!< #TODO if we can do it without a cycler since it initialises a string?
-    auto status = su->setCurrent(0, true, true);                 //!< set the current of the cell to 0
-
-    if (isStatusBad(status)) return status; //!< #TODO -> we are doing this because previously setCurrent was throwing.
-  }
+  for (size_t i = 0; i < cells.size(); i++)
+    if (isStatusBad(status[i]) || status[i] == Status::Invalid_Vset) { //!< #TODO -> we are doing this because previously setCurrent was throwing.
+      std::cout << "Error when rebalancing the cell with ID = " << cells[i]->getFullID()
+                << ", error " << getStatusMessage(status[i]) << ".\n";
+      return status[i];
+    }
 
   return Status::Success;
 }
@@ -444,14 +593,15 @@ void Procedure::checkUp(StorageUnit *su, double Ah, int nrCycle)
   checkUp_prep(su); //!< bring to correct voltage
 
   //!< get a vector with pointers to the cells
+  //!< the capacity test restores the states of each cell afterwards (backupStates/restoreStates), so the cells don't have to be copied
   std::vector<Cell *> cells;
 
-  auto copyCells = [&cells](auto *su_now) {
+  auto getCells = [&cells](auto *su_now) {
     if (auto c = dynamic_cast<Cell *>(su_now))
-      cells.push_back(static_cast<Cell *>(c->copy()));
+      cells.push_back(c);
   };
 
-  visit_SUs(su, copyCells);
+  visit_SUs(su, getCells);
 
   //!< write the usage stats of all cells in a separate document
   // if constexpr (settings::DATASTORE_CELL == settings::cellDataStorageLevel::storeHistogramData)
@@ -464,12 +614,14 @@ void Procedure::checkUp(StorageUnit *su, double Ah, int nrCycle)
 
   //!< If this is the first checkup, start by writing the cell IDs and cell-to-cell parameters
   //!< else write the cumulative charge throughput
-  file.open(name, std::ios_base::app); //!< open from scratch, clear whatever was in the file before
+  file.open(PathVar::results / (outPrefix + name), std::ios_base::app); //!< append to the check-ups which were done before
 
   file << "ID,var_cap,var_R,var_degSEI,var_degLAM,Ah,CycleNumber";
   file << "time [s],Current throughput [Ah],Energy throughput [Wh],Capacity [Ah],States\n";
 
-  for (auto &cell : cells) {
+  const auto caps = testCapacities(cells); //!< in parallel, the rows are still written in the order of the cells
+  for (size_t i_cell = 0; i_cell < cells.size(); i_cell++) {
+    auto *cell = cells[i_cell];
     file << cell->getFullID() << ','; //!< first column is cell IDs
 
     //!< columns 2-5 is are the variation-parameter (capacity, resistance, SEI degradation rate, LAM degradation rate spread)
@@ -480,10 +632,9 @@ void Procedure::checkUp(StorageUnit *su, double Ah, int nrCycle)
     //!< Write the charge throughput and cycle number of the entire battery (identical for all cells)
     file << Ah << ',' << nrCycle << ',';
 
-    const auto th = cell->getThroughputs();       // #TODO if throughputs are saved then they should be included in states. Therefore this should not be needed.
-    const auto cap = Cycler(cell).testCapacity(); // #TODO this should be done in parallel.
+    const auto th = cell->getThroughputs(); // #TODO if throughputs are saved then they should be included in states. Therefore this should not be needed.
 
-    file << th.time() << ',' << th.Ah() << ',' << th.Wh() << ',' << cap;
+    file << th.time() << ',' << th.Ah() << ',' << th.Wh() << ',' << caps[i_cell];
 
     const auto st_view = cell->viewStates();         //!< write the state of a cell, if an SPM cell, skip the concentration states since they don't give info
     for (size_t i{ start }; i < st_view.size(); i++) //!< loop for each state variable (rows)
@@ -499,6 +650,64 @@ void Procedure::checkUp(StorageUnit *su, double Ah, int nrCycle)
   if (!unitTest) std::cout << "Finishing the check-up after Ah = " << Ah << '\n';
 }
 
+std::vector<double> Procedure::testCapacities(const std::vector<Cell *> &cells)
+{
+  /*
+   * Measure the capacity of each cell with a slow full (dis)charge (see Cycler::testCapacity).
+   * The cells are independent, so the tests are done in parallel.
+   *
+   * If capTol > 0, the capacity of an SPM cell is first estimated from the capacity at its last full test:
+   * 		lithium-limited 	cap_ref - (LLI - LLI_ref)
+   * 		electrode-limited 	cap_ref * AM / AM_ref 	for the cathode and anode, with AM = thickness * volume fraction
+   * The smallest of the three is used if it differs less than capTol (relative) from cap_ref, else the full test is done.
+   * This first-order estimate ignores changes in the usable stoichiometry windows (e.g. due to a larger resistance),
+   * so capTol should be small and every so often a full test is done anyway.
+   *
+   * IN
+   * cells 	cells to test, their states are restored after the test
+   *
+   * OUT
+   * capacity of each cell [Ah], 0 if the test failed
+   */
+  std::vector<double> caps(cells.size());
+  std::vector<size_t> full; //!< indices of the cells which need a full test
+  full.reserve(cells.size());
+
+  auto degradationStates = [](Cell_SPM *c) {
+    auto &st = c->getStateObj();
+    return CapacityReference{ 0, st.LLI(), st.thickp() * st.ep(), st.thickn() * st.en() };
+  };
+
+  for (size_t i = 0; i < cells.size(); i++) {
+    auto *c = dynamic_cast<Cell_SPM *>(cells[i]);
+    const auto ref = capReference.find(cells[i]->getFullID());
+    if (capTol > 0 && c && ref != capReference.end()) {
+      const auto &r = ref->second;
+      const auto now = degradationStates(c);
+      const double cap_est = std::min({ r.cap - (now.LLI - r.LLI) / 3600.0, r.cap * now.AMp / r.AMp, r.cap * now.AMn / r.AMn });
+
+      if (std::abs(cap_est / r.cap - 1) < capTol) {
+        caps[i] = cap_est;
+        continue;
+      }
+    }
+    full.push_back(i);
+  }
+
+  auto task_indv = [&](int k) { caps[full[k]] = Cycler(cells[full[k]]).testCapacity(); };
+  slide::run(task_indv, static_cast<int>(full.size()));
+
+  if (capTol > 0)
+    for (auto i : full)
+      if (auto *c = dynamic_cast<Cell_SPM *>(cells[i]); c && caps[i] > 0) {
+        auto r = degradationStates(c);
+        r.cap = caps[i];
+        capReference[cells[i]->getFullID()] = r;
+      }
+
+  return caps;
+}
+
 void Procedure::checkUp_prep(StorageUnit *su)
 {
   /*
@@ -531,15 +740,15 @@ void Procedure::checkMod(StorageUnit *su)
   std::string name_hist = su->getFullID() + "_checkModules_histograms.csv";
 
   //!< create file and write module ID names
-  std::ofstream file_overall(PathVar::results / name_overall); //!< open from scratch, clear whatever was in the file before
-  std::ofstream file_histograms(PathVar::results / name_hist); //!< open from scratch, clear whatever was in the file before
+  std::ofstream file_overall(PathVar::results / (outPrefix + name_overall)); //!< open from scratch, clear whatever was in the file before
+  std::ofstream file_histograms(PathVar::results / (outPrefix + name_hist)); //!< open from scratch, clear whatever was in the file before
 
   if (!file_overall.is_open())
-    std::cerr << "Error in Procedure::checkMod, the file " << PathVar::results / name_overall
+    std::cerr << "Error in Procedure::checkMod, the file " << PathVar::results / (outPrefix + name_overall)
               << " is not open!. Skipping this checkup.\n";
 
   if (!file_histograms.is_open())
-    std::cerr << "Error in Procedure::checkMod, the file " << PathVar::results / name_hist
+    std::cerr << "Error in Procedure::checkMod, the file " << PathVar::results / (outPrefix + name_hist)
               << " is not open!. Skipping this checkup.\n";
 
   file_overall << "Full ID,";              //!< Module IDs
@@ -615,13 +824,13 @@ void Procedure::writeThroughput(const std::string &SUID, double Ahtot)
   std::string name = SUID + "_throughput.csv";
   std::ofstream file;
   if (Ahtot == 0) {
-    file.open(PathVar::results / name); //!< open from scratch, clear whatever was in the file before
+    file.open(PathVar::results / (outPrefix + name)); //!< open from scratch, clear whatever was in the file before
     file << "ID number" << ',' << "cells charge throughput" << ','
          << "Cells energy throughput" << ','
          << "total energy to operate the thermal management system" << ','
          << "losses in the converter" << '\n';
   } else
-    file.open(PathVar::results / name, std::ios_base::app); //!< append to the existing file
+    file.open(PathVar::results / (outPrefix + name), std::ios_base::app); //!< append to the existing file
 
   //!< Write the data
   for (const auto &th : throughput)
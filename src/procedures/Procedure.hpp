@@ -8,6 +8,8 @@
 #pragma once
 
 #include "Cycler.hpp"
+#include "Checkpoint.hpp"
+#include "Protocol.hpp"
 #include "../cells/Cell.hpp"
 #include "../modules/Module.hpp"
 #include "../system/Battery.hpp"
@@ -16,6 +18,9 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <filesystem>
+#include <map>
+#include <string>
 
 namespace slide {
 
@@ -26,27 +31,57 @@ protected:
   bool unitTest{ false };
   int ndata{ 0 };
   double balance_voltage{ 3.65 };
+  bool fastBalance{ false }; //!< balance by setting the cells directly to their relaxed state instead of a CCCV
 
   std::vector<ProcedureThroughputData> throughput;
   void storeThroughput(ThroughputData th, StorageUnit *su);
 
+  std::string outPrefix{}; //!< start of the names of the files written by the procedure, see setOutputPrefix
+
+  std::filesystem::path checkpointName{}; //!< checkpoint file, empty if no checkpoints are used
+  int Ncheckpoint{ 0 };                   //!< write a checkpoint every Ncheckpoint cycles, 0 to only restore
+  int restoreCheckpoint(Checkpoint &ckp, StorageUnit *su, ThroughputData &th);
+  void writeCheckpoint(Checkpoint &ckp, StorageUnit *su, int cycle, ThroughputData th);
+
+  struct CapacityReference
+  {
+    double cap{ 0 }, LLI{ 0 }, AMp{ 0 }, AMn{ 0 }; //!< capacity [Ah], lost lithium [As] and active material [m] of a cell at its last full capacity test
+  };
+  double capTol{ 0 };                                    //!< see setCapacityEstimate
+  std::map<std::string, CapacityReference> capReference; //!< last full capacity test of each cell, by full ID
+
 public:
   Procedure() = default;
   Procedure(bool balance, double Vbal, int ndata, bool unitTest = false);
 
   ~Procedure() = default;
 
+  //!< restart from the checkpoint name if it exists, and write one every Nevery cycles
+  void setCheckpoint(std::filesystem::path name, int Nevery)
+  {
+    checkpointName = std::move(name);
+    Ncheckpoint = Nevery;
+  }
+
+  //!< start the names of the check-up, state and throughput files with pref, e.g. "folder/" to write them in a subfolder of the results
+  void setOutputPrefix(std::string pref) { outPrefix = std::move(pref); }
+
   void cycleAge(StorageUnit *su, bool testCV);
   void cycleAge(StorageUnit *su, int Ncycle, int Ncheck, int Nbal, bool testCV, double Ccha, double Cdis, double Vmax, double Vmin);
   void useCaseAge(StorageUnit *su, int cool);
+  Status runProtocol(StorageUnit *su, const Protocol &prot, double dt = 2, const std::string &pref = "protocol");
 
   //!< function calls
   void balanceCheckup(StorageUnit *su, bool balance, bool checkup, double Ah, int nrCycle, std::string pref);
 
   //!< balancing
   Status rebalance(StorageUnit *su);
+  void setFastBalance(bool fast) { fastBalance = fast; }
 
   //!< check-up procedures
+  //!< estimate the capacity from the lost lithium and active material if it changed less than tol (relative) since the last full test, 0 to always do the full test
+  void setCapacityEstimate(double tol) { capTol = tol; }
+  std::vector<double> testCapacities(const std::vector<Cell *> &cells); //!< capacity of each cell, in the same order
   void checkUp(StorageUnit *su, double Ah, int nrCycle); //!< main checkup function which will call the others
   void checkUp_prep(StorageUnit *su);                    //!< bring the SU to a good voltage
   void checkUp_writeInitial(std::vector<Cell *> &cells, std::ofstream &file);
@@ -0,0 +1,319 @@
+/*
+ * Protocol.cpp
+ *
+ * Parser of the protocol language, see Protocol.hpp
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#include "Protocol.hpp"
+#include "../utility/io/MappedFile.hpp"
+
+#include <charconv>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+namespace slide {
+namespace {
+struct Token
+{
+  std::string s;
+  bool quoted{ false };
+};
+
+struct Quantity
+{
+  double value{ 0 };
+  std::string unit;
+};
+
+bool isNumberStart(char c) { return std::isdigit(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '+'; }
+
+std::vector<Token> tokenise(std::string_view line)
+{
+  /*
+   * Split a line in tokens at white space.
+   * Quoted tokens are kept as they are, the others are lower case and a number directly followed by a unit ("4.2V")
+   * is split into two tokens.
+   */
+  std::vector<Token> tok;
+  size_t i = 0;
+  while (i < line.size()) {
+    if (std::isspace(static_cast<unsigned char>(line[i]))) {
+      i++;
+      continue;
+    }
+
+    if (line[i] == '"') {
+      const auto close = line.find('"', i + 1);
+      const auto last = (close == std::string_view::npos) ? line.size() : close;
+      tok.push_back({ std::string(line.substr(i + 1, last - i - 1)), true });
+      i = last + 1;
+      continue;
+    }
+
+    size_t j = i;
+    while (j < line.size() && !std::isspace(static_cast<unsigned char>(line[j]))) j++;
+
+    std::string word(line.substr(i, j - i));
+    std::transform(word.begin(), word.end(), word.begin(), [](unsigned char c) { return std::tolower(c); });
+    i = j;
+
+    if (isNumberStart(word[0])) {
+      double x;
+      const auto [next, ec] = std::from_chars(word.data(), word.data() + word.size(), x);
+      if (ec == std::errc() && next != word.data() + word.size()) {
+        const auto nnum = static_cast<size_t>(next - word.data());
+        tok.push_back({ word.substr(0, nnum) });
+        tok.push_back({ word.substr(nnum) });
+        continue;
+      }
+    }
+    tok.push_back({ std::move(word) });
+  }
+  return tok;
+}
+
+class LineParser
+{
+  const std::vector<Token> &tok;
+  size_t k{ 0 };
+  int lineNr;
+  std::string_view line;
+
+public:
+  LineParser(const std::vector<Token> &tok_, int lineNr_, std::string_view line_) : tok(tok_), lineNr(lineNr_), line(line_) {}
+
+  [[noreturn]] void error(std::string_view msg) const
+  {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "ERROR in Protocol on line " << lineNr << " '" << line << "': " << msg << ".\n";
+    throw 1;
+  }
+
+  bool done() const { return k >= tok.size(); }
+  const std::string &peek() const { return tok[k].s; }
+
+  const Token &next(std::string_view what)
+  {
+    if (done()) error(std::string("expected ") + std::string(what) + " at the end of the line");
+    return tok[k++];
+  }
+
+  bool accept(std::string_view word)
+  {
+    if (done() || tok[k].quoted || tok[k].s != word) return false;
+    k++;
+    return true;
+  }
+
+  void expect(std::string_view word)
+  {
+    if (!accept(word)) error(std::string("expected '") + std::string(word) + "'");
+  }
+
+  double number()
+  {
+    const auto &s = next("a number").s;
+    double x;
+    const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), x);
+    if (ec != std::errc() || ptr != s.data() + s.size()) error("'" + s + "' is not a number");
+    return x;
+  }
+
+  int integer()
+  {
+    const double x = number();
+    if (x < 0 || x != static_cast<int>(x)) error("expected a non-negative integer");
+    return static_cast<int>(x);
+  }
+
+  Quantity quantity()
+  {
+    /*
+     * A number followed by its unit, or a C-rate written as C/x.
+     */
+    if (!done() && peek().size() > 2 && peek().compare(0, 2, "c/") == 0) {
+      const auto &s = tok[k++].s;
+      double x;
+      const auto [ptr, ec] = std::from_chars(s.data() + 2, s.data() + s.size(), x);
+      if (ec != std::errc() || ptr != s.data() + s.size() || x <= 0) error("'" + s + "' is not a valid C-rate");
+      return { 1.0 / x, "c" };
+    }
+    const double x = number();
+    return { x, next("a unit").s };
+  }
+
+  double duration()
+  {
+    /*
+     * A time in s, min or h, returned in seconds.
+     */
+    const auto [x, unit] = quantity();
+    double t{ x };
+    if (unit == "s" || unit == "sec" || unit == "second" || unit == "seconds")
+      t = x;
+    else if (unit == "min" || unit == "minute" || unit == "minutes")
+      t = x * 60;
+    else if (unit == "h" || unit == "hr" || unit == "hour" || unit == "hours")
+      t = x * 3600;
+    else
+      error("'" + unit + "' is not a unit of time");
+
+    if (t <= 0) error("the duration must be positive");
+    return t;
+  }
+};
+} // namespace
+
+Protocol::Protocol(std::string_view text)
+{
+  /*
+   * Parse the protocol in text.
+   *
+   * THROWS
+   * 1 	syntax error, the line is printed
+   */
+  std::vector<int> open; //!< indices of the repeat steps without an end yet
+  int lineNr{ 0 };
+  while (!text.empty()) {
+    const auto eol = text.find('\n');
+    auto line = text.substr(0, eol);
+    text = (eol == std::string_view::npos) ? std::string_view{} : text.substr(eol + 1);
+    lineNr++;
+
+    if (const auto hash = line.find('#'); hash != std::string_view::npos) line = line.substr(0, hash);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    parseLine(line, lineNr, open);
+  }
+
+  if (!open.empty()) {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "ERROR in Protocol, " << open.size() << " repeat(s) without an end.\n";
+    throw 1;
+  }
+}
+
+void Protocol::parseLine(std::string_view line, int lineNr, std::vector<int> &open)
+{
+  const auto tok = tokenise(line);
+  if (tok.empty()) return;
+
+  LineParser p(tok, lineNr, line);
+  ProtocolStep s{};
+  const auto cmd = p.next("a command").s;
+
+  if (cmd == "rest") {
+    s.type = ProtocolStep::Type::rest;
+    p.expect("for");
+    s.tlim = p.duration();
+  } else if (cmd == "charge" || cmd == "discharge") {
+    p.expect("at");
+    const auto [x, unit] = p.quantity();
+    if (x <= 0) p.error("the current or power must be positive, the direction is given by charge or discharge");
+
+    s.value = (cmd == "charge") ? -x : x; //!< charging is a negative current
+    if (unit == "w")
+      s.type = ProtocolStep::Type::CP;
+    else if (unit == "a" || unit == "c") {
+      s.type = ProtocolStep::Type::CC;
+      s.Crate = (unit == "c");
+    } else
+      p.error("'" + unit + "' is not a unit of current or power");
+
+    while (!p.done()) {
+      if (p.accept("or") || p.accept("and")) continue;
+      if (p.accept("until")) {
+        const auto [v, vunit] = p.quantity();
+        if (vunit != "v") p.error("a (dis)charge can only stop at a voltage");
+        s.vlim = v;
+      } else if (p.accept("for"))
+        s.tlim = p.duration();
+      else
+        p.error("unexpected '" + p.peek() + "'");
+    }
+  } else if (cmd == "hold") {
+    s.type = ProtocolStep::Type::CV;
+    p.expect("at");
+    const auto [v, vunit] = p.quantity();
+    if (vunit != "v") p.error("hold needs a voltage");
+    s.value = v;
+
+    while (!p.done()) {
+      if (p.accept("or") || p.accept("and")) continue;
+      if (p.accept("until")) {
+        const auto [I, Iunit] = p.quantity();
+        if (Iunit != "a" && Iunit != "c") p.error("hold can only stop at a current");
+        s.Ilim = std::abs(I);
+        s.Crate = (Iunit == "c");
+      } else if (p.accept("for"))
+        s.tlim = p.duration();
+      else
+        p.error("unexpected '" + p.peek() + "'");
+    }
+    if (s.Ilim == 0 && s.tlim == TIME_INF) p.error("hold needs a current or time limit");
+  } else if (cmd == "profile") {
+    s.type = ProtocolStep::Type::profile;
+    s.value = 1;
+    const auto &name = p.next("the name of the profile");
+    if (!name.quoted) p.error("the name of the profile must be between double quotes");
+    s.n = static_cast<int>(profiles.size());
+    profiles.emplace_back(name.s);
+
+    while (!p.done()) {
+      if (p.accept("or") || p.accept("and")) continue;
+      if (p.accept("power"))
+        s.power = true;
+      else if (p.accept("scale")) {
+        s.value = p.number();
+        s.Crate = p.accept("c");
+      } else if (p.accept("for"))
+        s.tlim = p.duration();
+      else
+        p.error("unexpected '" + p.peek() + "'");
+    }
+    if (s.power && s.Crate) p.error("a power profile cannot be scaled with a C-rate");
+  } else if (cmd == "repeat") {
+    s.type = ProtocolStep::Type::repeat;
+    s.n = p.integer();
+    p.accept("times");
+    open.push_back(static_cast<int>(steps.size()));
+    depth = std::max(depth, static_cast<int>(open.size()));
+  } else if (cmd == "end") {
+    if (open.empty()) p.error("end without repeat");
+    s.type = ProtocolStep::Type::end;
+    s.jump = open.back();
+    steps[open.back()].jump = static_cast<int>(steps.size());
+    open.pop_back();
+  } else if (cmd == "checkup" || cmd == "balance") {
+    s.type = (cmd == "checkup") ? ProtocolStep::Type::checkup : ProtocolStep::Type::balance;
+    s.n = 1;
+    if (p.accept("every")) {
+      s.n = p.integer();
+      if (s.n == 0) p.error("the period must be at least 1");
+    }
+  } else
+    p.error("unknown command '" + cmd + "'");
+
+  if (!p.done()) p.error("unexpected '" + p.peek() + "'");
+  steps.push_back(s);
+}
+
+Protocol Protocol::fromFile(const std::filesystem::path &name)
+{
+  /*
+   * Parse the protocol in the file name.
+   *
+   * THROWS
+   * 1 	syntax error
+   * 2 	the file could not be opened
+   */
+  MappedFile file(name);
+  return Protocol(std::string_view(file.data(), file.size()));
+}
+} // namespace slide
@@ -0,0 +1,71 @@
+/*
+ * Protocol.hpp
+ *
+ * A test protocol written in a small text language, parsed once into a flat program of steps
+ * which can be run by Procedure::runProtocol on any StorageUnit.
+ * A Protocol does not change after it is parsed, so one Protocol can be run on many storage units in parallel.
+ *
+ * Language, one step per line, case insensitive, everything after # is a comment:
+ * 	rest for 4 h
+ * 	charge at 1 C [until 4.2 V] [for 2 h] 		CC (dis)charge, the current can be given in A or C, the power in W (CP)
+ * 	discharge at 10 W [until 2.7 V] [for 30 min] 	without a voltage limit the limit of the storage unit is used
+ * 	hold at 4.2 V [until C/20] [for 1 h] 		CV until the current is below the limit (in A or C)
+ * 	profile "file.csv" [power] [scale 2 C] [for 1 h] 	current (or power) profile, with 1 s samples
+ * 	repeat 100 									the steps until the matching 'end' are repeated 100 times
+ * 	end
+ * 	checkup every 50 							do a check-up (or balance) in every 50th iteration of the innermost loop
+ * 	balance every 10
+ * Durations can be given in s, min or h. Rest and hold steps must have a limit.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "../settings/settings.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+#include <limits>
+
+namespace slide {
+struct ProtocolStep
+{
+  enum class Type : uint8_t { rest, CC, CV, CP, profile, repeat, end, checkup, balance };
+
+  Type type{ Type::rest };
+  bool Crate{ false };                                      //!< the current (CC, profile scale) or current limit (CV) is a C-rate
+  bool power{ false };                                      //!< profile of powers instead of currents
+  double value{ 0 };                                        //!< current [A or C] (CC), power [W] (CP), voltage [V] (CV), scale (profile)
+  double vlim{ std::numeric_limits<double>::quiet_NaN() }; //!< voltage limit of CC and CP [V], NaN to use the limit of the storage unit
+  double Ilim{ 0 };                                         //!< current limit of CV [A or C]
+  double tlim{ TIME_INF };                                  //!< time limit [s]
+  int n{ 0 };    //!< repeat: number of iterations, checkup and balance: period in iterations, profile: index in Protocol::getProfiles()
+  int jump{ 0 }; //!< repeat: index of the matching end, end: index of the matching repeat
+};
+
+class Protocol
+{
+  std::vector<ProtocolStep> steps;
+  std::vector<std::filesystem::path> profiles; //!< files of the profile steps
+  int depth{ 0 };                              //!< maximum number of nested loops
+
+  void parseLine(std::string_view line, int lineNr, std::vector<int> &open);
+
+public:
+  Protocol() = default;
+  explicit Protocol(std::string_view text);
+
+  static Protocol fromFile(const std::filesystem::path &name);
+
+  const auto &getSteps() const { return steps; }
+  const auto &getProfiles() const { return profiles; }
+  int getDepth() const { return depth; }
+  size_t size() const { return steps.size(); }
+};
+} // namespace slide
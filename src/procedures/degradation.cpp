@@ -2,8 +2,8 @@
  * degradation.cpp
  *
  * Implements simulations for degradation experiments where multiple cells undergo similar degradation experiments but with different parameters (e.g. different temperatures, voltage windows, C rates, etc).
- * The exact degradation procedures are defined in the Cycler.
- * In the functions defined here, the functions from the Cycler are called various times with slightly different parameters.
+ * Each experiment cycles one cell with the Cycler and does regular check-ups with a Procedure.
+ * The experiments are independent jobs (see slide::runJobs), so they run in parallel and a campaign which was interrupted only repeats the experiments which did not finish.
  * As such, we can simulate the effect the different parameters have on battery degradation
  *
  * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
@@ -13,54 +13,115 @@
 
 //!< Include header files
 #include "degradation.hpp"
-#include "cycler.hpp"
-#include "cell_user.hpp"
+#include "Cycler.hpp"
+#include "Procedure.hpp"
+#include "../cells/cells.hpp"
 #include "../utility/utility.hpp"
+#include "../utility/util_error.hpp"
+#include "../utility/parallelisation.hpp"
+#include "../utility/io/AsyncWriter.hpp"
+#include "../utility/io/ProfileStream.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <array>
+#include <vector>
+#include <algorithm>
+
+namespace slide {
+namespace {
+  std::unique_ptr<Cell_SPM> makeCell(int cellType, const DEG_ID &degid, double Ti)
+  {
+    //!< the cell of an experiment, at the temperature Ti [K] of its environment
+    if (cellType == LGChemNMC) {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "ERROR in degradation: the LG Chem cell is not available in this version, use cellType KokamNMC or UserCell.\n";
+      throw 3;
+    }
 
-void Cycle_one(const struct slide::Model_SPM &M, const struct DEG_ID &degid, int cellType, int verbose, //!< simulate one cycle ageing experiment
-               const struct CycleAgeingConfig &cycAgConfig, bool CVcha, double Icutcha, bool CVdis, double Icutdis, int timeCycleData, int nrCycles, int nrCap, struct checkUpProcedure &proc, const std::string &pref)
-{
-  Cycle_one(M, degid, cellType, verbose, cycAgConfig.Vma, cycAgConfig.Vmi, //!< simulate one cycle ageing experiment
-            cycAgConfig.Ccha,
-            CVcha,
-            Icutcha,
-            cycAgConfig.Cdis,
-            CVdis,
-            Icutdis,
-            cycAgConfig.Ti(),
-            timeCycleData,
-            nrCycles,
-            nrCap,
-            proc,
-            cycAgConfig.get_name(pref));
-}
+    //!< the default parameters of Cell_SPM are the ones of the high power Kokam NMC cell, a user cell changes them in Cell_SPM
+    auto c = std::make_unique<Cell_SPM>("cell", degid, 1, 1, 1, 1);
+    c->setTenv(Ti);
+    c->setT(Ti);
+    return c;
+  }
+
+  std::string outputPrefix(const std::filesystem::path &dir)
+  {
+    //!< every file is written in PathVar::results / (prefix + name), so a prefix with the relative path of dir writes in dir
+    return (std::filesystem::relative(dir, PathVar::results) / "").generic_string();
+  }
+
+  int dataSteps(int timeCycleData, double dt)
+  {
+    //!< number of time steps of dt between stored data points, 0 if no data is stored
+    return (timeCycleData > 0) ? std::max(1, static_cast<int>(std::lround(timeCycleData / dt))) : 0;
+  }
+
+  void check(bool reached, Status succ, const std::string &what, int n)
+  {
+    //!< throw if a step of an experiment did not end at its limit, so the experiment is not marked as finished
+    if (!reached) {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "ERROR in a degradation experiment when " << what << " in cycle " << n << ": " << getStatusMessage(succ) << '\n';
+      throw 15;
+    }
+  }
+
+  void runExperiment(const std::string &fun, const std::string &name, auto &&experiment)
+  {
+    //!< run an experiment, explain error 15 and throw the error on, so runJobs does the experiment again on the next run
+    try {
+      experiment();
+    } catch (int err) {
+      std::cout << fun << " experienced error " << err << " during execution of " << name << ", abort this test.\n";
+      if (err == 15) {
+        std::cout << "Error 15 means that the cell had degraded too much to continue simulating.\n"
+                     "This can be due to too much SEI growth, too much loss of lithium, too much loss of active material (thin electrodes, low volume fraction, or low effective surface)\n"
+                     "too much surface cracking, too low diffusion constants, too high resistance, or too much lithium plating.\n"
+                     "Continue simulating might lead to errors in the code so the simulation of this degradation test is stopped.\n"
+                     "The results which have been written are all valid and you can ignore the error messages above which explained where this error comes from.\n";
+      }
+      throw;
+    }
+  }
+
+  Status CCCV(Cycler &cyc, double I, double Vset, double Ilim, double dt, int ndt_data, ThroughputData &th)
+  {
+    //!< Cycler::CCCV overwrites the throughput it gets, so it is added to th here
+    ThroughputData th_now{};
+    const auto succ = cyc.CCCV(I, Vset, Ilim, dt, ndt_data, th_now);
+    th.time() += th_now.time();
+    th.Ah() += th_now.Ah();
+    th.Wh() += th_now.Wh();
+    return succ;
+  }
+
+  void finish(Cycler &cyc, Procedure &proc, Cell_SPM &c, double Ah, int n)
+  {
+    //!< final check-up, and write the data which is still stored so it is all in the folder when the job is marked as done
+    proc.checkUp(&c, Ah, n);
+    proc.writeThroughput(c.getFullID(), Ah);
+    if constexpr (settings::DATASTORE_CELL != settings::cellDataStorageLevel::noStorage)
+      cyc.writeData();
+    AsyncWriter::flush();
+  }
+} // namespace
 
-void Calendar_one(const struct slide::Model_SPM &M, const struct DEG_ID &degid, int cellType, int verbose,
-                  double V, double Ti, int Time, int mode, int timeCycleData, int timeCheck, struct checkUpProcedure &proc, std::string name)
+void Calendar_one(const DEG_ID &degid, int cellType, double V, double Ti, int Time, int mode, int timeCycleData, int timeCheck,
+                  const std::filesystem::path &dir)
 {
   /*
    * Function which simulates one calendar ageing regime.
-   * It does little more than calling the corresponding function from cycler.cpp
+   * The cell rests at a given voltage, with a check-up every timeCheck days.
    *
    * IN
-   * M 			matrices of the spatial discretisation for the solid diffusion PDE
    * degid 		struct with degradation settings (which degradation models to be used)
    * cellType 	integer deciding which cell to use for the simulation
    *  				0 	Kokam cell (high power Kokam NMC)
    *  				1 	Panasonic cell (high energy LGChem NMC)
    *  				2 	user cell
-   * verbose 		integer indicating how verbose the simulation has to be.
-   * 				The higher the number, the more output there is.
-   * 				Recommended value is 1, only use higher values for debugging
-   * 				From 4 (and above) there will be too much info printed to follow what is going on, but this might be useful for debugging to find where the error is and why it is happening
-   * 					0 	almost no messages are printed, only in case of critical errors related to illegal parameters
-   * 					1 	error messages are printed in case of critical errors which might crash the simulation
-   * 					2 	all error messages are printed, whether the simulation can recover from the errors or not
-   * 					3 	on top of the output from 2, a message is printed every time a function in the Cycler and BasicCycler is started and terminated
-   * 					4 	on top of the output from 3, the high-level flow of the program in the Cycler is printed (e.g. 'we are going to discharge the cell')
-   * 					5 	on top of the output from 4, the low-level flow of the program in the BasicCycler is printed (e.g. 'in time step 101, the voltage is 3.65V')
-   * 					6 	on top of the output from 5, we also print details of the nonlinear search for the current needed to do a CV phase
-   * 					7 	on top of the output from 6, a message is printed every time a function in the Cell is started and terminated
    * V 			the voltage at which the battery has to rest [V]
    * Ti 			the temperature at which the battery has to rest [K]
    * Time 		the time for which the battery has to rest [days]
@@ -75,267 +136,177 @@ void Calendar_one(const struct slide::Model_SPM &M, const struct DEG_ID &degid,
    * 				if 0, no cycle data is stored
    * timeCheck 	the time after which a check-up has to be done [days]
    * 				the total rest time is floored to the nearest multiple of timeCheck
-   * proc 		structure with the parameters of the check-up procedure with the following fields:
-   * 		blockDegradation 	if true [RECOMMENDED], degradation is not accounted for during this check-up,
-   * 								and at the end of the check-up, the exact battery state from the start of the check-up is restored
-   * 								if false [NOT RECOMMENDED], degradation is accounted for during this check-up,
-   * 								and at the end of the check-up, the cell's voltage and temperature are brought back to the levels from before the check-up
-   * 		capCheck 			boolean indicating if the capacity should be checked
-   * 		OCVCheck			boolean indicating if the half-cell OCV curves should be checked
-   * 		CCCVCheck			boolean indicating if some CCCV cycles should be done as part of the check-up procedure
-   * 		pulseCheck			boolean indicating if a pulse discharge test should be done as part of the check-up procedure
-   * 		includeCycleData	boolean indicating if the cycling data from the check-up should be included in the cycling data of the cell or not
-   * 		nCycles				number of different cycles to be simulated for the CCCV check-up (i.e. the length of the array crates)
-   * 		Crates				array with the Crates of the different cycles to be checked for the CCCV check-up, must be all positive
-   * 		Ccut				C rate of the cutoff current for the CV phase for the CCCV check-up, must be positive
-   * 		profileName 		name of the csv file which contains the current profile for the pulse test
-   * 								the first column contains the current in [A] (positive for discharge, negative for charge)
-   * 								the second column contains the time in [sec] the current should be maintained
-   * 								the profile must be a net discharge, i.e. sum (I*dt) > 0
-   * 		profileLength		length of the current profiles for the pulse test (number of rows in the csv file)
-   * name 		the name of the subfolder in which all the data for this simulation is written, must obey the naming convention for folders
-   * 				avoid special characters or spaces
+   * dir 			the folder in which all the data for this simulation is written
+   *
+   * THROWS
+   * 15 			the cell could not be brought to V, e.g. because it degraded too much
+   * 1014 		illegal input parameters
    */
-
-  //!< settings of the cycler
-  double dt = 2; //!< use a time step of 2 seconds
-  if (Ti < 40)
-    dt = 5; //!< a lower temperature allows a larger time step without numerical problems
-
-  //!< Make a cell, the type of the cell depending on the value of 'cellType' #TODO  -> There is a cast.
-  auto createCell = [&] {
-    if (cellType == 0)
-      return (Cell)Cell_KokamNMC(M, degid, verbose); //!< a high power NMC cell made by Kokam
-    else if (cellType == 1)
-      return (Cell)Cell_LGChemNMC(M, degid, verbose); //!< a high energy NMC cell made by LG Chem
-    else
-      return (Cell)slide::Cell_user(M, degid, verbose); //!< a user-defined cell
-  };
-
-  Cell c1 = createCell();
-
-  //!< Make the cycler
-  Cycler cycler(c1, name, verbose, timeCycleData);
-
-  //!< Call the Calendar-function of the cycler. Wrap it in a try-catch to avoid fatal errors
-  try {
-    cycler.calendarAgeing(dt, V, Ti, Time, timeCheck, mode, proc);
-  } catch (int err) {
-    //!< std::cout << "Throw test: " << 75 << '\n';
-    std::cout << "Calendar_one experienced error " << err << " during execution of " << name << ", abort this test.\n";
-    if (err == 15) //!< #TODO this is not valid anymore.
-    {
-      std::cout << "Error 15 means that the cell had degraded too much to continue simulating.\n"
-                   "This can be due to too much SEI growth, too much loss of lithium, too much loss of active material (thin electrodes, low volume fraction, or low effective surface)\n"
-                   "too much surface cracking, too low diffusion constants, too high resistance, or too much lithium plating.\n"
-                   "Continue simulating might lead to errors in the code so the simulation of this degradation test is stopped.\n"
-                   "The results which have been written are all valid and you can ignore the error messages above which explained where this error comes from.\n";
+  const double dt = (Ti < 40 + PhyConst::Kelvin) ? 5 : 2; //!< a lower temperature allows a larger time step without numerical problems
+  constexpr double day = 24 * 3600;
+
+  runExperiment("Calendar_one", dir.filename().string(), [&] {
+    auto c = makeCell(cellType, degid, Ti);
+    util::error::checkInputParam_CalAge(*c, V, Ti, Time, timeCheck, mode);
+
+    const auto pref = outputPrefix(dir);
+    Cycler cyc(c.get(), pref + "calendar");
+    Procedure proc(false, V, 0, true);
+    proc.setOutputPrefix(pref);
+
+    const int ndt_data = dataSteps(timeCycleData, dt);
+    ThroughputData th{};
+    auto recharge = [&](int n) {
+      const auto succ = CCCV(cyc, c->Cap(), V, c->Cap() / 100, dt, ndt_data, th);
+      check(isCurrentLimitReached(succ) || isVoltageLimitReached(succ), succ, "bringing the cell to the resting voltage", n);
+    };
+
+    for (int d = 0; d < Time; d++) {
+      if (d % timeCheck == 0) {
+        proc.checkUp(c.get(), th.Ah(), d);
+        recharge(d);
+      } else if (mode == 1)
+        recharge(d);
+
+      const auto succ = (mode == 2) ? cyc.CV(V, 0, day, dt, ndt_data, th) : cyc.rest(day, dt, ndt_data, th);
+      check(succ == Status::ReachedTimeLimit, succ, (mode == 2) ? "floating" : "resting", d);
     }
-  }
+
+    finish(cyc, proc, *c, th.Ah(), Time);
+  });
 }
 
-void Cycle_one(const struct slide::Model_SPM &M, const struct DEG_ID &degid, int cellType, int verbose, double Vma, double Vmi,
-               double Ccha, bool CVcha, double Ccutcha, double Cdis, bool CVdis, double Ccutdis, double Ti, int timeCycleData,
-               int nrCycles, int nrCap, struct checkUpProcedure &proc, std::string name)
+void Cycle_one(const DEG_ID &degid, int cellType, const CycleAgeingConfig &conf, bool CVcha, double Ccutcha, bool CVdis, double Ccutdis,
+               int timeCycleData, int nrCycles, int nrCap, const std::filesystem::path &dir)
 {
   /*
    * Function which simulates one cycle ageing regime.
-   * It does little more than calling the corresponding function from cycler.cpp
+   * The cell is cycled between the voltages of conf, with a check-up every nrCap cycles.
    *
    * IN
-   * M 			matrices of the spatial discretisation for the solid diffusion PDE
    * degid 		struct with degradation settings (which degradation models to be used)
    * cellType 	integer deciding which cell to use for the simulation
    *  				0 	Kokam cell (high power Kokam NMC)
    *  				1 	Panasonic cell (high energy LGChem NMC)
    *  				2 	user cell
-   * verbose 		integer indicating how verbose the simulation has to be.
-   * 				The higher the number, the more output there is.
-   * 				Recommended value is 1, only use higher values for debugging
-   * 				From 4 (and above) there will be too much info printed to follow what is going on, but this might be useful for debugging to find where the error is and why it is happening
-   * 					0 	almost no messages are printed, only in case of critical errors related to illegal parameters
-   * 					1 	error messages are printed in case of critical errors which might crash the simulation
-   * 					2 	all error messages are printed, whether the simulation can recover from the errors or not
-   * 					3 	on top of the output from 2, a message is printed every time a function in the Cycler and BasicCycler is started and terminated
-   * 					4 	on top of the output from 3, the high-level flow of the program in the Cycler is printed (e.g. 'we are going to discharge the cell')
-   * 					5 	on top of the output from 4, the low-level flow of the program in the BasicCycler is printed (e.g. 'in time step 101, the voltage is 3.65V')
-   * 					6 	on top of the output from 5, we also print details of the nonlinear search for the current needed to do a CV phase
-   * 					7 	on top of the output from 6, a message is printed every time a function in the Cell is started and terminated
-   * Vma 			maximum voltage of this cycle, below the maximum voltage of the cell [V]
-   * Vmi 			minimum voltage of this cycle, above the minimum voltage of the cell [V]
-   * Ccha 		C rate at which the battery should be charged during the CC phase[-]
+   * conf 		voltage window, C rates and temperature of the cycles
    * CVcha 		boolean indicating if a CV charge should be done after the CC charge (true) or not (false)
    * 				if true, charging is CC CV
    * 				if false, charging is CC only
-   * Ccutcha 		cutoff C rate for the CV charge [A], > 0
-   * Cdis 		C rate at which the battery should be discharged [-]
+   * Ccutcha 		cutoff C rate for the CV charge [-], > 0
    * CVdis 		boolean indicating if a CV discharge should be done after the CC discharge (true) or not (false)
    * 				if true, discharging is CC CV
    * 				if false, discharging is CC only
-   * Ccutdis 		cutoff C rate for the CV discharge [A], > 0
-   * Ti 			temperature at which the cell has to be cycled [K]
+   * Ccutdis 		cutoff C rate for the CV discharge [-], > 0
    * timeCycleData the time interval at which cycling data (e.g. the voltage of the cell) should be stored [s]
    * 				if 0, no cycle data is stored
    * nrCycles 	number of cycles to be simulated in total [-]
    * nrCap 		the number of cycles between consecutive check-ups [-]
-   * proc 		structure with the parameters of the check-up procedure with the following fields:
-   * 		blockDegradation 	if true [RECOMMENDED], degradation is not accounted for during this check-up,
-   * 								and at the end of the check-up, the exact battery state from the start of the check-up is restored
-   * 								if false [NOT RECOMMENDED], degradation is accounted for during this check-up,
-   * 								and at the end of the check-up, the cell's voltage and temperature are brought back to the levels from before the check-up
-   * 		capCheck 			boolean indicating if the capacity should be checked
-   * 		OCVCheck			boolean indicating if the half-cell OCV curves should be checked
-   * 		CCCVCheck			boolean indicating if some CCCV cycles should be done as part of the check-up procedure
-   * 		pulseCheck			boolean indicating if a pulse discharge test should be done as part of the check-up procedure
-   * 		includeCycleData	boolean indicating if the cycling data from the check-up should be included in the cycling data of the cell or not
-   * 		nCycles				number of different cycles to be simulated for the CCCV check-up (i.e. the length of the array crates)
-   * 		Crates				array with the Crates of the different cycles to be checked for the CCCV check-up, must be all positive
-   * 		Ccut				C rate of the cutoff current for the CV phase for the CCCV check-up, must be positive
-   * 		profileName 		name of the csv file which contains the current profile for the pulse test
-   * 								the first column contains the current in [A] (positive for discharge, negative for charge)
-   * 								the second column contains the time in [sec] the current should be maintained
-   * 								the profile must be a net discharge, i.e. sum (I*dt) > 0
-   * 		profileLength		length of the current profiles for the pulse test (number of rows in the csv file)
-   * name 		the name of the subfolder in which all the data for this simulation is written, must obey the naming convention for folders
-   * 				avoid special characters or spaces
+   * dir 			the folder in which all the data for this simulation is written
+   *
+   * THROWS
+   * 15 			a cycle did not end at its voltage or current limit, e.g. because the cell degraded too much
    */
-
-  //!< settings of the cycler
-  double dt = 2; //!< use a time step of 2 seconds to ensure numerical stability
-  if (Ti < 40)
-    dt = 3; //!< a lower temperature allows a larger time step without numerical problems
-
-  //!< Make a cell, the type of the cell depending on the value of 'cellType' #TODO  -> There is a cast.
-  auto createCell = [&] {
-    if (cellType == 0)
-      return (Cell)Cell_KokamNMC(M, degid, verbose); //!< a high power NMC cell made by Kokam
-    else if (cellType == 1)
-      return (Cell)Cell_LGChemNMC(M, degid, verbose); //!< a high energy NMC cell made by LG Chem
-    else
-      return (Cell)slide::Cell_user(M, degid, verbose); //!< a user-defined cell
-  };
-
-  Cell c1 = createCell();
-
-  //!< Make the cycler
-  Cycler cycler(c1, name, verbose, timeCycleData);
-
-  //!< Call the cycle ageing function from the cycler
-  try {
-    cycler.cycleAgeing(dt, Vma, Vmi, Ccha, CVcha, Ccutcha, Cdis, CVdis, Ccutdis, Ti, nrCycles, nrCap, proc);
-  } catch (int err) {
-    //!< std::cout << "Throw test: " << 76 << '\n';
-    std::cout << "Cycle_one experienced error " << err << " during execution of " << name << ", abort this test.\n";
-    if (err == 15) //!< #TODO this is not valid anymore.
-    {
-      std::cout << "Error 15 means that the cell had degraded too much to continue simulating.\n"
-                   "This can be due to too much SEI growth, too much loss of lithium, too much loss of active material (thin electrodes, low volume fraction, or low effective surface) \n"
-                   "too much surface cracking, too low diffusion constants, too high resistance, or too much lithium plating.\n"
-                   "Continue simulating might lead to errors in the code so the simulation of this degradation test is stopped.\n"
-                   "The results which have been written are all valid and you can ignore the error messages above which explained where this error comes from.\n";
+  const double Ti = conf.Ti();
+  const double dt = (Ti < 40 + PhyConst::Kelvin) ? 3 : 2; //!< a lower temperature allows a larger time step without numerical problems
+
+  runExperiment("Cycle_one", dir.filename().string(), [&] {
+    auto c = makeCell(cellType, degid, Ti);
+    util::error::checkInputParam_CycAge(*c, conf.Vma, conf.Vmi, conf.Ccha, Ccutcha, conf.Cdis, Ccutdis, Ti, nrCycles, nrCap);
+
+    const auto pref = outputPrefix(dir);
+    Cycler cyc(c.get(), pref + "cycle");
+    Procedure proc(false, conf.Vma, 0, true);
+    proc.setOutputPrefix(pref);
+
+    const int ndt_data = dataSteps(timeCycleData, dt);
+    const double Icha{ -conf.Ccha * c->Cap() }, Idis{ conf.Cdis * c->Cap() };
+    ThroughputData th{};
+    for (int i = 0; i < nrCycles; i++) {
+      if (i % nrCap == 0) proc.checkUp(c.get(), th.Ah(), i);
+
+      auto succ = cyc.CC(Icha, conf.Vma, TIME_INF, dt, ndt_data, th);
+      check(isVoltageLimitReached(succ), succ, "charging", i);
+      if (CVcha) {
+        succ = cyc.CV(conf.Vma, Ccutcha * c->Cap(), TIME_INF, dt, ndt_data, th);
+        check(isCurrentLimitReached(succ), succ, "CV charging", i);
+      }
+
+      succ = cyc.CC(Idis, conf.Vmi, TIME_INF, dt, ndt_data, th);
+      check(isVoltageLimitReached(succ), succ, "discharging", i);
+      if (CVdis) {
+        succ = cyc.CV(conf.Vmi, Ccutdis * c->Cap(), TIME_INF, dt, ndt_data, th);
+        check(isCurrentLimitReached(succ), succ, "CV discharging", i);
+      }
     }
-  }
+
+    finish(cyc, proc, *c, th.Ah(), nrCycles);
+  });
 }
 
-void Profile_one(const struct slide::Model_SPM &M, const struct DEG_ID &degid, int cellType, int verbose, std::string profName, int n, int limit,
-                 double Vma, double Vmi, double Ti, int timeCycleData, int nrProfiles, int nrCap, struct checkUpProcedure &proc, std::string name)
+void Profile_one(const DEG_ID &degid, int cellType, const ProfileAgeingConfig &conf, int timeCycleData, int nrProfiles, int nrCap,
+                 const std::filesystem::path &dir)
 {
   /*
-   * Calls the ProfileAgeing() function of a Cycler
+   * Function which simulates one drive cycle ageing regime.
+   * The cell follows the current profile, and is recharged with a 1C CCCV to the maximum voltage after every repetition.
+   * If a voltage limit is reached while following the profile, the voltage is kept at the limit for the rest of that step
+   * of the profile (i.e. the current of the step is reduced, see Cycler::Profile).
    *
    * IN
-   * M 			matrices of the spatial discretisation for the solid diffusion PDE
    * degid	 	struct with degradation settings (which degradation models to be used)
    * cellType 	integer deciding which cell to use for the simulation
    *  				0 	Kokam cell (high power Kokam NMC)
    *  				1 	Panasonic cell (high energy LGChem NMC)
    *  				2 	user cell
-   * verbose 		integer indicating how verbose the simulation has to be.
-   * 				The higher the number, the more output there is.
-   * 				Recommended value is 1, only use higher values for debugging
-   * 				From 4 (and above) there will be too much info printed to follow what is going on, but this might be useful for debugging to find where the error is and why it is happening
-   * 					0 	almost no messages are printed, only in case of critical errors related to illegal parameters
-   * 					1 	error messages are printed in case of critical errors which might crash the simulation
-   * 					2 	all error messages are printed, whether the simulation can recover from the errors or not
-   * 					3 	on top of the output from 2, a message is printed every time a function in the Cycler and BasicCycler is started and terminated
-   * 					4 	on top of the output from 3, the high-level flow of the program in the Cycler is printed (e.g. 'we are going to discharge the cell')
-   * 					5 	on top of the output from 4, the low-level flow of the program in the BasicCycler is printed (e.g. 'in time step 101, the voltage is 3.65V')
-   * 					6 	on top of the output from 5, we also print details of the nonlinear search for the current needed to do a CV phase
-   * 					7 	on top of the output from 6, a message is printed every time a function in the Cell is started and terminated
-   * profName 	name of the csv file with the current profile
-   * n			length of the profile (number of rows in the csv file)
-   * limit		integer describing what to do if the current can't be maintained because a voltage limit is reached
-   * 					0 	immediately go to the next current step of the profile (i.e. reduce the time of the step)
-   * 					1 	keep the voltage constant for the rest of this step of the profile (i.e. reduce the current of the step)
-   * Vma 			maximum voltage under which the cell should stay, below the maximum voltage of the cell [V]
-   * Vmi 			minimum voltage above which the cell should stay, above the minimum voltage of the cell [V]
-   * Ti 			temperature at which the cell has to be cycled [K]
+   * conf 		voltage window and temperature, and the name of the csv file with the current profile in PathVar::data
+   * 				the first column contains the current in [A] (positive for discharge, negative for charge)
+   * 				the second column contains the time in [sec] the current should be maintained
    * timeCycleData the time interval at which cycling data (e.g. the voltage of the cell) should be stored [s]
    * 				if 0, no cycle data is stored
    * nrProfiles 	number of profiles to be simulated in total [-]
    * nrCap 		number of profile repetitions between consecutive check-ups [-]
-   * proc 		structure with the parameters of the check-up procedure with the following fields:
-   * 		blockDegradation 	if true [RECOMMENDED], degradation is not accounted for during this check-up,
-   * 								and at the end of the check-up, the exact battery state from the start of the check-up is restored
-   * 								if false [NOT RECOMMENDED], degradation is accounted for during this check-up,
-   * 								and at the end of the check-up, the cell's voltage and temperature are brought back to the levels from before the check-up
-   * 		capCheck 			boolean indicating if the capacity should be checked
-   * 		OCVCheck			boolean indicating if the half-cell OCV curves should be checked
-   * 		CCCVCheck			boolean indicating if some CCCV cycles should be done as part of the check-up procedure
-   * 		pulseCheck			boolean indicating if a pulse discharge test should be done as part of the check-up procedure
-   * 		includeCycleData	boolean indicating if the cycling data from the check-up should be included in the cycling data of the cell or not
-   * 		nCycles				number of different cycles to be simulated for the CCCV check-up (i.e. the length of the array crates)
-   * 		Crates				array with the Crates of the different cycles to be checked for the CCCV check-up, must be all positive
-   * 		Ccut				C rate of the cutoff current for the CV phase for the CCCV check-up, must be positive
-   * 		profileName 		name of the csv file which contains the current profile for the pulse test
-   * 								the first column contains the current in [A] (positive for discharge, negative for charge)
-   * 								the second column contains the time in [sec] the current should be maintained
-   * 								the profile must be a net discharge, i.e. sum (I*dt) > 0
-   * 		profileLength		length of the current profiles for the pulse test (number of rows in the csv file)
-   * name 		the name of the subfolder in which all the data for this simulation is written, must obey the naming convention for folders
-   * 				avoid special characters or spaces
+   * dir 			the folder in which all the data for this simulation is written
+   *
+   * THROWS
+   * 2 			the profile could not be opened
+   * 15 			the profile or the recharge failed, e.g. because the cell degraded too much
    */
-
-  //!< Make a cell, the type of the cell depending on the value of 'cellType' #TODO  -> There is a cast.
-  auto createCell = [&] {
-    if (cellType == 0)
-      return (Cell)Cell_KokamNMC(M, degid, verbose); //!< a high power NMC cell made by Kokam
-    else if (cellType == 1)
-      return (Cell)Cell_LGChemNMC(M, degid, verbose); //!< a high energy NMC cell made by LG Chem
-    else
-      return (Cell)slide::Cell_user(M, degid, verbose); //!< a user-defined cell
-  };
-
-  Cell c1 = createCell();
-
-  //!< Make the cycler
-  Cycler cycler(c1, name, verbose, timeCycleData);
-
-  //!< Print a warning if you want to store cycling data
-  //!< In profileAgeing, you are guaranteed to get one point per step in the profile
-  //!< so if the steps are very short (e.g. 1sec), you are storing a huge amount of data (e.g. every second)
-  //!< 	This seriously slowing down the code (taking hours instead of minutes) and produces huge amounts of data (several GB)
-  if (timeCycleData != 0)
-    std::cout << "Warning for profile ageing: the cycling data of the cell is going to be stored, which will lead to much slower "
-                 "calculation (several hours) and a huge amount of data (several GB).\n";
-  //!< Call the profile ageing function from the Cycler
-  try {
-    cycler.profileAgeing(profName, limit, Vma, Vmi, Ti, nrProfiles, nrCap, proc);
-  } catch (int err) {
-    //!< std::cout << "Throw test: " << 77 << '\n';
-    std::cout << "Profile_one experienced error " << err << " during execution of " << name << ", abort this test.\n";
-    if (err == 15) //!< #TODO this is not valid anymore.
-    {
-      std::cout << "Error 15 means that the cell had degraded too much to continue simulating.\n"
-                   "This can be due to too much SEI growth, too much loss of lithium, too much loss of active material (thin electrodes, low volume fraction, or low effective surface)\n"
-                   "too much surface cracking, too low diffusion constants, too high resistance, or too much lithium plating.\n"
-                   "Continue simulating might lead to errors in the code so the simulation of this degradation test is stopped.\n"
-                   "The results which have been written are all valid and you can ignore the error messages above which explained where this error comes from.\n";
+  constexpr double dt = 1; //!< the profiles have a resolution of 1 second
+
+  runExperiment("Profile_one", dir.filename().string(), [&] {
+    auto c = makeCell(cellType, degid, conf.Ti());
+
+    const auto pref = outputPrefix(dir);
+    Cycler cyc(c.get(), pref + "profile");
+    Procedure proc(false, conf.Vma, 0, true);
+    proc.setOutputPrefix(pref);
+
+    //!< Print a warning if you want to store cycling data
+    //!< Profiles often change the current every second, so storing data of each step is a huge amount of data (several GB)
+    if (timeCycleData != 0)
+      std::cout << "Warning for profile ageing: the cycling data of the cell is going to be stored, which will lead to much slower "
+                   "calculation (several hours) and a huge amount of data (several GB).\n";
+
+    const int ndt_data = dataSteps(timeCycleData, dt);
+    ProfileStream prof(PathVar::data / conf.csvName, 1, dt);
+    ThroughputData th{};
+    for (int i = 0; i < nrProfiles; i++) {
+      if (i % nrCap == 0) proc.checkUp(c.get(), th.Ah(), i);
+
+      prof.rewind();
+      auto succ = cyc.Profile(prof, false, conf.Vma, conf.Vmi, TIME_INF, dt, ndt_data, th);
+      check(succ == Status::Success, succ, "following the profile", i);
+
+      succ = CCCV(cyc, c->Cap(), conf.Vma, c->Cap() / 20, dt, ndt_data, th);
+      check(isCurrentLimitReached(succ) || isVoltageLimitReached(succ), succ, "recharging after the profile", i);
     }
-  }
+
+    finish(cyc, proc, *c, th.Ah(), nrProfiles);
+  });
 }
 
-void CycleAgeing(const struct slide::Model_SPM &M, std::string pref, const struct DEG_ID &degid, int cellType, int verbose)
+void CycleAgeing(std::string pref, const DEG_ID &degid, int cellType)
 {
   /*
    * Function to simulate a selection of cycle ageing experiments.
@@ -343,13 +314,10 @@ void CycleAgeing(const struct slide::Model_SPM &M, std::string pref, const struc
    * Various simulations are done, with different settings for the cycles (temperatures, voltage windows, currents, etc.)
    * The results from the check-up procedures and the cycling data from cells are written in one subfolder per simulation.
    *
-   * The function uses multi-threaded code to accelerate the calculation.
-   * The optimal number of threads to use, is the total number of logical cores on your computer minus one (to avoid flooding the CPU)
-   * Currently, this function is programmed to use 3 threads, which is optimal for a dual-core PC.
-   * The function prints a warning if you PC has more or fewer cores, and a different number of threads is better
+   * The experiments are run in parallel as jobs (see slide::runJobs), the longest ones first.
+   * An experiment which finished in an earlier run is skipped, so an interrupted campaign can simply be started again.
    *
    * IN
-   * M 			matrices of the spatial discretisation for the solid diffusion PDE
    * pref 		std::string with which the name of the subfolder in which the results should be written, will begin
    * 				e.g. if pref = '1', then the subfolder will be called 1_xxxxxx (with xxxx the degradation identifier)
    * 				use this as an identifier for different simulations, e.g. the next time you simulate, change pref to '2'
@@ -360,43 +328,21 @@ void CycleAgeing(const struct slide::Model_SPM &M, std::string pref, const struc
    *  				0 	Kokam cell (high power Kokam NMC)
    *  				1 	Panasonic cell (high energy LGChem NMC)
    *  				2 	user cell
-   * verbose 		integer indicating how verbose the simulation has to be.
-   * 				The higher the number, the more output there is.
-   * 				Recommended value is 1, only use higher values for debugging
-   * 				From 4 (and above) there will be too much info printed to follow what is going on, but this might be useful for debugging to find where the error is and why it is happening
-   * 					0 	almost no messages are printed, only in case of critical errors related to illegal parameters
-   * 					1 	error messages are printed in case of critical errors which might crash the simulation
-   * 					2 	all error messages are printed, whether the simulation can recover from the errors or not
-   * 					3 	on top of the output from 2, a message is printed every time a function in the Cycler and BasicCycler is started and terminated
-   * 					4 	on top of the output from 3, the high-level flow of the program in the Cycler is printed (e.g. 'we are going to discharge the cell')
-   * 					5 	on top of the output from 4, the low-level flow of the program in the BasicCycler is printed (e.g. 'in time step 101, the voltage is 3.65V')
-   * 					6 	on top of the output from 5, we also print details of the nonlinear search for the current needed to do a CV phase
-   * 					7 	on top of the output from 6, a message is printed every time a function in the Cell is started and terminated
    *
    * OUT
-   * The function writes many csv files with the results of the check-up tests and cycling data of the cell.
-   * The following files are written in a subfolder called pref_degid
-   * (with pref the string in the variable pref and degid the string representing the degradation identifier, see print_DEG_ID):
+   * The function writes the results of each experiment in its own subfolder of PathVar::results, called pref_degid_conditions
+   * (with pref the string in the variable pref and degid the string representing the degradation identifier, see DEG_ID::print):
    *
-   * The cycling data (voltage and temperature on cycling) is written in files called CyclingData_x.csv
-   * 			(where x = 0 for the first data batch, x = 1 for the second, etc.)
-   * 			exact description of the file can be found in BasicCycler::writeCyclingData or Cycling::CCCV or in the word documents
-   * The capacity measurement are written in a csv file called DegradationData_batteryState.csv
-   * 			exact description of the file can be found in Cycler::checkUp_batteryStates or in the word document
-   * The half-cell OCV curves are written in a csv file called DegradationData_OCV.csv
-   * 			exact description of the file can be found in Cycler::checkUp_OCV
-   * The voltage measurements during the CCCV cycles from the check-ups are written in csv files called DegradationData_CheckupCycle_x.csv
-   * 			(x = 0 for the first check-up, x = 1 for the second, etc.)
-   * 			exact description of the file can be found in Cycler::checkUp_CCCV
-   * The voltage measurements during the pulse discharge test from the check-ups are written in csv files called DegradationData_CheckupPulse_x.csv
-   * 			(x = 0 for the first check-up, x = 1 for the second, etc.)
-   * 			exact description of the file can be found in Cycler::checkUp_pulse
+   * The cycling data (voltage and temperature on cycling) is written in files starting with cycle_ (see Cycler::writeData)
+   * The capacity and state of the cell at every check-up are written in cell_checkUp.csv (see Procedure::checkUp)
+   * The charge and energy throughput is written in cell_throughput.csv (see Procedure::writeThroughput)
+   * The file job_done marks an experiment which finished.
    */
 
   //!< *********************************************************** 1 variables ***********************************************************************
 
   //!< append the ageing identifiers to the prefix
-  pref += +"_" + degid.print() + "_";
+  pref += "_" + DEG_ID(degid).print() + "_";
 
   //!< Make variables to describe the cycling regimes
   bool CVcha = true;      //!< we want to have a CC CV charge (if false, then charge has only a CC phase)
@@ -411,30 +357,7 @@ void CycleAgeing(const struct slide::Model_SPM &M, std::string pref, const struc
 
   //!< *********************************************************** 2 check-up procedure ******************************************************************
 
-  //!< Make a struct to describe the check-up procedure
-  struct checkUpProcedure proc;
-  proc.blockDegradation = true;                    //!< boolean indicating if degradation is accounted for during the check-up, [RECOMMENDED: TRUE]
-  proc.capCheck = true;                            //!< boolean indicating if the capacity should be checked
-  proc.OCVCheck = true;                            //!< boolean indicating if the half-cell OCV curves should be checked
-  proc.CCCVCheck = true;                           //!< boolean indicating if some CCCV cycles should be done as part of the check-up procedure
-  proc.pulseCheck = true;                          //!< boolean indicating if a pulse discharge test should be done as part of the check-up procedure
-  proc.includeCycleData = true;                    //!< boolean indicating if the cycling data from the check-up should be included in the cycling data of the cell or not
-  proc.nCycles = 3;                                //!< number of different cycles to be simulated for the CCCV check-up (i.e. the length of the array crates)
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Crates[0] = 0.5;                            //!< do a 0.5C cycle as part of the CCCV check-up, must be positive
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Crates[1] = 1.0;                            //!< do a 1C cycle as part of the CCCV check-up, must be positive
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Crates[2] = 2.0;                            //!< do a 2C cycle as part of the CCCV check-up, must be positive
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Ccut_cha = 0.05;                            //!< C rate of the cutoff current for the CV phase for the charges in the CCCV check-up, must be positive
-  proc.Ccut_dis = 100;                             //!< C rate of the cutoff current for the CV phase for the discharges in the CCCV check-up, must be positive
-                                                   //!< if the cutoff is larger than the value in the CC phase, no CV phase is done
-  proc.set_profileName("CheckupPulseProfile.csv"); //!< name of the csv file which contains the current profile for the pulse test
-                                                   //	the first column contains the current in [A] (positive for discharge, negative for charge)
-                                                   //	the second column contains the time in [sec] the current should be maintained
-                                                   //	the profile must be a net discharge, i.e. sum (I*dt) > 0
-  proc.profileLength = 13;                         //!< length of the current profiles for the pulse test (number of rows in the csv file)
+  //!< Every check-up measures the capacity of the cell and writes its state (see Procedure::checkUp)
 
   //!< *********************************************************** 3 simulations ******************************************************************
 
@@ -481,17 +404,21 @@ void CycleAgeing(const struct slide::Model_SPM &M, std::string pref, const struc
       cycleAgConfigVec.emplace_back(Vma, Vmi, Tc, Ccha, Cdis, SOCma, SOCmi);
   }
 
-  auto task_indv = [&](int i_begin) {
+  std::vector<Job> jobs;
+  for (const auto &conf : cycleAgConfigVec) {
     //!< simulate one cycle ageing experiment
-    Cycle_one(M, degid, cellType, verbose, cycleAgConfigVec[i_begin], CVcha, Ccutcha, CVdis, Ccutdis, timeCycleData, nrCycles, nrCap, proc, pref);
-  };
+    auto task_indv = [&, conf](const std::filesystem::path &dir) {
+      Cycle_one(degid, cellType, conf, CVcha, Ccutcha, CVdis, Ccutdis, timeCycleData, nrCycles, nrCap, dir);
+    };
+    jobs.push_back({ conf.get_name(pref), conf.cost(), task_indv });
+  }
 
   //!< Print a message that we are starting the simulations
   std::cout << "\t Cycle ageing experiments are started.\n";
-  slide::run(task_indv, cycleAgConfigVec.size()); //!< Runs individual simulation in parallel or sequential depending on settings.
+  runJobs(jobs); //!< longest experiments first, experiments which finished in an earlier run are skipped
 }
 
-void CalendarAgeing(const struct slide::Model_SPM &M, std::string pref, const struct DEG_ID &degid, int cellType, int verbose)
+void CalendarAgeing(std::string pref, const DEG_ID &degid, int cellType)
 {
   /*
    * Function to simulate a selection of calendar ageing experiments.
@@ -499,13 +426,10 @@ void CalendarAgeing(const struct slide::Model_SPM &M, std::string pref, const st
    * Various simulations are done, with different settings for the resting (temperatures, state of charge)
    * The results from the check-up procedures and the cycling data from cells are written in one subfolder per simulation.
    *
-   * The function uses multi-threaded code to accelerate the calculation.
-   * The optimal number of threads to use, is the total number of logical cores on your computer minus one (to avoid flooding the CPU)
-   * Currently, this function is programmed to use 3 threads, which is optimal to a dual-core PC.
-   * The function prints a warning if you PC has more or fewer cores, and a different number of threads is better
+   * The experiments are run in parallel as jobs (see slide::runJobs), the longest ones first.
+   * An experiment which finished in an earlier run is skipped, so an interrupted campaign can simply be started again.
    *
    * IN
-   * M 			matrices of the spatial discretisation for the solid diffusion PDE
    * pref 		std::string with which the name of the subfolder in which the results should be written, will begin
    * 				e.g. if pref = '1', then the subfolder will be called 1_xxxxxx (with xxxx the degradation identifier)
    * 				use this as an identifier for different simulations, e.g. the next time you simulate, change pref to '2'
@@ -516,43 +440,21 @@ void CalendarAgeing(const struct slide::Model_SPM &M, std::string pref, const st
    *  				0 	Kokam cell (high power Kokam NMC)
    *  				1 	Panasonic cell (high energy LGChem NMC)
    *  				2 	user cell
-   * verbose 		integer indicating how verbose the simulation has to be.
-   * 				The higher the number, the more output there is.
-   * 				Recommended value is 1, only use higher values for debugging
-   * 				From 4 (and above) there will be too much info printed to follow what is going on, but this might be useful for debugging to find where the error is and why it is happening
-   * 					0 	almost no messages are printed, only in case of critical errors related to illegal parameters
-   * 					1 	error messages are printed in case of critical errors which might crash the simulation
-   * 					2 	all error messages are printed, whether the simulation can recover from the errors or not
-   * 					3 	on top of the output from 2, a message is printed every time a function in the Cycler and BasicCycler is started and terminated
-   * 					4 	on top of the output from 3, the high-level flow of the program in the Cycler is printed (e.g. 'we are going to discharge the cell')
-   * 					5 	on top of the output from 4, the low-level flow of the program in the BasicCycler is printed (e.g. 'in time step 101, the voltage is 3.65V')
-   * 					6 	on top of the output from 5, we also print details of the nonlinear search for the current needed to do a CV phase
-   * 					7 	on top of the output from 6, a message is printed every time a function in the Cell is started and terminated
    *
    * OUT
-   * The function writes many csv files with the results of the check-up tests and cycling data of the cell.
-   * The following files are written in a subfolder called pref_degid
-   * (with pref the string in the variable pref and degid the string representing the degradation identifier, see print_DEG_ID):
+   * The function writes the results of each experiment in its own subfolder of PathVar::results, called pref_degid_conditions
+   * (with pref the string in the variable pref and degid the string representing the degradation identifier, see DEG_ID::print):
    *
-   * The cycling data (voltage and temperature on cycling) is written in files called CyclingData_x.csv
-   * 			(where x = 0 for the first data batch, x = 1 for the second, etc.)
-   * 			exact description of the file can be found in BasicCycler::writeCyclingData or Cycling::CCCV
-   * The capacity measurement are written in a csv file called DegradationData_batteryState.csv
-   * 			exact description of the file can be found in Cycler::checkUp_batteryStates
-   * The half-cell OCV curves are written in a csv file called DegradationData_OCV.csv
-   * 			exact description of the file can be found in Cycler::checkUp_OCV
-   * The voltage measurements during the CCCV cycles from the check-ups are written in csv files called DegradationData_CheckupCycle_x.csv
-   * 			(x = 0 for the first check-up, x = 1 for the second, etc.)
-   * 			exact description of the file can be found in Cycler::checkUp_CCCV
-   * The voltage measurements during the pulse discharge test from the check-ups are written in csv files called DegradationData_CheckupPulse_x.csv
-   * 			(x = 0 for the first check-up, x = 1 for the second, etc.)
-   * 			exact description of the file can be found in Cycler::checkUp_pulse
+   * The cycling data (voltage and temperature on cycling) is written in files starting with calendar_ (see Cycler::writeData)
+   * The capacity and state of the cell at every check-up are written in cell_checkUp.csv (see Procedure::checkUp)
+   * The charge and energy throughput is written in cell_throughput.csv (see Procedure::writeThroughput)
+   * The file job_done marks an experiment which finished.
    */
 
   //!< *********************************************************** 1 variables ***********************************************************************
 
   //!< append the ageing identifiers to the prefix
-  pref += "_" + degid.print() + "_";
+  pref += "_" + DEG_ID(degid).print() + "_";
 
   //!< Make variables to describe the cycling regimes
   constexpr int mode = 0;             //!< integer deciding how often to recharge the cells (due to degradation, the voltage will decrease over time. But no self-discharge is simulated)
@@ -568,30 +470,7 @@ void CalendarAgeing(const struct slide::Model_SPM &M, std::string pref, const st
 
   //!< *********************************************************** 2 check-up procedure ******************************************************************
 
-  //!< Make a struct to describe the check-up procedure
-  struct checkUpProcedure proc;
-  proc.blockDegradation = true;                    //!< boolean indicating if degradation is accounted for during the check-up, [RECOMMENDED: TRUE]
-  proc.capCheck = true;                            //!< boolean indicating if the capacity should be checked
-  proc.OCVCheck = true;                            //!< boolean indicating if the half-cell OCV curves should be checked
-  proc.CCCVCheck = true;                           //!< boolean indicating if some CCCV cycles should be done as part of the check-up procedure
-  proc.pulseCheck = true;                          //!< boolean indicating if a pulse discharge test should be done as part of the check-up procedure
-  proc.includeCycleData = true;                    //!< boolean indicating if the cycling data from the check-up should be included in the cycling data of the cell or not
-  proc.nCycles = 3;                                //!< number of different cycles to be simulated for the CCCV check-up (i.e. the length of the array crates), maximum 100
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Crates[0] = 0.5;                            //!< do a 0.5C cycle as part of the CCCV check-up, must be positive
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Crates[1] = 1.0;                            //!< do a 1C cycle as part of the CCCV check-up, must be positive
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Crates[2] = 2.0;                            //!< do a 2C cycle as part of the CCCV check-up, must be positive
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Ccut_cha = 0.05;                            //!< C rate of the cutoff current for the CV phase for the charges in the CCCV check-up, must be positive
-  proc.Ccut_dis = 100;                             //!< C rate of the cutoff current for the CV phase for the discharges in the CCCV check-up, must be positive
-                                                   //!< if the cutoff is larger than the value in the CC phase, no CV phase is done
-  proc.set_profileName("CheckupPulseProfile.csv"); //!< name of the csv file which contains the current profile for the pulse test
-                                                   //	the first column contains the current in [A] (positive for discharge, negative for charge)
-                                                   //	the second column contains the time in [sec] the current should be maintained
-                                                   //	the profile must be a net discharge, i.e. sum (I*dt) > 0
-  proc.profileLength = 13;                         //!< length of the current profiles for the pulse test (number of rows in the csv file)
+  //!< Every check-up measures the capacity of the cell and writes its state (see Procedure::checkUp)
 
   //!< *********************************************************** Simulations ******************************************************************
 
@@ -614,16 +493,20 @@ void CalendarAgeing(const struct slide::Model_SPM &M, std::string pref, const st
     for (size_t i = 0; i < V_arr.size(); i++) //!< voltage at which the cell has to rest [V] above the minimum and below the maximum voltage of the cell
       calAgConfig.emplace_back(V_arr[i], Tc, SOC_arr[i]);
 
-  auto task_indv = [&](size_t i) {
-    Calendar_one(M, degid, cellType, verbose, calAgConfig[i].V, calAgConfig[i].Ti(), Time, mode, timeCycleData, timeCheck, proc, calAgConfig[i].get_name(pref));
-  };
+  std::vector<Job> jobs;
+  for (const auto &conf : calAgConfig) {
+    auto task_indv = [&, conf](const std::filesystem::path &dir) {
+      Calendar_one(degid, cellType, conf.V, conf.Ti(), Time, mode, timeCycleData, timeCheck, dir);
+    };
+    jobs.push_back({ conf.get_name(pref), 1.0, task_indv }); //!< all experiments rest equally long
+  }
 
   //!< Print a message that we are starting the simulations
   std::cout << "\t Calendar ageing experiments are started.\n";
-  slide::run(task_indv, calAgConfig.size());
+  runJobs(jobs);
 }
 
-void ProfileAgeing(const struct slide::Model_SPM &M, std::string pref, const struct DEG_ID &degid, int cellType, int verbose)
+void ProfileAgeing(std::string pref, const DEG_ID &degid, int cellType)
 {
   /*
    * Function to simulate a selection of drive cycle ageing experiments.
@@ -631,13 +514,10 @@ void ProfileAgeing(const struct slide::Model_SPM &M, std::string pref, const str
    * Various simulations are done, with different settings for the cycles (temperatures, voltage windows, currents, etc.)
    * The results from the check-up procedures and the cycling data from cells are written in one subfolder per simulation.
    *
-   * The function uses multi-threaded code to accelerate the calculation.
-   * The optimal number of threads to use, is the total number of logical cores on your computer minus one (to avoid flooding the CPU)
-   * Currently, this function is programmed to use 3 threads, which is optimal to a dual-core PC.
-   * The function prints a warning if you PC has more or fewer cores, and a different number of threads is better
+   * The experiments are run in parallel as jobs (see slide::runJobs), the longest ones first.
+   * An experiment which finished in an earlier run is skipped, so an interrupted campaign can simply be started again.
    *
    * IN
-   * M 			matrices of the spatial discretisation for the solid diffusion PDE
    * pref 		std::string with which the name of the subfolder in which the results should be written, will begin
    * 				e.g. if pref = '1', then the subfolder will be called 1_xxxxxx (with xxxx the degradation identifier)
    * 				use this as an identifier for different simulations, e.g. the next time you simulate, change pref to '2'
@@ -648,43 +528,21 @@ void ProfileAgeing(const struct slide::Model_SPM &M, std::string pref, const str
    *  				0 	Kokam cell (high power Kokam NMC)
    *  				1 	Panasonic cell (high energy LGChem NMC)
    *  				2 	user cell
-   * verbose 		integer indicating how verbose the simulation has to be.
-   * 				The higher the number, the more output there is.
-   * 				Recommended value is 1, only use higher values for debugging
-   * 				From 4 (and above) there will be too much info printed to follow what is going on, but this might be useful for debugging to find where the error is and why it is happening
-   * 					0 	almost no messages are printed, only in case of critical errors related to illegal parameters
-   * 					1 	error messages are printed in case of critical errors which might crash the simulation
-   * 					2 	all error messages are printed, whether the simulation can recover from the errors or not
-   * 					3 	on top of the output from 2, a message is printed every time a function in the Cycler and BasicCycler is started and terminated
-   * 					4 	on top of the output from 3, the high-level flow of the program in the Cycler is printed (e.g. 'we are going to discharge the cell')
-   * 					5 	on top of the output from 4, the low-level flow of the program in the BasicCycler is printed (e.g. 'in time step 101, the voltage is 3.65V')
-   * 					6 	on top of the output from 5, we also print details of the nonlinear search for the current needed to do a CV phase
-   * 					7 	on top of the output from 6, a message is printed every time a function in the Cell is started and terminated
    *
    * OUT
-   * The function writes many csv files with the results of the check-up tests and cycling data of the cell.
-   * The following files are written in a subfolder called pref_degid
-   * (with pref the string in the variable pref and degid the string representing the degradation identifier, see print_DEG_ID):
+   * The function writes the results of each experiment in its own subfolder of PathVar::results, called pref_degid_conditions
+   * (with pref the string in the variable pref and degid the string representing the degradation identifier, see DEG_ID::print):
    *
-   * The cycling data (voltage and temperature on cycling) is written in files called CyclingData_x.csv
-   * 			(where x = 0 for the first data batch, x = 1 for the second, etc.)
-   * 			exact description of the file can be found in BasicCycler::writeCyclingData or Cycling::CCCV
-   * The capacity measurement are written in a csv file called DegradationData_batteryState.csv
-   * 			exact description of the file can be found in Cycler::checkUp_batteryStates
-   * The half-cell OCV curves are written in a csv file called DegradationData_OCV.csv
-   * 			exact description of the file can be found in Cycler::checkUp_OCV
-   * The voltage measurements during the CCCV cycles from the check-ups are written in csv files called DegradationData_CheckupCycle_x.csv
-   * 			(x = 0 for the first check-up, x = 1 for the second, etc.)
-   * 			exact description of the file can be found in Cycler::checkUp_CCCV
-   * The voltage measurements during the pulse discharge test from the check-ups are written in csv files called DegradationData_CheckupPulse_x.csv
-   * 			(x = 0 for the first check-up, x = 1 for the second, etc.)
-   * 			exact description of the file can be found in Cycler::checkUp_pulse
+   * The cycling data (voltage and temperature on cycling) is written in files starting with profile_ (see Cycler::writeData)
+   * The capacity and state of the cell at every check-up are written in cell_checkUp.csv (see Procedure::checkUp)
+   * The charge and energy throughput is written in cell_throughput.csv (see Procedure::writeThroughput)
+   * The file job_done marks an experiment which finished.
    */
 
   //!< *********************************************************** 1 variables ***********************************************************************
 
   //!< append the ageing identifiers to the prefix
-  pref += "_" + degid.print() + "_";
+  pref += "_" + DEG_ID(degid).print() + "_";
 
   //!< find the number of parallel threads that are optimal to use
   //!< unsigned int Ncor = std::thread::hardware_concurrency(); //!< Ncor is the number of (logical) cores, 0 if c++ can't identify it
@@ -702,11 +560,6 @@ void ProfileAgeing(const struct slide::Model_SPM &M, std::string pref, const str
   //	Current Profile drive cycle NYCC.csv		599			NYCC drive cycle with a maximum current of 8.1A (= 3C), each current step takes 1 second
   //	Current Profile drive cycle UDDS.csv		1370		UDDS drive cycle with a maximum current of 8.1A (= 3C), each current step takes 1 second
   //!< 	Current Profile drive cycle US06.csv		601			US06 drive cycle with a maximum current of 8.1A (= 3C), each current step takes 1 second
-  int length;    //!< length of the profile (number of rows)
-  int limit = 0; //!< what to do if the voltage limits are reached while following the profile:
-                 //!< 0 immediately go to the next current step of the profile (i.e. reduce the time of this step)
-                 //!< 1 keep the voltage constant for the rest of this step of the profile (i.e. reduce the current of this step)
-
   int nrProfiles = 10000; //!< number of times the current profile should be repeated [-]
   int nrCap = 1000;       //!< number of times the current profile should be repeated between consecutive check-ups [-]
   int timeCycleData = 0;  //!< time interval at which cycling data (voltage and temperature) has to be recorded [s]
@@ -721,30 +574,7 @@ void ProfileAgeing(const struct slide::Model_SPM &M, std::string pref, const str
 
   //!< *********************************************************** 2 check-up procedure ******************************************************************
 
-  //!< Make a struct to describe the check-up procedure
-  struct checkUpProcedure proc;
-  proc.blockDegradation = true;                    //!< boolean indicating if degradation is accounted for during the check-up, [RECOMMENDED: TRUE]
-  proc.capCheck = true;                            //!< boolean indicating if the capacity should be checked
-  proc.OCVCheck = true;                            //!< boolean indicating if the half-cell OCV curves should be checked
-  proc.CCCVCheck = true;                           //!< boolean indicating if some CCCV cycles should be done as part of the check-up procedure
-  proc.pulseCheck = true;                          //!< boolean indicating if a pulse discharge test should be done as part of the check-up procedure
-  proc.includeCycleData = true;                    //!< boolean indicating if the cycling data from the check-up should be included in the cycling data of the cell or not
-  proc.nCycles = 3;                                //!< number of different cycles to be simulated for the CCCV check-up (i.e. the length of the array crates).
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Crates[0] = 0.5;                            //!< do a 0.5C cycle as part of the CCCV check-up, must be positive
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Crates[1] = 1.0;                            //!< do a 1C cycle as part of the CCCV check-up, must be positive
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Crates[2] = 2.0;                            //!< do a 2C cycle as part of the CCCV check-up, must be positive
-                                                   //!< If you change this variable, also change it in the MATLAB script which reads the results from the check-up (the variable Crates in readAgeing_CCCV.m)
-  proc.Ccut_cha = 0.05;                            //!< C rate of the cutoff current for the CV phase for the charges in the CCCV check-up, must be positive
-  proc.Ccut_dis = 100;                             //!< C rate of the cutoff current for the CV phase for the discharges in the CCCV check-up, must be positive
-                                                   //!< if the cutoff is larger than the value in the CC phase, no CV phase is done
-  proc.set_profileName("CheckupPulseProfile.csv"); //!< name of the csv file which contains the current profile for the pulse test
-                                                   //	the first column contains the current in [A] (positive for discharge, negative for charge)
-                                                   //	the second column contains the time in [sec] the current should be maintained
-                                                   //	the profile must be a net discharge, i.e. sum (I*dt) > 0
-  proc.profileLength = 13;                         //!< length of the current profiles for the pulse test (number of rows in the csv file)
+  //!< Every check-up measures the capacity of the cell and writes its state (see Procedure::checkUp)
 
   //!< *********************************************************** 3 simulations ******************************************************************
 
@@ -787,13 +617,19 @@ void ProfileAgeing(const struct slide::Model_SPM &M, std::string pref, const str
       profAgConfigVec.emplace_back(Vma, Vmi, Tc, SOCma, SOCmi, profile_arr[i], prefName_arr[i]);
   }
 
-  auto task_indv = [&](size_t i) {
+  std::vector<Job> jobs;
+  for (const auto &conf : profAgConfigVec) {
     //!< simulate one profile ageing experiment
-    auto &conf = profAgConfigVec[i];
-    Profile_one(M, degid, cellType, verbose, conf.csvName, length, limit, conf.Vma, conf.Vmi, conf.Ti(), timeCycleData, nrProfiles, nrCap, proc, conf.get_name(pref));
-  };
+    auto task_indv = [&, conf](const std::filesystem::path &dir) {
+      Profile_one(degid, cellType, conf, timeCycleData, nrProfiles, nrCap, dir);
+    };
+    std::error_code ec; //!< the length of the profile is proportional to the size of its file
+    const auto size = std::filesystem::file_size(PathVar::data / conf.csvName, ec);
+    jobs.push_back({ conf.get_name(pref), ec ? 1.0 : static_cast<double>(size), task_indv });
+  }
 
   //!< Print a message that we are starting the simulations
   std::cout << "\t Profile ageing experiments are started.\n";
-  slide::run(task_indv, profAgConfigVec.size());
-}
\ No newline at end of file
+  runJobs(jobs);
+}
+} // namespace slide
@@ -2,7 +2,7 @@
  * Degradation.hpp
  *
  * Header file for the degradation simulations.
- * The exact degradation procedures are defined in the Cycler.
+ * The degradation experiments (Calendar_one, Cycle_one, Profile_one) are made of the (dis)charges of the Cycler.
  * In the functions defined here, the functions from the Cycler are called various times with slightly different parameters (e.g. different temperatures, C rates, etc).
  * As such, we can simulate the effect the different parameters have on battery degradation
  *
@@ -13,16 +13,13 @@
 
 #pragma once
 
-#include "Cell.hpp"
-#include "settings/settings.hpp"
+#include "../cells/Cell_SPM/param/DEG_ID.hpp"
+#include "../settings/settings.hpp"
 
-#include <cmath>
-#include <iostream>
-#include <fstream>
-#include <cassert>
-#include <memory>
-//#include <thread>
+#include <string>
+#include <filesystem>
 
+namespace slide {
 //!< Definitions of custom datatypes:
 struct CycleAgeingConfig
 {
@@ -38,6 +35,7 @@ struct CycleAgeingConfig
     : Vma(Vma), Vmi(Vmi), Tc(Tc), Ccha(Ccha), Cdis(Cdis), SOCma(SOCma), SOCmi(SOCmi) {}
 
   double Ti() const { return Tc + PhyConst::Kelvin; }
+  double cost() const { return (SOCma - SOCmi) / 100 * (1 / Ccha + 1 / Cdis); } //!< time of one cycle relative to a full 1C1D cycle, to run the longest experiments first
   std::string get_name(const std::string &pref) const
   {
     //!< Example output: pref + "T45_1C1D_SOC0-100";
@@ -71,7 +69,7 @@ struct ProfileAgeingConfig
   std::string csvName{ "Current Profile drive cycle HWFET.csv" };
   std::string namePrefix{ "prof-HWFET" };
 
-  ProfileAgeingConfig(double Vma, double Vmi, double Tc, double SOCma, double SOCmi, std::string &csvName, std::string &namePrefix)
+  ProfileAgeingConfig(double Vma, double Vmi, double Tc, double SOCma, double SOCmi, const std::string &csvName, const std::string &namePrefix)
     : Vma(Vma), Vmi(Vmi), Tc(Tc), SOCma(SOCma), SOCmi(SOCmi), csvName(csvName), namePrefix(namePrefix) {}
 
   double Ti() const { return Tc + PhyConst::Kelvin; }
@@ -82,20 +80,16 @@ struct ProfileAgeingConfig
   }
 };
 
-//!< Auxiliary functions for multi-threaded simulations
-void Calendar_one(const struct slide::Model_SPM &M, const struct DEG_ID &degid, int cellType, int verbose, //!< simulate one calendar ageing experiment
-                  double V, double Ti, int Time, int mode, int timeCycleData, int timeCheck, struct checkUpProcedure &proc, std::string name);
-void Cycle_one(const struct slide::Model_SPM &M, const struct DEG_ID &degid, int cellType, int verbose, double Vma, double Vmi, //!< simulate one cycle ageing experiment
-               double Ccha, bool CVcha, double Icutcha, double Cdis, bool CVdis, double Icutdis, double Ti, int timeCycleData, int nrCycles, int nrCap, struct checkUpProcedure &proc, std::string name);
-void Profile_one(const struct slide::Model_SPM &M, const struct DEG_ID &degid, int cellType, int verbose, std::string profName, int n, int limit, //!< simulate one drive cycle ageing experiment
-                 double Vma, double Vmi, double Ti, int timeCycleData, int nrProfiles, int nrCap, struct checkUpProcedure &proc, std::string name);
+//!< One experiment, which writes its results in the folder dir and throws if the cell could not be cycled until the end
+void Calendar_one(const DEG_ID &degid, int cellType, double V, double Ti, int Time, int mode, int timeCycleData, int timeCheck,
+                  const std::filesystem::path &dir); //!< simulate one calendar ageing experiment
+void Cycle_one(const DEG_ID &degid, int cellType, const CycleAgeingConfig &conf, bool CVcha, double Ccutcha, bool CVdis, double Ccutdis,
+               int timeCycleData, int nrCycles, int nrCap, const std::filesystem::path &dir); //!< simulate one cycle ageing experiment
+void Profile_one(const DEG_ID &degid, int cellType, const ProfileAgeingConfig &conf, int timeCycleData, int nrProfiles, int nrCap,
+                 const std::filesystem::path &dir); //!< simulate one drive cycle ageing experiment
 
 //!< Degradation experiments
-void CycleAgeing(const struct slide::Model_SPM &M, std::string pref, const struct DEG_ID &degid, int cellType, int verbose);    //!< simulate a range of cycle ageing experiments (different temperatures, SOC windows, currents)
-void CalendarAgeing(const struct slide::Model_SPM &M, std::string pref, const struct DEG_ID &degid, int cellType, int verbose); //!< simulate a range of calendar ageing experiments (different temperatures, SOC levels)
-void ProfileAgeing(const struct slide::Model_SPM &M, std::string pref, const struct DEG_ID &degid, int cellType, int verbose);  //!< simulate a range of drive cycle experiments (different cycles, different temperatures, etc.)
-
-//!< Configuration struct for above-given functions.
-
-void Cycle_one(const struct slide::Model_SPM &M, const struct DEG_ID &degid, int cellType, int verbose, //!< simulate one cycle ageing experiment
-               const struct CycleAgeingConfig &cycAgConfig, bool CVcha, double Icutcha, bool CVdis, double Icutdis, int timeCycleData, int nrCycles, int nrCap, struct checkUpProcedure &proc, const std::string &pref);
+void CycleAgeing(std::string pref, const DEG_ID &degid, int cellType);    //!< simulate a range of cycle ageing experiments (different temperatures, SOC windows, currents)
+void CalendarAgeing(std::string pref, const DEG_ID &degid, int cellType); //!< simulate a range of calendar ageing experiments (different temperatures, SOC levels)
+void ProfileAgeing(std::string pref, const DEG_ID &degid, int cellType);  //!< simulate a range of drive cycle experiments (different cycles, different temperatures, etc.)
+} // namespace slide
@@ -7,7 +7,16 @@
 
 #pragma once
 
+#include "../cells/Cell.hpp"
+#include "../modules/Module.hpp"
 #include "../system/Battery.hpp"
+#include "../types/StreamingStats.hpp"
+#include "../utility/parallelisation.hpp"
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <type_traits>
 
 namespace slide {
 inline void visit_SUs(StorageUnit *su, auto &&fn)
@@ -22,8 +31,144 @@ inline void visit_SUs(StorageUnit *su, auto &&fn)
   } else if (auto m = dynamic_cast<Module *>(su)) {
     //!< If su is a module, recursively call this function on its children
     fn(m);
-    for (auto &su_ptr : m->getSUs())
-      visit_SUs(su_ptr.get(), fn);
+    for (size_t i = 0; i < m->getNSUs(); i++)
+      visit_SUs(m->getSU(i), fn);
+  }
+}
+inline bool setStates_unchecked(StorageUnit *su, std::span<double> &s)
+{
+  /*
+   * Same as su->setStates(s) but without checking the states are valid.
+   * For states which were made by the simulation itself and can be slightly outside the range accepted as input,
+   * e.g. the SOC of a cell is slightly below 0 after a CV discharge.
+   * The caches of the SUs are not reset, so call setCheckpoints afterwards.
+   * Returns false if s is too short.
+   */
+  if (auto c = dynamic_cast<Cell *>(su)) {
+    const auto st = c->viewStates();
+    if (st.empty()) //!< cells without a view of their states
+      return !isStatusBad(c->setStates(s, false, false));
+
+    if (s.size() < st.size()) return false;
+
+    std::copy_n(s.begin(), st.size(), st.begin());
+    s = s.subspan(st.size());
+    return true;
+  }
+
+  if (auto b = dynamic_cast<Battery *>(su)) {
+    if (!setStates_unchecked(b->getCells(), s)) return false;
+  } else if (auto m = dynamic_cast<Module *>(su)) {
+    for (size_t i = 0; i < m->getNSUs(); i++)
+      if (!setStates_unchecked(m->getSU(i), s)) return false;
   }
+
+  if (s.empty()) return false;
+
+  su->setT(s.front()); //!< the temperature of the module or battery is its last state
+  s = s.subspan(1);
+  return true;
+}
+
+inline size_t getCheckpoints(StorageUnit *su, std::vector<double> &s)
+{
+  //!< append the getCheckpoint record of every node of su, each preceded by its length. Returns the number of nodes
+  size_t Nnodes{ 0 };
+  visit_SUs(su, [&](StorageUnit *node) {
+    const auto i = s.size();
+    s.push_back(0); //!< length of the record, known after getCheckpoint
+    node->getCheckpoint(s);
+    s[i] = static_cast<double>(s.size() - i - 1);
+    Nnodes++;
+  });
+  return Nnodes;
 }
+
+inline void setCheckpoints(StorageUnit *su, std::span<double> s)
+{
+  //!< opposite of getCheckpoints
+  visit_SUs(su, [&](StorageUnit *node) {
+    if (s.empty()) return;
+    const auto n = std::min(static_cast<size_t>(s[0]), s.size() - 1);
+    node->setCheckpoint(s.subspan(1, n));
+    s = s.subspan(n + 1);
+  });
+}
+
+template <typename CellData_t>
+void mergeUsageStats(CellUsageStats &u, const CellData_t &cellData)
+{
+  //!< only the cell data storage of storeHistogramData has usage statistics
+  if constexpr (requires { u.merge(cellData.data); }) u.merge(cellData.data);
+}
+
+inline CellUsageStats usageStats(StorageUnit *su, unsigned int numMaxParallelWorkers = settings::numMaxParallelWorkers)
+{
+  /*
+   * Usage statistics of all cells of su merged, i.e. as if all samples came from one cell.
+   * Every worker merges a part of the cells and the partial results are merged at the end (parallel reduction).
+   * Empty unless DATASTORE_CELL is storeHistogramData, or cells store usage statistics because their capture was lowered to it.
+   */
+  CellUsageStats total;
+  if constexpr (settings::DATASTORE_CELL >= settings::cellDataStorageLevel::storeHistogramData) {
+    std::vector<Cell *> cells;
+    visit_SUs(su, [&](auto *node) {
+      if constexpr (std::is_same_v<decltype(node), Cell *>) cells.push_back(node);
+    });
+
+    const auto Npart = std::min<size_t>(std::max(1u, numMaxParallelWorkers), cells.size());
+    std::vector<CellUsageStats> partial(Npart);
+    run(
+      [&](int p) {
+        for (size_t i = static_cast<size_t>(p); i < cells.size(); i += Npart)
+        {
+          mergeUsageStats(partial[static_cast<size_t>(p)], cells[i]->getCellData());
+          mergeUsageStats(partial[static_cast<size_t>(p)], cells[i]->getCellStats());
+        }
+      },
+      static_cast<int>(Npart), numMaxParallelWorkers);
+
+    for (const auto &p : partial)
+      total.merge(p);
+  }
+  return total;
+}
+
+class Snapshot
+{
+  /*
+   * Copy of the full state of a storage unit (states and the non-state variables of getCheckpoint, e.g. the
+   * thermal accumulators and the stress history of SPM cells) to undo a time step, e.g. to locate an event inside a time step.
+   * Unlike backupStates, this does not overwrite the backup of the SUs, and the buffers are reused.
+   */
+  std::vector<double> s, ckp, s_now; //!< s_now: states at restore, to check they have the layout of s
+  size_t Nnodes{ 0 };
+
+public:
+  void save(StorageUnit *su)
+  {
+    s.clear();
+    ckp.clear();
+    su->getStates(s);
+    Nnodes = getCheckpoints(su, ckp);
+  }
+
+  bool restore(StorageUnit *su)
+  {
+    //!< returns false if the configuration of su changed since save (e.g. a cluster was split), su is then not changed
+    size_t N{ 0 };
+    visit_SUs(su, [&](auto) { N++; });
+    if (N != Nnodes) return false;
+
+    s_now.clear();
+    su->getStates(s_now); //!< check before writing, setStates_unchecked stops halfway if s is too short
+    if (s_now.size() != s.size()) return false;
+
+    std::span<double> spn{ s };
+    if (!setStates_unchecked(su, spn)) return false;
+
+    setCheckpoints(su, ckp);
+    return true;
+  }
+};
 } // namespace slide
\ No newline at end of file
@@ -13,3 +13,6 @@
 #include "Procedure.hpp"
 #include "Cycler.hpp"
 #include "determine_OCV.hpp"
+#include "Checkpoint.hpp"
+#include "Protocol.hpp"
+#include "degradation.hpp"
@@ -22,6 +22,14 @@ constexpr bool writeCumulativeData = storeCumulativeData;
 constexpr size_t N_CumulativeCell = storeCumulativeData ? 3 : 0;
 constexpr size_t N_CumulativeModule = (DATASTORE_MODULE >= moduleDataStorageLevel::storeCumulativeData) ? 3 : 0;
 
+//!< the pack store replaces the recursive storeData of a module, so only if the modules and cooling systems store no time data themselves
+constexpr bool packCellData = DATASTORE_PACK && DATASTORE_CELL == cellDataStorageLevel::storeTimeData
+                              && DATASTORE_MODULE < moduleDataStorageLevel::storeTimeData && DATASTORE_COOL == 0;
+
+//!< second data storage of the cells, for the usage statistics of cells whose capture is lowered at runtime (see StorageUnit::setCapture)
+constexpr auto lowCaptureStorage = (DATASTORE_CELL == cellDataStorageLevel::storeTimeData) ? cellDataStorageLevel::storeHistogramData
+                                                                                          : cellDataStorageLevel::noStorage;
+
 
 } // namespace slide::settings::data
 
@@ -30,6 +30,11 @@ enum class moduleDataStorageLevel {
   storeTimeData
 };
 
+enum class dataFormat {
+  csv = 0, //!< one text file per storage unit and prefix
+  binary   //!< one columnar binary file per prefix, see ColumnarFile.hpp
+};
+
 enum CVcurrentAlgorithm //!< Current finding method;
 {
   linearSearch = 0,
@@ -47,6 +47,11 @@ constexpr bool overwrite_data = true; //!< if this is false then folder overwrit
 
 //!< Data storage  //!< from slidepack
 constexpr int DATASTORE_NHIST = 100; //!< length of the arrays with the histograms (if 1)
+constexpr double DATASTORE_SOC_BIN{ 0.01 };             //!< width of the bins of the time-at-SOC histograms of the cell usage statistics
+constexpr double DATASTORE_T_BIN{ 1 };                  //!< width of the bins of the time-at-temperature histograms [K]
+constexpr double DATASTORE_QUANTILE_ACCURACY{ 1e-3 };   //!< relative accuracy of the quantiles of the cell usage statistics
+constexpr double DATASTORE_DOD_BIN{ 0.05 };             //!< width of the depth and mean-SOC bins of the rainflow cycle counts
+constexpr double DATASTORE_RAINFLOW_HYSTERESIS{ 0.1 };  //!< reversals smaller than this fraction of a depth bin are not counted as cycles
 
 constexpr auto DATASTORE_CELL = cellDataStorageLevel::storeTimeData; //!< if 0, no cell-level data is stored
                                                                      //!< if 1, statistics about I, V and T are stored, as well as overall utilisation (throughput)
@@ -55,6 +60,18 @@ constexpr auto DATASTORE_CELL = cellDataStorageLevel::storeTimeData; //!< if 0,
 
 constexpr auto DATASTORE_MODULE = moduleDataStorageLevel::noStorage; //!< See moduleDataStorageLevel for different options.
 
+constexpr auto DATASTORE_FORMAT = dataFormat::binary; //!< format of the cell and module data, the binary files can be converted to csv by slide2csv
+constexpr bool DATASTORE_COMPRESS = true;             //!< compress the columns of the binary files (lossless)
+constexpr bool DATASTORE_ASYNC = true;                //!< write the data in a background thread while the simulation continues, see AsyncWriter.hpp
+constexpr size_t DATASTORE_ASYNC_BYTES{ 1ULL << 30 }; //!< maximum memory of the data waiting to be written [bytes], storeData waits if there is more
+constexpr bool DATASTORE_PACK = true;                 //!< store the time data of all cells of a module in one buffer of the top-level module, see PackDataStore.hpp
+constexpr bool DATASTORE_DECIMATE = true;             //!< store a sample of the time data only if I, V, SOC or T changed by more than its tolerance, see Decimator.hpp
+constexpr double DATASTORE_TOL_I{ 1e-3 };             //!< tolerance of the current [A]
+constexpr double DATASTORE_TOL_V{ 1e-3 };             //!< tolerance of the voltage [V]
+constexpr double DATASTORE_TOL_SOC{ 1e-3 };           //!< tolerance of the SOC [-]
+constexpr double DATASTORE_TOL_T{ 0.1 };              //!< tolerance of the temperature [K]
+constexpr double DATASTORE_DECIMATE_TMAX{ 600 };      //!< a sample is stored at least every this many seconds [s]
+
 //!< constexpr int DATASTORE_MODULE = 0; //!< if 0, no module-level data is stored
 //!< if 2, current, voltage, temperature, soc is stored at every time step, as well as overall utilisation (throughput)
 //!< constexpr int DATASTORE_BATT = 0; //!< if 0, no module-level data is stored
@@ -36,6 +36,10 @@ const static fs::path data_folder = "data";
 
 static fs::path results = root_folder / results_folder;
 static fs::path data = root_folder / data_folder;
+
+//!< Folder in which parsed input files (csv) are cached in binary form, so later runs map them instead of parsing again.
+//!< Empty (default) disables the cache. inline so setting it (e.g. in main) holds for every translation unit.
+inline fs::path cache{};
 } // namespace PathVar
 
 namespace slide::settings::path::Kokam {
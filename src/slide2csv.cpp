@@ -0,0 +1,40 @@
+/*
+ * slide2csv.cpp
+ *
+ * Converts the columnar binary data files (prefix_data.slb, see utility/io/ColumnarFile.hpp) to one csv file per series.
+ * 	slide2csv results/Cycler_data.slb [output folder]
+ * writes e.g. results/Cycler_H_cell0_cellData.csv. Without an output folder, the csv files are put next to the binary file.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#include "utility/io/ColumnarFile.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: slide2csv <file.slb> [output folder]\n";
+    return 1;
+  }
+
+  const std::filesystem::path name{ argv[1] };
+  const auto folder = (argc == 3) ? std::filesystem::path(argv[2]) : name.parent_path();
+
+  auto prefix = name.stem().string(); //!< prefix_data.slb -> prefix
+  if (prefix.ends_with("_data")) prefix.resize(prefix.size() - 5);
+
+  try {
+    const slide::ColumnarReader reader(name);
+    reader.toCSV(folder, prefix);
+    std::cout << "Wrote " << reader.getSeries().size() << " series of " << name << " to " << folder << ".\n";
+  } catch (int e) {
+    return e;
+  }
+  return 0;
+}
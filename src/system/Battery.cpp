@@ -110,6 +110,31 @@ Status Battery::setStates(setStates_t s, bool checkStates, bool print)
   return status;
 }
 
+void Battery::backupStates()
+{
+  cells->backupStates();
+  T_backup = T();
+}
+
+void Battery::restoreStates()
+{
+  cells->restoreStates();
+  setT(T_backup);
+}
+
+void Battery::getCheckpoint(std::vector<double> &s)
+{
+  s.insert(s.end(), { convlosses, convlosses_tot });
+  cool->getCheckpoint(s);
+}
+
+void Battery::setCheckpoint(std::span<double> s)
+{
+  free::pop_checkpoint(s, convlosses);
+  free::pop_checkpoint(s, convlosses_tot);
+  cool->setCheckpoint(s);
+}
+
 double Battery::getAndResetConvLosses()
 {
   double loss = convlosses;
@@ -216,7 +241,9 @@ void Battery::timeStep_CC(double dt, int steps)
   }
 
   //!< control the cooling system
-  double Tlocal = transform_max(cells->getSUs(), free::get_T<Module::SU_t>);
+  double Tlocal = 0;
+  for (size_t i = 0; i < cells->getNSUs(); i++)
+    Tlocal = std::max(Tlocal, cells->getSU(i)->T());
   cool->control(Tlocal, getThotSpot());
 
 //!< data storage
@@ -228,7 +255,8 @@ void Battery::timeStep_CC(double dt, int steps)
 void Battery::storeData()
 {
   //!< Store data of the cells and the cooling system
-  cells->storeData();
+  if (cells->getCapture() != settings::cellDataStorageLevel::noStorage)
+    cells->storeData();
   cool->storeData(getNcells());
 
 //!< store local data
@@ -246,7 +274,8 @@ void Battery::writeData(const std::string &prefix)
 #endif
 
   //!< write data for the cells
-  cells->writeData(prefix);
+  if (cells->getCapture() != settings::cellDataStorageLevel::noStorage)
+    cells->writeData(prefix);
 
 //!< write local data
 #if DATASTORE_BATT == 2
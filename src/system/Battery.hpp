@@ -27,6 +27,7 @@ protected:
   Converter conv{};                          //!< power electronic converter. Dual step DC/DC and DC/AC
   unsigned int nseries{ 1 }, nparallel{ 1 }; //!< number of series/parallel 'copies' of this module
 
+  double T_backup{};       //!< temperature at the time of backupStates()
   double convlosses{};     //!< losses in the converter during a given period (set to 0 by reset_convlosses)
   double convlosses_tot{}; //!< total cumulative losses in the converter during the entire lifetime
 
@@ -52,6 +53,7 @@ public:
   size_t getNcells() override { return cells->getNcells() * nseries * nparallel; }
 
   Module *getCells() { return cells.get(); }
+  Converter &getConverter() { return conv; }
   //!< int getNstates() { return cells->getNstates() + 1; } //!< +1 for the temperature of this battery
   void getStates(getStates_t &s) override; //!< returns one long array with the states
   void setBlockDegAndTherm(bool block);
@@ -62,6 +64,10 @@ public:
   }
 
   Status setStates(setStates_t s, bool checkStates = true, bool print = true) override; //!< opposite of getStates, check the states are valid?
+  void backupStates() override;
+  void restoreStates() override;
+  void getCheckpoint(std::vector<double> &s) override; //!< converter losses and the variables of the HVAC system
+  void setCheckpoint(std::span<double> s) override;
   double getAndResetConvLosses();
   double getConvLosses_total() { return convlosses_tot; }
   void resetConvLosses() { convlosses = 0; }
@@ -92,6 +98,16 @@ public:
   void storeData() override;
   void writeData(const std::string &prefix) override;
 
+  void applyCapture(settings::cellDataStorageLevel level) override
+  {
+    if (cells) cells->applyCapture(level);
+    capture = level;
+  }
+  void refreshCapture() override
+  {
+    if (cells) capture = cells->getCapture();
+  }
+
   Battery *copy() override { return new Battery(*this); }
 };
 
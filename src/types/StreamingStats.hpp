@@ -0,0 +1,377 @@
+/*
+ * StreamingStats.hpp
+ *
+ * Usage statistics which are updated one sample at a time in constant memory, independent of the length of the run.
+ * All accumulators can be merged, so the statistics of a module or battery are the merge of the ones of its cells
+ * and can be computed by a parallel reduction. Samples are weighted, e.g. by the time since the previous sample,
+ * so histograms hold the time spent in each bin and means are time averages.
+ *
+ * 	RunningStats 		count, minimum, maximum, weighted mean and variance (West's update, Chan's merge)
+ * 	BinnedHistogram 	histogram with a fixed bin width which grows to the range of the data, so nothing lands in an edge bin
+ * 	QuantileSketch 		quantiles with a relative accuracy (log-spaced bins, DDSketch), the number of bins is bounded
+ * 	RainflowCounter 	rainflow cycle counts binned by cycle depth and mean, counted online from the turning points
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "../settings/settings.hpp"
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <numeric>
+#include <algorithm>
+
+namespace slide {
+class RunningStats
+{
+  size_t n{ 0 };     //!< number of samples
+  double W{ 0 };     //!< sum of the weights
+  double mu{ 0 };    //!< weighted mean
+  double M2{ 0 };    //!< weighted sum of the squared deviations from the mean
+  double xmin{ std::numeric_limits<double>::infinity() }, xmax{ -std::numeric_limits<double>::infinity() };
+
+public:
+  void add(double x, double weight = 1)
+  {
+    n++;
+    xmin = std::min(xmin, x);
+    xmax = std::max(xmax, x);
+    if (weight <= 0) return;
+
+    W += weight;
+    const double d = x - mu;
+    mu += d * weight / W;
+    M2 += weight * d * (x - mu);
+  }
+
+  void merge(const RunningStats &o)
+  {
+    n += o.n;
+    xmin = std::min(xmin, o.xmin);
+    xmax = std::max(xmax, o.xmax);
+    if (o.W <= 0) return;
+
+    const double Wt = W + o.W, d = o.mu - mu;
+    mu += d * o.W / Wt;
+    M2 += o.M2 + d * d * W * o.W / Wt;
+    W = Wt;
+  }
+
+  size_t count() const { return n; }
+  double weight() const { return W; }
+  double min() const { return xmin; }
+  double max() const { return xmax; }
+  double mean() const { return mu; }
+  double variance() const { return (W > 0) ? M2 / W : 0; } //!< of the (weighted) population
+  double std() const { return std::sqrt(variance()); }
+};
+
+class SparseBins
+{
+  /*
+   * Weights of consecutive integer bin indices, from the lowest to the highest index which was used.
+   */
+  int64_t first{ 0 };
+  std::vector<double> w;
+
+public:
+  void add(int64_t k, double weight)
+  {
+    if (w.empty()) {
+      first = k;
+      w.assign(1, 0.0);
+    } else if (k < first) {
+      w.insert(w.begin(), static_cast<size_t>(first - k), 0.0);
+      first = k;
+    } else if (k - first >= static_cast<int64_t>(w.size()))
+      w.resize(static_cast<size_t>(k - first + 1), 0.0);
+
+    w[static_cast<size_t>(k - first)] += weight;
+  }
+
+  void merge(const SparseBins &o)
+  {
+    for (size_t i = 0; i < o.w.size(); i++)
+      if (o.w[i] != 0) add(o.first + static_cast<int64_t>(i), o.w[i]);
+  }
+
+  void collapseLowest(size_t maxBins)
+  {
+    //!< add the lowest bins to the lowest remaining one until there are at most maxBins
+    if (w.size() <= maxBins) return;
+    const auto n = static_cast<std::ptrdiff_t>(w.size() - maxBins);
+    const double s = std::accumulate(w.begin(), w.begin() + n, 0.0);
+    w.erase(w.begin(), w.begin() + n);
+    w.front() += s;
+    first += n;
+  }
+
+  int64_t firstIndex() const { return first; }
+  size_t size() const { return w.size(); }
+  double operator[](size_t i) const { return w[i]; }
+  double total() const { return std::accumulate(w.begin(), w.end(), 0.0); }
+};
+
+class BinnedHistogram
+{
+  double dx{ 1 }; //!< bin width, bin k holds the weight of x in [k*dx, (k+1)*dx)
+  SparseBins bins;
+
+public:
+  BinnedHistogram() = default;
+  explicit BinnedHistogram(double dx_) : dx(dx_) {}
+
+  void add(double x, double weight = 1)
+  {
+    if (weight > 0 && std::isfinite(x)) bins.add(static_cast<int64_t>(std::floor(x / dx)), weight);
+  }
+
+  void merge(const BinnedHistogram &o) { bins.merge(o.bins); } //!< both must have the same bin width
+
+  double width() const { return dx; }
+  size_t size() const { return bins.size(); }
+  double lower(size_t i) const { return static_cast<double>(bins.firstIndex() + static_cast<int64_t>(i)) * dx; } //!< lower edge of bin i
+  double operator[](size_t i) const { return bins[i]; }
+  double total() const { return bins.total(); }
+};
+
+class QuantileSketch
+{
+  /*
+   * Every quantile is within a relative accuracy alpha of the exact weighted quantile.
+   * Positive and negative values have their own log-spaced bins, values with a magnitude below minValue are counted as 0.
+   * If a sign has more than maxBins bins, the ones closest to 0 are merged, so only small values lose accuracy.
+   */
+  static constexpr double minValue{ 1e-9 };
+  static constexpr size_t maxBins{ 2048 };
+
+  double gamma, logGamma;
+  SparseBins pos, neg;
+  double zero{ 0 };
+
+  int64_t index(double x) const { return static_cast<int64_t>(std::ceil(std::log(x) / logGamma)); }
+  double value(int64_t k) const { return 2 * std::pow(gamma, static_cast<double>(k)) / (gamma + 1); } //!< middle of bin k
+
+public:
+  explicit QuantileSketch(double alpha = settings::DATASTORE_QUANTILE_ACCURACY)
+    : gamma((1 + alpha) / (1 - alpha)), logGamma(std::log(gamma)) {}
+
+  void add(double x, double weight = 1)
+  {
+    if (weight <= 0 || !std::isfinite(x)) return;
+
+    if (x > minValue) {
+      pos.add(index(x), weight);
+      pos.collapseLowest(maxBins);
+    } else if (x < -minValue) {
+      neg.add(index(-x), weight);
+      neg.collapseLowest(maxBins);
+    } else
+      zero += weight;
+  }
+
+  void merge(const QuantileSketch &o) //!< both must have the same accuracy
+  {
+    pos.merge(o.pos);
+    neg.merge(o.neg);
+    pos.collapseLowest(maxBins);
+    neg.collapseLowest(maxBins);
+    zero += o.zero;
+  }
+
+  double total() const { return pos.total() + neg.total() + zero; }
+
+  double quantile(double q) const
+  {
+    /*
+     * Value below which a fraction q of the weight lies, NaN if the sketch is empty.
+     */
+    const double Wt = total();
+    if (Wt <= 0) return std::numeric_limits<double>::quiet_NaN();
+
+    const double rank = std::clamp(q, 0.0, 1.0) * Wt;
+    double cum{ 0 };
+    for (size_t i = neg.size(); i-- > 0;) { //!< from the most negative value
+      cum += neg[i];
+      if (cum >= rank && neg[i] > 0) return -value(neg.firstIndex() + static_cast<int64_t>(i));
+    }
+    cum += zero;
+    if (cum >= rank && zero > 0) return 0;
+    for (size_t i = 0; i < pos.size(); i++) {
+      cum += pos[i];
+      if (cum >= rank && pos[i] > 0) return value(pos.firstIndex() + static_cast<int64_t>(i));
+    }
+
+    for (size_t i = pos.size(); i-- > 0;) //!< rounding in cum, return the largest value
+      if (pos[i] > 0) return value(pos.firstIndex() + static_cast<int64_t>(i));
+    return (zero > 0) ? 0 : -value(neg.firstIndex());
+  }
+};
+
+class RainflowCounter
+{
+  /*
+   * Online rainflow counting (four-point method) of a signal such as the SOC.
+   * Only the turning points which did not close a cycle yet are kept (the residue), every new turning point closes
+   * the cycles it can in O(1) amortised time. Reversals smaller than the hysteresis are ignored, and if the residue
+   * grows beyond maxResidue its oldest point is counted as a half cycle, so the memory is bounded.
+   * Cycle k of the counts holds the histogram of the mean of the cycles with a depth in [k*dDepth, (k+1)*dDepth).
+   */
+  static constexpr size_t maxResidue{ 256 };
+
+  double dDepth, dMean, hyst;
+  std::vector<BinnedHistogram> counts; //!< number of cycles per depth bin and mean bin, a half cycle counts 0.5
+  std::vector<double> residue;         //!< turning points which did not close a cycle yet
+  double cand{ 0 };                    //!< extreme of the current half cycle, the next turning point
+  int dir{ 0 };                        //!< direction of the current half cycle, 0 before the first reversal
+  bool started{ false };
+
+  void count(double a, double b, double n)
+  {
+    const auto k = static_cast<size_t>(std::abs(a - b) / dDepth);
+    if (k >= counts.size()) counts.resize(k + 1, BinnedHistogram(dMean));
+    counts[k].add((a + b) / 2, n);
+  }
+
+  void push(double x)
+  {
+    residue.push_back(x);
+    while (residue.size() >= 4) {
+      const auto n = residue.size();
+      const double AB = std::abs(residue[n - 4] - residue[n - 3]), BC = std::abs(residue[n - 3] - residue[n - 2]),
+                   CD = std::abs(residue[n - 2] - residue[n - 1]);
+      if (BC > AB || BC > CD) break;
+
+      count(residue[n - 3], residue[n - 2], 1); //!< B-C is a full cycle
+      residue.erase(residue.end() - 3, residue.end() - 1);
+    }
+
+    if (residue.size() > maxResidue) {
+      count(residue[0], residue[1], 0.5);
+      residue.erase(residue.begin());
+    }
+  }
+
+public:
+  explicit RainflowCounter(double dDepth_ = settings::DATASTORE_DOD_BIN, double dMean_ = settings::DATASTORE_DOD_BIN)
+    : dDepth(dDepth_), dMean(dMean_), hyst(settings::DATASTORE_RAINFLOW_HYSTERESIS * dDepth_) {}
+
+  void add(double x)
+  {
+    if (!std::isfinite(x)) return;
+    if (!started) {
+      started = true;
+      cand = x;
+      push(x); //!< the first sample is a turning point
+    } else if (dir == 0) {
+      if (std::abs(x - cand) > hyst) {
+        dir = (x > cand) ? 1 : -1;
+        cand = x;
+      }
+    } else if ((x - cand) * dir >= 0)
+      cand = x; //!< the half cycle continues
+    else if (std::abs(x - cand) > hyst) {
+      push(cand);
+      dir = -dir;
+      cand = x;
+    }
+  }
+
+  void merge(const RainflowCounter &o)
+  {
+    //!< add the cycles of o, the residue of o is added as half cycles. Both must have the same bins
+    o.forEach([this](double depth, double mean, double n) {
+      const auto k = static_cast<size_t>(std::round(depth / dDepth));
+      if (k >= counts.size()) counts.resize(k + 1, BinnedHistogram(dMean));
+      counts[k].add(mean + dMean / 2, n); //!< the middle of the bin, so rounding of the edge does not move it to the previous bin
+    });
+  }
+
+  double depthWidth() const { return dDepth; }
+  double meanWidth() const { return dMean; }
+  size_t residueSize() const { return residue.size(); }
+
+  void forEach(auto &&fn) const
+  {
+    /*
+     * Calls fn(lower edge of the depth bin, lower edge of the mean bin, number of cycles) for every bin with cycles.
+     * The residue, including the current half cycle, is counted as half cycles.
+     */
+    auto all = *this;
+    if (dir != 0) all.residue.push_back(cand);
+    for (size_t i = 0; i + 1 < all.residue.size(); i++)
+      all.count(all.residue[i], all.residue[i + 1], 0.5);
+
+    for (size_t k = 0; k < all.counts.size(); k++)
+      for (size_t i = 0; i < all.counts[k].size(); i++)
+        if (all.counts[k][i] > 0) fn(static_cast<double>(k) * dDepth, all.counts[k].lower(i), all.counts[k][i]);
+  }
+
+  double total() const
+  {
+    //!< number of cycles, half cycles count 0.5
+    double n{ 0 };
+    forEach([&n](double, double, double c) { n += c; });
+    return n;
+  }
+};
+
+struct VariableStats
+{
+  RunningStats stats;
+  QuantileSketch sketch;
+
+  void add(double x, double weight)
+  {
+    stats.add(x, weight);
+    sketch.add(x, weight);
+  }
+
+  void merge(const VariableStats &o)
+  {
+    stats.merge(o.stats);
+    sketch.merge(o.sketch);
+  }
+};
+
+struct CellUsageStats
+{
+  /*
+   * Usage statistics of a cell (or merged ones of a group of cells), each sample weighted by its duration [s].
+   */
+  VariableStats I, V, SOC, T;
+  BinnedHistogram timeAtSOC{ settings::DATASTORE_SOC_BIN }, timeAtT{ settings::DATASTORE_T_BIN }; //!< time [s] in each SOC and temperature bin
+  RainflowCounter cyclesSOC{}, cyclesT{ settings::DATASTORE_T_BIN, settings::DATASTORE_T_BIN };        //!< rainflow cycles by depth and mean
+
+  void add(double I_, double V_, double SOC_, double T_, double dt)
+  {
+    I.add(I_, dt);
+    V.add(V_, dt);
+    SOC.add(SOC_, dt);
+    T.add(T_, dt);
+    timeAtSOC.add(SOC_, dt);
+    timeAtT.add(T_, dt);
+    cyclesSOC.add(SOC_);
+    cyclesT.add(T_);
+  }
+
+  void merge(const CellUsageStats &o)
+  {
+    I.merge(o.I);
+    V.merge(o.V);
+    SOC.merge(o.SOC);
+    T.merge(o.T);
+    timeAtSOC.merge(o.timeAtSOC);
+    timeAtT.merge(o.timeAtT);
+    cyclesSOC.merge(o.cyclesSOC);
+    cyclesT.merge(o.cyclesT);
+  }
+};
+} // namespace slide
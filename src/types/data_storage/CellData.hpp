@@ -19,6 +19,8 @@ struct CellData : public CellDataStorage<N>
 {
   auto writeData(auto &cell, const std::string &prefix)
   {
+    if constexpr (N == settings::cellDataStorageLevel::storeTimeData)
+      this->flush();
     CellDataWriter<N>::writeData(cell, prefix, *this);
   }
 };
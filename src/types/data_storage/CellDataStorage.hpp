@@ -8,45 +8,62 @@
 #pragma once
 
 #include "../Histogram.hpp"
+#include "../StreamingStats.hpp"
 #include "cell_data.hpp"
+#include "Decimator.hpp"
 #include "../../settings/enum_definitions.hpp"
+#include "../../utility/free_functions.hpp"
 
 #include <utility>
 #include <iostream>
 #include <array>
 #include <vector>
+#include <span>
 
 namespace slide {
 
 template <settings::cellDataStorageLevel N>
 struct CellDataStorage
 {
+  static constexpr size_t Ncheckpoint{ 0 }; //!< number of values written by getCheckpoint
+
   template <typename Cell_t>
   inline void initialise(Cell_t &) {} //!< Do nothing.
 
   template <typename Cell_t>
   inline void storeData(Cell_t &) {} //!< Do nothing.
+
+  void getCheckpoint(std::vector<double> &) const {}
+  void setCheckpoint(std::span<double> &) {}
 };
 
 template <>
-struct CellDataStorage<settings::cellDataStorageLevel::storeHistogramData> //!< Store as histogram.
+struct CellDataStorage<settings::cellDataStorageLevel::storeHistogramData> //!< Store usage statistics in constant memory.
 {
-  std::array<Histogram<>, 3> data;
+  CellUsageStats data;
+  double tprev{ 0 };     //!< time of the previous sample [s]
+  bool started{ false }; //!< true after the first sample
+
+  static constexpr size_t Ncheckpoint{ 2 };
 
   template <typename Cell_t>
-  inline void initialise(Cell_t &cell) //!< Initialise the histograms.
-  {
-    data[0] = Histogram<>(-cell.Cap(), cell.Cap()); //!< 1C charge/discharge
-    data[1] = Histogram<>(cell.Vmin(), cell.Vmax());
-    data[2] = Histogram<>(cell.Tmin(), cell.Tmax());
-  }
+  inline void initialise(Cell_t &) {} //!< Do nothing, the histograms grow to the range of the data.
 
   template <typename Cell_t>
   inline void storeData(Cell_t &cell)
   {
-    data[0].add(cell.I());
-    data[1].add(cell.V());
-    data[2].add(cell.T());
+    //!< every sample is weighted by the time since the previous one, the first one has no previous sample
+    const double t = cell.getThroughputs().time();
+    data.add(cell.I(), cell.V(), cell.SOC(), cell.T(), started ? t - tprev : 0);
+    tprev = t;
+    started = true;
+  }
+
+  void getCheckpoint(std::vector<double> &s) const { s.insert(s.end(), { tprev, static_cast<double>(started) }); }
+  void setCheckpoint(std::span<double> &s)
+  {
+    free::pop_checkpoint(s, tprev);
+    free::pop_checkpoint(s, started);
   }
 };
 
@@ -54,6 +71,9 @@ template <>
 struct CellDataStorage<settings::cellDataStorageLevel::storeTimeData>
 {
   std::vector<double> data; //!< Common data
+  Decimator decimator;      //!< skips samples in which nothing changed
+
+  static constexpr size_t Ncheckpoint{ 0 };
 
   template <typename Cell_t>
   inline void initialise(Cell_t &) {} //!< Do nothing.
@@ -63,13 +83,14 @@ struct CellDataStorage<settings::cellDataStorageLevel::storeTimeData>
   {
     const auto throughputs = cell.getThroughputs();
     // #TODO just write all states, throughputs will be included.
-    data.push_back(cell.I());
-    data.push_back(cell.V());
-    data.push_back(cell.SOC());
-    data.push_back(cell.T());
-    data.push_back(throughputs.time()); // time
-    data.push_back(throughputs.Ah());   // Ah
-    data.push_back(throughputs.Wh());   // Wh
+    const std::array<double, 7> sample{ cell.I(), cell.V(), cell.SOC(), cell.T(),
+                                        throughputs.time(), throughputs.Ah(), throughputs.Wh() };
+    decimator.offer(sample, cellDataTolerances, 4, data);
   }
+
+  inline void flush() { decimator.flush(data); } //!< before the data is written
+
+  void getCheckpoint(std::vector<double> &) const {}
+  void setCheckpoint(std::span<double> &) {}
 };
 } // namespace slide
\ No newline at end of file
@@ -8,17 +8,21 @@
 #pragma once
 
 #include "cell_data.hpp"
+#include "../StreamingStats.hpp"
 #include "../../settings/enum_definitions.hpp"
 #include "../../utility/free_functions.hpp"
+#include "../../utility/io/ColumnarFile.hpp"
 
 #include <string>
 #include <vector>
 #include <fstream>
+#include <iostream>
 #include <span>
 #include <cstdlib>
 #include <array>
 #include <span>
 #include <variant>
+#include <algorithm>
 
 namespace slide {
 
@@ -29,25 +33,213 @@ inline void writeData(std::ofstream &file, std::span<Histogram<>> histograms)
 }
 
 
-inline void writeVarAndStates(std::ofstream &file, auto &cell)
+inline void writeVarAndStates(std::ofstream &file, std::span<const double> states)
 {
-  file << "States:,";                       // #TODO we need names for states.
-  for (const auto st_i : cell.viewStates()) // Time and Throughput data is written here if available.
+  file << "States:,";            // #TODO we need names for states.
+  for (const auto st_i : states) // Time and Throughput data is written here if available.
     file << st_i << ',';
   file << "\n\n\n";
 }
 
+constexpr std::array<double, 5> usageQuantiles{ 0.01, 0.05, 0.5, 0.95, 0.99 }; //!< quantiles which are written for every variable
+
+inline std::array<const VariableStats *, 4> usageVariables(const CellUsageStats &u) { return { &u.I, &u.V, &u.SOC, &u.T }; }
+
+inline const std::vector<Column> &usageColumns()
+{
+  //!< time of the snapshot, then min, max, mean, std and the quantiles of I, V, SOC and T
+  static const auto columns = [] {
+    std::vector<Column> c{ { "time", ColumnType::f64 } };
+    for (const std::string var : { "I", "V", "SOC", "T" })
+      for (const std::string s : { "min", "max", "mean", "std", "p1", "p5", "p50", "p95", "p99" })
+        c.push_back({ var + "_" + s, ColumnType::f64 });
+    return c;
+  }();
+  return columns;
+}
+
+inline void usageRow(const VariableStats &v, std::vector<double> &row)
+{
+  row.insert(row.end(), { v.stats.min(), v.stats.max(), v.stats.mean(), v.stats.std() });
+  for (const auto q : usageQuantiles) //!< the sketch is only accurate to a relative error, so keep it in the range which was seen
+    row.push_back((v.sketch.total() > 0) ? std::clamp(v.sketch.quantile(q), v.stats.min(), v.stats.max()) : v.sketch.quantile(q));
+}
+
+inline void writeCycles(std::ofstream &file, const char *name, const RainflowCounter &rf)
+{
+  //!< matrix with the number of cycles per depth bin (rows) and mean bin (columns), by their lower edges
+  std::vector<std::array<double, 3>> bins;
+  rf.forEach([&bins](double depth, double mean, double n) { bins.push_back({ depth, mean, n }); });
+
+  file << '\n'
+       << name << ":,depth bin," << rf.depthWidth() << ",mean bin," << rf.meanWidth() << '\n';
+  if (bins.empty()) return;
+
+  double mmin{ bins[0][1] }, mmax{ bins[0][1] }, dmax{ 0 };
+  for (const auto &b : bins) {
+    mmin = std::min(mmin, b[1]);
+    mmax = std::max(mmax, b[1]);
+    dmax = std::max(dmax, b[0]);
+  }
+  const auto Nd = static_cast<size_t>(std::round(dmax / rf.depthWidth())) + 1;
+  const auto Nm = static_cast<size_t>(std::round((mmax - mmin) / rf.meanWidth())) + 1;
+  std::vector<double> cycles(Nd * Nm, 0.0);
+  for (const auto &b : bins)
+    cycles[static_cast<size_t>(std::round(b[0] / rf.depthWidth())) * Nm + static_cast<size_t>(std::round((b[1] - mmin) / rf.meanWidth()))] += b[2];
+
+  file << "depth \\ mean:";
+  for (size_t j = 0; j < Nm; j++)
+    file << ',' << mmin + static_cast<double>(j) * rf.meanWidth();
+  file << '\n';
+  for (size_t i = 0; i < Nd; i++) {
+    file << static_cast<double>(i) * rf.depthWidth();
+    for (size_t j = 0; j < Nm; j++)
+      file << ',' << cycles[i * Nm + j];
+    file << '\n';
+  }
+}
+
+inline void writeData(std::ofstream &file, const CellUsageStats &u, double time)
+{
+  file << "Usage statistics at time:," << time << "\n"
+       << "variable,min,max,mean,std,p1,p5,p50,p95,p99\n";
+
+  constexpr std::array<const char *, 4> names{ "I", "V", "SOC", "T" };
+  std::vector<double> row;
+  for (size_t i = 0; i < names.size(); i++) {
+    row.clear();
+    usageRow(*usageVariables(u)[i], row);
+    file << names[i];
+    for (const auto x : row)
+      file << ',' << x;
+    file << '\n';
+  }
+
+  for (const auto &[name, hist] : { std::pair{ "Time at SOC", &u.timeAtSOC }, std::pair{ "Time at T", &u.timeAtT } }) {
+    file << '\n'
+         << name << ":,bin width," << hist->width() << "\nlower edge:";
+    for (size_t i = 0; i < hist->size(); i++)
+      file << ',' << hist->lower(i);
+    file << "\ntime [s]:";
+    for (size_t i = 0; i < hist->size(); i++)
+      file << ',' << (*hist)[i];
+    file << '\n';
+  }
+
+  writeCycles(file, "Rainflow cycles of SOC", u.cyclesSOC);
+  writeCycles(file, "Rainflow cycles of T", u.cyclesT);
+  file << "\n\n";
+}
+
 template <settings::cellDataStorageLevel N>
 void writeDataImpl(std::ofstream &file, auto &cell, auto &dataStorage)
 {
   if constexpr (settings::data::writeCumulativeData)
-    writeVarAndStates(file, cell);
+    writeVarAndStates(file, cell.viewStates());
 
-  if constexpr (N >= settings::cellDataStorageLevel::storeHistogramData)
+  if constexpr (N == settings::cellDataStorageLevel::storeHistogramData)
+    writeData(file, dataStorage.data, dataStorage.tprev);
+  else if constexpr (N >= settings::cellDataStorageLevel::storeTimeData)
     free::write_data(file, dataStorage.data, 7);
   //!< else write nothing.
 }
 
+inline const std::array<Column, 7> &cellDataColumns()
+{
+  //!< I, V, SOC and T are stored as float which is more precise than the 6 digits of the csv files, the cumulative variables as double.
+  static const std::array<Column, 7> columns{ { { "I", ColumnType::f32 },
+                                                { "V", ColumnType::f32 },
+                                                { "SOC", ColumnType::f32 },
+                                                { "T", ColumnType::f32 },
+                                                { "time", ColumnType::f64 },
+                                                { "Ah", ColumnType::f64 },
+                                                { "Wh", ColumnType::f64 } } };
+  return columns;
+}
+
+template <settings::cellDataStorageLevel N>
+void writeDataBinary(auto &cell, const std::string &prefix, auto &dataStorage)
+{
+
+  auto writer = ColumnarWriter::get(PathVar::results / (prefix + "_data.slb"));
+  std::vector<double> states, data;
+  if constexpr (settings::data::writeCumulativeData) {
+    const auto st = cell.viewStates();
+    states.assign(st.begin(), st.end());
+  }
+  if constexpr (N >= settings::cellDataStorageLevel::storeTimeData)
+    data = AsyncWriter::take(dataStorage.data);
+
+  std::vector<double> usage, timeAtSOC, timeAtT; //!< one snapshot row and the rows (time, lower edge, time in bin) of the histograms
+  std::vector<double> cyclesSOC, cyclesT;        //!< rows (time, depth, mean, cycles) of the rainflow counts
+  if constexpr (N == settings::cellDataStorageLevel::storeHistogramData) {
+    const auto &u = dataStorage.data;
+    usage.push_back(dataStorage.tprev);
+    for (const auto *v : usageVariables(u))
+      usageRow(*v, usage);
+
+    for (auto [hist, rows] : { std::pair{ &u.timeAtSOC, &timeAtSOC }, std::pair{ &u.timeAtT, &timeAtT } })
+      for (size_t i = 0; i < hist->size(); i++)
+        rows->insert(rows->end(), { dataStorage.tprev, hist->lower(i), (*hist)[i] });
+
+    for (auto [rf, rows] : { std::pair{ &u.cyclesSOC, &cyclesSOC }, std::pair{ &u.cyclesT, &cyclesT } })
+      rf->forEach([&, rows = rows](double depth, double mean, double n) { rows->insert(rows->end(), { dataStorage.tprev, depth, mean, n }); });
+  }
+
+  const auto bytes = (states.size() + data.size() + usage.size() + timeAtSOC.size() + timeAtT.size() + cyclesSOC.size() + cyclesT.size()) * sizeof(double);
+  AsyncWriter::submit([writer, ID = cell.getFullID(), states = std::move(states), data = std::move(data), usage = std::move(usage),
+                       timeAtSOC = std::move(timeAtSOC), timeAtT = std::move(timeAtT), cyclesSOC = std::move(cyclesSOC), cyclesT = std::move(cyclesT)] {
+    if (!states.empty()) {
+      std::vector<Column> stateColumns(states.size()); // #TODO we need names for states.
+      for (size_t i = 0; i < states.size(); i++)
+        stateColumns[i].name = "state" + std::to_string(i);
+      writer->write(ID + "_cellStates", stateColumns, states);
+    }
+    if (!usage.empty()) {
+      static const std::array<Column, 3> socColumns{ { { "time", ColumnType::f64 }, { "SOC", ColumnType::f64 }, { "seconds", ColumnType::f64 } } };
+      static const std::array<Column, 3> tColumns{ { { "time", ColumnType::f64 }, { "T", ColumnType::f64 }, { "seconds", ColumnType::f64 } } };
+      writer->write(ID + "_cellStats", usageColumns(), usage);
+      writer->write(ID + "_timeAtSOC", socColumns, timeAtSOC);
+      writer->write(ID + "_timeAtT", tColumns, timeAtT);
+
+      static const std::array<Column, 4> cycleColumns{ { { "time", ColumnType::f64 }, { "depth", ColumnType::f64 }, { "mean", ColumnType::f64 }, { "cycles", ColumnType::f64 } } };
+      writer->write(ID + "_cyclesSOC", cycleColumns, cyclesSOC);
+      writer->write(ID + "_cyclesT", cycleColumns, cyclesT);
+    }
+    writer->write(ID + "_cellData", cellDataColumns(), data);
+  },
+                      bytes);
+}
+
+template <settings::cellDataStorageLevel N>
+void writeDataAsync(auto &cell, const std::string &prefix, auto &dataStorage)
+{
+  /*
+   * Write the csv file of the cycling data in the AsyncWriter.
+   */
+  std::vector<double> states;
+  if constexpr (settings::data::writeCumulativeData) {
+    const auto st = cell.viewStates();
+    states.assign(st.begin(), st.end());
+  }
+  auto data = AsyncWriter::take(dataStorage.data);
+
+  const auto name = PathVar::results / (prefix + "_" + cell.getFullID() + "_cellData.csv");
+  const auto bytes = (states.size() + data.size()) * sizeof(double);
+  AsyncWriter::submit([name, states = std::move(states), data = std::move(data)]() mutable {
+    std::ofstream file(name, std::ios_base::app);
+    if (!file.is_open()) {
+      std::cerr << "ERROR in Cell::writeData, could not open file " << name << '\n';
+      throw 11;
+    }
+
+    if constexpr (settings::data::writeCumulativeData)
+      writeVarAndStates(file, states);
+    free::write_data(file, data, 7);
+  },
+                      bytes);
+}
+
 template <settings::cellDataStorageLevel N>
 struct CellDataWriter
 {
@@ -58,12 +250,29 @@ struct CellDataWriter
    *
    * Depending on the value of DATASTORE_CELL, different things are written
    * 	0 	nothing
-   * 	1 	general info about the cell and usage statistics in file xxx_cellStats.csv
+   * 	1 	general info about the cell and usage statistics in file xxx_cellData.csv
    * 	2 	cycling data (I, V, T at every time step) in file xxx_cellData.csv
+   *
+   * If DATASTORE_FORMAT is binary, the states and cycling data are written as the series
+   * ID_cellStates and ID_cellData in the columnar file prefix_data.slb,
+   * and the usage statistics as a snapshot row of ID_cellStats, the histograms ID_timeAtSOC and ID_timeAtT
+   * and the rainflow cycle counts ID_cyclesSOC and ID_cyclesT.
+   * The cycling data is handed over to the AsyncWriter, which writes it while the simulation continues.
    */
 
   inline static void writeData(auto &cell, const std::string &prefix, auto &storage)
   {
+    if constexpr (settings::DATASTORE_FORMAT == settings::dataFormat::binary
+                  && N != settings::cellDataStorageLevel::noStorage) {
+      writeDataBinary<N>(cell, prefix, storage);
+      return;
+    }
+
+    if constexpr (N == settings::cellDataStorageLevel::storeTimeData) {
+      writeDataAsync<N>(cell, prefix, storage);
+      return;
+    }
+
     constexpr auto suffix = "cellData.csv";
     auto file = free::openFile(cell, PathVar::results, prefix, suffix);
     writeDataImpl<N>(file, cell, storage);
@@ -0,0 +1,89 @@
+/*
+ * Decimator.hpp
+ *
+ * Decides which samples of a time series are stored, so long rests do not fill the data with identical samples.
+ * A sample is stored if a variable moved by more than its tolerance since the last stored sample,
+ * or if DATASTORE_DECIMATE_TMAX seconds passed. The last skipped sample is kept, and stored before a sample
+ * which jumped away from it, so the end of a plateau and the start of the next step (e.g. a new current) are both exact.
+ * Without DATASTORE_DECIMATE every sample is stored.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "../../settings/settings.hpp"
+
+#include <vector>
+#include <span>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <cstddef>
+
+namespace slide {
+class Decimator
+{
+  std::vector<double> last, pending; //!< last stored sample and the last skipped one
+  bool hasPending{ false };
+
+  static bool moved(std::span<const double> a, std::span<const double> b, std::span<const double> tol)
+  {
+    //!< tol holds the tolerance of every variable of a row, a sample can be several rows (e.g. one per cell)
+    for (size_t j = 0; j < a.size(); j++)
+      if (std::abs(a[j] - b[j]) > tol[j % tol.size()]) return true;
+    return false;
+  }
+
+public:
+  static constexpr double noTol{ std::numeric_limits<double>::infinity() }; //!< tolerance of variables which are not checked
+
+  void offer(std::span<const double> s, std::span<const double> tol, size_t iTime, std::vector<double> &data)
+  {
+    /*
+     * Append the sample s to data if it has to be stored, preceded by the last skipped sample if s jumped away from it.
+     * iTime is the index of the time [s] in s.
+     */
+    if constexpr (!settings::DATASTORE_DECIMATE) {
+      data.insert(data.end(), s.begin(), s.end());
+      return;
+    }
+
+    if (!last.empty() && last.size() == s.size() && !moved(s, last, tol)
+        && s[iTime] - last[iTime] < settings::DATASTORE_DECIMATE_TMAX) {
+      pending.assign(s.begin(), s.end());
+      hasPending = true;
+      return;
+    }
+
+    if (hasPending && pending.size() == s.size() && moved(s, pending, tol))
+      data.insert(data.end(), pending.begin(), pending.end());
+
+    data.insert(data.end(), s.begin(), s.end());
+    last.assign(s.begin(), s.end());
+    hasPending = false;
+  }
+
+  void flush(std::vector<double> &data)
+  {
+    //!< store the last skipped sample, e.g. before the data is written, so the last state is in the data
+    if (hasPending) {
+      data.insert(data.end(), pending.begin(), pending.end());
+      last.swap(pending);
+      hasPending = false;
+    }
+  }
+
+  void reset()
+  {
+    last.clear();
+    pending.clear();
+    hasPending = false;
+  }
+};
+
+inline constexpr std::array<double, 7> cellDataTolerances{ settings::DATASTORE_TOL_I, settings::DATASTORE_TOL_V, settings::DATASTORE_TOL_SOC,
+                                                           settings::DATASTORE_TOL_T, Decimator::noTol, Decimator::noTol, Decimator::noTol }; //!< I, V, SOC, T, time, Ah, Wh
+} // namespace slide
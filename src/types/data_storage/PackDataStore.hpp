@@ -0,0 +1,159 @@
+/*
+ * PackDataStore.hpp
+ *
+ * Time data of all cells of a pack in one contiguous buffer, instead of one growing vector per cell.
+ * The top-level module fills it in a single pass over its cells at every storeData,
+ * so the cost of sampling and of allocating grows with the number of samples and not with the number of cells.
+ * Every sample is one row with the variables of CellDataStorage<storeTimeData> (I, V, SOC, T, time, Ah, Wh)
+ * of every cell, i.e. the buffer is a samples x cells x variables matrix.
+ * Cells whose capture (see StorageUnit::setCapture) is lowered to storeHistogramData store their usage statistics instead.
+ * With DATASTORE_DECIMATE, a row is only kept if a variable of any cell changed by more than its tolerance.
+ * writeData hands the full matrix to the AsyncWriter, which splits it into the data of each cell
+ * and writes it to the same files (or series) as CellDataWriter.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "CellDataWriter.hpp"
+#include "Decimator.hpp"
+#include "../../settings/settings.hpp"
+#include "../../utility/io/AsyncWriter.hpp"
+#include "../../utility/io/ColumnarFile.hpp"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace slide {
+template <typename Cell_t>
+class PackDataStore
+{
+  std::vector<Cell_t *> cells;     //!< cells of the pack which store time data, cell i is column block i of every row
+  std::vector<Cell_t *> statCells; //!< cells of the pack which only store usage statistics
+  bool attached{ false };
+  std::vector<std::string> IDs; //!< full ID of every cell
+  std::vector<double> data;     //!< samples x cells x Nvar
+  std::vector<double> row;      //!< the newest sample of all cells
+  Decimator decimator;          //!< skips rows in which nothing changed
+
+public:
+  static constexpr size_t Nvar{ 7 };
+
+  PackDataStore() = default;
+  PackDataStore(const PackDataStore &) {} //!< a copy of a module has other cells, so the copy is attached again
+  PackDataStore &operator=(const PackDataStore &)
+  {
+    reset();
+    return *this;
+  }
+
+  bool isAttached() const { return attached; }
+  size_t size() const { return cells.empty() ? 0 : data.size() / (cells.size() * Nvar); } //!< number of samples which were not written yet
+
+  static size_t maxRows(size_t Ncells)
+  {
+    //!< samples of Ncells cells which fit in half of the memory of the AsyncWriter, so the full buffer and the one which is being filled fit in it
+    const size_t rowBytes = std::max<size_t>(1, Ncells * Nvar * sizeof(double));
+    return std::clamp<size_t>(settings::DATASTORE_ASYNC_BYTES / 2 / rowBytes, 1, settings::CELL_NDATA_MAX);
+  }
+
+  void attach(std::vector<Cell_t *> cells_)
+  {
+    /*
+     * Store the data of cells from now on.
+     * Room for maxRows samples is reserved, the Cycler writes the data before more are stored.
+     */
+    reset();
+    for (auto *c : cells_)
+      if (c->getCapture() == settings::cellDataStorageLevel::storeTimeData) {
+        cells.push_back(c);
+        IDs.push_back(c->getFullID());
+      } else if (c->getCapture() == settings::cellDataStorageLevel::storeHistogramData)
+        statCells.push_back(c);
+    attached = true;
+
+    data.reserve(maxRows(cells.size()) * cells.size() * Nvar);
+  }
+
+  void reset()
+  {
+    //!< detach from the cells, samples which were not written yet are dropped
+    cells.clear();
+    statCells.clear();
+    IDs.clear();
+    data = {};
+    decimator.reset();
+    attached = false;
+  }
+
+  void store()
+  {
+    //!< add one sample of every cell
+    row.resize(cells.size() * Nvar);
+    double *p = row.data();
+    for (auto *c : cells) {
+      const auto th = c->getThroughputs();
+      p[0] = c->I();
+      p[1] = c->V();
+      p[2] = c->SOC();
+      p[3] = c->T();
+      p[4] = th.time();
+      p[5] = th.Ah();
+      p[6] = th.Wh();
+      p += Nvar;
+    }
+    decimator.offer(row, cellDataTolerances, 4, data);
+
+    for (auto *c : statCells)
+      c->storeData();
+  }
+
+  void write(const std::string &prefix)
+  {
+    /*
+     * Write the stored samples of every cell, like CellDataWriter does for the data of a single cell.
+     */
+    decimator.flush(data);
+    if (data.empty()) return;
+
+    const auto bytes = data.size() * sizeof(double);
+    auto split = [IDs = IDs, m = AsyncWriter::take(data)](auto &&writeCell) {
+      const size_t Nc = IDs.size(), Nrow = m.size() / (Nc * Nvar);
+      std::vector<double> rows;
+      for (size_t c = 0; c < Nc; c++) {
+        rows.resize(Nrow * Nvar);
+        for (size_t r = 0; r < Nrow; r++)
+          std::copy_n(m.data() + (r * Nc + c) * Nvar, Nvar, rows.data() + r * Nvar);
+        writeCell(IDs[c], rows);
+      }
+    };
+
+    if constexpr (settings::DATASTORE_FORMAT == settings::dataFormat::binary) {
+      AsyncWriter::submit([split = std::move(split), writer = ColumnarWriter::get(PathVar::results / (prefix + "_data.slb"))] {
+        split([&](const std::string &ID, std::vector<double> &rows) { writer->write(ID + "_cellData", cellDataColumns(), rows); });
+      },
+                          bytes);
+    } else {
+      AsyncWriter::submit([split = std::move(split), prefix] {
+        split([&](const std::string &ID, std::vector<double> &rows) {
+          const auto name = PathVar::results / (prefix + "_" + ID + "_cellData.csv");
+          std::ofstream file(name, std::ios_base::app);
+          if (!file.is_open()) {
+            std::cerr << "ERROR in PackDataStore::write, could not open file " << name << '\n';
+            throw 11;
+          }
+          free::write_data(file, rows, Nvar);
+        });
+      },
+                          bytes);
+    }
+  }
+};
+} // namespace slide
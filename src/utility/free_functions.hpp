@@ -18,6 +18,7 @@
 #include <vector>
 #include <fstream>
 #include <iostream>
+#include <span>
 
 namespace slide::free {
 
@@ -242,6 +243,17 @@ auto inline check_current(bool checkV, auto &su) //!< Check voltage.
   //!< TBC
 }
 
+template <typename T>
+inline void pop_checkpoint(std::span<double> &s, T &x)
+{
+  //!< read the next value of a checkpoint record and remove it from s.
+  //!< If s is empty (record written by an older version with fewer fields), x keeps its current value.
+  if (s.empty()) return;
+
+  x = static_cast<T>(s.front());
+  s = s.subspan(1);
+}
+
 inline std::ofstream openFile(auto &SU, const auto &folder, const std::string &prefix, const std::string &suffix)
 {
   const auto name = PathVar::results / (prefix + "_" + SU.getFullID() + "_" + suffix);
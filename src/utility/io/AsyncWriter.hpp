@@ -0,0 +1,151 @@
+/*
+ * AsyncWriter.hpp
+ *
+ * Background thread which writes the data of cells and modules while the simulation continues.
+ * A storage unit swaps its full data buffer for an empty one and submits a job which owns the full buffer,
+ * so writeData returns immediately and the buffers are encoded and written in the order they were submitted.
+ * The memory of the queued buffers is bounded by DATASTORE_ASYNC_BYTES: if the queue is full, submit() waits
+ * until the thread has written enough (back-pressure), so a slow disk slows the simulation down instead of exhausting the RAM.
+ *
+ * Errors (thrown ints) of a job are rethrown by the next call to submit() or flush() in the simulation thread.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "../../settings/settings.hpp"
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <exception>
+#include <cstddef>
+
+namespace slide {
+class AsyncWriter
+{
+  struct Job
+  {
+    std::function<void()> fun;
+    size_t bytes{ 0 };
+  };
+
+  std::mutex mtx;
+  std::condition_variable cv; //!< signals new jobs, finished jobs and the stop
+  std::deque<Job> jobs;
+  size_t queued{ 0 };         //!< bytes of the queued and running jobs
+  bool busy{ false }, stop{ false };
+  std::exception_ptr error;
+  std::thread worker;
+
+  AsyncWriter() : worker([this] { loop(); }) {}
+
+  ~AsyncWriter()
+  {
+    {
+      std::lock_guard lock(mtx);
+      stop = true;
+    }
+    cv.notify_all();
+    worker.join(); //!< the queued jobs are written first
+  }
+
+  static AsyncWriter &instance()
+  {
+    static AsyncWriter w;
+    return w;
+  }
+
+  void loop()
+  {
+    std::unique_lock lock(mtx);
+    while (true) {
+      cv.wait(lock, [this] { return stop || !jobs.empty(); });
+      if (jobs.empty()) return;
+
+      auto job = std::move(jobs.front());
+      jobs.pop_front();
+      busy = true;
+
+      lock.unlock();
+      try {
+        job.fun();
+      } catch (...) {
+        std::lock_guard elock(mtx);
+        if (!error) error = std::current_exception();
+      }
+      job.fun = nullptr; //!< release the buffer before the memory is counted as free
+      lock.lock();
+
+      busy = false;
+      queued -= job.bytes;
+      cv.notify_all();
+    }
+  }
+
+  void rethrow()
+  {
+    //!< called with the lock held
+    if (error) std::rethrow_exception(std::exchange(error, nullptr));
+  }
+
+public:
+  AsyncWriter(const AsyncWriter &) = delete;
+  AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+  static void submit(std::function<void()> fun, size_t bytes)
+  {
+    /*
+     * Queue a job which writes bytes of data.
+     * Waits while the queued jobs exceed DATASTORE_ASYNC_BYTES, a job larger than the limit is queued once the queue is empty.
+     * Without DATASTORE_ASYNC the job is done immediately in this thread.
+     */
+    if constexpr (!settings::DATASTORE_ASYNC) {
+      fun();
+      return;
+    }
+
+    auto &w = instance();
+    {
+      std::unique_lock lock(w.mtx);
+      w.cv.wait(lock, [&w, bytes] { return w.queued == 0 || w.queued + bytes <= settings::DATASTORE_ASYNC_BYTES; });
+      w.rethrow();
+      w.jobs.push_back({ std::move(fun), bytes });
+      w.queued += bytes;
+    }
+    w.cv.notify_all();
+  }
+
+  static std::vector<double> take(std::vector<double> &buffer)
+  {
+    /*
+     * Swap a full data buffer for an empty one with the same capacity, and return the full one to be submitted.
+     */
+    std::vector<double> full;
+    full.swap(buffer);
+    buffer.reserve(full.capacity());
+    return full;
+  }
+
+  static void flush()
+  {
+    /*
+     * Wait until all submitted jobs are written, e.g. at the end of a procedure or before a checkpoint.
+     */
+    if constexpr (!settings::DATASTORE_ASYNC)
+      return;
+
+    auto &w = instance();
+    std::unique_lock lock(w.mtx);
+    w.cv.wait(lock, [&w] { return w.jobs.empty() && !w.busy; });
+    w.rethrow();
+  }
+};
+} // namespace slide
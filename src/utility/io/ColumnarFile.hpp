@@ -0,0 +1,599 @@
+/*
+ * ColumnarFile.hpp
+ *
+ * Chunked columnar binary files for the data of cells and modules, one file per prefix (i.e. per run)
+ * instead of one text file per storage unit.
+ * Every storage unit writes a series (e.g. "H1_cell3_cellData") with typed columns (e.g. I, V, time).
+ * Every flush of the data of a series appends one chunk in which each column is stored contiguously.
+ * At the end an index with the chunks of each series is written, so a reader can jump to the data of one cell.
+ *
+ * Layout, in native byte order:
+ * 	header 	"SLIDECOL", uint32 version
+ * 	blocks 	uint8 kind, uint64 size of the payload, payload
+ * 		series 	uint32 index, name, uint16 ncol, ncol * (name, uint8 type)
+ * 		chunk 	uint32 series, uint32 nrow, ncol * (uint8 encoding, uint64 size, data)
+ * 		index 	uint32 nseries, nseries * (name, uint16 ncol, ncol * (name, uint8 type), uint32 nchunk, nchunk * (uint64 offset, uint32 nrow))
+ * 	footer 	uint64 offset of the index block, "SLIDEEND"
+ * Strings are a uint16 length followed by the characters.
+ * The index and footer are only written when the file is closed. Files without them (e.g. after a crash) are read
+ * by scanning the blocks, and a writer which opens an existing file appends to it.
+ *
+ * Compressed columns store each value XORed with the previous one, without its leading and trailing zero bytes.
+ * This is lossless and time series which change slowly (or not at all, like I during a CC step) shrink a lot.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "MappedFile.hpp"
+#include "AsyncWriter.hpp"
+#include "../../settings/settings.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <charconv>
+#include <bit>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+
+namespace slide {
+enum class ColumnType : uint8_t { f64, f32 };
+
+struct Column
+{
+  std::string name;
+  ColumnType type{ ColumnType::f64 };
+};
+
+namespace columnar {
+constexpr char magic[] = "SLIDECOL", endMagic[] = "SLIDEEND"; //!< 8 characters without the terminating zero
+constexpr uint32_t version{ 1 };
+constexpr size_t headerSize{ 8 + sizeof(uint32_t) };
+constexpr size_t blockHeaderSize{ 1 + sizeof(uint64_t) };
+constexpr size_t footerSize{ sizeof(uint64_t) + 8 };
+
+enum Block : uint8_t { series = 1, chunk, index };
+enum Encoding : uint8_t { raw = 0, xorBytes };
+
+struct Series
+{
+  std::string name;
+  std::vector<Column> columns;
+  std::vector<std::pair<uint64_t, uint32_t>> chunks; //!< offset of the block and number of rows of every chunk
+
+  size_t rows() const
+  {
+    size_t n{ 0 };
+    for (const auto &c : chunks) n += c.second;
+    return n;
+  }
+};
+
+[[noreturn]] inline void corrupt(std::string_view what)
+{
+  if constexpr (settings::printBool::printCrit)
+    std::cerr << "ERROR in ColumnarFile, " << what << ".\n";
+  throw 3;
+}
+
+inline size_t width(ColumnType type) { return type == ColumnType::f32 ? sizeof(float) : sizeof(double); }
+
+class Sink
+{
+public:
+  std::string buf;
+
+  template <typename T>
+  void put(T x)
+  {
+    const auto n = buf.size();
+    buf.resize(n + sizeof(T));
+    std::memcpy(buf.data() + n, &x, sizeof(T));
+  }
+
+  template <typename T>
+  void patch(size_t at, T x) { std::memcpy(buf.data() + at, &x, sizeof(T)); }
+
+  void putString(std::string_view s)
+  {
+    put(static_cast<uint16_t>(s.size()));
+    buf.append(s);
+  }
+
+  void putColumns(std::span<const Column> columns)
+  {
+    put(static_cast<uint16_t>(columns.size()));
+    for (const auto &c : columns) {
+      putString(c.name);
+      put(static_cast<uint8_t>(c.type));
+    }
+  }
+};
+
+class Source
+{
+  const char *p, *end;
+
+public:
+  Source(const char *begin, const char *end_) : p(begin), end(end_) {}
+
+  size_t left() const { return static_cast<size_t>(end - p); }
+
+  const char *bytes(size_t n)
+  {
+    if (left() < n) corrupt("unexpected end of a block");
+    const char *q = p;
+    p += n;
+    return q;
+  }
+
+  template <typename T>
+  T get()
+  {
+    T x;
+    std::memcpy(&x, bytes(sizeof(T)), sizeof(T));
+    return x;
+  }
+
+  std::string getString()
+  {
+    const auto n = get<uint16_t>();
+    return std::string(bytes(n), n);
+  }
+
+  std::vector<Column> getColumns()
+  {
+    std::vector<Column> columns(get<uint16_t>());
+    for (auto &c : columns) {
+      c.name = getString();
+      const auto type = get<uint8_t>();
+      if (type > static_cast<uint8_t>(ColumnType::f32)) corrupt("unknown column type");
+      c.type = static_cast<ColumnType>(type);
+    }
+    return columns;
+  }
+};
+
+template <typename U, typename F>
+void encode(Sink &out, std::span<const double> rows, size_t col, size_t ncol, bool compress)
+{
+  /*
+   * Append column col of the row-major values in rows, as type F (float or double) whose bits are U.
+   */
+  constexpr int W = sizeof(U);
+  U prev{ 0 };
+  for (size_t i = col; i < rows.size(); i += ncol) {
+    const U bits = std::bit_cast<U>(static_cast<F>(rows[i]));
+    if (!compress) {
+      out.put(bits);
+      continue;
+    }
+
+    const U u = bits ^ prev;
+    prev = bits;
+    const int lz = (u == 0) ? W : std::countl_zero(u) / 8; //!< number of leading and trailing zero bytes
+    const int tz = (u == 0) ? 0 : std::countr_zero(u) / 8;
+    out.put(static_cast<uint8_t>((lz << 4) | tz));
+    for (int b = tz; b < W - lz; b++)
+      out.put(static_cast<uint8_t>(u >> (8 * b)));
+  }
+}
+
+template <typename U, typename F>
+void decode(Source &in, size_t nrow, uint8_t encoding, std::vector<double> &x)
+{
+  constexpr int W = sizeof(U);
+  U prev{ 0 };
+  for (size_t i = 0; i < nrow; i++) {
+    U bits{ 0 };
+    if (encoding == raw)
+      bits = in.get<U>();
+    else {
+      const auto h = in.get<uint8_t>();
+      const int lz = h >> 4, tz = h & 0x0F;
+      if (lz + tz > W) corrupt("invalid compressed value");
+
+      U u{ 0 };
+      for (int b = tz; b < W - lz; b++)
+        u |= static_cast<U>(in.get<uint8_t>()) << (8 * b);
+      bits = prev = (u ^ prev);
+    }
+    x.push_back(static_cast<double>(std::bit_cast<F>(bits)));
+  }
+}
+
+inline void decodeColumn(Source &in, ColumnType type, size_t nrow, std::vector<double> &x)
+{
+  const auto encoding = in.get<uint8_t>();
+  const auto size = in.get<uint64_t>();
+  if (encoding > xorBytes) corrupt("unknown encoding");
+
+  const char *p = in.bytes(size);
+  Source data(p, p + size);
+  if (type == ColumnType::f32)
+    decode<uint32_t, float>(data, nrow, encoding, x);
+  else
+    decode<uint64_t, double>(data, nrow, encoding, x);
+}
+
+inline size_t scan(std::span<const char> file, std::vector<Series> &series)
+{
+  /*
+   * Read the series and chunks by going through all blocks.
+   * Returns the end of the last complete series or chunk block,
+   * i.e. the index, footer and an incomplete block at the end of a crashed run are not included.
+   *
+   * THROWS
+   * 3 	this is not a columnar file
+   */
+  if (file.size() < headerSize || std::memcmp(file.data(), magic, 8) != 0)
+    corrupt("this is not a columnar file");
+
+  size_t pos{ headerSize };
+  while (file.size() - pos >= blockHeaderSize) {
+    Source head(file.data() + pos, file.data() + file.size());
+    const auto kind = head.get<uint8_t>();
+    const auto size = head.get<uint64_t>();
+    if (head.left() < size || (kind != Block::series && kind != Block::chunk)) break;
+
+    Source block(head.bytes(size), file.data() + pos + blockHeaderSize + size);
+    if (kind == Block::series) {
+      if (block.get<uint32_t>() != series.size()) break;
+      auto &s = series.emplace_back();
+      s.name = block.getString();
+      s.columns = block.getColumns();
+    } else {
+      const auto i = block.get<uint32_t>();
+      if (i >= series.size()) break;
+      series[i].chunks.emplace_back(pos, block.get<uint32_t>());
+    }
+    pos += blockHeaderSize + size;
+  }
+  return pos;
+}
+} // namespace columnar
+
+class ColumnarWriter
+{
+  /*
+   * Writes series of data to one columnar file.
+   * Different threads can write to the same file, e.g. the cells of a battery which are cycled in parallel.
+   * Use get() to share one writer for every file in the program.
+   */
+  std::filesystem::path name;
+  std::ofstream file;
+  uint64_t pos{ 0 }; //!< size of the file [bytes]
+  std::vector<columnar::Series> series;
+  std::map<std::string, uint32_t, std::less<>> lookup; //!< index in series of every name
+  bool compress;
+  std::mutex mtx;
+
+  static auto &registry()
+  {
+    static std::map<std::filesystem::path, std::shared_ptr<ColumnarWriter>> writers;
+    return writers;
+  }
+
+  static auto &registryMutex()
+  {
+    static std::mutex m;
+    return m;
+  }
+
+  void append(const std::string &buf)
+  {
+    file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    pos += buf.size();
+  }
+
+  void appendBlock(columnar::Block kind, const std::string &payload)
+  {
+    columnar::Sink head;
+    const uint64_t size = payload.size();
+    head.put(static_cast<uint8_t>(kind));
+    head.put(size);
+    append(head.buf);
+    append(payload);
+  }
+
+public:
+  explicit ColumnarWriter(const std::filesystem::path &name_, bool compress_ = settings::DATASTORE_COMPRESS)
+    : name(name_), compress(compress_)
+  {
+    /*
+     * Open the file name. If it exists, the new series and chunks are appended to it.
+     *
+     * THROWS
+     * 3 	the file exists but is not a columnar file
+     * 11 	the file could not be opened
+     */
+    std::error_code ec;
+    if (std::filesystem::file_size(name, ec) > 0 && !ec) {
+      {
+        MappedFile old(name);
+        pos = columnar::scan({ old.data(), old.size() }, series);
+      }
+      for (size_t i = 0; i < series.size(); i++)
+        lookup.emplace(series[i].name, static_cast<uint32_t>(i));
+
+      std::filesystem::resize_file(name, pos); //!< remove the index and footer, they are written again by close()
+      file.open(name, std::ios::binary | std::ios::app);
+    } else {
+      file.open(name, std::ios::binary | std::ios::trunc);
+      columnar::Sink head;
+      head.buf.append(columnar::magic, 8);
+      head.put(columnar::version);
+      if (file.is_open()) append(head.buf);
+    }
+
+    if (!file.is_open()) {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "ERROR in ColumnarWriter, could not open file " << name << '\n';
+      throw 11;
+    }
+  }
+
+  ColumnarWriter(const ColumnarWriter &) = delete;
+  ColumnarWriter &operator=(const ColumnarWriter &) = delete;
+
+  ~ColumnarWriter()
+  {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+
+  void write(std::string_view seriesName, std::span<const Column> columns, std::span<const double> rows)
+  {
+    /*
+     * Append a chunk to a series, which is created the first time it is written.
+     *
+     * IN
+     * seriesName 	name of the series, e.g. the full ID of a cell followed by the kind of data
+     * columns 		name and type of the columns, the same in every call for a series
+     * rows 		values row by row, i.e. rows.size() is a multiple of columns.size()
+     *
+     * THROWS
+     * 4 	the columns differ from the ones of the series or the file is closed
+     */
+    const size_t ncol = columns.size();
+    if (ncol == 0 || rows.empty()) return;
+
+    columnar::Sink chunk; //!< encode outside of the lock
+    chunk.put(uint32_t{ 0 });
+    chunk.put(static_cast<uint32_t>(rows.size() / ncol));
+    for (size_t j = 0; j < ncol; j++) {
+      chunk.put(static_cast<uint8_t>(compress ? columnar::xorBytes : columnar::raw));
+      const auto at = chunk.buf.size();
+      chunk.put(uint64_t{ 0 });
+      if (columns[j].type == ColumnType::f32)
+        columnar::encode<uint32_t, float>(chunk, rows, j, ncol, compress);
+      else
+        columnar::encode<uint64_t, double>(chunk, rows, j, ncol, compress);
+      const uint64_t size = chunk.buf.size() - at - sizeof(uint64_t);
+      chunk.patch(at, size);
+    }
+
+    std::lock_guard lock(mtx);
+    auto fail = [&](std::string_view what) {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "ERROR in ColumnarWriter::write, series " << seriesName << ' ' << what << ".\n";
+      throw 4;
+    };
+    if (!file.is_open()) fail("is written after its file was closed");
+
+    auto it = lookup.find(seriesName);
+    if (it == lookup.end()) {
+      const auto i = static_cast<uint32_t>(series.size());
+      it = lookup.emplace(std::string(seriesName), i).first;
+      series.push_back({ std::string(seriesName), { columns.begin(), columns.end() }, {} });
+
+      columnar::Sink def;
+      def.put(i);
+      def.putString(seriesName);
+      def.putColumns(columns);
+      appendBlock(columnar::series, def.buf);
+    }
+
+    auto &s = series[it->second];
+    if (s.columns.size() != ncol) fail("is written with a different number of columns");
+    for (size_t j = 0; j < ncol; j++)
+      if (s.columns[j].type != columns[j].type || s.columns[j].name != columns[j].name)
+        fail("is written with different columns");
+
+    chunk.patch(0, it->second);
+    s.chunks.emplace_back(pos, static_cast<uint32_t>(rows.size() / ncol));
+    appendBlock(columnar::chunk, chunk.buf);
+    file.flush(); //!< so the chunk survives if the simulation crashes later
+  }
+
+  void close()
+  {
+    /*
+     * Write the index and footer and close the file.
+     */
+    std::lock_guard lock(mtx);
+    if (!file.is_open()) return;
+
+    columnar::Sink index;
+    index.put(static_cast<uint32_t>(series.size()));
+    for (const auto &s : series) {
+      index.putString(s.name);
+      index.putColumns(s.columns);
+      index.put(static_cast<uint32_t>(s.chunks.size()));
+      for (const auto &[offset, nrow] : s.chunks) {
+        index.put(offset);
+        index.put(nrow);
+      }
+    }
+
+    const uint64_t at = pos;
+    appendBlock(columnar::index, index.buf);
+
+    columnar::Sink footer;
+    footer.put(at);
+    footer.buf.append(columnar::endMagic, 8);
+    append(footer.buf);
+    file.close();
+  }
+
+  static std::shared_ptr<ColumnarWriter> get(const std::filesystem::path &name)
+  {
+    /*
+     * The writer of the file name, which is opened the first time and stays open until closeAll() or the end of the program.
+     * Jobs of the AsyncWriter keep a copy, so the writer stays alive until their data is written.
+     */
+    std::lock_guard lock(registryMutex());
+    auto &w = registry()[name];
+    if (!w) w = std::make_shared<ColumnarWriter>(name);
+    return w;
+  }
+
+  static void closeAll()
+  {
+    /*
+     * Write the data queued in the AsyncWriter and close all files opened by get(), e.g. to read them in the same program.
+     * No other thread may be writing.
+     */
+    AsyncWriter::flush();
+    std::lock_guard lock(registryMutex());
+    for (auto &[name, w] : registry())
+      w->close();
+    registry().clear();
+  }
+};
+
+class ColumnarReader
+{
+  MappedFile file;
+  std::vector<columnar::Series> series;
+
+public:
+  explicit ColumnarReader(const std::filesystem::path &name) : file(name)
+  {
+    /*
+     * Read the index of the file name, or scan it if it has no index.
+     *
+     * THROWS
+     * 2 	the file could not be opened
+     * 3 	this is not a (valid) columnar file
+     */
+    const std::span<const char> all{ file.data(), file.size() };
+    if (all.size() >= columnar::headerSize + columnar::footerSize
+        && std::memcmp(all.data() + all.size() - 8, columnar::endMagic, 8) == 0) {
+      uint64_t at;
+      std::memcpy(&at, all.data() + all.size() - columnar::footerSize, sizeof(at));
+      if (std::memcmp(all.data(), columnar::magic, 8) != 0 || at + columnar::blockHeaderSize > all.size())
+        columnar::corrupt("invalid footer");
+
+      columnar::Source in(all.data() + at, all.data() + all.size() - columnar::footerSize);
+      if (in.get<uint8_t>() != columnar::index) columnar::corrupt("invalid footer");
+      in.get<uint64_t>();
+
+      series.resize(in.get<uint32_t>());
+      for (auto &s : series) {
+        s.name = in.getString();
+        s.columns = in.getColumns();
+        s.chunks.resize(in.get<uint32_t>());
+        for (auto &c : s.chunks) {
+          c.first = in.get<uint64_t>();
+          c.second = in.get<uint32_t>();
+        }
+      }
+    } else
+      columnar::scan(all, series);
+  }
+
+  const auto &getSeries() const { return series; }
+
+  int find(std::string_view name) const
+  {
+    //!< index of the series with this name, or -1
+    for (size_t i = 0; i < series.size(); i++)
+      if (series[i].name == name) return static_cast<int>(i);
+    return -1;
+  }
+
+  std::vector<std::vector<double>> read(size_t i) const
+  {
+    /*
+     * Read all values of series i, column by column.
+     *
+     * THROWS
+     * 3 	a chunk is corrupt
+     */
+    const auto &s = series.at(i);
+    std::vector<std::vector<double>> cols(s.columns.size());
+    for (auto &c : cols) c.reserve(s.rows());
+
+    for (const auto &[offset, nrow] : s.chunks) {
+      if (offset + columnar::blockHeaderSize > file.size()) columnar::corrupt("invalid chunk offset");
+      columnar::Source in(file.data() + offset, file.data() + file.size());
+      if (in.get<uint8_t>() != columnar::chunk) columnar::corrupt("invalid chunk offset");
+      const auto size = in.get<uint64_t>();
+
+      columnar::Source block(in.bytes(size), file.data() + offset + columnar::blockHeaderSize + size);
+      block.get<uint32_t>();
+      if (block.get<uint32_t>() != nrow) columnar::corrupt("the index does not match the chunk");
+      for (size_t j = 0; j < cols.size(); j++)
+        columnar::decodeColumn(block, s.columns[j].type, nrow, cols[j]);
+    }
+    return cols;
+  }
+
+  void toCSV(const std::filesystem::path &folder, const std::string &prefix) const
+  {
+    /*
+     * Write every series to folder/prefix_<series>.csv, with the names of the columns on the first line.
+     * Every value is written with the fewest digits which read back to the same float or double.
+     *
+     * THROWS
+     * 11 	a file could not be opened
+     */
+    for (size_t i = 0; i < series.size(); i++) {
+      const auto &s = series[i];
+      const auto name = folder / (prefix + "_" + s.name + ".csv");
+      std::ofstream out(name);
+      if (!out.is_open()) {
+        if constexpr (settings::printBool::printCrit)
+          std::cerr << "ERROR in ColumnarReader::toCSV, could not open file " << name << '\n';
+        throw 11;
+      }
+
+      for (size_t j = 0; j < s.columns.size(); j++)
+        out << (j == 0 ? "" : ",") << s.columns[j].name;
+      out << '\n';
+
+      const auto cols = read(i);
+      const size_t nrow = cols.empty() ? 0 : cols[0].size();
+      std::string line;
+      char num[32];
+      for (size_t r = 0; r < nrow; r++) {
+        line.clear();
+        for (size_t j = 0; j < cols.size(); j++) {
+          if (j != 0) line += ',';
+          const auto res = (s.columns[j].type == ColumnType::f32)
+                             ? std::to_chars(num, num + sizeof(num), static_cast<float>(cols[j][r]))
+                             : std::to_chars(num, num + sizeof(num), cols[j][r]);
+          line.append(num, res.ptr);
+        }
+        line += '\n';
+        out << line;
+      }
+    }
+  }
+};
+} // namespace slide
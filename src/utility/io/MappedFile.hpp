@@ -0,0 +1,132 @@
+/*
+ * MappedFile.hpp
+ *
+ * Read-only view of the contents of a file.
+ * On POSIX systems the file is memory mapped, so the OS pages it in on demand and nothing is copied.
+ * On other systems the file is read into a buffer owned by this object.
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "../../settings/settings.hpp"
+
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <span>
+#include <cstddef>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace slide {
+class MappedFile
+{
+  const char *ptr{ nullptr }; //!< start of the contents
+  size_t len{ 0 };            //!< size of the file [bytes]
+#ifdef _WIN32
+  std::vector<char> buffer; //!< contents of the file if it cannot be mapped
+#endif
+
+  void release() noexcept
+  {
+#ifndef _WIN32
+    if (ptr != nullptr && len != 0)
+      munmap(const_cast<char *>(ptr), len);
+#endif
+    ptr = nullptr;
+    len = 0;
+  }
+
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::filesystem::path &name)
+  {
+    /*
+     * Map the file name into memory.
+     *
+     * THROWS
+     * 2 	the file could not be opened or mapped
+     */
+    auto fail = [&name]() {
+      if constexpr (settings::printBool::printCrit)
+        std::cerr << "ERROR in MappedFile, file " << name << " could not be opened.\n";
+      throw 2;
+    };
+
+#ifndef _WIN32
+    const int fd = ::open(name.c_str(), O_RDONLY);
+    if (fd < 0) fail();
+
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) {
+      ::close(fd);
+      fail();
+    }
+
+    len = static_cast<size_t>(sb.st_size);
+    if (len != 0) {
+      void *p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        len = 0;
+        fail();
+      }
+      ptr = static_cast<const char *>(p);
+    }
+    ::close(fd); //!< the mapping stays valid after closing the file
+#else
+    std::ifstream in(name, std::ios::in | std::ios::binary);
+    if (!in.good()) fail();
+
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    ptr = buffer.data();
+    len = buffer.size();
+#endif
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+  MappedFile &operator=(MappedFile &&other) noexcept
+  {
+    if (this != &other) {
+      release();
+      std::swap(ptr, other.ptr);
+      std::swap(len, other.len);
+#ifdef _WIN32
+      std::swap(buffer, other.buffer);
+#endif
+    }
+    return *this;
+  }
+
+  ~MappedFile() { release(); }
+
+  void adviseSequential() const noexcept
+  {
+    //!< the file will be read once from front to back, so the OS can read ahead and drop pages behind
+#ifndef _WIN32
+    if (ptr != nullptr && len != 0)
+      madvise(const_cast<char *>(ptr), len, MADV_SEQUENTIAL);
+#endif
+  }
+
+  const char *data() const noexcept { return ptr; }
+  size_t size() const noexcept { return len; }
+  bool empty() const noexcept { return len == 0; }
+  std::string_view view() const noexcept { return { ptr, len }; }
+  std::span<const std::byte> bytes() const noexcept { return { reinterpret_cast<const std::byte *>(ptr), len }; }
+};
+} // namespace slide
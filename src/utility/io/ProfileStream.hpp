@@ -0,0 +1,161 @@
+/*
+ * ProfileStream.hpp
+ *
+ * Streams the set-points (current or power) of a load profile from a memory-mapped file or from memory.
+ * Only the part of the file which is being read is paged in, so profiles can be much larger than the RAM.
+ * Consecutive identical set-points are merged into one SetPoint, so they can be simulated with a single multi-step time step.
+ *
+ * Supported formats:
+ * 	.csv 	one column: one set-point per sample
+ * 			two columns: set-point and its duration [s], which is rounded to a whole number of samples
+ * 			lines which do not start with a number (headers, empty lines) are skipped
+ * 	.bin 	raw doubles in native byte order, one set-point per sample
+ *
+ * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
+ * of Oxford, VITO nv, and the 'Slide' Developers.
+ * See the licence file LICENCE.txt for more information.
+ */
+
+#pragma once
+
+#include "MappedFile.hpp"
+#include "../../settings/settings.hpp"
+
+#include <span>
+#include <filesystem>
+#include <charconv>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <iostream>
+
+namespace slide {
+struct SetPoint
+{
+  double value{ 0 }; //!< current [A] or power [W]
+  size_t n{ 0 };     //!< number of consecutive samples with this value
+};
+
+class ProfileStream
+{
+public:
+  enum class Format { automatic, csv, binary };
+
+private:
+  MappedFile file;
+  const char *begin{ nullptr }, *pos{ nullptr }, *end{ nullptr }; //!< unread part of the profile
+  bool binary{ true };
+  double scale{ 1 }; //!< multiplies every set-point, e.g. the capacity for a profile of C-rates
+  double dt{ 1 };    //!< length of one sample [s], to convert the durations in two-column csv files
+
+  SetPoint ahead{};   //!< set-point which was read but not yet returned
+  bool haveAhead{ false };
+
+  bool readBinary(SetPoint &sp)
+  {
+    if (end - pos < static_cast<std::ptrdiff_t>(sizeof(double))) return false;
+    std::memcpy(&sp.value, pos, sizeof(double)); //!< the data in memory does not need to be aligned
+    pos += sizeof(double);
+    sp.n = 1;
+    return true;
+  }
+
+  bool readCSV(SetPoint &sp)
+  {
+    /*
+     * Read the next line with a number.
+     *
+     * THROWS
+     * 3 	the duration in a two-column file is not a number or is negative
+     */
+    while (pos < end) {
+      const char *eol = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+      if (eol == nullptr) eol = end;
+      const char *p = pos;
+      pos = (eol < end) ? eol + 1 : end;
+
+      if (p == begin && eol - p >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0) p += 3; //!< skip the byte order mark
+
+      auto [next, ec] = std::from_chars(p, eol, sp.value);
+      if (ec != std::errc()) continue; //!< no number, e.g. a header
+
+      sp.n = 1;
+      if (next < eol && *next == ',') {
+        double duration{ 0 };
+        auto [next2, ec2] = std::from_chars(next + 1, eol, duration);
+        if (ec2 != std::errc() || duration < 0) {
+          if constexpr (settings::printBool::printCrit)
+            std::cerr << "ERROR in ProfileStream, the duration on the line starting with " << sp.value
+                      << " is not a valid number.\n";
+          throw 3;
+        }
+        sp.n = static_cast<size_t>(std::llround(duration / dt));
+        if (sp.n == 0) continue; //!< shorter than one sample
+      }
+      return true;
+    }
+    return false;
+  }
+
+  bool read(SetPoint &sp)
+  {
+    if (!(binary ? readBinary(sp) : readCSV(sp))) return false;
+    sp.value *= scale;
+    return true;
+  }
+
+public:
+  ProfileStream() = default;
+  explicit ProfileStream(const std::filesystem::path &name, double scale_ = 1, double dt_ = 1, Format format = Format::automatic)
+    : file(name), scale(scale_), dt(dt_)
+  {
+    /*
+     * Stream the profile in the file name.
+     *
+     * IN
+     * scale 	factor with which each set-point is multiplied
+     * dt 		length of one sample [s]
+     * format 	format of the file, if automatic this is deduced from the extension (.bin is binary, else csv)
+     *
+     * THROWS
+     * 2 	the file could not be opened
+     */
+    binary = (format == Format::binary) || (format == Format::automatic && name.extension() == ".bin");
+    file.adviseSequential();
+    begin = pos = file.data();
+    end = begin + file.size();
+  }
+
+  explicit ProfileStream(std::span<const double> samples, double scale_ = 1)
+    : begin(reinterpret_cast<const char *>(samples.data())), pos(begin), end(begin + samples.size_bytes()), scale(scale_) {}
+
+  ProfileStream(const ProfileStream &) = delete;
+  ProfileStream &operator=(const ProfileStream &) = delete;
+
+  bool next(SetPoint &sp)
+  {
+    /*
+     * Get the next set-point, merged with all consecutive samples with the same value.
+     * Returns false at the end of the profile.
+     */
+    if (!haveAhead && !read(ahead)) return false;
+
+    sp = ahead;
+    haveAhead = false;
+    while (read(ahead)) {
+      if (ahead.value != sp.value) {
+        haveAhead = true;
+        break;
+      }
+      sp.n += ahead.n;
+    }
+    return true;
+  }
+
+  void rewind()
+  {
+    pos = begin;
+    haveAhead = false;
+  }
+};
+} // namespace slide
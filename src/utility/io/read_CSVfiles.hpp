@@ -3,6 +3,11 @@
  *
  * groups functions for reading csv files into arrays and matrices
  *
+ * The files are memory mapped (MappedFile) and the numbers are parsed with std::from_chars directly into the output,
+ * without streams or intermediate copies. A byte order mark, lines which do not start with a number (headers, empty lines),
+ * spaces, carriage returns and the separators ',', ';' and tabs are skipped.
+ * If PathVar::cache is set, the parsed numbers are cached in binary files there, which later runs map instead of parsing the csv file.
+ *
  * Copyright (c) 2019, The Chancellor, Masters and Scholars of the University
  * of Oxford, VITO nv, and the 'Slide' Developers.
  * See the licence file LICENCE.txt for more information.
@@ -10,47 +15,306 @@
 
 #pragma once
 
+#include "MappedFile.hpp"
 #include "../../types/matrix.hpp"
 #include "../util_debug.hpp"
 
 #include <string>
+#include <string_view>
 #include <iostream>
-#include <fstream>
 #include <cassert>
-#include <sstream>
 #include <vector>
 #include <map>
 #include <span>
-#include <cstring> //!< -> for memcpy
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <type_traits>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 
 namespace slide {
-template <typename Tpath>
-std::string getFileContents(const Tpath &name)
-{
+namespace csv {
+  inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
 
-  std::cerr << "NOT IMPLEMENTED YET!\n";
-  throw 1234;
+  template <typename T>
+  const char *parse(const char *p, const char *end, T &x)
+  {
+    //!< parse a number at p, returns the end of the number or nullptr if there is none
+    if (p < end && *p == '+') p++; //!< from_chars does not accept a leading +
+    auto [next, ec] = std::from_chars(p, end, x);
+    if (ec == std::errc()) return next;
+    if (ec != std::errc::result_out_of_range) return nullptr;
+
+    char buf[64]{}; //!< e.g. denormal numbers, which strtod converts
+    const auto n = std::min<size_t>(static_cast<size_t>(next - p), sizeof(buf) - 1);
+    std::memcpy(buf, p, n);
+    x = static_cast<T>(std::strtod(buf, nullptr));
+    return next;
+  }
 
-  //!< For more info see: https://insanecoding.blogspot.com/2011/11/how-to-read-in-file-in-c.html
+  inline size_t countLines(std::string_view text)
+  {
+    //!< upper bound of the number of rows, to reserve memory
+    return static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) + 1;
+  }
 
-  std::ifstream in(name, std::ios::in | std::ios::binary);
-  if (!in.good()) //!< check if we could open the file
+  template <typename T = double, typename Fun>
+  size_t forEachValue(std::string_view text, Fun &&fn, size_t nrow_max = 0)
   {
-    std::cerr << "Error in getFileContents. File " << name << " could not be opened.\n";
-    throw 2;
+    /*
+     * Parse the numbers of a csv file and call fn(row, column, value) for each of them, in the order of the file.
+     * Only lines which start with a number are rows, other lines (e.g. headers) are skipped.
+     * A row ends at the first field which is not a number.
+     *
+     * IN
+     * text 		contents of the file
+     * nrow_max 	maximum number of rows to read (if 0, read all)
+     *
+     * OUT
+     * number of rows
+     */
+    const char *p = text.data(), *end = p + text.size();
+    if (text.starts_with("\xEF\xBB\xBF")) p += 3; //!< skip the byte order mark
+
+    size_t row{ 0 };
+    while (p < end && (nrow_max == 0 || row < nrow_max)) {
+      const char *eol = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+      if (eol == nullptr) eol = end;
+
+      size_t col{ 0 };
+      for (const char *q = p; q < eol;) {
+        while (q < eol && isBlank(*q)) q++;
+        T x{};
+        const char *next = parse(q, eol, x);
+        if (next == nullptr) break;
+
+        fn(row, col++, x);
+        q = next;
+        while (q < eol && isBlank(*q)) q++;
+        if (q < eol && (*q == ',' || *q == ';')) q++;
+      }
+
+      if (col != 0) row++;
+      p = eol + 1;
+    }
+    return row;
+  }
+
+  //!< Binary cache of parsed csv files, used if PathVar::cache is set. A cache file holds
+  //!< CacheHeader, uint64_t rowStart[nrows + 1], double values[nvalues]; the values of row i are values[rowStart[i] ... rowStart[i + 1]).
+  //!< It is only used if the size and modification time of the csv file are the ones in its header, else it is written again.
+  struct CacheHeader
+  {
+    char magic[8]{ 'S', 'L', 'C', 'S', 'V', '0', '1', '\0' };
+    uint64_t size{ 0 }; //!< size of the csv file [bytes]
+    int64_t mtime{ 0 }; //!< modification time of the csv file
+    uint64_t nrows{ 0 }, nvalues{ 0 };
+  };
+
+  inline std::filesystem::path cachePath(const std::filesystem::path &name)
+  {
+    //!< the name of the csv file and a hash of its full path, so files with the same name in different folders have their own cache
+    std::error_code ec;
+    const auto full = std::filesystem::absolute(name, ec).lexically_normal();
+    char hash[2 * sizeof(size_t)]{};
+    const auto res = std::to_chars(std::begin(hash), std::end(hash), std::hash<std::string>{}(full.string()), 16);
+    return PathVar::cache / (name.stem().string() + "_" + std::string(hash, res.ptr) + ".slc");
+  }
+
+  inline bool isValidCache(const MappedFile &c, const CacheHeader &sig)
+  {
+    CacheHeader h;
+    if (c.size() < sizeof(h)) return false;
+    std::memcpy(&h, c.data(), sizeof(h));
+    return std::memcmp(h.magic, sig.magic, sizeof(h.magic)) == 0 && h.size == sig.size && h.mtime == sig.mtime
+           && c.size() == sizeof(h) + (h.nrows + 1) * sizeof(uint64_t) + h.nvalues * sizeof(double);
+  }
+
+  inline bool writeCache(const std::filesystem::path &name, const std::filesystem::path &cname, CacheHeader h)
+  {
+    /*
+     * Parse the csv file name and write its values to the cache file cname.
+     * The file is written under a temporary name and renamed, so jobs which run at the same time never map half a file.
+     *
+     * OUT
+     * false if the cache could not be written
+     *
+     * THROWS
+     * 2 		could not open the csv file
+     */
+    std::vector<uint64_t> rowStart;
+    std::vector<double> values;
+    {
+      const MappedFile file(name);
+      file.adviseSequential();
+      forEachValue(file.view(), [&](size_t i, size_t, double v) {
+        if (rowStart.size() == i) rowStart.push_back(values.size());
+        values.push_back(v);
+      });
+    }
+    rowStart.push_back(values.size());
+    h.nrows = rowStart.size() - 1;
+    h.nvalues = values.size();
+
+    std::error_code ec;
+    std::filesystem::create_directories(PathVar::cache, ec);
+
+    auto tmp = cname;
+    tmp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()) ^ static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+      out.write(reinterpret_cast<const char *>(rowStart.data()), static_cast<std::streamsize>(rowStart.size() * sizeof(uint64_t)));
+      out.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(double)));
+      if (out.good()) {
+        out.close();
+        std::filesystem::rename(tmp, cname, ec);
+        if (!ec) return true;
+      }
+    }
+
+    if constexpr (settings::printBool::printNonCrit)
+      std::cerr << "WARNING in csv::writeCache, could not write the cache " << cname << " of " << name << ", the file is parsed instead.\n";
+    std::filesystem::remove(tmp, ec);
+    return false;
   }
 
-  std::ostringstream fileContents;
-  fileContents << in.rdbuf();
-  in.close();
-  return (fileContents.str());
+  class Source
+  {
+    //!< The numbers of a csv file, parsed from the file itself or read from its binary cache if PathVar::cache is set.
+    MappedFile file;
+    bool cached{ false };
+
+    bool openCache(const std::filesystem::path &name)
+    {
+      //!< map the cache of name, after (re)writing it if needed. Returns false if there is no usable cache.
+      std::error_code ec1, ec2;
+      CacheHeader sig;
+      sig.size = std::filesystem::file_size(name, ec1);
+      const auto mtime = std::filesystem::last_write_time(name, ec2);
+      if (ec1 || ec2) return false; //!< the csv file itself will report the error
+
+      sig.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+      const auto cname = cachePath(name);
+      for (int attempt = 0; attempt < 2; attempt++) {
+        if (std::filesystem::exists(cname, ec1)) {
+          try {
+            MappedFile c(cname);
+            if (isValidCache(c, sig)) {
+              file = std::move(c);
+              return true;
+            }
+          } catch (int) {
+          }
+        }
+        if (attempt == 0 && !writeCache(name, cname, sig)) return false;
+      }
+      return false;
+    }
+
+  public:
+    explicit Source(const std::filesystem::path &name)
+    {
+      /*
+       * THROWS
+       * 2 		could not open the file
+       */
+      if (!PathVar::cache.empty()) cached = openCache(name);
+      if (!cached) file = MappedFile(name);
+      file.adviseSequential();
+    }
+
+    size_t rowsHint() const
+    {
+      //!< upper bound of the number of rows, to reserve memory
+      if (!cached) return countLines(file.view());
+
+      CacheHeader h;
+      std::memcpy(&h, file.data(), sizeof(h));
+      return h.nrows;
+    }
+
+    template <typename T = double, typename Fun>
+    size_t forEach(Fun &&fn, size_t nrow_max = 0) const
+    {
+      //!< like forEachValue, call fn(row, column, value) for each number in the file
+      if (!cached) return forEachValue<T>(file.view(), fn, nrow_max);
+
+      CacheHeader h;
+      std::memcpy(&h, file.data(), sizeof(h));
+      const char *rowStart = file.data() + sizeof(h);
+      const char *values = rowStart + (h.nrows + 1) * sizeof(uint64_t);
+
+      const auto N = (nrow_max == 0) ? h.nrows : std::min<uint64_t>(nrow_max, h.nrows);
+      uint64_t begin{ 0 }, end{ 0 };
+      std::memcpy(&begin, rowStart, sizeof(begin));
+      for (size_t i = 0; i < N; i++) {
+        std::memcpy(&end, rowStart + (i + 1) * sizeof(end), sizeof(end));
+        for (auto k = begin; k < end; k++) {
+          double v;
+          std::memcpy(&v, values + k * sizeof(v), sizeof(v));
+          fn(i, static_cast<size_t>(k - begin), static_cast<T>(v));
+        }
+        begin = end;
+      }
+      return static_cast<size_t>(N);
+    }
+  };
+} // namespace csv
+
+inline std::shared_ptr<const MappedFile> getFile(const std::filesystem::path &name)
+{
+  /*
+   * Contents of a file, mapped once and shared by everyone who reads it (e.g. all cells which read the same parameter file).
+   * The file is mapped again if its size or modification time changed since it was mapped.
+   * A mapping which is still in use shows the file as it is on disk, so it is not valid after the file was overwritten.
+   *
+   * THROWS
+   * 2 		could not open the file
+   */
+  struct Entry
+  {
+    std::shared_ptr<const MappedFile> file;
+    std::uintmax_t size{ 0 };
+    std::filesystem::file_time_type mtime{};
+  };
+  static std::mutex mtx;
+  static std::map<std::string, Entry> fileMap;
+
+  std::error_code ec1, ec2;
+  const auto size = std::filesystem::file_size(name, ec1);
+  const auto mtime = std::filesystem::last_write_time(name, ec2);
+
+  std::lock_guard lock(mtx);
+  auto &entry = fileMap[name.string()];
+  if (!entry.file || ec1 || ec2 || entry.size != size || entry.mtime != mtime) {
+    entry.file = std::make_shared<const MappedFile>(name);
+    entry.size = size;
+    entry.mtime = mtime;
+  }
+  return entry.file;
 }
 
-inline auto getFile(std::string name)
+template <typename Tpath>
+std::string getFileContents(const Tpath &name)
 {
-  std::cerr << "NOT IMPLEMENTED YET!\n";
-  throw 1234;
-  static std::map<std::string, std::string> fileMap;
+  /*
+   * Copy of the contents of a file.
+   *
+   * THROWS
+   * 2 		could not open the file
+   */
+  return std::string(getFile(name)->view());
 }
 
 template <typename Tpath, typename T, size_t ROW, size_t COL>
@@ -65,49 +329,39 @@ void loadCSV_mat(const Tpath &name, Matrix<T, ROW, COL> &x)
   //!< 	 *
   //!< 	 * THROWS
   //!< 	 * 2 		could not open the file
+  //!< 	 * 3 		the file has less than ROW rows of COL numbers
   //!< 	 */
-  std::ifstream in(name, std::ios_base::in);
+  const csv::Source file(name);
 
-  if (!in.good()) //!< check if we could open the file
-  {
-    std::cerr << "Error in ReadCSVfiles::loadCSV_mat. File " << name << " could not be opened\n";
-    throw 2;
-  }
-
-  char c = '.';
-
-  while (in.peek() <= 32) //!< Ignore byte order mark (BOM) at the beginning
-    in >> c;
-
-  for (size_t i = 0; i < ROW; i++) {
-    //!< read all but the last column
-    for (size_t j = 0; j < COL - 1; j++) {
-      in >> x[i][j] >> c; //!< Read number and comma
+  size_t n{ 0 };
+  file.forEach<T>([&](size_t i, size_t j, T v) {
+    if (j < COL) {
+      x[i][j] = v;
+      n++;
     }
-    in >> x[i][COL - 1]; //!< Read only number since there is no comma.
+  },
+                       ROW);
+
+  if (n != ROW * COL) {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "Error in ReadCSVfiles::loadCSV_mat. File " << name << " has " << n
+                << " numbers instead of " << ROW << " rows of " << COL << ".\n";
+    throw 3;
   }
-
-  in.close();
 }
 
 template <typename Tpath, typename T, size_t ROW>
 void loadCSV_1col(const Tpath &name, std::array<T, ROW> &x)
 {
   //!< read data from a CSV file with one column
-  slide::Matrix<T, ROW, 1> temp;
-  loadCSV_mat(name, temp);
-  std::memcpy(&x, &temp, sizeof temp);
-}
-
-inline void ignoreBOM(std::ifstream &in)
-{
-  char c = '.';
+  const csv::Source file(name);
+  const auto n = file.forEach<T>([&x](size_t i, size_t j, T v) { if (j == 0) x[i] = v; }, ROW);
 
-  do {
-    in >> c;
-  } while (c < 45); //!< Ignore byte order mark (BOM) at the beginning
-
-  in.putback(c);
+  if (n != ROW) {
+    if constexpr (settings::printBool::printCrit)
+      std::cerr << "Error in ReadCSVfiles::loadCSV_1col. File " << name << " has " << n << " rows instead of " << ROW << ".\n";
+    throw 3;
+  }
 }
 
 template <typename Tpath, typename Tx, typename Ty>
@@ -128,83 +382,95 @@ void loadCSV_2col(const Tpath &name, Tx &x, Ty &y, int n = 0)
    * 2 		could not open the specified file
    */
 
-  std::ifstream in(name, std::ios_base::in);
-
-  if (!in.good()) //!< check if we could open the file
-  {
-    std::cerr << "Error in ReadCSVfiles::loadCSV_2col. File " << name
-              << " could not be opened.\n";
-    throw 2;
-  }
-
-  ignoreBOM(in);
+  const csv::Source file(name);
+  const auto nmax = static_cast<size_t>(std::max(n, 0));
 
-  int j = 0;
-  char c;
   if constexpr (std::is_same<std::vector<double>, Tx>::value) {
     x.clear(); //!< Sometimes pre-allocated vectors are passed; therefore, cleared to be able to use push_back.
     y.clear();
-
-    double x_i, y_i;
-    while ((n == 0 || j < n) && (in >> x_i >> c >> y_i)) //!< Read file.
-    {
-      x.push_back(x_i);
-      y.push_back(y_i);
-      j++;
-    }
-  } else {                                                 //!< It must be a std::array, then just read without clear.
-    while ((n == 0 || j < n) && (in >> x[j] >> c >> y[j])) //!< Read file.
-      j++;
+    const auto nrow = (nmax != 0) ? nmax : file.rowsHint();
+    x.reserve(nrow);
+    y.reserve(nrow);
+
+    double x_i{ 0 };
+    file.forEach([&](size_t, size_t j, double v) {
+      if (j == 0)
+        x_i = v;
+      else if (j == 1) {
+        x.push_back(x_i);
+        y.push_back(v);
+      }
+    },
+                      nmax);
+  } else { //!< It must be a std::array, then just read without clear.
+    size_t N = std::min<size_t>(std::size(x), std::size(y));
+    if (nmax != 0) N = std::min(N, nmax);
+
+    file.forEach([&](size_t i, size_t j, double v) {
+      if (j == 0)
+        x[i] = v;
+      else if (j == 1)
+        y[i] = v;
+    },
+                      N);
   }
 }
 
+template <typename Tpath>
+size_t loadCSV_cols(const Tpath &name, std::span<const std::span<double>> cols, int n = 0)
+{
+  /*
+   * Reads the first columns of a CSV file into spans provided by the caller, e.g. parts of a larger array.
+   *
+   * IN
+   * name 	the name of the file
+   * n 		the number of rows to read (if n==0, read until the shortest span is full)
+   *
+   * OUT
+   * cols 	column j of the file is put in cols[j]
+   * returns the number of rows which were read
+   *
+   * THROWS
+   * 2 		could not open the specified file
+   */
+  size_t N = cols.empty() ? 0 : cols[0].size();
+  for (const auto &c : cols)
+    N = std::min(N, c.size());
+  if (n > 0) N = std::min(N, static_cast<size_t>(n));
+  if (N == 0) return 0;
+
+  const csv::Source file(name);
+  return file.forEach([&cols](size_t i, size_t j, double v) { if (j < cols.size()) cols[j][i] = v; }, N);
+}
+
 template <typename Tpath, typename Tx>
 void loadCSV_Ncol(const Tpath &name, DynamicMatrix<Tx> &x, int n = 0)
 {
   /*
-   * Reads data from a CSV file with 2 columns
+   * Reads data from a CSV file with any number of columns
    *
    * IN
    * name 	the name of the file
    * n 		the number of rows to read (if n==0, read all), it is used to read a portion of a *.csv file.
    *
    * OUT
-   * x 		array in which the data from the first column will be put
-   * y 		array in which the data from the second column will be put
+   * x 		matrix in which the data will be put, x(i, j) is column i of row j
    *
    * THROWS
    * 2 		could not open the specified file
    */
 
-  std::ifstream in(name, std::ios_base::in);
-
-  if (!in.good()) //!< check if we could open the file
-  {
-    std::cerr << "Error in ReadCSVfiles::loadCSV_2col. File " << name
-              << " could not be opened.\n";
-    throw 2;
-  }
-
-  ignoreBOM(in);
+  const csv::Source file(name);
 
   x.data.clear(); //!< Sometimes pre-allocated vectors are passed; therefore, cleared to be able to use push_back.
 
-  std::string line;
-
-  int n_rows{ 0 };
-  while ((n == 0 || n_rows < n) && std::getline(in, line)) //!< Read file.
-  {
-    n_rows++;
-    std::istringstream in_line(line);
-    double x_i;
-    char c;
-    while (in_line >> x_i) {
-      x.data.push_back(x_i);
-      in_line >> c;
-    }
+  const auto n_rows = file.forEach<Tx>([&x](size_t, size_t, Tx v) { x.data.push_back(v); }, static_cast<size_t>(std::max(n, 0)));
+  if (n_rows == 0) {
+    x.reshape(0, 0);
+    return;
   }
 
-  int n_cols = x.data.size() / n_rows;
+  const auto n_cols = x.data.size() / n_rows;
 
   x.reshape(n_cols, n_rows);
 
@@ -235,26 +501,25 @@ void loadCSV_2col(const Tpath &name, std::span<double> &x, std::span<double> &y,
    * 2 		could not open the specified file
    */
 
+  static std::mutex mtx; //!< cells may be constructed in parallel
   static std::map<std::string, XYplain> XYdataMap;
 
   auto name_str = name.string();
 
+  std::lock_guard lock(mtx);
   auto fm = XYdataMap.find(name_str);
 
   if (fm == XYdataMap.end()) {
     XYplain xyp{};
-    loadCSV_2col(name, xyp.x_vec, xyp.y_vec); //!< #TODO -> for some reason it does not take XYdataMap[name] directly.
+    loadCSV_2col(name, xyp.x_vec, xyp.y_vec);
 
-    XYdataMap[name_str] = std::move(xyp);
+    fm = XYdataMap.emplace(name_str, std::move(xyp)).first;
   }
 
-  if (n == 0) {
-    x = std::span<double>(XYdataMap[name_str].x_vec);
-    y = std::span<double>(XYdataMap[name_str].y_vec);
-  } else {
-    x = std::span<double>(&XYdataMap[name_str].x_vec[0], &XYdataMap[name_str].x_vec[0] + n); // #TODO temporary solution using pointers instead of iterators.
-    y = std::span<double>(&XYdataMap[name_str].y_vec[0], &XYdataMap[name_str].y_vec[0] + n);
-  }
+  auto &xy = fm->second; //!< elements of a std::map are not moved by later insertions, so the spans stay valid.
+  const auto N = (n == 0) ? xy.x_vec.size() : std::min(xy.x_vec.size(), static_cast<size_t>(n));
+  x = std::span<double>(xy.x_vec.data(), N);
+  y = std::span<double>(xy.y_vec.data(), N);
 }
 
 } // namespace slide
\ No newline at end of file
@@ -11,9 +11,21 @@
 #pragma once
 
 #include "../settings/settings.hpp"
+#include "timing.hpp"
 
 #include <thread>
 #include <vector>
+#include <string>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <exception>
 
 namespace slide {
 
@@ -56,4 +68,96 @@ void run(Tfun task_indv, int i_end, unsigned int numMaxParallelWorkers = setting
     task_par(0, i_end, 1);
   }
 }
+
+struct Job
+{
+  std::string name;                                       //!< unique name, also the name of the subfolder of the results with the output of the job
+  double cost{ 1 };                                       //!< expected run time in arbitrary units, only used to order the jobs
+  std::function<void(const std::filesystem::path &)> fun; //!< runs the job, gets the folder where it should write its output
+};
+
+inline void runJobs(std::vector<Job> jobs, const std::filesystem::path &folder = PathVar::results,
+                    unsigned int numMaxParallelWorkers = settings::numMaxParallelWorkers)
+{
+  /*
+   * Run independent jobs (e.g. degradation experiments) in parallel.
+   *
+   * The jobs are taken from a shared queue, ordered from the longest expected run time to the shortest,
+   * so the long jobs start first and the short ones fill the gaps at the end.
+   * The total run time is then close to the run time of the longest job if there are enough threads.
+   *
+   * Each job writes in its own subfolder folder/name. When a job finishes without throwing,
+   * an empty file 'job_done' is written in this subfolder, and the job is skipped if runJobs is called again.
+   * So a campaign which was interrupted can be restarted and only does the jobs which did not finish.
+   *
+   * After every job, the progress and estimated remaining time are printed.
+   *
+   * IN
+   * jobs 					jobs to run, the names must be unique and valid folder names
+   * folder 				folder in which the subfolder of each job is made
+   * numMaxParallelWorkers 	maximum number of threads, < 1 to use all cores, 1 to run in this thread
+   */
+  constexpr auto doneName = "job_done";
+
+  std::erase_if(jobs, [&](const Job &job) {
+    const bool done = std::filesystem::exists(folder / job.name / doneName);
+    if (done && settings::printBool::printNonCrit)
+      std::cout << "Job " << job.name << " was done before, skipping it.\n";
+    return done;
+  });
+
+  std::stable_sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) { return a.cost > b.cost; });
+
+  const double costTot = std::accumulate(jobs.begin(), jobs.end(), 0.0, [](double sum, const Job &job) { return sum + job.cost; });
+  double costDone{ 0 };
+  size_t nDone{ 0 };
+  std::atomic<size_t> next{ 0 }; //!< index of the next job to start
+  std::mutex mtx;                //!< protects the progress and std::cout
+  Clock clk{};
+
+  auto worker = [&]() {
+    for (size_t i = next++; i < jobs.size(); i = next++) {
+      auto &job = jobs[i];
+      const auto dir = folder / job.name;
+      bool success{ false };
+      try {
+        std::filesystem::create_directories(dir);
+        job.fun(dir);
+        std::ofstream{ dir / doneName };
+        success = true;
+      } catch (int err) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::cerr << "Job " << job.name << " stopped with error " << err << ", it will be done again on the next run.\n";
+      } catch (std::exception &e) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::cerr << "Job " << job.name << " stopped with error '" << e.what() << "', it will be done again on the next run.\n";
+      }
+
+      std::lock_guard<std::mutex> lock(mtx);
+      nDone++;
+      costDone += job.cost;
+      const double eta = (costDone > 0) ? clk.duration() * (costTot - costDone) / costDone : 0;
+      std::cout << "Job " << nDone << "/" << jobs.size() << ' ' << job.name << (success ? " finished" : " failed")
+                << " after " << clk << ", expected remaining time " << std::floor(eta / 60) << ":"
+                << std::round(eta - std::floor(eta / 60) * 60) << " min:sec.\n";
+    }
+  };
+
+  if (numMaxParallelWorkers < 1)
+    numMaxParallelWorkers = std::thread::hardware_concurrency();
+
+  const auto Nth = std::min<size_t>({ numMaxParallelWorkers, std::thread::hardware_concurrency(), jobs.size() });
+
+  if (!settings::isParallel || Nth <= 1)
+    worker();
+  else {
+    std::vector<std::thread> threads;
+    threads.reserve(Nth);
+    for (size_t i = 0; i < Nth; i++)
+      threads.emplace_back(worker);
+
+    for (auto &th : threads)
+      th.join();
+  }
+}
 } // namespace slide
\ No newline at end of file
@@ -36,11 +36,11 @@ inline void checkInputParam_CalAge(Cell &c, double V, double Ti, int Time, int t
   if (vmin)
     std::cerr << "Error in Cycler::CalendarAgeing. The voltage " << V << " is too low. The minimum value is " << c.Vmin() << ".\n";
 
-  bool Temin = Ti < settings::Tmin_K; //!< check the temperature is above 0 degrees, TMIN is defined in State.hpp
+  bool Temin = Ti < settings::Tmin_Cell_K; //!< check the temperature is above 0 degrees
   if (Temin)
     std::cerr << "Error in Cycler::CalendarAgeing. The temperature " << Ti << "K is too low. The minimum value is 273.\n";
 
-  bool Temax = Ti > settings::Tmax_K; //!< check the temperature is below 60 degrees, TMAX is defined in State.hpp
+  bool Temax = Ti > settings::Tmax_Cell_K; //!< check the temperature is below 60 degrees
   if (Temax)
     std::cerr << "Error in Cycler::CalendarAgeing. The temperature " << Ti << " is too high. The maximum value is (273+60).\n";
 
@@ -105,11 +105,11 @@ inline void checkInputParam_CycAge(Cell &c, double Vma, double Vmi, double Ccha,
   if (vmin)
     std::cerr << "Error in Cycler::cycleAgeing. The minimum voltage " << Vmi << " is too low. The minimum value is " << c.Vmin() << ".\n";
 
-  bool Temin = Ti < settings::Tmin_Cell_K; //!< check the temperature is above 0 degrees, TMIN is defined in State.hpp ->settings::Tmin_K
+  bool Temin = Ti < settings::Tmin_Cell_K; //!< check the temperature is above 0 degrees
   if (Temin)
     std::cerr << "Error in Cycler::cycleAgeing. The temperature " << Ti << "K is too low. The minimum value is 273.\n";
 
-  bool Temax = Ti > settings::Tmax_Cell_K; //!< check the temperature is below 60 degrees, TMAX is defined in State.hpp ->settings::Tmax_K
+  bool Temax = Ti > settings::Tmax_Cell_K; //!< check the temperature is below 60 degrees
   if (Temax)
     std::cerr << "Error in Cycler::cycleAgeing. The temperature " << Ti << " is too high. The maximum value is (273+60).\n";
 
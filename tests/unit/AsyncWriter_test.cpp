@@ -0,0 +1,85 @@
+/*
+ * AsyncWriter_test.cpp
+ *
+ *  Checks the order, back-pressure and errors of the background data writer
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace slide::tests::unit {
+
+bool test_AsyncWriter_order()
+{
+  //!< jobs are done in the order they were submitted, and flush waits for all of them
+  std::vector<int> done;
+  for (int i = 0; i < 100; i++)
+    AsyncWriter::submit([&done, i] { done.push_back(i); }, 8);
+  AsyncWriter::flush();
+
+  assert(EQ(done.size(), 100));
+  for (int i = 0; i < 100; i++)
+    assert(EQ(done[i], i));
+
+  //!< take leaves an empty buffer with the same capacity
+  std::vector<double> buffer(1000, 1.0);
+  const auto full = AsyncWriter::take(buffer);
+  assert(EQ(full.size(), 1000));
+  assert(buffer.empty());
+  assert(buffer.capacity() >= 1000);
+  return true;
+}
+
+bool test_AsyncWriter_backpressure()
+{
+  //!< a job which does not fit in the queue waits until the queue is empty
+  if constexpr (!settings::DATASTORE_ASYNC)
+    return true;
+
+  std::atomic<bool> first{ false };
+  AsyncWriter::submit([&first] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    first = true;
+  },
+                      settings::DATASTORE_ASYNC_BYTES);
+  AsyncWriter::submit([] {}, 1);
+  assert(first);
+  AsyncWriter::flush();
+  return true;
+}
+
+bool test_AsyncWriter_error()
+{
+  //!< an error in a job is thrown by the next flush, once
+  if constexpr (!settings::DATASTORE_ASYNC)
+    return true;
+
+  AsyncWriter::submit([] { throw 11; }, 8);
+  try {
+    AsyncWriter::flush();
+    return false;
+  } catch (int e) {
+    assert(EQ(e, 11));
+  }
+  AsyncWriter::flush();
+  return true;
+}
+
+int test_all_AsyncWriter()
+{
+  //!< calls all test-functions
+  if (!TEST(test_AsyncWriter_order, "test_AsyncWriter_order")) return 1;
+  if (!TEST(test_AsyncWriter_backpressure, "test_AsyncWriter_backpressure")) return 2;
+  if (!TEST(test_AsyncWriter_error, "test_AsyncWriter_error")) return 3;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_AsyncWriter(); }
@@ -0,0 +1,98 @@
+/*
+ * Cell_SPM_fast_test.cpp
+ *
+ *  Compares the reduced-order Cell_SPM_fast against the full Cell_SPM
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <cmath>
+#include <span>
+#include <vector>
+
+namespace slide::tests::unit {
+
+bool test_constructor_SPM_fast()
+{
+  Cell_SPM c0;
+  Cell_SPM_fast c1;
+
+  assert(NEAR(c1.Cap(), c0.Cap()));
+  assert(NEAR(c1.SOC(), c0.SOC()));
+  assert(NEAR(c1.T(), c0.T()));
+
+  //!< the initial concentration is uniform so only the uniform mode is non-zero and the OCV is the same
+  assert(NEAR(c1.V(), c0.V(), 1e-9));
+
+  return true;
+}
+
+bool test_CC_SPM_fast()
+{
+  //!< 1C discharge for 30 minutes without thermal and degradation models
+  Cell_SPM c0;
+  Cell_SPM_fast c1;
+  c0.setBlockDegAndTherm(true);
+  c1.setBlockDegAndTherm(true);
+
+  const double I = c0.Cap();
+  c0.setCurrent(I);
+  c1.setCurrent(I);
+
+  //!< right after a current step the residualised modes are already at their quasi-steady value, so the reduced model has the larger drop
+  assert(c1.V() < c0.V());
+
+  for (int i = 0; i < 180; i++) {
+    c0.timeStep_CC(2, 5); //!< the full model with Euler steps of 2 seconds
+    c1.timeStep_CC(10);   //!< the reduced model in one exact step
+  }
+
+  assert(NEAR(c1.SOC(), c0.SOC(), 1e-9));
+  assert(NEAR(c1.V(), c0.V(), 5e-3));
+
+  double cp0[settings::nch + 2], cn0[settings::nch + 2], cp1[settings::nch + 2], cn1[settings::nch + 2];
+  c0.getC(cp0, cn0);
+  c1.getC(cp1, cn1);
+  for (size_t i = 0; i < settings::nch + 2; i++) {
+    assert(NEAR(cp1[i], cp0[i], 1e-2 * cp0[i]));
+    assert(NEAR(cn1[i], cn0[i], 1e-2 * cn0[i]));
+  }
+
+  return true;
+}
+
+bool test_setStates_SPM_fast()
+{
+  Cell_SPM_fast c1;
+  c1.setCurrent(1);
+  c1.timeStep_CC(5, 10);
+
+  std::vector<double> s;
+  c1.getStates(s);
+  const double V1 = c1.V();
+
+  c1.timeStep_CC(5, 10);
+  assert(c1.V() < V1);
+
+  std::span<double> spn(s);
+  c1.setStates(spn, false, false);
+  assert(NEAR(c1.V(), V1, 1e-12));
+
+  return true;
+}
+
+int test_all_Cell_SPM_fast()
+{
+  //!< calls all test-functions
+  if (!TEST(test_constructor_SPM_fast, "test_constructor_SPM_fast")) return 1;
+  if (!TEST(test_CC_SPM_fast, "test_CC_SPM_fast")) return 2;
+  if (!TEST(test_setStates_SPM_fast, "test_setStates_SPM_fast")) return 3;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_Cell_SPM_fast(); }
@@ -0,0 +1,106 @@
+/*
+ * Cell_SPM_mixed_test.cpp
+ *
+ *  Checks the switching of the mixed-fidelity Cell_SPM_mixed and compares it against the full Cell_SPM
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <cmath>
+#include <span>
+#include <vector>
+
+namespace slide::tests::unit {
+
+bool test_switching_SPM_mixed()
+{
+  Cell_SPM_mixed c1;
+  c1.setBlockDegAndTherm(true);
+  assert(!c1.isReduced()); //!< starts with the full model
+
+  //!< half C discharge at 50% SOC is benign, so the cell switches to the surrogate
+  c1.setCurrent(0.5 * c1.Cap());
+  c1.timeStep_CC(2, 5);
+  assert(c1.isReduced());
+
+  //!< lowering the voltage margin to the limit promotes the cell again
+  auto fid = c1.getFidelityParam();
+  fid.dV_margin = c1.V() - c1.Vmin() + 0.1;
+  c1.setFidelityParam(fid);
+  c1.timeStep_CC(2);
+  assert(!c1.isReduced());
+
+  return true;
+}
+
+bool test_CC_SPM_mixed()
+{
+  //!< 1C discharge until the voltage limit, compared to the full model
+  Cell_SPM c0;
+  Cell_SPM_mixed c1;
+  c0.setBlockDegAndTherm(true);
+  c1.setBlockDegAndTherm(true);
+
+  const double I = c0.Cap();
+  c0.setCurrent(I);
+  c1.setCurrent(I);
+
+  double errmax{ 0 };
+  while (c0.V() > c0.Vmin() + 0.05) {
+    c0.timeStep_CC(2, 5);
+    c1.timeStep_CC(2, 5);
+    errmax = std::max(errmax, std::abs(c1.V() - c0.V()));
+  }
+
+  assert(NEAR(c1.SOC(), c0.SOC(), 1e-9));
+  assert(errmax < 0.02); //!< the linearisation error is bounded by the recalibration thresholds
+  assert(!c1.isReduced());               //!< close to Vmin, the full model is used
+  assert(c1.getReducedFraction() > 0.5); //!< but most of the discharge is done with the surrogate
+
+  return true;
+}
+
+bool test_currentStep_SPM_mixed()
+{
+  //!< a current step recalibrates the surrogate, so the voltage stays close to the full model
+  Cell_SPM c0;
+  Cell_SPM_mixed c1;
+  c0.setBlockDegAndTherm(true);
+  c1.setBlockDegAndTherm(true);
+
+  c0.setCurrent(0.5 * c0.Cap());
+  c1.setCurrent(0.5 * c1.Cap());
+  for (int i = 0; i < 30; i++) {
+    c0.timeStep_CC(2, 5);
+    c1.timeStep_CC(2, 5);
+  }
+  assert(c1.isReduced());
+
+  c0.setCurrent(-1.0 * c0.Cap());
+  c1.setCurrent(-1.0 * c1.Cap());
+  assert(NEAR(c1.V(), c0.V(), 0.01));
+
+  for (int i = 0; i < 30; i++) {
+    c0.timeStep_CC(2, 5);
+    c1.timeStep_CC(2, 5);
+  }
+  assert(NEAR(c1.V(), c0.V(), 0.01));
+
+  return true;
+}
+
+int test_all_Cell_SPM_mixed()
+{
+  //!< calls all test-functions
+  if (!TEST(test_switching_SPM_mixed, "test_switching_SPM_mixed")) return 1;
+  if (!TEST(test_CC_SPM_mixed, "test_CC_SPM_mixed")) return 2;
+  if (!TEST(test_currentStep_SPM_mixed, "test_currentStep_SPM_mixed")) return 3;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_Cell_SPM_mixed(); }
@@ -246,6 +246,65 @@ bool test_timeStep_CC_SPM()
   return true;
 }
 
+bool test_kinetics_invalidation_SPM()
+{
+  //!< the cached kinetics must follow changes in current, temperature and states
+  Cell_SPM c1;
+  const double tol = 1e-12;
+
+  //!< at zero current there is no overpotential or resistive drop so V == OCV
+  assert(NEAR(c1.V(), c1.getOCV(), tol));
+
+  c1.setCurrent(1);
+  const double V1 = c1.V();
+  assert(V1 < c1.getOCV());
+
+  std::vector<double> s;
+  c1.getStates(s);
+
+  //!< changing the temperature changes the kinetics
+  c1.setT(45_degC);
+  const double V2 = c1.V();
+  assert(!NEAR(V1, V2, 1e-6));
+
+  //!< restoring the states restores the voltage
+  std::span<double> spn(s);
+  c1.setStates(spn, false, false);
+  assert(NEAR(c1.V(), V1, tol));
+
+  //!< a time step changes the concentrations, so the voltage must be recalculated
+  c1.timeStep_CC(5);
+  assert(c1.V() < V1);
+
+  return true;
+}
+
+bool test_variations_SPM()
+{
+  //!< the cell-to-cell variations of the constructor scale the capacity, resistance and degradation rates
+  DEG_ID deg;
+  deg.SEI_id.add_model(4); //!< kinetic and diffusion limited SEI growth
+  Cell_SPM c0("c0", deg, 1, 1, 1, 1), c1("c1", deg, 1.1, 1.2, 1.3, 1.4), c2("c2", deg, 1, 1, 2, 1);
+
+  const auto [var_cap, var_R, var_degSEI, var_degLAM] = c1.getVariations();
+  assert(NEAR(var_cap, 1.1));
+  assert(NEAR(var_R, 1.2));
+  assert(NEAR(var_degSEI, 1.3));
+  assert(NEAR(var_degLAM, 1.4));
+  assert(NEAR(c1.Cap(), 1.1 * c0.Cap()));
+
+  c0.setT(25.0_degC); //!< at the reference temperature, so only the rate constants matter
+  c2.setT(25.0_degC);
+  for (int i = 0; i < 100; i++) {
+    c0.timeStep_CC(10, 10);
+    c2.timeStep_CC(10, 10);
+  }
+  const double LLI = c0.getStateObj().LLI();
+  assert(NEAR(c2.getStateObj().LLI(), 2 * LLI, 0.01 * LLI)); //!< twice the SEI growth
+
+  return true;
+}
+
 int test_all_Cell_SPM()
 {
   //!< calls all test-functions
@@ -254,6 +313,8 @@ int test_all_Cell_SPM()
   if (!TEST(test_getV_SPM, "test_getV_SPM")) return 3;
   if (!TEST(test_setStates_SPM, "test_setStates_SPM")) return 4;
   if (!TEST(test_timeStep_CC_SPM, "test_timeStep_CC_SPM")) return 5;
+  if (!TEST(test_kinetics_invalidation_SPM, "test_kinetics_invalidation_SPM")) return 6;
+  if (!TEST(test_variations_SPM, "test_variations_SPM")) return 7;
 
   return 0;
 }
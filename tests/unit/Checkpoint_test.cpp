@@ -0,0 +1,288 @@
+/*
+ * Checkpoint_test.cpp
+ *
+ *  Checks that restarting from a checkpoint continues exactly as an uninterrupted simulation
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+
+namespace slide::tests::unit {
+
+auto SEIdegradation()
+{
+  DEG_ID deg;
+  deg.SEI_id.add_model(4);
+  deg.SEI_porosity = 1;
+  return deg;
+}
+
+auto stressDegradation()
+{
+  //!< LAM and surface cracks depend on the stress of the previous time step (Dai and Laresgoiti stress models)
+  auto deg = SEIdegradation();
+  deg.LAM_id.add_model(1);
+  deg.CS_id.add_model(1);
+  return deg;
+}
+
+auto makeCheckpointModule(const DEG_ID &deg = SEIdegradation())
+{
+  //!< series module of SPM cells with degradation and a spread in capacity and resistance
+  constexpr size_t N = 3;
+  std::vector<Deep_ptr<StorageUnit>> cs;
+  for (size_t i = 0; i < N; i++)
+    cs.push_back(make<Cell_SPM>("cell" + std::to_string(i), deg, 1 + 0.01 * i, 1 - 0.01 * i, 1, 1));
+
+  auto mp = make<Module_s>("ckp", settings::T_ENV, true, false, N, 1, 1);
+  mp->setSUs(cs, false, false);
+  std::vector<double> Rc(N, 1e-3);
+  mp->setRcontact(Rc);
+  return mp;
+}
+
+bool test_checkpoint_restart(const DEG_ID &deg)
+{
+  const auto name = std::filesystem::temp_directory_path() / "slide_checkpoint_restart.bin";
+  std::filesystem::remove(name);
+
+  auto m0 = makeCheckpointModule(deg);
+  m0->setCurrent(m0->Cap());
+  for (int i = 0; i < 50; i++)
+    m0->timeStep_CC(2, 5);
+
+  CheckpointProcedure proc0{ 7, {}, { { 1, 2, 3, 4 }, { 5, 6, 7, 8 } } };
+  proc0.th.Ah() = 1.5;
+
+  Checkpoint ckp{ name };
+  assert(!ckp.exists());
+  ckp.write(m0.get(), proc0);
+  ckp.wait();
+  assert(ckp.exists());
+
+  //!< restore in a new module
+  auto m1 = makeCheckpointModule(deg);
+  CheckpointProcedure proc1;
+  assert(ckp.read(m1.get(), proc1));
+  assert(proc1.cycle == 7);
+  assert(proc1.th.Ah() == 1.5);
+  assert(proc1.throughput.size() == 2);
+  assert(proc1.throughput[1].energy == 6);
+
+  std::vector<double> s0, s1;
+  m0->getStates(s0);
+  m1->getStates(s1);
+  assert(s0 == s1);
+
+  //!< both continue on exactly the same trajectory
+  for (int i = 0; i < 50; i++) {
+    m0->timeStep_CC(2, 5);
+    m1->timeStep_CC(2, 5);
+  }
+
+  s0.clear();
+  s1.clear();
+  m0->getStates(s0);
+  m1->getStates(s1);
+  assert(s0 == s1);
+  assert(m0->V() == m1->V());
+
+  std::filesystem::remove(name);
+  return true;
+}
+
+bool test_checkpoint_invalid()
+{
+  const auto name = std::filesystem::temp_directory_path() / "slide_checkpoint_invalid.bin";
+  std::filesystem::remove(name);
+
+  auto m0 = makeCheckpointModule();
+  Checkpoint ckp{ name };
+  CheckpointProcedure proc;
+  assert(!ckp.read(m0.get(), proc)); //!< no checkpoint yet
+
+  ckp.write(m0.get(), proc);
+  ckp.wait();
+
+  //!< a storage unit with a different configuration
+  auto c = make<Cell_SPM>();
+  try {
+    ckp.read(c.get(), proc);
+    return false;
+  } catch (int e) {
+    assert(e == 5);
+  }
+
+  //!< a checkpoint of a different major version
+  {
+    std::fstream file(name, std::ios::in | std::ios::out | std::ios::binary);
+    const uint32_t major = Checkpoint::version_major + 1;
+    file.seekp(8);
+    file.write(reinterpret_cast<const char *>(&major), sizeof(major));
+  }
+
+  try {
+    ckp.read(m0.get(), proc);
+    return false;
+  } catch (int e) {
+    assert(e == 4);
+  }
+
+  std::filesystem::remove(name);
+  return true;
+}
+
+bool test_checkpoint_procedure()
+{
+  //!< cycle ageing restarted from a checkpoint ends in the same state as an uninterrupted run
+  const auto name = std::filesystem::temp_directory_path() / "slide_checkpoint_procedure.bin";
+  std::filesystem::remove(name);
+
+  constexpr int Ncycle = 4, Ncheck = 100, Nbal = 100;
+  auto c0 = make<Cell_SPM>("ckp_cell0", DEG_ID{}, 1, 1, 1, 1);
+  auto c1 = make<Cell_SPM>("ckp_cell1", DEG_ID{}, 1, 1, 1, 1);
+
+  auto p0 = Procedure(false, 3.5, 20, true);
+  p0.setCheckpoint(name, 2); //!< leaves the checkpoint of cycle 2
+  p0.cycleAge(c0.get(), Ncycle, Ncheck, Nbal, true, 1, 1, c0->Vmax() - 0.1, c0->Vmin() + 0.1);
+  assert(std::filesystem::exists(name));
+
+  auto p1 = Procedure(false, 3.5, 20, true);
+  p1.setCheckpoint(name, 2); //!< continues at cycle 2
+  p1.cycleAge(c1.get(), Ncycle, Ncheck, Nbal, true, 1, 1, c1->Vmax() - 0.1, c1->Vmin() + 0.1);
+
+  std::vector<double> s0, s1;
+  c0->getStates(s0);
+  c1->getStates(s1);
+  assert(s0 == s1);
+
+  std::filesystem::remove(name);
+  return true;
+}
+
+bool test_checkpoint_mixed()
+{
+  //!< the record of the mixed-fidelity cell follows the one of Cell_SPM, the surrogate continues with the same linearisation
+  const auto name = std::filesystem::temp_directory_path() / "slide_checkpoint_mixed.bin";
+  std::filesystem::remove(name);
+
+  auto c0 = make<Cell_SPM_mixed>("ckp_mixed", stressDegradation(), 1, 1, 1, 1);
+  c0->setCurrent(0.5 * c0->Cap());
+  for (int i = 0; i < 20; i++)
+    c0->timeStep_CC(2, 5);
+  assert(c0->isReduced());
+
+  Checkpoint ckp{ name };
+  CheckpointProcedure proc;
+  ckp.write(c0.get(), proc);
+  ckp.wait();
+
+  auto c1 = make<Cell_SPM_mixed>("ckp_mixed", stressDegradation(), 1, 1, 1, 1);
+  assert(ckp.read(c1.get(), proc));
+  assert(c1->isReduced());
+  assert(c1->getReducedFraction() == c0->getReducedFraction());
+
+  for (int i = 0; i < 20; i++) {
+    c0->timeStep_CC(2, 5);
+    c1->timeStep_CC(2, 5);
+  }
+
+  std::vector<double> s0, s1;
+  c0->getStates(s0);
+  c1->getStates(s1);
+  assert(s0 == s1);
+  assert(c0->V() == c1->V());
+
+  std::filesystem::remove(name);
+  return true;
+}
+
+bool test_snapshot()
+{
+  //!< a time step redone from a snapshot gives the same result, so the snapshot includes the stress history
+  auto m = makeCheckpointModule(stressDegradation());
+  m->setCurrent(m->Cap());
+  for (int i = 0; i < 10; i++)
+    m->timeStep_CC(2, 5);
+
+  Snapshot snap;
+  snap.save(m.get());
+
+  std::vector<double> s0, s1;
+  for (int i = 0; i < 10; i++)
+    m->timeStep_CC(2, 5);
+  m->getStates(s0);
+  const double V0 = m->V();
+
+  assert(snap.restore(m.get()));
+  for (int i = 0; i < 10; i++)
+    m->timeStep_CC(2, 5);
+  m->getStates(s1);
+  assert(s0 == s1);
+  assert(m->V() == V0);
+
+  return true;
+}
+
+bool test_checkpoint_usage()
+{
+  //!< the first usage sample has no weight, after a restart the next one is weighted by the time since the last sample
+  using enum settings::cellDataStorageLevel;
+  if constexpr (settings::data::lowCaptureStorage != storeHistogramData)
+    return true;
+
+  const auto name = std::filesystem::temp_directory_path() / "slide_checkpoint_usage.bin";
+  std::filesystem::remove(name);
+
+  auto c0 = make<Cell_SPM>("ckp_usage", SEIdegradation(), 1, 1, 1, 1);
+  c0->setCapture(storeHistogramData);
+  c0->setCurrent(0.5 * c0->Cap());
+  c0->timeStep_CC(2, 50);
+  c0->storeData();
+  assert(c0->getCellStats().data.I.stats.weight() == 0);
+  c0->timeStep_CC(2, 50);
+  c0->storeData();
+  assert(NEAR(c0->getCellStats().data.I.stats.weight(), 100, 1e-9));
+
+  Checkpoint ckp{ name };
+  CheckpointProcedure proc;
+  ckp.write(c0.get(), proc);
+  ckp.wait();
+
+  auto c1 = make<Cell_SPM>("ckp_usage", SEIdegradation(), 1, 1, 1, 1);
+  c1->setCapture(storeHistogramData);
+  assert(ckp.read(c1.get(), proc));
+  c1->timeStep_CC(2, 50);
+  c1->storeData();
+  assert(NEAR(c1->getCellStats().data.I.stats.weight(), 100, 1e-9)); //!< not the 300 s since the start
+
+  std::filesystem::remove(name);
+  return true;
+}
+
+int test_all_Checkpoint()
+{
+  //!< calls all test-functions
+  auto test_checkpoint_restart_SEI = []() { return test_checkpoint_restart(SEIdegradation()); };
+  auto test_checkpoint_restart_stress = []() { return test_checkpoint_restart(stressDegradation()); };
+
+  if (!TEST(test_checkpoint_restart_SEI, "test_checkpoint_restart_SEI")) return 1;
+  if (!TEST(test_checkpoint_invalid, "test_checkpoint_invalid")) return 2;
+  if (!TEST(test_checkpoint_procedure, "test_checkpoint_procedure")) return 3;
+  if (!TEST(test_checkpoint_restart_stress, "test_checkpoint_restart_stress")) return 4;
+  if (!TEST(test_checkpoint_mixed, "test_checkpoint_mixed")) return 5;
+  if (!TEST(test_snapshot, "test_snapshot")) return 6;
+  if (!TEST(test_checkpoint_usage, "test_checkpoint_usage")) return 7;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_Checkpoint(); }
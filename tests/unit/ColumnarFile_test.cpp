@@ -0,0 +1,188 @@
+/*
+ * ColumnarFile_test.cpp
+ *
+ *  Checks that the columnar binary files read back the data which was written, also after appending or a crash
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <vector>
+#include <string>
+
+namespace slide::tests::unit {
+
+const std::vector<Column> testColumns{ { "time" }, { "V", ColumnType::f32 } };
+
+std::vector<double> testRows(size_t n, double t0)
+{
+  std::vector<double> rows;
+  for (size_t i = 0; i < n; i++) {
+    rows.push_back(t0 + 2.0 * i);
+    rows.push_back(3.7 + 0.001 * std::sin(0.1 * i));
+  }
+  return rows;
+}
+
+bool checkSeries(const ColumnarReader &reader, std::string_view name, const std::vector<double> &rows)
+{
+  const int i = reader.find(name);
+  assert(i >= 0);
+  const auto cols = reader.read(i);
+  assert(EQ(cols.size(), 2));
+  assert(EQ(cols[0].size(), rows.size() / 2));
+  for (size_t r = 0; r < cols[0].size(); r++) {
+    assert(EQ(cols[0][r], rows[2 * r]));                                              //!< double is exact
+    assert(EQ(cols[1][r], static_cast<double>(static_cast<float>(rows[2 * r + 1])))); //!< float is exact as a float
+  }
+  return true;
+}
+
+bool test_ColumnarFile_roundtrip()
+{
+  const auto name = std::filesystem::temp_directory_path() / "slide_columnar_roundtrip.slb";
+  for (const bool compress : { false, true }) {
+    std::filesystem::remove(name);
+    const auto a0 = testRows(100, 0), a1 = testRows(50, 200), b0 = testRows(1, 0);
+    {
+      ColumnarWriter writer(name, compress);
+      writer.write("cell0_cellData", testColumns, a0);
+      writer.write("cell1_cellData", testColumns, b0);
+      writer.write("cell0_cellData", testColumns, a1);
+
+      try {
+        writer.write("cell0_cellData", std::vector<Column>{ { "time" } }, a0);
+        return false;
+      } catch (int e) {
+        assert(EQ(e, 4));
+      }
+    }
+
+    ColumnarReader reader(name);
+    assert(EQ(reader.getSeries().size(), 2));
+    assert(EQ(reader.getSeries()[0].chunks.size(), 2));
+
+    auto a = a0;
+    a.insert(a.end(), a1.begin(), a1.end());
+    assert(checkSeries(reader, "cell0_cellData", a));
+    assert(checkSeries(reader, "cell1_cellData", b0));
+    assert(EQ(reader.find("cell2_cellData"), -1));
+  }
+
+  //!< compression makes a smooth time series much smaller.
+  std::filesystem::remove(name);
+  ColumnarWriter(name, false).write("cell0_cellData", testColumns, testRows(1000, 0));
+  const auto rawSize = std::filesystem::file_size(name);
+  std::filesystem::remove(name);
+  ColumnarWriter(name, true).write("cell0_cellData", testColumns, testRows(1000, 0));
+  assert(std::filesystem::file_size(name) < rawSize / 2);
+
+  std::filesystem::remove(name);
+  return true;
+}
+
+bool test_ColumnarFile_append()
+{
+  //!< a file is appended to when it is opened again, also if it was not closed (e.g. after a crash)
+  const auto name = std::filesystem::temp_directory_path() / "slide_columnar_append.slb";
+  std::filesystem::remove(name);
+  const auto a0 = testRows(10, 0), a1 = testRows(10, 20), a2 = testRows(10, 40);
+
+  ColumnarWriter(name).write("cell0_cellData", testColumns, a0);
+  {
+    ColumnarWriter writer(name);
+    writer.write("cell0_cellData", testColumns, a1);
+
+    auto a = a0;
+    a.insert(a.end(), a1.begin(), a1.end());
+    ColumnarReader open(name); //!< no index yet
+    assert(checkSeries(open, "cell0_cellData", a));
+  }
+  std::ofstream(name, std::ios::binary | std::ios::app) << "garbage"; //!< incomplete block of a crashed run
+  {
+    ColumnarWriter writer(name);
+    writer.write("cell1_cellData", testColumns, a2);
+  }
+
+  ColumnarReader reader(name);
+  auto a = a0;
+  a.insert(a.end(), a1.begin(), a1.end());
+  assert(checkSeries(reader, "cell0_cellData", a));
+  assert(checkSeries(reader, "cell1_cellData", a2));
+
+  std::filesystem::remove(name);
+  return true;
+}
+
+bool test_ColumnarFile_toCSV()
+{
+  const auto folder = std::filesystem::temp_directory_path();
+  const auto name = folder / "slide_columnar_csv_data.slb";
+  std::filesystem::remove(name);
+  ColumnarWriter(name).write("cell0_cellData", testColumns, std::vector<double>{ 0, 3.7, 2, 3.65 });
+
+  ColumnarReader(name).toCSV(folder, "slide_columnar_csv");
+  const auto csv = folder / "slide_columnar_csv_cell0_cellData.csv";
+  std::ifstream in(csv);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  assert(ss.str() == "time,V\n0,3.7\n2,3.65\n");
+
+  std::filesystem::remove(name);
+  std::filesystem::remove(csv);
+  return true;
+}
+
+bool test_ColumnarFile_cell()
+{
+  //!< the cycling data of a cell ends up in the file of the prefix
+  if constexpr (settings::DATASTORE_FORMAT != settings::dataFormat::binary
+                || settings::DATASTORE_CELL != settings::cellDataStorageLevel::storeTimeData)
+    return true;
+
+  const std::string prefix = "columnar_test";
+  const auto name = PathVar::results / (prefix + "_data.slb");
+  std::filesystem::remove(name);
+
+  Cell_SPM c;
+  std::vector<double> V;
+  for (int i = 0; i < 5; i++) {
+    c.setCurrent(i % 2 ? -1 : 1); //!< every sample changes, so none is skipped by the Decimator
+    c.timeStep_CC(2);
+    c.storeData();
+    V.push_back(c.V());
+  }
+  c.writeData(prefix);
+  ColumnarWriter::closeAll();
+
+  ColumnarReader reader(name);
+  const int i = reader.find(c.getFullID() + "_cellData");
+  assert(i >= 0);
+  const auto cols = reader.read(i);
+  assert(EQ(cols.size(), 7));
+  assert(EQ(cols[1].size(), V.size()));
+  for (size_t r = 0; r < V.size(); r++)
+    assert(NEAR(cols[1][r], V[r], 1e-6));
+
+  std::filesystem::remove(name);
+  return true;
+}
+
+int test_all_ColumnarFile()
+{
+  //!< calls all test-functions
+  if (!TEST(test_ColumnarFile_roundtrip, "test_ColumnarFile_roundtrip")) return 1;
+  if (!TEST(test_ColumnarFile_append, "test_ColumnarFile_append")) return 2;
+  if (!TEST(test_ColumnarFile_toCSV, "test_ColumnarFile_toCSV")) return 3;
+  if (!TEST(test_ColumnarFile_cell, "test_ColumnarFile_cell")) return 4;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_ColumnarFile(); }
@@ -13,6 +13,8 @@
 #include <cassert>
 #include <iostream>
 #include <fstream>
+#include <filesystem>
+#include <vector>
 
 namespace slide::tests::unit {
 
@@ -612,6 +614,284 @@ bool test_Cycler_CoolSystem()
   return true;
 }
 
+bool test_Cycler_event()
+{
+  /*
+   * The limits are located inside the time step, so large time steps end at the same point as small ones.
+   */
+  double Ah[2], Ah_CV[2], V[2];
+  const double dts[2] = { 0.5, 5 };
+  for (int k = 0; k < 2; k++) {
+    auto c = make<Cell_SPM>();
+    Cycler cyc(c.get(), "Cycler_event");
+    ThroughputData th{}, th_CV{};
+    const double vlim = c->Vmax() - 0.1;
+
+    auto succ = cyc.CC(-c->Cap(), vlim, TIME_INF, dts[k], 0, th);
+    assert(succ == Status::ReachedVoltageLimit);
+    assert(NEAR(c->V(), vlim, settings::MODULE_P_V_ABSTOL));
+
+    succ = cyc.CV(vlim, c->Cap() / 20, TIME_INF, dts[k], 0, th_CV);
+    assert(succ == Status::ReachedCurrentLimit);
+    assert(NEAR(-c->I(), c->Cap() / 20, 1e-3 * c->Cap()));
+
+    Ah[k] = th.Ah();
+    Ah_CV[k] = th_CV.Ah();
+    V[k] = c->V();
+  }
+
+  assert(NEAR(Ah[0], Ah[1], 1e-3 * Ah[0]));
+  assert(NEAR(Ah_CV[0], Ah_CV[1], 2e-2 * Ah_CV[0]));
+  assert(NEAR(V[0], V[1], settings::MODULE_P_V_ABSTOL));
+  return true;
+}
+
+bool test_Cycler_Profile()
+{
+  /*
+   * Following a profile gives the same result as applying every sample separately,
+   * and the current is clipped at the voltage limits.
+   */
+  constexpr double dt = 1;
+  auto c0 = make<Cell_SPM>();
+  auto c1 = make<Cell_SPM>();
+  const double Cap = c0->Cap();
+
+  std::vector<double> prof(300, Cap);
+  std::fill(prof.begin() + 100, prof.begin() + 150, 0);
+  std::fill(prof.begin() + 150, prof.end(), -0.5 * Cap);
+
+  Cycler cyc(c0.get(), "Cycler_profile");
+  ThroughputData th{};
+  auto succ = cyc.Profile(prof, c0->Vmax(), c0->Vmin(), TIME_INF, dt, 0, th);
+  assert(succ == Status::Success);
+  assert(NEAR(th.time(), prof.size() * dt, 1e-9));
+  assert(NEAR(th.Ah(), (100 * Cap + 150 * 0.5 * Cap) * dt / 3600, 1e-9));
+
+  for (auto I : prof) {
+    c1->setCurrent(I);
+    c1->timeStep_CC(dt, 1);
+  }
+  assert(NEAR(c0->V(), c1->V(), 1e-6));
+  assert(NEAR(c0->SOC(), c1->SOC(), 1e-9));
+
+  //!< time limit
+  th = ThroughputData{};
+  succ = cyc.Profile(prof, c0->Vmax(), c0->Vmin(), 120, dt, 0, th);
+  assert(succ == Status::ReachedTimeLimit);
+  assert(NEAR(th.time(), 120, 1e-9));
+
+  //!< clip the charge current at the voltage limit
+  const double vlim = c0->V() + 0.05;
+  std::vector<double> charge(3600, -Cap);
+  th = ThroughputData{};
+  succ = cyc.Profile(charge, vlim, c0->Vmin(), TIME_INF, dt, 0, th);
+  assert(succ == Status::Success);
+  assert(NEAR(c0->V(), vlim, settings::MODULE_P_V_ABSTOL));
+  assert(-c0->I() < Cap);
+  assert(th.Ah() < Cap);
+
+  return true;
+}
+
+bool test_ProfileStream()
+{
+  //!< csv files with one set-point per sample or set-points with a duration are merged in the same way
+  const auto name1 = std::filesystem::temp_directory_path() / "slide_profile_1col.csv";
+  const auto name2 = std::filesystem::temp_directory_path() / "slide_profile_2col.csv";
+  const auto nameb = std::filesystem::temp_directory_path() / "slide_profile.bin";
+  {
+    std::ofstream f1(name1), f2(name2), fb(nameb, std::ios::binary);
+    f1 << "I [C-rate]\n1\n1\n1\n0\n-0.5\n-0.5\n";
+    f2 << "I [C-rate],t [s]\n1,2\n1,1\n0,1\n-0.5,2\n";
+    const double d[] = { 1, 1, 1, 0, -0.5, -0.5 };
+    fb.write(reinterpret_cast<const char *>(d), sizeof(d));
+  }
+
+  for (const auto &name : { name1, name2, nameb }) {
+    ProfileStream prof(name, 2.0);
+    SetPoint sp;
+    assert(prof.next(sp) && sp.value == 2 && sp.n == 3);
+    assert(prof.next(sp) && sp.value == 0 && sp.n == 1);
+    assert(prof.next(sp) && sp.value == -1 && sp.n == 2);
+    assert(!prof.next(sp));
+
+    prof.rewind();
+    assert(prof.next(sp) && sp.value == 2 && sp.n == 3);
+    std::filesystem::remove(name);
+  }
+
+  return true;
+}
+
+bool test_Cycler_CP()
+{
+  //!< constant power discharge and charge of a cell
+  auto c = make<Cell_SPM>();
+  Cycler cyc(c.get(), "Cycler_CP");
+  ThroughputData th{};
+
+  const double P = c->Cap() * c->V();
+  auto succ = cyc.CP(P, c->Vmin() + 0.1, 600, 1, 0, th);
+  assert(succ == Status::ReachedTimeLimit);
+  assert(NEAR(c->V() * c->I(), P, 1e-5 * P));
+  assert(NEAR(th.time(), 600, 1e-9));
+  assert(NEAR(th.Wh(), P * 600 / 3600, 1e-2 * th.Wh()));
+
+  const double vlim = c->Vmin() + 0.1;
+  succ = cyc.CP(P, vlim, TIME_INF, 1, 0, th);
+  assert(succ == Status::ReachedVoltageLimit);
+  assert(NEAR(c->V(), vlim, settings::MODULE_P_V_ABSTOL));
+
+  succ = cyc.CP(-P, c->Vmax() - 0.1, 600, 1, 0, th);
+  assert(succ == Status::ReachedTimeLimit);
+  assert(NEAR(c->V() * c->I(), -P, 1e-5 * P));
+
+  //!< power profile
+  std::vector<double> prof(60, -P);
+  ProfileStream ps(prof);
+  th = ThroughputData{};
+  succ = cyc.Profile(ps, true, c->Vmax() - 0.1, c->Vmin(), TIME_INF, 1, 0, th);
+  assert(succ == Status::Success);
+  assert(NEAR(th.time(), 60, 1e-9));
+  assert(NEAR(c->V() * c->I(), -P, 1e-5 * P));
+
+  //!< power on the grid side of the converter of a battery
+  constexpr size_t N = 100;
+  std::vector<Deep_ptr<StorageUnit>> cs;
+  for (size_t i = 0; i < N; i++)
+    cs.push_back(make<Cell_SPM>());
+  auto mp = make<Module_s>("CP_module", settings::T_ENV, true, false, N, 1, 2);
+  mp->setSUs(cs, false, true);
+  auto bat = make<Battery>("CP_battery");
+  bat->setModule(std::move(mp));
+
+  Cycler cycb(bat.get(), "Cycler_CP_battery");
+  cycb.setConverter(true);
+  const double Pgrid = -2000; //!< the converter itself uses about 1.5 kW
+  succ = cycb.CP(Pgrid, bat->Vmax() - 1, 60, 2, 0, th);
+  assert(succ == Status::ReachedTimeLimit);
+  const double Pbat = bat->V() * bat->I();
+  assert(NEAR(Pbat - bat->getConverter().getLosses(bat->V(), bat->I()), Pgrid, 1e-5 * std::abs(Pgrid)));
+  assert(Pbat < 0 && Pbat > Pgrid);
+
+  return true;
+}
+
+bool test_Cycler_CV_module()
+{
+  //!< the CV phase of a parallel module with different cells ends at the set voltage and current limit
+  std::vector<Deep_ptr<StorageUnit>> cs;
+  for (int i = 0; i < 3; i++)
+    cs.push_back(make<Cell_SPM>("CV_cell" + std::to_string(i), DEG_ID{}, 1 + 0.02 * i, 1, 1, 1));
+  auto mp = make<Module_p>("CV_module", settings::T_ENV, true, false, cs.size(), 1, 1);
+  mp->setSUs(cs, false, false);
+
+  Cycler cyc(mp.get(), "Cycler_CV_module");
+  ThroughputData th{};
+  const double Vset = mp->Vmax() - 0.1, Ilim = mp->Cap() / 100;
+  auto succ = cyc.CC(-mp->Cap(), Vset, TIME_INF, 2, 0, th);
+  assert(succ == Status::ReachedVoltageLimit);
+
+  succ = cyc.CV(Vset, Ilim, TIME_INF, 2, 0, th);
+  assert(succ == Status::ReachedCurrentLimit);
+  assert(NEAR(mp->V(), Vset, settings::MODULE_P_V_ABSTOL));
+  assert(NEAR(-mp->I(), Ilim, 2e-3 * Ilim));
+
+  return true;
+}
+
+bool test_Cycler_rest_long()
+{
+  //!< a long rest with long steps ages the cell in the same way as resting with 10 steps at once
+  DEG_ID deg;
+  deg.SEI_id.add_model(4);
+  deg.SEI_porosity = 1;
+  auto c0 = make<Cell_SPM>("rest_cell0", deg, 1, 1, 1, 1);
+  auto c1 = make<Cell_SPM>("rest_cell1", deg, 1, 1, 1, 1);
+
+  Cycler cyc(c0.get(), "Cycler_rest");
+  ThroughputData th{};
+  constexpr double tlim = 2 * 24 * 3600, dt = 2;
+  auto succ = cyc.rest(tlim, dt, 0, th);
+  assert(succ == Status::ReachedTimeLimit);
+  assert(NEAR(th.time(), tlim, 1e-6));
+
+  c1->setCurrent(0);
+  for (int i = 0; i < tlim / (10 * dt); i++)
+    c1->timeStep_CC(dt, 10);
+
+  assert(NEAR(c0->V(), c1->V(), 1e-6));
+  assert(NEAR(c0->getStateObj().LLI(), c1->getStateObj().LLI(), 1e-3 * c1->getStateObj().LLI()));
+  assert(NEAR(c0->getStateObj().delta(), c1->getStateObj().delta(), 1e-3 * c1->getStateObj().delta()));
+
+  return true;
+}
+
+bool test_Cycler_rest_warm()
+{
+  //!< a cell and a module of cells which start warmer than their environment rest with long steps
+  //!< they cool down to the environment without overshooting it, and age as when resting with single time steps
+  DEG_ID deg;
+  deg.SEI_id.add_model(4);
+  deg.SEI_porosity = 1;
+  constexpr double Twarm = settings::T_ENV + 20, tlim = 6 * 3600, dt = 2;
+
+  auto makeCell = [&](const std::string &ID) {
+    auto c = make<Cell_SPM>(ID, deg, 1, 1, 1, 1);
+    c->setT(Twarm);
+    return c;
+  };
+  auto makeModule = [&](const std::string &ID) {
+    Deep_ptr<StorageUnit> cs[] = { makeCell("cell0"), makeCell("cell1") };
+    auto ms = make<Module_s>(ID, settings::T_ENV, true, false, std::size(cs), 1, 1);
+    ms->setSUs(cs, false, true);
+    return ms;
+  };
+
+  auto check = [&](StorageUnit *su, StorageUnit *ref) {
+    Cycler cyc(su, "Cycler_rest_warm");
+    ThroughputData th{};
+    auto succ = cyc.rest(tlim, dt, 0, th);
+    assert(succ == Status::ReachedTimeLimit);
+
+    ref->setCurrent(0);
+    for (int i = 0; i < tlim / dt; i++)
+      ref->timeStep_CC(dt);
+
+    auto getCells = [](StorageUnit *top) {
+      std::vector<Cell_SPM *> cells;
+      visit_SUs(top, [&](auto node) {
+        if (auto c = dynamic_cast<Cell_SPM *>(node))
+          cells.push_back(c);
+      });
+      return cells;
+    };
+    const auto cells = getCells(su), cellsRef = getCells(ref);
+    assert(EQ(cells.size(), cellsRef.size()));
+
+    for (size_t i = 0; i < cells.size(); i++) {
+      const double T = cells[i]->T();
+      assert(T >= settings::T_ENV - 1e-6 && T <= Twarm + 1e-6); //!< no overshoot
+      assert(NEAR(T, cellsRef[i]->T(), 1e-2));
+      if constexpr (settings::T_MODEL == 1)
+        assert(NEAR(T, settings::T_ENV, 0.1)); //!< the cell cooled down to its environment
+
+      assert(NEAR(cells[i]->V(), cellsRef[i]->V(), 1e-6));
+      const double LLI = cellsRef[i]->getStateObj().LLI();
+      assert(NEAR(cells[i]->getStateObj().LLI(), LLI, 1e-3 * LLI)); //!< the degradation sees the temperature at the start of every step
+    }
+  };
+
+  auto c0 = makeCell("rest_warm0"), c1 = makeCell("rest_warm1");
+  check(c0.get(), c1.get());
+
+  auto m0 = makeModule("rest_warm_module0"), m1 = makeModule("rest_warm_module1");
+  check(m0.get(), m1.get());
+
+  return true;
+}
+
 int test_all_Cycler()
 {
   auto test_CyclerVariations_0 = []() { return test_CyclerVariations(0.0); };
@@ -628,6 +908,14 @@ int test_all_Cycler()
   if (settings::T_MODEL == 2) // #TODO only valid if T_MODEL==2
     if (!TEST(test_Cycler_CoolSystem, "test_Cycler_CoolSystem")) return 7;
 
+  if (!TEST(test_Cycler_event, "test_Cycler_event")) return 8;
+  if (!TEST(test_Cycler_Profile, "test_Cycler_Profile")) return 9;
+  if (!TEST(test_ProfileStream, "test_ProfileStream")) return 10;
+  if (!TEST(test_Cycler_CP, "test_Cycler_CP")) return 11;
+  if (!TEST(test_Cycler_CV_module, "test_Cycler_CV_module")) return 12;
+  if (!TEST(test_Cycler_rest_long, "test_Cycler_rest_long")) return 13;
+  if (!TEST(test_Cycler_rest_warm, "test_Cycler_rest_warm")) return 14;
+
   return 0;
 }
 } // namespace slide::tests::unit
@@ -0,0 +1,101 @@
+/*
+ * Decimator_test.cpp
+ *
+ *  Checks which samples of the time data are stored by the Decimator
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <vector>
+#include <array>
+
+namespace slide::tests::unit {
+
+bool test_Decimator_step()
+{
+  //!< a rest followed by a current step: the end of the rest and the start of the step are both stored
+  if constexpr (!settings::DATASTORE_DECIMATE)
+    return true;
+
+  constexpr std::array<double, 3> tol{ 1e-3, 1e-3, Decimator::noTol }; //!< I, V, time
+  Decimator d;
+  std::vector<double> data;
+  for (int t = 0; t < 150; t++) {
+    const double I = (t < 100) ? 0 : 1;
+    const double V = (t < 100) ? 3.7 : 3.65 - 1e-4 * (t - 100); //!< slow drift during the step
+    const std::array<double, 3> s{ I, V, static_cast<double>(t) };
+    d.offer(s, tol, 2, data);
+  }
+  d.flush(data);
+
+  std::vector<double> times;
+  for (size_t i = 2; i < data.size(); i += 3)
+    times.push_back(data[i]);
+
+  assert(times.size() < 20);
+  assert(EQ(times[0], 0));
+  assert(EQ(times[1], 99)); //!< the last sample of the rest
+  assert(EQ(times[2], 100));
+  assert(EQ(times.back(), 149)); //!< flush stores the last sample
+  for (size_t i = 3; i + 1 < times.size(); i++)
+    assert(times[i] - times[i - 1] <= 11); //!< the drift of 1e-4 V/s passes the tolerance every 11 s
+  return true;
+}
+
+bool test_Decimator_tmax()
+{
+  //!< a constant signal is stored every DATASTORE_DECIMATE_TMAX seconds
+  if constexpr (!settings::DATASTORE_DECIMATE)
+    return true;
+
+  constexpr std::array<double, 2> tol{ 1e-3, Decimator::noTol };
+  Decimator d;
+  std::vector<double> data;
+  const int tend = static_cast<int>(3.5 * settings::DATASTORE_DECIMATE_TMAX);
+  for (int t = 0; t < tend; t++) {
+    const std::array<double, 2> s{ 1.0, static_cast<double>(t) };
+    d.offer(s, tol, 1, data);
+  }
+  assert(EQ(data.size(), 2 * 4));
+  for (size_t i = 1; i < data.size(); i += 2)
+    assert(EQ(data[i], static_cast<double>((i / 2)) * settings::DATASTORE_DECIMATE_TMAX));
+
+  d.flush(data);
+  assert(EQ(data.back(), tend - 1));
+  d.flush(data); //!< nothing pending anymore
+  assert(EQ(data.size(), 2 * 5));
+  return true;
+}
+
+template <typename Cell_t>
+bool test_Decimator_cell()
+{
+  //!< a resting cell only stores its first sample until its data is written
+  if constexpr (!settings::DATASTORE_DECIMATE || settings::DATASTORE_CELL != settings::cellDataStorageLevel::storeTimeData)
+    return true;
+  else {
+    Cell_t c;
+    c.setCurrent(0);
+    for (int i = 0; i < 100; i++) {
+      c.timeStep_CC(1);
+      c.storeData();
+    }
+    assert(EQ(c.getCellData().data.size(), 7));
+    return true;
+  }
+}
+
+int test_all_Decimator()
+{
+  //!< calls all test-functions
+  if (!TEST(test_Decimator_step, "test_Decimator_step")) return 1;
+  if (!TEST(test_Decimator_tmax, "test_Decimator_tmax")) return 2;
+  if (!TEST(test_Decimator_cell<Cell_Bucket>, "test_Decimator_cell")) return 3;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_Decimator(); }
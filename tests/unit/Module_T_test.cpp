@@ -0,0 +1,178 @@
+/*
+ * Module_T_test.cpp
+ *
+ *  Checks that the modules with cells stored by value (Module_s_T, Module_p_T) give the same results as Module_s and Module_p
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+#include "../../src/procedures/procedure_util.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <cmath>
+#include <span>
+#include <vector>
+#include <string>
+
+namespace slide::tests::unit {
+
+bool test_setSUs_T()
+{
+  Deep_ptr<StorageUnit> cs[] = { make<Cell_Bucket>(), make<Cell_Bucket>(), make<Cell_ECM<1>>() };
+
+  auto mp = make<Module_s_T<Cell_Bucket>>("na", settings::T_ENV, true, false, 2, 1, 1);
+  mp->setSUs(std::span(cs, 2), false, false);
+  assert(mp->getNSUs() == 2);
+  assert(mp->getNcells() == 2);
+  assert(mp->getSU(1)->getFullID() == "na_Cell_ECM<0>");
+  assert(&(*mp)[1] == mp->getSU(1)); //!< the cells are stored by value
+
+  try { //!< so there are no Deep_ptr to return
+    static_cast<Module &>(*mp).getSUs();
+    return false;
+  } catch (int e) {
+    assert(e == 10);
+  }
+
+  //!< a different cell type can't be stored
+  try {
+    mp->setSUs(std::span(cs + 1, 2), false, false);
+    return false;
+  } catch (int e) {
+    assert(e == 10);
+  }
+
+  //!< a cell which belongs to another module
+  auto m_other = make<Module_s>("other", settings::T_ENV, true, false, 1, 1, 1);
+  Deep_ptr<StorageUnit> cs_other[] = { make<Cell_Bucket>() };
+  m_other->setSUs(cs_other, false, false);
+  Deep_ptr<StorageUnit> owned[] = { make<Cell_Bucket>() };
+  owned[0]->setParent(m_other.get());
+  try {
+    mp->setSUs(owned, false, false);
+    return false;
+  } catch (int e) {
+    assert(e == 10);
+  }
+
+  //!< checkCells: the same current in series, the same voltage in parallel
+  Deep_ptr<StorageUnit> cb[] = { make<Cell_Bucket>(), make<Cell_Bucket>() };
+  mp->setSUs(cb, true, false);
+  dynamic_cast<Cell_Bucket *>(cb[1].get())->setSOC(0.2);
+  auto mpar = make<Module_p_T<Cell_Bucket>>("par", settings::T_ENV, true, false, 2, 1, 1);
+  try {
+    mpar->setSUs(cb, true, false);
+    return false;
+  } catch (int e) {
+    assert(e == 10);
+  }
+  mpar->setSUs(cb, false, false);
+  dynamic_cast<Cell_Bucket *>(cb[1].get())->setCurrent(1);
+  try {
+    mp->setSUs(cb, true, false);
+    return false;
+  } catch (int e) {
+    assert(e == 10);
+  }
+
+  mp->setSUs(std::span(cs, 2), false, false);
+
+  //!< a copy has its own cells, which have the copy as parent
+  std::unique_ptr<Module> mp2{ mp->copy() };
+  mp2->setID("copy");
+  assert(mp2->getSU(0)->getFullID() == "copy_Cell_ECM<0>");
+
+  //!< generic code reaches the cells through getSU
+  int Nvisited{ 0 };
+  visit_SUs(mp.get(), [&](auto) { Nvisited++; });
+  assert(Nvisited == 3); //!< module and 2 cells
+
+  return true;
+}
+
+bool test_series_T()
+{
+  //!< CC discharge of a Module_s_T<Cell_SPM> and a Module_s with the same cells
+  constexpr size_t N = 5;
+  DEG_ID deg;
+  std::vector<Deep_ptr<StorageUnit>> cs0, cs1;
+  std::vector<double> Rc(N, 1e-3);
+  for (size_t i = 0; i < N; i++) {
+    cs0.push_back(make<Cell_SPM>("cell" + std::to_string(i), deg, 1 + 0.01 * i, 1 - 0.01 * i, 1, 1));
+    cs1.push_back(make<Cell_SPM>("cell" + std::to_string(i), deg, 1 + 0.01 * i, 1 - 0.01 * i, 1, 1));
+  }
+
+  auto m0 = make<Module_s>("full", settings::T_ENV, true, false, N, 1, 1);
+  auto m1 = make<Module_s_T<Cell_SPM>>("byvalue", settings::T_ENV, true, false, N, 1, 1);
+  m0->setSUs(cs0, false, false);
+  m1->setSUs(cs1, false, false);
+  m0->setRcontact(Rc);
+  m1->setRcontact(Rc);
+
+  assert(NEAR(m1->V(), m0->V(), 1e-12));
+  assert(NEAR(m1->getRtot(), m0->getRtot(), 1e-12));
+  assert(NEAR(m1->Cap(), m0->Cap(), 1e-12));
+  assert(NEAR(m1->Vmin(), m0->Vmin(), 1e-12));
+
+  m0->setCurrent(m0->Cap());
+  m1->setCurrent(m1->Cap());
+  for (int i = 0; i < 20; i++) {
+    m0->timeStep_CC(2, 5);
+    m1->timeStep_CC(2, 5);
+  }
+
+  assert(NEAR(m1->V(), m0->V(), 1e-12));
+  assert(NEAR(m1->T(), m0->T(), 1e-12));
+
+  std::vector<double> s0, s1;
+  m0->getStates(s0);
+  m1->getStates(s1);
+  assert(s0 == s1);
+
+  return true;
+}
+
+bool test_parallel_T()
+{
+  //!< current sharing in a Module_p_T<Cell_ECM<1>> and a Module_p with the same cells
+  Deep_ptr<StorageUnit> cs0[] = { make<Cell_ECM<1>>(), make<Cell_ECM<1>>(), make<Cell_ECM<1>>() };
+  Deep_ptr<StorageUnit> cs1[] = { make<Cell_ECM<1>>(), make<Cell_ECM<1>>(), make<Cell_ECM<1>>() };
+  dynamic_cast<Cell_ECM<1> *>(cs0[1].get())->setSOC(0.4);
+  dynamic_cast<Cell_ECM<1> *>(cs1[1].get())->setSOC(0.4);
+
+  auto m0 = make<Module_p>("full", settings::T_ENV, true, false, std::size(cs0), 1, 1);
+  auto m1 = make<Module_p_T<Cell_ECM<1>>>("byvalue", settings::T_ENV, true, false, std::size(cs1), 1, 1);
+  m0->setSUs(cs0, false, false);
+  m1->setSUs(cs1, false, false);
+
+  const double Inew = 2.0 * std::size(cs0);
+  m0->setCurrent(Inew);
+  m1->setCurrent(Inew);
+  assert(NEAR(m1->I(), Inew, 1e-9));
+  assert(NEAR(m1->V(), m0->V(), 1e-9));
+  assert(NEAR(m1->getSU(1)->I(), m0->getSU(1)->I(), 1e-6));
+  assert(m1->getSU(1)->I() < m1->getSU(0)->I()); //!< the cell with the lower SOC takes less current
+
+  for (int i = 0; i < 20; i++) {
+    m0->timeStep_CC(2, 5);
+    m1->timeStep_CC(2, 5);
+  }
+  assert(NEAR(m1->V(), m0->V(), 1e-6));
+  assert(NEAR(m1->I(), Inew, 1e-6));
+
+  return true;
+}
+
+int test_all_Module_T()
+{
+  //!< calls all test-functions
+  if (!TEST(test_setSUs_T, "test_setSUs_T")) return 1;
+  if (!TEST(test_series_T, "test_series_T")) return 2;
+  if (!TEST(test_parallel_T, "test_parallel_T")) return 3;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_Module_T(); }
@@ -0,0 +1,192 @@
+/*
+ * Module_s_clustered_test.cpp
+ *
+ *  Checks the clustering of Module_s_clustered and compares it against a Module_s with all cells
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <cmath>
+#include <span>
+#include <vector>
+#include <string>
+
+namespace slide::tests::unit {
+
+//!< cells with a small spread in capacity and resistance, in two groups which are far apart
+auto makeSpreadCells(size_t N)
+{
+  DEG_ID deg;
+  std::vector<Deep_ptr<StorageUnit>> cs;
+  for (size_t i = 0; i < N; i++) {
+    const double capf = (i % 2 == 0 ? 1.0 : 0.97) + 0.001 * (i % 3);
+    const double resf = 1.0 + 0.005 * (i % 4);
+    cs.push_back(make<Cell_SPM>("cell" + std::to_string(i), deg, capf, resf, 1.0, 1.0));
+  }
+  return cs;
+}
+
+bool test_identicalCells_clustered()
+{
+  Deep_ptr<StorageUnit> cs[] = { make<Cell_SPM>(), make<Cell_SPM>(), make<Cell_SPM>(), make<Cell_SPM>(), make<Cell_SPM>() };
+  const double Vcell = cs[0]->V();
+
+  auto mp = make<Module_s_clustered>("na", settings::T_ENV, true, false, std::size(cs), 1, 1);
+  mp->setSUs(cs, false, false);
+
+  assert(mp->getNclusters() == 1);
+  assert(mp->getNSUs() == 2); //!< representative and sentinel
+  assert(mp->getNcells() == std::size(cs));
+  assert(mp->getWeights()[0] == 4);
+  assert(mp->getWeights()[1] == 1);
+  assert(NEAR(mp->V(), std::size(cs) * Vcell, 1e-9));
+  assert(NEAR(mp->Vmax(), std::size(cs) * mp->getSUs()[0]->Vmax(), 1e-9));
+
+  return true;
+}
+
+bool test_spreadCells_clustered()
+{
+  constexpr size_t N = 12;
+  auto cs = makeSpreadCells(N);
+
+  auto mp = make<Module_s_clustered>("na", settings::T_ENV, true, false, N, 1, 1);
+  mp->setSUs(cs, false, false);
+
+  assert(mp->getNclusters() == 2); //!< the two capacity groups
+  assert(mp->getNSUs() == 4);
+  assert(mp->getNcells() == N);
+
+  double wtot{ 0 };
+  for (const auto w : mp->getWeights())
+    wtot += w;
+  assert(wtot == N);
+
+  //!< the contact resistances of all cells are lumped in the simulated cells
+  const double Rtot = mp->getRtot();
+  std::vector<double> Rc(N, 1e-3);
+  mp->setRcontact(Rc);
+  assert(NEAR(mp->getRtot(), Rtot + N * 1e-3, 1e-12));
+
+  return true;
+}
+
+bool test_CC_clustered()
+{
+  //!< 1C discharge of a clustered and a full module, the voltage must agree within the estimated error
+  constexpr size_t N = 12;
+  auto cs0 = makeSpreadCells(N);
+  auto cs1 = makeSpreadCells(N);
+  std::vector<double> Rc(N, 1e-3);
+
+  auto m0 = make<Module_s>("full", settings::T_ENV, true, false, N, 1, 1);
+  auto m1 = make<Module_s_clustered>("clustered", settings::T_ENV, true, false, N, 1, 1);
+  m0->setSUs(cs0, false, false);
+  m1->setSUs(cs1, false, false);
+  m0->setRcontact(Rc);
+  m1->setRcontact(Rc);
+  m0->setBlockDegAndTherm(true);
+  m1->setBlockDegAndTherm(true);
+
+  assert(NEAR(m1->V(), m0->V(), 0.01));
+  assert(NEAR(m1->getRtot(), m0->getRtot(), 1e-3));
+
+  const double I = m0->Cap();
+  m0->setCurrent(I);
+  m1->setCurrent(I);
+
+  for (int i = 0; i < 100; i++) {
+    m0->timeStep_CC(2, 5);
+    m1->timeStep_CC(2, 5);
+
+    const auto err = m1->getClusterError();
+    assert(std::abs(m1->V() - m0->V()) < err.dV + 0.01);
+  }
+
+  return true;
+}
+
+bool test_split_clustered()
+{
+  //!< with a tight threshold, the diverging voltage of cells with a different resistance splits the clusters
+  constexpr size_t N = 12;
+  auto cs = makeSpreadCells(N);
+
+  ClusterParam cpar;
+  cpar.dV_split = 1e-4;
+
+  auto mp = make<Module_s_clustered>("na", settings::T_ENV, true, false, N, 1, 1, cpar);
+  mp->setSUs(cs, false, false);
+  mp->setBlockDegAndTherm(true);
+  assert(mp->getNclusters() == 2);
+
+  mp->setCurrent(mp->Cap());
+  mp->timeStep_CC(2, 5);
+
+  const auto err = mp->getClusterError();
+  assert(mp->getNclusters() > 2); //!< at least the cluster whose sentinel has a different resistance is split
+  assert(err.Nclusters == mp->getNclusters());
+  assert(err.dV > 0);
+  assert(err.Nsimulated == mp->getNSUs());
+  assert(err.Ncells == N);
+  assert(mp->getNSUs() > mp->getNclusters()); //!< the clusters after the split have new sentinels
+
+  double wtot{ 0 };
+  for (const auto w : mp->getWeights())
+    wtot += w;
+  assert(wtot == N);
+
+  return true;
+}
+
+bool test_split_CC_clustered()
+{
+  //!< after splits, the new sentinels keep bounding the error w.r.t. a module with all cells
+  constexpr size_t N = 12;
+  auto cs0 = makeSpreadCells(N);
+  auto cs1 = makeSpreadCells(N);
+
+  ClusterParam cpar;
+  cpar.dV_split = 5e-4;
+
+  auto m0 = make<Module_s>("full", settings::T_ENV, true, false, N, 1, 1);
+  auto m1 = make<Module_s_clustered>("clustered", settings::T_ENV, true, false, N, 1, 1, cpar);
+  m0->setSUs(cs0, false, false);
+  m1->setSUs(cs1, false, false);
+  m0->setBlockDegAndTherm(true);
+  m1->setBlockDegAndTherm(true);
+
+  const double I = m0->Cap();
+  m0->setCurrent(I);
+  m1->setCurrent(I);
+
+  for (int i = 0; i < 100; i++) {
+    m0->timeStep_CC(2, 5);
+    m1->timeStep_CC(2, 5);
+
+    const auto err = m1->getClusterError();
+    assert(err.Nsimulated == m1->getNSUs());
+    assert(std::abs(m1->V() - m0->V()) < err.dV + 0.01);
+  }
+  assert(m1->getNclusters() > 2);
+
+  return true;
+}
+
+int test_all_Module_s_clustered()
+{
+  //!< calls all test-functions
+  if (!TEST(test_identicalCells_clustered, "test_identicalCells_clustered")) return 1;
+  if (!TEST(test_spreadCells_clustered, "test_spreadCells_clustered")) return 2;
+  if (!TEST(test_CC_clustered, "test_CC_clustered")) return 3;
+  if (!TEST(test_split_clustered, "test_split_clustered")) return 4;
+  if (!TEST(test_split_CC_clustered, "test_split_CC_clustered")) return 5;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_Module_s_clustered(); }
@@ -15,6 +15,7 @@
 #include <memory>
 #include <typeinfo>
 #include <span>
+#include <filesystem>
 
 namespace slide::tests::unit {
 
@@ -1103,6 +1104,182 @@ bool test_CoolSystem_s()
 }
 
 //!< ***************************************************************** test all functions *************************************************************************
+bool test_backupRestore()
+{
+  //!< backupStates/restoreStates of a module with SPM cells
+  std::vector<double> s0, s1;
+
+  Deep_ptr<StorageUnit> cs[] = { make<Cell_SPM>(), make<Cell_SPM>() };
+
+  auto mp = make<Module_s>("na", settings::T_ENV, true, false, std::size(cs), 1, 1);
+  mp->setSUs(cs, false, true);
+  const double V0 = mp->V(); //!< the cells store their voltage in their states
+  mp->getStates(s0);
+
+  mp->backupStates();
+  mp->setCurrent(mp->Cap());
+  mp->timeStep_CC(2, 100);
+  mp->setT(settings::T_ENV + 10);
+  assert(mp->V() < V0);
+
+  mp->restoreStates();
+  mp->getStates(s1);
+  assert(s0 == s1);
+  assert(NEAR(mp->V(), V0, 1e-12)); //!< the stored voltage has been invalidated
+
+  return true;
+}
+
+bool test_backupRestore_trajectory()
+{
+  //!< a module which is restored after an excursion continues exactly as a module without the excursion,
+  //!< so the stress history of the LAM and crack growth models is part of the backup
+  DEG_ID deg;
+  deg.LAM_id.add_model(1);
+  deg.CS_id.add_model(1);
+
+  auto makeModule = [&] {
+    Deep_ptr<StorageUnit> cs[] = { make<Cell_SPM>("cell0", deg, 1, 1, 1, 1), make<Cell_SPM>("cell1", deg, 0.98, 1.02, 1, 1) };
+    auto mp = make<Module_s>("traj", settings::T_ENV, true, false, std::size(cs), 1, 1);
+    mp->setSUs(cs, false, true);
+    mp->setCurrent(mp->Cap());
+    return mp;
+  };
+
+  auto m0 = makeModule(), m1 = makeModule();
+  for (int i = 0; i < 10; i++) {
+    m0->timeStep_CC(2, 5);
+    m1->timeStep_CC(2, 5);
+  }
+
+  m1->backupStates();
+  m1->setCurrent(-2 * m1->Cap());
+  for (int i = 0; i < 10; i++)
+    m1->timeStep_CC(2, 5);
+  m1->restoreStates();
+
+  for (int i = 0; i < 10; i++) {
+    m0->timeStep_CC(2, 5);
+    m1->timeStep_CC(2, 5);
+  }
+
+  std::vector<double> s0, s1;
+  m0->getStates(s0);
+  m1->getStates(s1);
+  assert(s0 == s1);
+  assert(m0->V() == m1->V());
+
+  return true;
+}
+
+bool test_packData()
+{
+  //!< the top-level module stores the time data of all its cells, which is written per cell
+  if constexpr (!settings::data::packCellData || settings::DATASTORE_FORMAT != settings::dataFormat::binary)
+    return true;
+
+  const std::string prefix = "test_packData";
+  const auto name = PathVar::results / (prefix + "_data.slb");
+  std::filesystem::remove(name);
+
+  std::vector<Cell *> cells;
+  Deep_ptr<StorageUnit> ms[2];
+  for (int j = 0; j < 2; j++) {
+    Deep_ptr<StorageUnit> cs[] = { make<Cell_SPM>("cell0", DEG_ID{}, 1, 1, 1, 1), make<Cell_SPM>("cell1", DEG_ID{}, 1, 1, 1, 1) };
+    for (auto &c : cs) cells.push_back(dynamic_cast<Cell *>(c.get()));
+    auto m = make<Module_s>("sub" + std::to_string(j), settings::T_ENV, true, false, std::size(cs), 1, 1);
+    m->setSUs(cs, false, true);
+    ms[j] = std::move(m);
+  }
+  auto mp = make<Module_s>("pack", settings::T_ENV, true, false, 4, 1, 1);
+  mp->setSUs(ms, false, true);
+
+  std::vector<std::vector<double>> V(cells.size());
+  for (int i = 0; i < 5; i++) {
+    mp->setCurrent(i % 2 ? -1 : 1, false, false); //!< every sample changes, so none is skipped by the Decimator
+    mp->timeStep_CC(2, 1);
+    mp->storeData();
+    for (size_t k = 0; k < cells.size(); k++)
+      V[k].push_back(cells[k]->V());
+  }
+  mp->writeData(prefix);
+  ColumnarWriter::closeAll();
+
+  ColumnarReader reader(name);
+  for (size_t k = 0; k < cells.size(); k++) {
+    const int i = reader.find(cells[k]->getFullID() + "_cellData");
+    assert(i >= 0);
+    const auto cols = reader.read(i);
+    assert(EQ(cols[1].size(), 5));
+    for (size_t r = 0; r < 5; r++)
+      assert(NEAR(cols[1][r], V[k][r], 1e-6));
+  }
+
+  //!< the Cycler writes the data of a large pack more often, so its buffer fits in the memory of the AsyncWriter
+  using Store = PackDataStore<Cell>;
+  assert(EQ(Store::maxRows(cells.size()), settings::CELL_NDATA_MAX));
+  constexpr size_t Nlarge = 100'000;
+  assert(Store::maxRows(Nlarge) < settings::CELL_NDATA_MAX);
+  assert(Store::maxRows(Nlarge) * Nlarge * Store::Nvar * sizeof(double) <= settings::DATASTORE_ASYNC_BYTES / 2);
+
+  std::filesystem::remove(name);
+  return true;
+}
+
+bool test_capture()
+{
+  //!< time data for one module, usage statistics for the other, except one cell which stores nothing
+  if constexpr (!settings::data::packCellData || settings::DATASTORE_FORMAT != settings::dataFormat::binary)
+    return true;
+
+  using enum settings::cellDataStorageLevel;
+  const std::string prefix = "test_capture";
+  const auto name = PathVar::results / (prefix + "_data.slb");
+  std::filesystem::remove(name);
+
+  std::vector<Cell *> cells;
+  Deep_ptr<StorageUnit> ms[2];
+  for (int j = 0; j < 2; j++) {
+    Deep_ptr<StorageUnit> cs[] = { make<Cell_SPM>("cell0", DEG_ID{}, 1, 1, 1, 1), make<Cell_SPM>("cell1", DEG_ID{}, 1, 1, 1, 1) };
+    for (auto &c : cs) cells.push_back(dynamic_cast<Cell *>(c.get()));
+    auto m = make<Module_s>("sub" + std::to_string(j), settings::T_ENV, true, false, std::size(cs), 1, 1);
+    m->setSUs(cs, false, true);
+    ms[j] = std::move(m);
+  }
+  auto mp = make<Module_s>("pack", settings::T_ENV, true, false, 4, 1, 1);
+  mp->setSUs(ms, false, true);
+
+  mp->setCapture(storeHistogramData);
+  mp->getSU(0)->setCapture(storeTimeData);
+  cells[3]->setCapture(noStorage);
+  assert(mp->getCapture() == storeTimeData); //!< the parents store data if any child does
+  assert(mp->getSU(1)->getCapture() == storeHistogramData);
+  assert(cells[2]->getCapture() == storeHistogramData);
+
+  for (int i = 0; i < 5; i++) {
+    mp->setCurrent(i % 2 ? -1 : 1, false, false);
+    mp->timeStep_CC(2, 1);
+    mp->storeData();
+  }
+  assert(EQ(usageStats(mp.get()).I.stats.count(), 5)); //!< only cell 2 has usage statistics
+  mp->writeData(prefix);
+  ColumnarWriter::closeAll();
+
+  ColumnarReader reader(name);
+  for (size_t k = 0; k < 2; k++) {
+    const int i = reader.find(cells[k]->getFullID() + "_cellData");
+    assert(i >= 0);
+    assert(EQ(reader.read(i)[1].size(), 5));
+  }
+  assert(reader.find(cells[2]->getFullID() + "_cellData") < 0);
+  assert(reader.find(cells[2]->getFullID() + "_cellStats") >= 0);
+  assert(reader.find(cells[3]->getFullID() + "_cellStats") < 0);
+  assert(reader.find(cells[3]->getFullID() + "_cellStates") < 0);
+
+  std::filesystem::remove(name);
+  return true;
+}
+
 int test_all_Module_s()
 {
   //!< if we test the errors, suppress error messages
@@ -1123,6 +1300,10 @@ int test_all_Module_s()
 
   if (!TEST(test_timeStep_CC, "test_timeStep_CC")) return 13;
   if (!TEST(test_copy_s, "test_copy_s")) return 14;
+  if (!TEST(test_backupRestore, "test_backupRestore")) return 20;
+  if (!TEST(test_packData, "test_packData")) return 21;
+  if (!TEST(test_capture, "test_capture")) return 22;
+  if (!TEST(test_backupRestore_trajectory, "test_backupRestore_trajectory")) return 23;
 
   //!< Combinations
   if (!TEST(test_Modules_s<Cell_ECM<1>>, "test_Modules_s_ECM")) return 15;
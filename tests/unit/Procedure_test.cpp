@@ -573,9 +573,102 @@ bool test_allDegradationModels(int cool)
   return true;
 }
 
+bool test_Procedure_testCapacities()
+{
+  /*
+   * The capacity tests of all cells (in parallel) give the same result as testing them one by one,
+   * and with a tolerance the estimate from the degradation states is close to the full test
+   */
+  constexpr size_t ncel = 4;
+  DEG_ID deg;
+  deg.SEI_id.add_model(4); //!< fast SEI growth so a few cycles cause some degradation
+  deg.SEI_porosity = 0;
+
+  std::vector<Deep_ptr<StorageUnit>> cs;
+  std::vector<Cell *> cells;
+  for (size_t i = 0; i < ncel; i++) {
+    cs.push_back(make<Cell_SPM>("capcell" + std::to_string(i), deg, 1 - 0.02 * i, 1 + 0.05 * i, 1 + 0.2 * i, 1));
+    cells.push_back(dynamic_cast<Cell *>(cs.back().get()));
+  }
+
+  auto proc = Procedure(false, 3.5, 0, true);
+  proc.setCapacityEstimate(0.01);
+  const auto caps = proc.testCapacities(cells); //!< full tests, also stores the reference
+
+  for (size_t i = 0; i < ncel; i++) {
+    assert(caps[i] > 0);
+    assert(caps[i] == Cycler(cells[i]).testCapacity());
+  }
+
+  //!< age the cells a bit
+  for (auto c : cells) {
+    auto cyc = Cycler(c, "capcell");
+    ThroughputData th{};
+    for (int k = 0; k < 5; k++) {
+      cyc.CC(-c->Cap(), c->Vmax(), TIME_INF, 2, 0, th);
+      cyc.CC(c->Cap(), c->Vmin(), TIME_INF, 2, 0, th);
+    }
+  }
+
+  const auto caps_est = proc.testCapacities(cells);
+  for (size_t i = 0; i < ncel; i++) {
+    const auto cap_full = Cycler(cells[i]).testCapacity();
+    assert(caps_est[i] < caps[i]);                     //!< the estimate sees the degradation
+    assert(NEAR(caps_est[i], cap_full, 1e-3 * cap_full)); //!< and is close to the full test
+  }
+
+  return true;
+}
+
+bool test_Procedure_rebalance()
+{
+  /*
+   * Rebalancing brings every cell (SPM and ECM) of a module to the balance voltage at 0 current,
+   * and the direct reset ends close to the state reached by the CCCV
+   */
+  constexpr double Vbal = 3.7;
+  auto makeModule = [] {
+    Deep_ptr<StorageUnit> cs[] = { make<Cell_SPM>("spm0", DEG_ID{}, 1, 1, 1, 1), make<Cell_SPM>("spm1", DEG_ID{}, 0.95, 1.1, 1, 1),
+                                   make<Cell_Bucket>("ecm0", 16, 0.3), make<Cell_ECM<1>>("ecm1", 16, 0.8) };
+    auto mp = make<Module_s>("bal", settings::T_ENV, true, false, std::size(cs), 1, 1);
+    mp->setSUs(cs, false, true);
+    dynamic_cast<Cell_SPM *>(mp->getSU(1))->setC(0.6, 0.6); //!< start at different voltages
+    return mp;
+  };
+
+  auto m0 = makeModule(), m1 = makeModule();
+
+  auto p0 = Procedure(true, Vbal, 0, true);
+  auto p1 = Procedure(true, Vbal, 0, true);
+  p1.setFastBalance(true);
+
+  Status st0 = p0.rebalance(m0.get()), st1 = p1.rebalance(m1.get());
+  assert(st0 == Status::Success && st1 == Status::Success);
+
+  for (size_t i = 0; i < m0->getNSUs(); i++) {
+    auto *c0 = m0->getSU(i), *c1 = m1->getSU(i);
+    assert(NEAR(c0->I(), 0.0, 1e-12));
+    assert(NEAR(c1->I(), 0.0, 1e-12));
+    assert(NEAR(c0->V(), Vbal, 5e-3)); //!< the CCCV stops at C/1000, so the cell is not fully relaxed
+    assert(NEAR(c1->V(), Vbal, 1e-6));
+    assert(NEAR(dynamic_cast<Cell *>(c1)->SOC(), dynamic_cast<Cell *>(c0)->SOC(), 5e-3)); //!< the direct reset moves the same charge as the CCCV
+  }
+
+  //!< a voltage which no cell can reach
+  auto p2 = Procedure(true, 10, 0, true);
+  p2.setFastBalance(true);
+  st1 = p2.rebalance(m1.get());
+  assert(st1 == Status::Invalid_Vset);
+
+  return true;
+}
+
 int test_all_Procedure()
 {
   int cool = 1;
+  if (!test_Procedure_testCapacities()) return 1;
+  if (!test_Procedure_rebalance()) return 2;
+
   //!< Test normal procedures, with and without contact resistance and CV phases
   test_Procedure_cycleAge(0, true, cool);
   //!< test with two different values for contact resistance
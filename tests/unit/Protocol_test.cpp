@@ -0,0 +1,161 @@
+/*
+ * Protocol_test.cpp
+ *
+ *  Checks the parsing of protocols and that running them is the same as calling the Cycler directly
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <string>
+
+namespace slide::tests::unit {
+
+bool test_Protocol_parse()
+{
+  using Type = ProtocolStep::Type;
+  const Protocol prot{ R"(# cycle ageing with a check-up
+    Repeat 3
+      checkup every 50
+      charge at 1 C until 4.1 V     # CC
+      hold at 4.1V until C/20
+      discharge at 2 A for 30 min or until 2.7 V
+      discharge at 5 W
+      rest for 1 h
+    end
+    profile "profiles/drive.csv" power for 10 s
+  )" };
+
+  const auto &s = prot.getSteps();
+  assert(prot.size() == 9);
+  assert(prot.getDepth() == 1);
+
+  assert(s[0].type == Type::repeat);
+  assert(EQ(s[0].n, 3));
+  assert(EQ(s[0].jump, 7));
+  assert(s[7].type == Type::end);
+  assert(EQ(s[7].jump, 0));
+
+  assert(s[1].type == Type::checkup);
+  assert(EQ(s[1].n, 50));
+
+  assert(s[2].type == Type::CC && s[2].Crate);
+  assert(NEAR(s[2].value, -1, 1e-15));
+  assert(NEAR(s[2].vlim, 4.1, 1e-15));
+  assert(EQ(s[2].tlim, TIME_INF));
+
+  assert(s[3].type == Type::CV && s[3].Crate);
+  assert(NEAR(s[3].value, 4.1, 1e-15));
+  assert(NEAR(s[3].Ilim, 0.05, 1e-15));
+
+  assert(s[4].type == Type::CC && !s[4].Crate);
+  assert(NEAR(s[4].value, 2, 1e-15));
+  assert(NEAR(s[4].vlim, 2.7, 1e-15));
+  assert(NEAR(s[4].tlim, 1800, 1e-12));
+
+  assert(s[5].type == Type::CP);
+  assert(NEAR(s[5].value, 5, 1e-15));
+  assert(std::isnan(s[5].vlim)); //!< the limit of the storage unit
+
+  assert(s[6].type == Type::rest);
+  assert(NEAR(s[6].tlim, 3600, 1e-12));
+
+  assert(s[8].type == Type::profile && s[8].power);
+  assert(NEAR(s[8].tlim, 10, 1e-12));
+  assert(prot.getProfiles()[s[8].n] == "profiles/drive.csv");
+
+  return true;
+}
+
+bool test_Protocol_errors()
+{
+  //!< every line has a syntax error
+  const std::vector<std::string> bad{
+    "rest 4 h",                       //!< missing for
+    "charge at 1 V",                  //!< not a current
+    "charge at 1 C until 0.1 A",      //!< a CC stops at a voltage
+    "hold at 4.2 V",                  //!< no limit
+    "discharge at 1 C for 2 parsecs", //!< not a time
+    "repeat 2\nrest for 1 s",         //!< missing end
+    "end",                            //!< end without repeat
+    "repeat 1.5\nend",                //!< not an integer
+    "profile drive.csv",              //!< no quotes
+    "jump 3",                         //!< unknown command
+  };
+
+  for (const auto &text : bad) {
+    try {
+      Protocol prot{ text };
+      return false;
+    } catch (int e) {
+      assert(EQ(e, 1));
+    }
+  }
+  return true;
+}
+
+bool test_Protocol_run()
+{
+  //!< running a protocol is the same as doing its steps with the Cycler
+  constexpr double dt = 2;
+  auto c0 = make<Cell_SPM>("prot_cell0", DEG_ID{}, 1, 1, 1, 1);
+  auto c1 = make<Cell_SPM>("prot_cell1", DEG_ID{}, 1, 1, 1, 1);
+
+  const Protocol prot{ R"(
+    repeat 2
+      charge at 1 C until 4.1 V
+      hold at 4.1 V until C/20
+      rest for 10 min
+      discharge at 2 A until 3 V
+      repeat 0
+        rest for 1 h
+      end
+    end
+    discharge at 1 W for 5 min
+  )" };
+
+  auto proc = Procedure(false, 3.5, 0, true);
+  const auto succ = proc.runProtocol(c0.get(), prot, dt);
+  assert(succ == Status::Success);
+
+  auto cyc = Cycler(c1.get(), "protocol").setDiagnostic(true);
+  ThroughputData th{};
+  Status st{};
+  for (int i = 0; i < 2; i++) {
+    st = cyc.CC(-c1->Cap(), 4.1, TIME_INF, dt, 0, th);
+    assert(st == Status::ReachedVoltageLimit);
+    st = cyc.CV(4.1, c1->Cap() / 20, TIME_INF, dt, 0, th);
+    assert(st == Status::ReachedCurrentLimit);
+    st = cyc.rest(600, dt, 0, th);
+    assert(st == Status::ReachedTimeLimit);
+    st = cyc.CC(2, 3, TIME_INF, dt, 0, th);
+    assert(st == Status::ReachedVoltageLimit);
+  }
+  st = cyc.CP(1, c1->Vmin(), 300, dt, 0, th);
+  assert(st == Status::ReachedTimeLimit);
+
+  std::vector<double> s0, s1;
+  c0->getStates(s0);
+  c1->getStates(s1);
+  assert(s0 == s1);
+  assert(NEAR(c0->V(), c1->V(), 1e-15));
+
+  return true;
+}
+
+int test_all_Protocol()
+{
+  //!< calls all test-functions
+  if (!TEST(test_Protocol_parse, "test_Protocol_parse")) return 1;
+  if (!TEST(test_Protocol_errors, "test_Protocol_errors")) return 2;
+  if (!TEST(test_Protocol_run, "test_Protocol_run")) return 3;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_Protocol(); }
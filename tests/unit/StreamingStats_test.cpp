@@ -0,0 +1,194 @@
+/*
+ * StreamingStats_test.cpp
+ *
+ *  Checks the streaming usage statistics: merging, accuracy of the quantiles, growth of the histograms and rainflow counting
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace slide::tests::unit {
+
+std::vector<double> samples(size_t n)
+{
+  //!< reproducible samples with positive, negative and zero values
+  std::mt19937 gen(42);
+  std::normal_distribution<double> dist(0.5, 2.0);
+  std::vector<double> x(n);
+  for (auto &xi : x)
+    xi = dist(gen);
+  x[n / 2] = 0;
+  return x;
+}
+
+bool test_RunningStats_merge()
+{
+  //!< the merge of two halves is the same as adding all samples to one
+  const auto x = samples(10000);
+  RunningStats all, a, b;
+  for (size_t i = 0; i < x.size(); i++) {
+    const double w = 1 + static_cast<double>(i % 3);
+    all.add(x[i], w);
+    (i < 3000 ? a : b).add(x[i], w);
+  }
+  a.merge(b);
+
+  assert(EQ(a.count(), all.count()));
+  assert(NEAR(a.weight(), all.weight()));
+  assert(EQ(a.min(), all.min()));
+  assert(EQ(a.max(), all.max()));
+  assert(NEAR(a.mean(), all.mean(), 1e-12));
+  assert(NEAR(a.variance(), all.variance(), 1e-10));
+
+  //!< against the two-pass values
+  double W{ 0 }, S{ 0 };
+  for (size_t i = 0; i < x.size(); i++) {
+    W += 1 + static_cast<double>(i % 3);
+    S += (1 + static_cast<double>(i % 3)) * x[i];
+  }
+  const double mean = S / W;
+  double V{ 0 };
+  for (size_t i = 0; i < x.size(); i++)
+    V += (1 + static_cast<double>(i % 3)) * (x[i] - mean) * (x[i] - mean);
+
+  assert(NEAR(all.mean(), mean, 1e-12));
+  assert(NEAR(all.variance(), V / W, 1e-10));
+
+  //!< merging an empty one changes nothing
+  a.merge(RunningStats{});
+  assert(NEAR(a.mean(), all.mean(), 1e-12));
+  return true;
+}
+
+bool test_BinnedHistogram()
+{
+  //!< the histogram grows to the range of the data in both directions, and merges bin by bin
+  BinnedHistogram all(0.5), a(0.5), b(0.5);
+  const auto x = samples(5000);
+  for (size_t i = 0; i < x.size(); i++) {
+    all.add(x[i], 2);
+    (i % 2 ? a : b).add(x[i], 2);
+  }
+  a.merge(b);
+
+  assert(EQ(a.size(), all.size()));
+  for (size_t i = 0; i < all.size(); i++) {
+    assert(EQ(a.lower(i), all.lower(i)));
+    assert(NEAR(a[i], all[i]));
+  }
+  assert(NEAR(all.total(), 2.0 * static_cast<double>(x.size()), 1e-6));
+
+  const auto [xmin, xmax] = std::minmax_element(x.begin(), x.end());
+  assert(all.lower(0) <= *xmin && *xmin < all.lower(0) + 0.5);
+  assert(all.lower(all.size() - 1) <= *xmax && *xmax < all.lower(all.size() - 1) + 0.5);
+
+  all.add(-100, 1); //!< far outside the previous range
+  all.add(100, 1);
+  assert(NEAR(all.lower(0), -100));
+  assert(NEAR(all.lower(all.size() - 1), 100));
+  assert(NEAR(all[0], 1));
+  return true;
+}
+
+bool test_QuantileSketch()
+{
+  //!< every quantile is within the relative accuracy of the exact one, also after a merge
+  const double alpha = 1e-2;
+  auto x = samples(20001);
+  QuantileSketch all(alpha), a(alpha), b(alpha);
+  for (size_t i = 0; i < x.size(); i++) {
+    all.add(x[i]);
+    (i < 7000 ? a : b).add(x[i]);
+  }
+  a.merge(b);
+  assert(NEAR(a.total(), static_cast<double>(x.size())));
+
+  std::sort(x.begin(), x.end());
+  for (const double q : { 0.0, 0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99, 1.0 }) {
+    const auto k = static_cast<size_t>(std::max(0.0, std::ceil(q * static_cast<double>(x.size())) - 1));
+    const double exact = x[k];
+    assert(std::abs(all.quantile(q) - exact) <= alpha * std::abs(exact) + 1e-12);
+    assert(EQ(a.quantile(q), all.quantile(q)));
+  }
+
+  assert(std::isnan(QuantileSketch{}.quantile(0.5)));
+  return true;
+}
+
+bool test_CellUsageStats()
+{
+  //!< samples are weighted by their duration, so the mean is a time average
+  CellUsageStats u, v;
+  u.add(1, 4, 0.5, 25, 10); //!< 10 s at 1 A
+  v.add(-3, 3, 0.2, 35, 30); //!< 30 s at -3 A
+  u.merge(v);
+
+  assert(NEAR(u.I.stats.mean(), (10 * 1 - 30 * 3) / 40.0, 1e-12));
+  assert(NEAR(u.T.stats.mean(), (10 * 25 + 30 * 35) / 40.0, 1e-12));
+  assert(NEAR(u.timeAtSOC.total(), 40));
+  assert(NEAR(u.timeAtT.total(), 40));
+  assert(EQ(u.I.stats.count(), 2));
+  assert(NEAR(u.I.sketch.quantile(0.5), -3, 3 * settings::DATASTORE_QUANTILE_ACCURACY));
+  return true;
+}
+
+bool test_Rainflow()
+{
+  //!< the example of ASTM E1049, with samples between the turning points: depths 3: 0.5, 4: 1.5, 6: 0.5, 8: 1, 9: 0.5 cycles
+  const std::vector<double> tp{ -2, 1, -3, 5, -1, 3, -4, 4, -2 };
+  RainflowCounter rf(1, 1);
+  for (size_t i = 0; i + 1 < tp.size(); i++)
+    for (int j = 0; j < 4; j++)
+      rf.add(tp[i] + (tp[i + 1] - tp[i]) * j / 4.0);
+  rf.add(tp.back());
+
+  std::vector<double> perDepth(10, 0.0);
+  rf.forEach([&](double depth, double, double n) { perDepth[static_cast<size_t>(depth)] += n; });
+  const std::vector<double> expected{ 0, 0, 0, 0.5, 1.5, 0, 0.5, 0, 1, 0.5 };
+  for (size_t k = 0; k < expected.size(); k++)
+    assert(NEAR(perDepth[k], expected[k]));
+  assert(NEAR(rf.total(), 4));
+
+  //!< a merge adds the cycles and the residue as half cycles
+  RainflowCounter merged(1, 1);
+  merged.merge(rf);
+  merged.merge(rf);
+  assert(NEAR(merged.total(), 8));
+
+  //!< a sine with small noise: the noise is below the hysteresis, one cycle per period and the residue stays small
+  RainflowCounter soc;
+  for (int i = 0; i < 100 * 360; i++)
+    soc.add(0.5 + 0.31 * std::sin(i * 3.14159265358979 / 180) + 1e-4 * ((i % 7) - 3));
+
+  double full{ 0 };
+  soc.forEach([&](double depth, double mean, double n) {
+    if (std::abs(depth - 0.6) < 1e-9) {
+      assert(std::abs(mean - 0.5) <= 0.05 + 1e-9); //!< the mean 0.5 is on a bin edge
+      full += n;
+    }
+  });
+  assert(NEAR(full, 100, 1));
+  assert(soc.residueSize() <= 4);
+  return true;
+}
+
+int test_all_StreamingStats()
+{
+  //!< calls all test-functions
+  if (!TEST(test_RunningStats_merge, "test_RunningStats_merge")) return 1;
+  if (!TEST(test_BinnedHistogram, "test_BinnedHistogram")) return 2;
+  if (!TEST(test_QuantileSketch, "test_QuantileSketch")) return 3;
+  if (!TEST(test_CellUsageStats, "test_CellUsageStats")) return 4;
+  if (!TEST(test_Rainflow, "test_Rainflow")) return 5;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_StreamingStats(); }
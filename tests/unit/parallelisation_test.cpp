@@ -0,0 +1,99 @@
+/*
+ * parallelisation_test.cpp
+ *
+ *  Checks that runJobs runs every job in its own folder, skips the jobs which finished before
+ *  and runs the jobs which failed again
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace slide::tests::unit {
+
+bool test_runJobs()
+{
+  const auto folder = PathVar::results / "test_runJobs";
+  std::filesystem::remove_all(folder);
+
+  std::atomic<int> nGood{ 0 }, nBad{ 0 };
+  bool fail{ true }; //!< the job 'bad' throws as long as this is true
+
+  std::vector<Job> jobs{
+    { "good", 1, [&](const std::filesystem::path &dir) {
+       nGood++;
+       std::ofstream{ dir / "out.csv" } << "1,2\n";
+     } },
+    { "bad", 2, [&](const std::filesystem::path &) {
+       nBad++;
+       if (fail) throw 15;
+     } }
+  };
+
+  runJobs(jobs, folder);
+  assert(EQ(nGood.load(), 1));
+  assert(EQ(nBad.load(), 1));
+  assert(std::filesystem::exists(folder / "good" / "out.csv")); //!< the output is in the folder of the job
+  assert(std::filesystem::exists(folder / "good" / "job_done"));
+  assert(!std::filesystem::exists(folder / "bad" / "job_done")); //!< a job which threw is not done
+
+  fail = false;
+  runJobs(jobs, folder); //!< only the failed job is run again
+  assert(EQ(nGood.load(), 1));
+  assert(EQ(nBad.load(), 2));
+  assert(std::filesystem::exists(folder / "bad" / "job_done"));
+
+  runJobs(jobs, folder, 1); //!< everything is done
+  assert(EQ(nGood.load(), 1));
+  assert(EQ(nBad.load(), 2));
+
+  std::filesystem::remove_all(folder);
+  return true;
+}
+
+bool test_runJobs_degradation()
+{
+  //!< a short calendar ageing experiment writes all its files in the folder of its job
+  const auto folder = PathVar::results / "test_runJobs_degradation";
+  std::filesystem::remove_all(folder);
+
+  DEG_ID deg;
+  deg.SEI_id.add_model(4); //!< kinetic and diffusion limited SEI growth
+  deg.SEI_porosity = 0;
+  deg.CS_id.add_model(0); //!< no surface cracks
+  deg.CS_diffusion = 0;
+  deg.LAM_id.add_model(0); //!< no LAM
+  deg.pl_id = 0;           //!< no plating
+
+  std::vector<Job> jobs{ { "calendar", 1, [&](const std::filesystem::path &dir) {
+                            Calendar_one(deg, cellType::KokamNMC, 3.8, PhyConst::Kelvin + 25, 1, 0, 0, 1, dir);
+                          } } };
+  runJobs(jobs, folder);
+
+  const auto dir = folder / "calendar";
+  assert(std::filesystem::exists(dir / "job_done"));
+  size_t nFiles{ 0 };
+  for (const auto &f : std::filesystem::directory_iterator(dir))
+    nFiles += f.path().filename() != "job_done";
+  assert(nFiles > 0); //!< the check-ups and throughput are in the folder of the job
+
+  std::filesystem::remove_all(folder);
+  return true;
+}
+
+int test_all_parallelisation()
+{
+  //!< calls all test-functions
+  if (!TEST(test_runJobs, "test_runJobs")) return 1;
+  if (!TEST(test_runJobs_degradation, "test_runJobs_degradation")) return 2;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_parallelisation(); }
@@ -0,0 +1,166 @@
+/*
+ * read_CSVfiles_test.cpp
+ *
+ *  Checks that the csv readers parse headers, byte order marks, CRLF line ends and spaces, that files are mapped once
+ *  and that the binary cache of parsed files is used and refreshed
+ */
+
+#include "../tests_util.hpp"
+#include "../../src/slide.hpp"
+
+#include <cassert>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <array>
+#include <span>
+
+namespace slide::tests::unit {
+
+auto writeTestFile(const std::string &name, const std::string &contents)
+{
+  const auto path = PathVar::results / name;
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << contents;
+  return path;
+}
+
+bool test_loadCSV_2col()
+{
+  //!< a BOM, a header, CRLF line ends, spaces and a file which does not end with a new line
+  const auto path = writeTestFile("test_csv_2col.csv", "\xEF\xBB\xBFx,y\r\n0, 3.5\r\n1 ,+4e-1\r\n2;-5.25\r\n\r\n3,1e-320");
+
+  std::vector<double> x{ 9, 9, 9, 9, 9, 9 }, y;
+  loadCSV_2col(path, x, y);
+  assert(EQ(x.size(), 4));
+  assert(EQ(y.size(), 4));
+  const std::vector<double> xr{ 0, 1, 2, 3 }, yr{ 3.5, 0.4, -5.25, 1e-320 };
+  for (size_t i = 0; i < xr.size(); i++) {
+    assert(EQ(x[i], xr[i]));
+    assert(EQ(y[i], yr[i]));
+  }
+
+  loadCSV_2col(path, x, y, 2); //!< only the first two rows
+  assert(EQ(x.size(), 2));
+  assert(EQ(y[1], 0.4));
+
+  std::array<double, 3> xa{}, ya{}; //!< an array is filled up to its size
+  loadCSV_2col(path, xa, ya);
+  assert(EQ(xa[2], 2));
+  assert(EQ(ya[2], -5.25));
+  return true;
+}
+
+bool test_loadCSV_mat()
+{
+  //!< a matrix, its first column, and all columns of a file with extra rows
+  const auto path = writeTestFile("test_csv_mat.csv", "1,2,3\n4,5,6\n7,8,9\n");
+
+  Matrix<double, 2, 3> m;
+  loadCSV_mat(path, m);
+  assert(EQ(m[0][0], 1));
+  assert(EQ(m[1][2], 6));
+
+  std::array<double, 3> c{};
+  loadCSV_1col(path, c);
+  assert(EQ(c[0], 1));
+  assert(EQ(c[2], 7));
+
+  DynamicMatrix<double> d;
+  loadCSV_Ncol(path, d);
+  assert(EQ(d.rows(), 3));
+  assert(EQ(d.cols(), 3));
+  assert(EQ(d.data[5], 6));
+
+  std::vector<double> a(4, 0), b(4, 0);
+  const std::array<std::span<double>, 2> cols{ std::span<double>(a), std::span<double>(b) };
+  assert(EQ(loadCSV_cols(path, cols), 3));
+  assert(EQ(a[2], 7));
+  assert(EQ(b[2], 8));
+  assert(EQ(a[3], 0)); //!< not in the file
+
+  bool thrown{ false }; //!< the file does not have enough rows
+  try {
+    Matrix<double, 4, 3> big;
+    loadCSV_mat(path, big);
+  } catch (int e) {
+    thrown = (e == 3);
+  }
+  assert(thrown);
+  return true;
+}
+
+bool test_getFile()
+{
+  //!< a file is only mapped again if it changed
+  const auto path = writeTestFile("test_csv_getFile.csv", "1,2\n");
+  const auto f1 = getFile(path), f2 = getFile(path);
+  assert(f1 == f2);
+  assert(getFileContents(path) == "1,2\n");
+
+  writeTestFile("test_csv_getFile.csv", "1,2\n3,4\n");
+  const auto f3 = getFile(path);
+  assert(f3 != f1);
+  assert(f3->view() == "1,2\n3,4\n");
+
+  bool thrown{ false };
+  try {
+    getFile(PathVar::results / "test_csv_doesNotExist.csv");
+  } catch (int e) {
+    thrown = (e == 2);
+  }
+  assert(thrown);
+  return true;
+}
+
+bool test_csvCache()
+{
+  //!< the second read comes from the cache, which is written again when the csv file changes
+  PathVar::cache = PathVar::results / "test_csv_cache";
+  std::filesystem::remove_all(PathVar::cache);
+
+  const auto path = writeTestFile("test_csv_cache.csv", "x,y\n0,1.5\n1,2.5\n2,3.5\n");
+  std::vector<double> x, y;
+  loadCSV_2col(path, x, y);
+  const auto cname = csv::cachePath(path);
+  assert(std::filesystem::exists(cname));
+  assert(EQ(y.size(), 3));
+  assert(EQ(y[2], 3.5));
+
+  { //!< change the last value in the cache only, reading again has to give the changed value
+    std::fstream c(cname, std::ios::in | std::ios::out | std::ios::binary);
+    c.seekp(-static_cast<std::streamoff>(sizeof(double)), std::ios::end);
+    const double v{ 42 };
+    c.write(reinterpret_cast<const char *>(&v), sizeof(v));
+  }
+  loadCSV_2col(path, x, y);
+  assert(EQ(y[2], 42));
+
+  Matrix<double, 2, 2> m; //!< the other readers use the same cache
+  loadCSV_mat(path, m);
+  assert(EQ(m[1][1], 2.5));
+
+  writeTestFile("test_csv_cache.csv", "0,1.5\n1,2.5\n2,3.5\n3,4.5\n"); //!< another size, so the cache is refreshed
+  loadCSV_2col(path, x, y);
+  assert(EQ(y.size(), 4));
+  assert(EQ(y[2], 3.5));
+  assert(EQ(y[3], 4.5));
+
+  PathVar::cache.clear();
+  return true;
+}
+
+int test_all_read_CSVfiles()
+{
+  //!< calls all test-functions
+  if (!TEST(test_loadCSV_2col, "test_loadCSV_2col")) return 1;
+  if (!TEST(test_loadCSV_mat, "test_loadCSV_mat")) return 2;
+  if (!TEST(test_getFile, "test_getFile")) return 3;
+  if (!TEST(test_csvCache, "test_csvCache")) return 4;
+
+  return 0;
+}
+} // namespace slide::tests::unit
+
+int main() { return slide::tests::unit::test_all_read_CSVfiles(); }